@@ -1,8 +1,11 @@
 #include "include/analysis/ast_context.hpp"
 
+#include "include/analysis/decl_export.hpp"
 #include "repl.hpp"
 #include "simdjson.h"
+#include <algorithm>
 #include <cassert>
+#include <charconv>
 #include <filesystem>
 #include <format>
 #include <fstream>
@@ -11,6 +14,7 @@
 #include <mutex>
 #include <readline/chardefs.h>
 #include <system_error>
+#include <utility>
 #include <vector>
 
 // Forward declaration do replCounter global definido em repl.cpp
@@ -25,16 +29,15 @@ static std::mutex contextWriteMutex;
  * @brief duração estática porque as declarações devem ser visíveis em toda a
  * duração do REPL.
  */
-std::string AstContext::outputHeader_;
+DeclarationStore AstContext::declarations_;
 std::unordered_map<std::string, bool> AstContext::includedFiles_;
-std::vector<CodeTracking> AstContext::codeSnippets_;
+std::vector<std::pair<std::string, bool>> AstContext::includeOrder_;
+SnippetGraph AstContext::snippetGraph_;
 bool AstContext::includesChanged = false;
 
 AstContext::AstContext() {
     std::scoped_lock<std::mutex> lock(contextWriteMutex);
-    if (outputHeader_.empty()) {
-        outputHeader_.reserve(1024 * 10); // Reserva inicial de 10KB
-    }
+    lastGeneration_ = declarations_.generation();
 }
 
 bool AstContext::addInclude(const std::string &includePath,
@@ -42,22 +45,18 @@ bool AstContext::addInclude(const std::string &includePath,
     std::scoped_lock<std::mutex> lock(contextWriteMutex);
     if (includedFiles_.find(includePath) == includedFiles_.end()) {
         includedFiles_.insert({includePath, systemInclude});
+        includeOrder_.emplace_back(includePath, systemInclude);
         includesChanged = true;
 
-        // Adicionando tracking para o outputHeader_
-        std::string includeDeclaration =
+        CodeTracking tracking;
+        tracking.codeSnippet =
             systemInclude ? std::format("#include <{}>\n", includePath)
                           : std::format("#include \"{}\"\n", includePath);
-        outputHeader_ += includeDeclaration;
-
-        // Criar CodeTracking correspondente
-        CodeTracking tracking;
-        tracking.codeSnippet = includeDeclaration;
         tracking.filename = includePath;
         tracking.line = -1; // Include não tem linha específica
         tracking.column = -1;
         tracking.replCounter = replCounter;
-        codeSnippets_.emplace_back(std::move(tracking));
+        declarations_.add(std::move(tracking));
 
         return true;
     }
@@ -68,37 +67,42 @@ bool AstContext::addInclude(const std::string &includePath,
 void AstContext::addDeclaration(const std::string &declaration) {
     std::scoped_lock<std::mutex> lock(contextWriteMutex);
 
-    // Adicionando tracking para o outputHeader_
-    std::string formattedDeclaration = std::format("{}\n", declaration);
-    outputHeader_ += formattedDeclaration;
-
-    // Criar CodeTracking correspondente
     CodeTracking tracking;
-    tracking.codeSnippet = formattedDeclaration;
+    tracking.codeSnippet = std::format("{}\n", declaration);
     tracking.filename = ""; // Declaração não tem arquivo específico (gerada)
     tracking.line = -1;
     tracking.column = -1;
     tracking.replCounter = replCounter;
-    codeSnippets_.emplace_back(std::move(tracking));
+    declarations_.add(std::move(tracking));
+}
+
+bool AstContext::addEntity(const std::string &key,
+                           const std::string &declaration, int64_t line,
+                           const std::filesystem::path &file) {
+    std::scoped_lock<std::mutex> lock(contextWriteMutex);
+
+    CodeTracking tracking;
+    tracking.codeSnippet = std::format("{}\n", declaration);
+    tracking.filename = file.string();
+    tracking.line = line;
+    tracking.column = -1;
+    tracking.replCounter = replCounter;
+    tracking.key = key;
+    return declarations_.add(std::move(tracking));
 }
 
 void AstContext::addLineDirective(int64_t line,
                                   const std::filesystem::path &file) {
     std::scoped_lock<std::mutex> lock(contextWriteMutex);
 
-    // Adicionando tracking para o outputHeader_
-    std::string lineDirective =
-        std::format("#line {} \"{}\"\n", line, file.string());
-    outputHeader_ += lineDirective;
-
-    // Criar CodeTracking correspondente
     CodeTracking tracking;
-    tracking.codeSnippet = lineDirective;
+    tracking.codeSnippet =
+        std::format("#line {} \"{}\"\n", line, file.string());
     tracking.filename = file.string();
     tracking.line = line;
     tracking.column = -1; // Line directive não tem coluna específica
     tracking.replCounter = replCounter;
-    codeSnippets_.emplace_back(std::move(tracking));
+    declarations_.add(std::move(tracking));
 }
 
 bool AstContext::isFileIncluded(const std::string &filePath) const {
@@ -108,54 +112,129 @@ bool AstContext::isFileIncluded(const std::string &filePath) const {
 void AstContext::markFileIncluded(const std::string &filePath,
                                   bool systemInclude) {
     std::scoped_lock<std::mutex> lock(contextWriteMutex);
-    includedFiles_.insert({filePath, systemInclude});
+    if (includedFiles_.insert({filePath, systemInclude}).second) {
+        includeOrder_.emplace_back(filePath, systemInclude);
+    }
+}
+
+std::vector<std::pair<std::string, bool>> AstContext::getOrderedIncludes() {
+    std::scoped_lock<std::mutex> lock(contextWriteMutex);
+    return includeOrder_;
 }
 
 bool AstContext::hasHeaderChanged() const {
     std::scoped_lock<std::mutex> lock(contextWriteMutex);
-    bool changed = outputHeader_.size() != lastHeaderSize_;
-    lastHeaderSize_ = outputHeader_.size();
+    const bool changed = declarations_.generation() != lastGeneration_;
+    lastGeneration_ = declarations_.generation();
     return changed;
 }
 
+uint64_t AstContext::headerGeneration() {
+    std::scoped_lock<std::mutex> lock(contextWriteMutex);
+    return declarations_.generation();
+}
+
 void AstContext::clear() {
     std::scoped_lock<std::mutex> lock(contextWriteMutex);
 
-    // CRÍTICO: outputHeader_.clear() NÃO deve ser chamado!
-    // O outputHeader_ deve manter duração estática para acumular
+    // CRÍTICO: declarations_ NÃO deve ser limpo!
+    // As declarações devem manter duração estática para acumular
     // todas as declarações durante toda a sessão REPL.
-    // Limpar esta variável quebra a geração do decl_amalgama.hpp
-    // outputHeader_.clear(); // ← NUNCA DESCOMENTE ESTA LINHA!
+    // Limpar o store quebra a geração do decl_amalgama.hpp
 
     includedFiles_.clear();
-    lastHeaderSize_ = 0;
+    includeOrder_.clear();
+    lastGeneration_ = 0;
 }
 
 bool AstContext::saveHeaderToFile(const std::string &filename) const {
-    std::fstream headerOutput(filename, std::ios::out);
-    if (!headerOutput.is_open()) {
-        return false;
-    }
-    headerOutput << outputHeader_ << std::endl;
-    return headerOutput.good();
+    return staticSaveHeaderToFile(filename);
 }
 
 bool AstContext::staticSaveHeaderToFile(const std::string &filename) {
     std::scoped_lock<std::mutex> lock(contextWriteMutex);
-    std::fstream headerOutput(filename, std::ios::out);
-    if (!headerOutput.is_open()) {
-        return false;
+    return declarations_.writeTo(filename);
+}
+
+std::string AstContext::snapshotOutputHeader() {
+    std::scoped_lock<std::mutex> lock(contextWriteMutex);
+    return declarations_.text();
+}
+
+DeclarationStore::Fold AstContext::planDeclarationFold(size_t minBytes,
+                                                       size_t keepRecent) {
+    std::scoped_lock<std::mutex> lock(contextWriteMutex);
+    return declarations_.planFold(minBytes, keepRecent);
+}
+
+bool AstContext::commitDeclarationFold(const DeclarationStore::Fold &fold) {
+    std::scoped_lock<std::mutex> lock(contextWriteMutex);
+    return declarations_.commitFold(fold);
+}
+
+size_t AstContext::codeSnippetCount() {
+    std::scoped_lock<std::mutex> lock(contextWriteMutex);
+    return declarations_.entries().size();
+}
+
+std::vector<CodeTracking> AstContext::codeSnippetsSince(size_t first) {
+    std::scoped_lock<std::mutex> lock(contextWriteMutex);
+    const auto &entries = declarations_.entries();
+    if (first >= entries.size()) {
+        return {};
     }
-    headerOutput << outputHeader_ << std::endl;
-    return headerOutput.good();
+    return {entries.begin() + static_cast<std::ptrdiff_t>(first),
+            entries.end()};
 }
 
 void AstContext::regenerateOutputHeaderWithSnippets() {
     std::scoped_lock<std::mutex> lock(contextWriteMutex);
-    outputHeader_.clear();
-    for (const auto &snippet : codeSnippets_) {
-        outputHeader_ += snippet.codeSnippet;
+    declarations_.rebuild();
+}
+
+AstContext::StaleSnippets
+AstContext::recordSnippetDependencies(const std::string &unit,
+                                      std::string_view code,
+                                      std::vector<std::string> provides) {
+    std::scoped_lock<std::mutex> lock(contextWriteMutex);
+
+    std::vector<std::string> redefined;
+    for (const auto &name : provides) {
+        const auto providers = snippetGraph_.providersOf(name);
+        if (std::ranges::any_of(providers, [&](const std::string &other) {
+                return other != unit;
+            })) {
+            redefined.push_back(name);
+        }
+    }
+
+    snippetGraph_.record(unit, code, std::move(provides));
+
+    StaleSnippets stale;
+    for (auto &name : redefined) {
+        auto units = snippetGraph_.affectedBy(name);
+        if (!units.empty()) {
+            stale.emplace_back(std::move(name), std::move(units));
+        }
     }
+    return stale;
+}
+
+void AstContext::reportStaleSnippets(const StaleSnippets &stale) {
+    for (const auto &[name, units] : stale) {
+        std::string list;
+        for (const auto &u : units) {
+            list += list.empty() ? u : ", " + u;
+        }
+        std::cout << std::format(
+            "⚠️  {} redefined; still built against the old definition: {}\n",
+            name, list);
+    }
+}
+
+SnippetGraph AstContext::snippetGraph() {
+    std::scoped_lock<std::mutex> lock(contextWriteMutex);
+    return snippetGraph_;
 }
 
 ContextualAstAnalyzer::ContextualAstAnalyzer(
@@ -366,70 +445,96 @@ void ContextualAstAnalyzer::analyzeInnerAST(std::filesystem::path source,
 
         if (kind_string.value() == "FunctionDecl" ||
             kind_string.value() == "CXXMethodDecl") {
+            auto mangledName = element["mangledName"];
+            std::string_view mangled;
+            if (!mangledName.error()) {
+                mangled = mangledName.get_string().value();
+            }
 
-            if (kind_string.value() != "CXXMethodDecl") {
-                auto qualTypestr = std::string(qualType_string.value());
-
-                auto parem = qualTypestr.find_first_of('(');
+            addFunctionDeclaration(kind_string.value(), name_string.value(),
+                                   qualType_string.value(), mangled, lastfile,
+                                   lastLine, vars);
+        } else if (kind_string.value() == "VarDecl") {
+            auto type_var = type["desugaredQualType"];
 
-                if (parem == std::string::npos) {
-                    continue;
-                }
+            addVariableDeclaration(
+                name_string.value(), qualType_string.value(),
+                type_var.error() ? std::string_view{}
+                                 : type_var.get_string().value(),
+                lastfile, lastLine, vars);
+        }
+    }
+}
 
-                qualTypestr.insert(parem, std::string(name_string.value()));
+void ContextualAstAnalyzer::addFunctionDeclaration(
+    std::string_view kind, std::string_view name, std::string_view qualType,
+    std::string_view mangledName, const std::filesystem::path &file,
+    int64_t line, std::vector<VarDecl> &vars) {
+    if (kind != "CXXMethodDecl") {
+        auto qualTypestr = std::string(qualType);
 
-                std::cout << "extern " << qualTypestr << ";" << std::endl;
+        auto parem = qualTypestr.find_first_of('(');
 
-                context_->addDeclaration(
-                    std::format("extern {};", qualTypestr));
-            }
+        if (parem == std::string::npos) {
+            return;
+        }
 
-            auto mangledName = element["mangledName"];
+        qualTypestr.insert(parem, std::string(name));
 
-            if (mangledName.error()) {
-                continue;
-            }
+        std::cout << "extern " << qualTypestr << ";" << std::endl;
 
-            VarDecl var;
+        // Sobrecargas têm mangled names diferentes
+        context_->addEntity(
+            mangledName.empty() ? std::format("fn:{}{}", name, qualType)
+                                : std::format("fn:{}", mangledName),
+            std::format("extern {};", qualTypestr));
+        provided_.emplace_back(name);
+    }
 
-            var.name = name_string.value();
-            var.type = "";
-            var.qualType = qualType_string.value();
-            var.kind = kind_string.value();
-            var.file = lastfile;
-            var.line = lastLine;
-            var.mangledName = mangledName.get_string().value();
+    if (mangledName.empty()) {
+        return;
+    }
 
-            vars.push_back(std::move(var));
-        } else if (kind_string.value() == "VarDecl") {
-            context_->addLineDirective(lastLine, lastfile);
+    VarDecl var;
 
-            std::string typenamestr = std::string(qualType_string.value());
+    var.name = name;
+    var.type = "";
+    var.qualType = qualType;
+    var.kind = kind;
+    var.file = file;
+    var.line = line;
+    var.mangledName = mangledName;
 
-            if (auto bracket = typenamestr.find_first_of('[');
-                bracket != std::string::npos) {
-                typenamestr.insert(bracket,
-                                   std::format(" {}", name_string.value()));
-            } else {
-                typenamestr += std::format(" {}", name_string.value());
-            }
+    vars.push_back(std::move(var));
+}
 
-            context_->addDeclaration(std::format("extern {};", typenamestr));
+void ContextualAstAnalyzer::addVariableDeclaration(
+    std::string_view name, std::string_view qualType,
+    std::string_view desugaredQualType, const std::filesystem::path &file,
+    int64_t line, std::vector<VarDecl> &vars) {
+    std::string typenamestr = std::string(qualType);
+
+    if (auto bracket = typenamestr.find_first_of('[');
+        bracket != std::string::npos) {
+        typenamestr.insert(bracket, std::format(" {}", name));
+    } else {
+        typenamestr += std::format(" {}", name);
+    }
 
-            VarDecl var;
+    context_->addEntity(std::format("var:{}", name),
+                        std::format("extern {};", typenamestr), line, file);
+    provided_.emplace_back(name);
 
-            auto type_var = type["desugaredQualType"];
+    VarDecl var;
 
-            var.name = name_string.value();
-            var.type = type_var.error() ? "" : type_var.get_string().value();
-            var.qualType = qualType_string.value();
-            var.kind = kind_string.value();
-            var.file = lastfile;
-            var.line = lastLine;
+    var.name = name;
+    var.type = desugaredQualType;
+    var.qualType = qualType;
+    var.kind = "VarDecl";
+    var.file = file;
+    var.line = line;
 
-            vars.push_back(std::move(var));
-        }
-    }
+    vars.push_back(std::move(var));
 }
 
 int ContextualAstAnalyzer::analyzeASTFromJsonString(
@@ -459,8 +564,11 @@ int ContextualAstAnalyzer::analyzeASTFromJsonString(
         return EXIT_FAILURE;
     }
 
+    provided_.clear();
+    stale_.clear();
     auto inner = doc["inner"];
     analyzeInnerAST(source, vars, &inner);
+    recordSnippet(source);
 
     return EXIT_SUCCESS;
 }
@@ -631,67 +739,173 @@ void ContextualAstAnalyzer::extractCompleteClassDefinition(
             return;
         }
 
-        // ---- Leitura ipsis litteris do trecho do arquivo-fonte ----
-        std::fstream sourceFileStream(lastfile,
-                                      std::ios::in | std::ios::binary);
-        if (!sourceFileStream.is_open()) {
-            if (::verbosityLevel >= 1) {
-                std::cerr << "⚠️  Could not open source file: " << lastfile
-                          << std::endl;
-            }
-            return;
+        addSourceDefinition(lastfile, lastLine, begin_value,
+                            end_value + tok_length, name);
+
+    } catch (const std::exception &e) {
+        if (::verbosityLevel >= 1) {
+            std::cerr << "⚠️  Error extracting class definition: " << e.what()
+                      << std::endl;
+        }
+    } catch (...) {
+        if (::verbosityLevel >= 1) {
+            std::cerr << "⚠️  Unknown error extracting class definition"
+                      << std::endl;
         }
+    }
+}
 
-        sourceFileStream.seekg(0, std::ios::end);
-        const auto fileSize = static_cast<int64_t>(sourceFileStream.tellg());
-        sourceFileStream.seekg(0, std::ios::beg);
+void ContextualAstAnalyzer::addSourceDefinition(
+    const std::filesystem::path &file, int64_t line, int64_t beginOffset,
+    int64_t endOffset, std::string_view name) {
+    // ---- Leitura ipsis litteris do trecho do arquivo-fonte ----
+    std::fstream sourceFileStream(file, std::ios::in | std::ios::binary);
+    if (!sourceFileStream.is_open()) {
+        if (::verbosityLevel >= 1) {
+            std::cerr << "⚠️  Could not open source file: " << file
+                      << std::endl;
+        }
+        return;
+    }
 
-        if (begin_value < 0 || end_value < 0 || begin_value >= fileSize ||
-            end_value > fileSize) {
-            if (::verbosityLevel >= 1) {
-                std::cerr << "⚠️  Range offsets out of bounds for file: "
-                          << lastfile << std::endl;
-            }
-            return;
+    sourceFileStream.seekg(0, std::ios::end);
+    const auto fileSize = static_cast<int64_t>(sourceFileStream.tellg());
+    sourceFileStream.seekg(0, std::ios::beg);
+
+    if (beginOffset < 0 || endOffset < 0 || beginOffset >= fileSize ||
+        endOffset > fileSize || beginOffset >= endOffset) {
+        if (::verbosityLevel >= 1) {
+            std::cerr << "⚠️  Range offsets out of bounds for file: " << file
+                      << std::endl;
         }
+        return;
+    }
 
-        const size_t length =
-            static_cast<size_t>((end_value - begin_value) + tok_length);
-        std::string sourceDefinition;
-        sourceDefinition.reserve(length + 1);
+    const size_t length = static_cast<size_t>(endOffset - beginOffset);
+    std::string sourceDefinition;
+    sourceDefinition.reserve(length + 1);
 
-        sourceFileStream.seekg(begin_value, std::ios::beg);
-        std::copy_n(std::istreambuf_iterator<char>(sourceFileStream), length,
-                    std::back_insert_iterator<std::string>(sourceDefinition));
-        sourceFileStream.close();
+    sourceFileStream.seekg(beginOffset, std::ios::beg);
+    std::copy_n(std::istreambuf_iterator<char>(sourceFileStream), length,
+                std::back_insert_iterator<std::string>(sourceDefinition));
+    sourceFileStream.close();
 
-        sourceDefinition.push_back(';');
+    sourceDefinition.push_back(';');
 
-        if (!sourceDefinition.empty()) {
-            if (::verbosityLevel >= 3) {
-                std::cout << std::format(
-                    "Copying source definition ipsis litteris: {}\n", name);
+    if (::verbosityLevel >= 3) {
+        std::cout << std::format(
+            "Copying source definition ipsis litteris: {}\n", name);
+    }
+    context_->addEntity(std::format("record:{}", name), sourceDefinition, line,
+                        file);
+    provided_.emplace_back(name);
+}
+
+void ContextualAstAnalyzer::recordSnippet(
+    const std::filesystem::path &source) {
+    std::ifstream in(source, std::ios::in | std::ios::binary);
+    const std::string code{std::istreambuf_iterator<char>(in),
+                           std::istreambuf_iterator<char>()};
+    const std::string unit = unit_.empty() ? source.stem().string() : unit_;
+
+    stale_ = AstContext::recordSnippetDependencies(unit, code, provided_);
+}
+
+int ContextualAstAnalyzer::analyzeDeclRecords(std::string_view records,
+                                              const std::string &source,
+                                              std::vector<VarDecl> &vars) {
+    namespace dx = decl_export;
+
+    size_t pos = records.find('\n');
+    if (pos == std::string_view::npos ||
+        records.substr(0, pos) != dx::kMagic) {
+        std::cerr << "⚠️  Invalid declaration export header\n";
+        return EXIT_FAILURE;
+    }
+    ++pos;
+
+    const std::filesystem::path sourcePath(source);
+    provided_.clear();
+    stale_.clear();
+
+    while (pos < records.size()) {
+        size_t eol = records.find('\n', pos);
+        if (eol == std::string_view::npos) {
+            eol = records.size();
+        }
+        const auto line = records.substr(pos, eol - pos);
+        pos = eol + 1;
+
+        if (line.empty()) {
+            continue;
+        }
+
+        const auto fields = dx::splitFields(line);
+
+        if (fields[0] == "I" && fields.size() == 2) {
+            // Mesmo filtro do caminho JSON (includedFrom == source)
+            std::filesystem::path p(dx::unescape(fields[1]));
+            std::error_code ec;
+            auto canonical = std::filesystem::canonical(p, ec);
+            if (!ec) {
+                p = std::filesystem::absolute(canonical, ec);
             }
-            context_->addLineDirective(lastLine, lastfile);
-            context_->addDeclaration(sourceDefinition);
-        } else {
-            if (::verbosityLevel >= 2) {
-                std::cout << std::format(
-                    "⚠️  Failed to extract source definition for: {}\n", name);
+
+            std::string path = p.string();
+            if (!path.empty() && !path.ends_with(".cpp") &&
+                !path.ends_with(".cc") &&
+                p.filename() != "decl_amalgama.hpp" &&
+                p.filename() != "printerOutput.hpp" &&
+                p.filename() != "precompiledheader.hpp" &&
+                !context_->isFileIncluded(path)) {
+                context_->addInclude(path);
+            }
+            continue;
+        }
+
+        if (fields[0] != "D" || fields.size() != 11) {
+            continue;
+        }
+
+        dx::DeclRecord rec{.kind = dx::unescape(fields[1]),
+                           .name = dx::unescape(fields[2]),
+                           .qualType = dx::unescape(fields[3]),
+                           .desugaredQualType = dx::unescape(fields[4]),
+                           .mangledName = dx::unescape(fields[5]),
+                           .storageClass = dx::unescape(fields[6]),
+                           .file = dx::unescape(fields[7])};
+        std::from_chars(fields[8].data(), fields[8].data() + fields[8].size(),
+                        rec.line);
+        std::from_chars(fields[9].data(), fields[9].data() + fields[9].size(),
+                        rec.beginOffset);
+        std::from_chars(fields[10].data(),
+                        fields[10].data() + fields[10].size(), rec.endOffset);
+
+        if (rec.kind == "CXXRecordDecl" || rec.kind == "RecordDecl") {
+            std::error_code ec;
+            if (std::filesystem::equivalent(rec.file, sourcePath, ec) && !ec) {
+                addSourceDefinition(rec.file, rec.line, rec.beginOffset,
+                                    rec.endOffset, rec.name);
             }
+            continue;
         }
 
-    } catch (const std::exception &e) {
-        if (::verbosityLevel >= 1) {
-            std::cerr << "⚠️  Error extracting class definition: " << e.what()
-                      << std::endl;
+        if (rec.storageClass == "extern" || rec.storageClass == "static") {
+            continue;
         }
-    } catch (...) {
-        if (::verbosityLevel >= 1) {
-            std::cerr << "⚠️  Unknown error extracting class definition"
-                      << std::endl;
+
+        if (rec.kind == "FunctionDecl" || rec.kind == "CXXMethodDecl") {
+            addFunctionDeclaration(rec.kind, rec.name, rec.qualType,
+                                   rec.mangledName, rec.file, rec.line, vars);
+        } else if (rec.kind == "VarDecl") {
+            addVariableDeclaration(rec.name, rec.qualType,
+                                   rec.desugaredQualType, rec.file, rec.line,
+                                   vars);
         }
     }
+
+    recordSnippet(sourcePath);
+    return EXIT_SUCCESS;
 }
 
 } // namespace analysis
@@ -3,6 +3,8 @@
 #include "analysis/ast_context.hpp"
 #include "repl.hpp"
 
+#include <utility>
+
 namespace analysis {
 
 ClangAstAnalyzerAdapter::ClangAstAnalyzerAdapter() {
@@ -44,6 +46,15 @@ int ClangAstAnalyzerAdapter::analyzeFile(const std::string &jsonFilename,
     return analyzer_->analyzeASTFile(jsonFilename, source, vars);
 }
 
+int ClangAstAnalyzerAdapter::analyzeDeclRecords(std::string_view records,
+                                                const std::string &source,
+                                                std::vector<VarDecl> &vars) {
+    if (!analyzer_) {
+        return -1;
+    }
+    return analyzer_->analyzeDeclRecords(records, source, vars);
+}
+
 std::shared_ptr<AstContext> ClangAstAnalyzerAdapter::getContext() const {
     return context_;
 }
@@ -52,6 +63,12 @@ const ContextualAstAnalyzer &ClangAstAnalyzerAdapter::getAnalyzer() const {
     return *analyzer_;
 }
 
+void ClangAstAnalyzerAdapter::setSnippetUnit(std::string unit) {
+    if (analyzer_) {
+        analyzer_->setSnippetUnit(std::move(unit));
+    }
+}
+
 ClangAstAnalyzerAdapter ClangAstAnalyzerAdapter::createWithSharedContext(
     std::shared_ptr<AstContext> context) {
     return ClangAstAnalyzerAdapter(context, nullptr);
@@ -27,6 +27,13 @@ class IAstAnalyzer {
                             const std::string &source,
                             std::vector<VarDecl> &vars) = 0;
 
+    // Analyze the line records written by the cpprepl-decls clang plugin
+    virtual int analyzeDeclRecords(std::string_view records,
+                                   const std::string &source,
+                                   std::vector<VarDecl> &vars) {
+        return -1;
+    }
+
     // Get the AST context (may return null if not supported)
     virtual std::shared_ptr<AstContext> getContext() const { return nullptr; }
 };
@@ -1,12 +1,16 @@
 #pragma once
 
 #include "../../simdjson.h"
+#include "declaration_store.hpp"
+#include "snippet_graph.hpp"
 #include <cstdint>
 #include <filesystem>
 #include <memory>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <unordered_set>
+#include <utility>
 #include <vector>
 
 // forward declarations
@@ -14,27 +18,6 @@ struct VarDecl;
 
 namespace analysis {
 
-/**
- * @brief Estrutura para rastreamento de código fonte
- * Esta estrutura mantém informações sobre trechos de código fonte,
- * incluindo o snippet de código, o nome do arquivo, a linha e coluna
- * onde o código começa, e um contador de REPL para identificar
- * a ordem de inserção.
- */
-struct CodeTracking {
-    std::string codeSnippet;
-    std::string filename;
-    int64_t line{};
-    int64_t column{};
-
-    int64_t replCounter{};
-
-    CodeTracking() = default;
-    CodeTracking(std::string file, int64_t ln = {}, int64_t col = {},
-                 int64_t repl = {})
-        : filename(std::move(file)), line(ln), column(col), replCounter(repl) {}
-};
-
 /**
  * @brief Contexto para análise AST que encapsula o estado compartilhado
  *
@@ -69,6 +52,20 @@ class AstContext {
      */
     void addDeclaration(const std::string &declaration);
 
+    /**
+     * @brief Adiciona ou substitui a declaração da entidade @p key
+     *
+     * Mesma chave com o mesmo texto é redeclaração e não muda o header;
+     * texto diferente substitui a definição anterior.
+     * @param key Chave da entidade ("fn:<mangled>", "var:<nome>"...)
+     * @param declaration Declaração, sem '\n' final
+     * @param line Linha da diretiva #line que precede a declaração; -1 omite
+     * @param file Arquivo citado na diretiva #line
+     * @return true se o header mudou
+     */
+    bool addEntity(const std::string &key, const std::string &declaration,
+                   int64_t line = -1, const std::filesystem::path &file = {});
+
     /**
      * @brief Adiciona uma diretiva #line ao header de saída
      * @param line Número da linha
@@ -95,14 +92,22 @@ class AstContext {
      * @brief Obtém o header de saída completo
      * @return String contendo todas as declarações
      */
-    const std::string &getOutputHeader() const { return outputHeader_; }
+    const std::string &getOutputHeader() const {
+        return declarations_.text();
+    }
 
     /**
      * @brief Verifica se o header foi modificado desde a última verificação
+     * (ou desde a criação deste contexto)
      * @return true se foi modificado, false caso contrário
      */
     bool hasHeaderChanged() const;
 
+    /**
+     * @brief Contador que muda a cada alteração efetiva do header
+     */
+    static uint64_t headerGeneration();
+
     /**
      * @brief Limpa todo o contexto
      */
@@ -117,27 +122,100 @@ class AstContext {
 
     static bool staticSaveHeaderToFile(const std::string &filename);
 
+    /**
+     * @brief Cópia do conteúdo que saveHeaderToFile gravaria em disco
+     *
+     * Usado pelo backend in-process para servir decl_amalgama.hpp da memória.
+     */
+    static std::string snapshotOutputHeader();
+
+    /**
+     * @brief Declarações estáveis que podem ir para uma camada do PCH
+     * @see DeclarationStore::planFold
+     */
+    static DeclarationStore::Fold planDeclarationFold(size_t minBytes,
+                                                      size_t keepRecent);
+
+    /**
+     * @brief Tira do header as declarações que a camada de @p fold contém
+     * @return false se o plano ficou velho (header intacto)
+     */
+    static bool commitDeclarationFold(const DeclarationStore::Fold &fold);
+
+    /**
+     * @brief Número de registros no log (marca para codeSnippetsSince)
+     */
+    static size_t codeSnippetCount();
+
+    /**
+     * @brief Cópia dos registros adicionados a partir da posição @p first
+     *
+     * Usado pelo cache de artefatos para guardar o que uma análise acrescentou
+     * ao decl_amalgama.hpp.
+     */
+    static std::vector<CodeTracking> codeSnippetsSince(size_t first);
+
     static void regenerateOutputHeaderWithSnippets();
 
+    /**
+     * @brief Nome redefinido e as unidades compiladas contra a definição
+     * anterior
+     */
+    using StaleSnippets =
+        std::vector<std::pair<std::string, std::vector<std::string>>>;
+
+    /**
+     * @brief Registra @p unit no grafo de dependências entre trechos
+     * @param code Fonte da unidade (os nomes citados saem dos tokens)
+     * @param provides Nomes que a análise acrescentou ao decl_amalgama.hpp
+     * @return Nomes de @p provides que já vinham de outra unidade, com as
+     * unidades que ficaram desatualizadas
+     */
+    static StaleSnippets
+    recordSnippetDependencies(const std::string &unit, std::string_view code,
+                              std::vector<std::string> provides);
+
+    /**
+     * @brief Avisa, no terminal, sobre as unidades de @p stale
+     *
+     * Fica com quem chamou a análise: os workers paralelos só coletam.
+     */
+    static void reportStaleSnippets(const StaleSnippets &stale);
+
+    /**
+     * @brief Cópia do grafo de dependências entre trechos
+     */
+    static SnippetGraph snippetGraph();
+
     static const std::unordered_map<std::string, bool> &getIncludedFiles() {
         return includedFiles_;
     }
 
+    /**
+     * @brief Cópia dos includes na ordem em que foram adicionados
+     *
+     * Usado pelas camadas de PCH: cada camada nova contém apenas o sufixo
+     * ainda não pré-compilado.
+     */
+    static std::vector<std::pair<std::string, bool>> getOrderedIncludes();
+
   private:
     /**
-     * @brief Header de declarações com duração estática
+     * @brief Declarações com duração estática
      *
      * CRÍTICO: Esta variável NUNCA deve ser limpa durante a execução do REPL
      * pois é usada para gerar decl_amalgama.hpp com todas as declarações
      * acumuladas ao longo da sessão. Limpar esta variável quebra a
      * funcionalidade básica do REPL.
-     * NEW: para cada adição nova no outputHeader_, deve haver um equivalente em
-     * codeSnippets_
+     * O log de registros (codeSnippets) e o texto do header vivem juntos
+     * no DeclarationStore.
      */
-    static std::string outputHeader_;
+    static DeclarationStore declarations_;
     static std::unordered_map<std::string, bool> includedFiles_;
-    static std::vector<CodeTracking> codeSnippets_;
-    mutable size_t lastHeaderSize_ = 0;
+    static std::vector<std::pair<std::string, bool>> includeOrder_;
+    // Quem declara e quem cita o quê, por unidade analisada
+    static SnippetGraph snippetGraph_;
+    mutable uint64_t lastGeneration_ = 0;
 
   public:
     /**
@@ -145,7 +223,7 @@ class AstContext {
      * @return const std::vector<CodeTracking>&
      */
     const std::vector<CodeTracking> &getCodeSnippets() const {
-        return codeSnippets_;
+        return declarations_.entries();
     }
 
     /**
@@ -153,7 +231,7 @@ class AstContext {
      * @return std::vector<CodeTracking>&
      */
     std::vector<CodeTracking> &getCodeSnippetsMutable() {
-        return codeSnippets_;
+        return declarations_.entries();
     }
 
     /**
@@ -199,14 +277,83 @@ class ContextualAstAnalyzer {
     int analyzeASTFile(const std::string &filename, const std::string &source,
                        std::vector<VarDecl> &vars);
 
+    /**
+     * @brief Analisa os registros do exportador de declarações
+     *
+     * Alternativa ao JSON: consome a saída do plugin cpprepl-decls (formato
+     * em analysis/decl_export.hpp) com os mesmos efeitos no contexto.
+     *
+     * @param records Conteúdo do arquivo .decls
+     * @param source Arquivo de origem
+     * @param vars Vector para armazenar as variáveis encontradas
+     * @return Código de saída (0 para sucesso)
+     */
+    int analyzeDeclRecords(std::string_view records, const std::string &source,
+                           std::vector<VarDecl> &vars);
+
     /**
      * @brief Obtém o contexto AST
      * @return Ponteiro compartilhado para o contexto
      */
     std::shared_ptr<AstContext> getContext() const { return context_; }
 
+    /**
+     * @brief Nome da unidade no grafo de dependências
+     *
+     * Vazio usa o nome do fonte sem extensão; útil quando o fonte é um
+     * caminho /proc/<pid>/fd/N do modo diskless.
+     */
+    void setSnippetUnit(std::string unit) { unit_ = std::move(unit); }
+
+    /**
+     * @brief Nomes que a última análise acrescentou ao decl_amalgama.hpp
+     */
+    const std::vector<std::string> &providedNames() const {
+        return provided_;
+    }
+
+    /**
+     * @brief Redefinições vistas pela última análise; o chamador avisa com
+     * AstContext::reportStaleSnippets()
+     */
+    const AstContext::StaleSnippets &staleSnippets() const { return stale_; }
+
   private:
     std::shared_ptr<AstContext> context_;
+    std::string unit_;
+    std::vector<std::string> provided_; // nomes registrados nesta análise
+    AstContext::StaleSnippets stale_;
+
+    /**
+     * @brief Registra a unidade analisada no grafo e guarda os trechos
+     * compilados contra uma definição que acabou de mudar
+     */
+    void recordSnippet(const std::filesystem::path &source);
+
+    /**
+     * @brief Registra uma FunctionDecl/CXXMethodDecl (extern + VarDecl)
+     */
+    void addFunctionDeclaration(std::string_view kind, std::string_view name,
+                                std::string_view qualType,
+                                std::string_view mangledName,
+                                const std::filesystem::path &file,
+                                int64_t line, std::vector<VarDecl> &vars);
+
+    /**
+     * @brief Registra uma VarDecl (#line + extern + VarDecl)
+     */
+    void addVariableDeclaration(std::string_view name,
+                                std::string_view qualType,
+                                std::string_view desugaredQualType,
+                                const std::filesystem::path &file,
+                                int64_t line, std::vector<VarDecl> &vars);
+
+    /**
+     * @brief Copia [beginOffset, endOffset) do arquivo como definição
+     */
+    void addSourceDefinition(const std::filesystem::path &file, int64_t line,
+                             int64_t beginOffset, int64_t endOffset,
+                             std::string_view name);
 
     /**
      * @brief Extrai e adiciona definição completa de classe/struct ao contexto
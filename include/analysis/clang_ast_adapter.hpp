@@ -70,6 +70,16 @@ class ClangAstAnalyzerAdapter : public IAstAnalyzer {
     int analyzeFile(const std::string &jsonFilename, const std::string &source,
                     std::vector<VarDecl> &vars) override;
 
+    /**
+     * @brief Analisa os registros do plugin cpprepl-decls
+     * @param records Conteúdo do arquivo .decls
+     * @param source Arquivo de origem
+     * @param vars Vector para armazenar variáveis encontradas
+     * @return 0 para sucesso, código de erro caso contrário
+     */
+    int analyzeDeclRecords(std::string_view records, const std::string &source,
+                           std::vector<VarDecl> &vars) override;
+
     /**
      * @brief Obtém o contexto AST compartilhado
      * @return Ponteiro compartilhado para o contexto
@@ -82,6 +92,12 @@ class ClangAstAnalyzerAdapter : public IAstAnalyzer {
      */
     const ContextualAstAnalyzer &getAnalyzer() const;
 
+    /**
+     * @brief Nome da unidade no grafo de dependências entre trechos
+     * @param unit Nome do TU sem extensão (repl_N, fonte do #batch_eval)
+     */
+    void setSnippetUnit(std::string unit);
+
     /**
      * @brief Cria uma nova instância com contexto compartilhado
      * @param context Contexto a ser compartilhado
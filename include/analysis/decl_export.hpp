@@ -0,0 +1,126 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace analysis::decl_export {
+
+/**
+ * @brief Formato de linha do exportador de declarações (plugin cpprepl-decls)
+ *
+ * Substitui o -ast-dump=json: o plugin emite apenas as declarações de nível
+ * superior que o ContextualAstAnalyzer usaria, uma por linha, com campos
+ * separados por TAB. TAB, quebra de linha e '\' dentro de campos são
+ * escapados como \t, \n e \\.
+ *
+ *   CPPREPL-DECLS 1
+ *   I <arquivo incluído diretamente pelo fonte principal>
+ *   D <kind> <name> <qualType> <desugaredQualType> <mangledName>
+ *     <storageClass> <file> <line> <beginOffset> <endOffset>
+ *
+ * kind segue a nomenclatura do JSON do clang (VarDecl, FunctionDecl,
+ * CXXMethodDecl, CXXRecordDecl, RecordDecl). endOffset é exclusivo (já inclui
+ * o último token).
+ */
+inline constexpr std::string_view kMagic = "CPPREPL-DECLS 1";
+inline constexpr std::string_view kPluginName = "cpprepl-decls";
+
+struct DeclRecord {
+    std::string kind;
+    std::string name;
+    std::string qualType;
+    std::string desugaredQualType;
+    std::string mangledName;
+    std::string storageClass;
+    std::string file;
+    int64_t line = 0;
+    int64_t beginOffset = -1;
+    int64_t endOffset = -1;
+};
+
+inline void appendEscaped(std::string &out, std::string_view field) {
+    for (char c : field) {
+        switch (c) {
+        case '\\':
+            out += "\\\\";
+            break;
+        case '\t':
+            out += "\\t";
+            break;
+        case '\n':
+            out += "\\n";
+            break;
+        default:
+            out += c;
+        }
+    }
+}
+
+inline std::string unescape(std::string_view field) {
+    std::string out;
+    out.reserve(field.size());
+    for (size_t i = 0; i < field.size(); ++i) {
+        if (field[i] != '\\' || i + 1 == field.size()) {
+            out += field[i];
+            continue;
+        }
+        switch (field[++i]) {
+        case 't':
+            out += '\t';
+            break;
+        case 'n':
+            out += '\n';
+            break;
+        default:
+            out += field[i];
+        }
+    }
+    return out;
+}
+
+/**
+ * @brief Divide uma linha em campos separados por TAB (sem desescapar)
+ */
+inline std::vector<std::string_view> splitFields(std::string_view line) {
+    std::vector<std::string_view> fields;
+    size_t start = 0;
+    while (true) {
+        size_t tab = line.find('\t', start);
+        if (tab == std::string_view::npos) {
+            fields.push_back(line.substr(start));
+            return fields;
+        }
+        fields.push_back(line.substr(start, tab - start));
+        start = tab + 1;
+    }
+}
+
+inline void appendInclude(std::string &out, std::string_view path) {
+    out += "I\t";
+    appendEscaped(out, path);
+    out += '\n';
+}
+
+inline void appendDecl(std::string &out, const DeclRecord &rec) {
+    out += "D";
+    for (std::string_view field :
+         {std::string_view(rec.kind), std::string_view(rec.name),
+          std::string_view(rec.qualType),
+          std::string_view(rec.desugaredQualType),
+          std::string_view(rec.mangledName), std::string_view(rec.storageClass),
+          std::string_view(rec.file)}) {
+        out += '\t';
+        appendEscaped(out, field);
+    }
+    out += '\t';
+    out += std::to_string(rec.line);
+    out += '\t';
+    out += std::to_string(rec.beginOffset);
+    out += '\t';
+    out += std::to_string(rec.endOffset);
+    out += '\n';
+}
+
+} // namespace analysis::decl_export
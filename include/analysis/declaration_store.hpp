@@ -0,0 +1,137 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace analysis {
+
+/**
+ * @brief Estrutura para rastreamento de código fonte
+ * Esta estrutura mantém informações sobre trechos de código fonte,
+ * incluindo o snippet de código, o nome do arquivo, a linha e coluna
+ * onde o código começa, e um contador de REPL para identificar
+ * a ordem de inserção.
+ */
+struct CodeTracking {
+    std::string codeSnippet;
+    std::string filename;
+    int64_t line{};
+    int64_t column{};
+
+    int64_t replCounter{};
+
+    // Entidade declarada ("fn:<mangled>", "var:<nome>", "record:<nome>");
+    // vazio para includes, diretivas e declarações avulsas. Com chave, a
+    // diretiva #line (line >= 0) é gerada junto com codeSnippet
+    std::string key;
+
+    CodeTracking() = default;
+    CodeTracking(std::string file, int64_t ln = {}, int64_t col = {},
+                 int64_t repl = {})
+        : filename(std::move(file)), line(ln), column(col), replCounter(repl) {}
+};
+
+/**
+ * @brief Declarações da sessão que formam o decl_amalgama.hpp
+ *
+ * Registros com chave são entidades: a mesma chave com o mesmo texto é uma
+ * redeclaração e não muda nada; texto diferente substitui a definição
+ * anterior, que sai do header. Registros sem chave só são acrescentados.
+ *
+ * entries() é o log completo (inclusive as substituídas), na ordem de
+ * inserção. O header concatena as vivas por posição: cada entrada nova ocupa
+ * uma posição no fim, e a redefinição herda a posição da versão anterior,
+ * ficando antes das entradas que dependem dela. generation() muda a cada
+ * alteração efetiva do header. writeTo() acrescenta ao arquivo só o que
+ * entrou desde a última escrita, e reescreve tudo depois de uma
+ * substituição.
+ *
+ * As posições antes de folded() foram dobradas numa camada do PCH: no header
+ * sobram só os #include e #pragma delas, e o resto é o delta recente. Uma
+ * entrada dobrada não sai mais do PCH; substituí-la só acrescenta o texto
+ * novo, numa posição nova, como antes das chaves.
+ *
+ * Não é thread-safe: o AstContext serializa o acesso.
+ */
+class DeclarationStore {
+  public:
+    /**
+     * @return true se o header mudou
+     */
+    bool add(CodeTracking entry);
+
+    /**
+     * @brief Texto de @p entry no header (com a diretiva #line das entidades)
+     */
+    static std::string render(const CodeTracking &entry);
+
+    const std::string &text() const { return text_; }
+    uint64_t generation() const { return generation_; }
+
+    const std::vector<CodeTracking> &entries() const { return entries_; }
+    std::vector<CodeTracking> &entries() { return entries_; }
+    bool live(size_t index) const {
+        return index < live_.size() && live_[index];
+    }
+
+    /**
+     * @brief Remonta o header a partir do log (depois de editar entries())
+     */
+    void rebuild();
+
+    /**
+     * @brief Grava o header em @p path, incrementalmente quando possível
+     */
+    bool writeTo(const std::filesystem::path &path);
+
+    /**
+     * @brief Trecho do header que pode ir para o PCH
+     */
+    struct Fold {
+        size_t begin = 0; // posições [begin, end)
+        size_t end = 0;
+        std::vector<size_t> folded; // entradas vivas nessas posições
+        std::string text;           // o que sai do header
+
+        bool empty() const { return text.empty(); }
+    };
+
+    /**
+     * @brief Propõe dobrar as posições desde folded(), menos as
+     * @p keepRecent últimas
+     * @return Vazio se o header ainda tem menos de @p minBytes, ou se menos
+     * da metade disso sairia dele
+     */
+    Fold planFold(size_t minBytes, size_t keepRecent) const;
+
+    /**
+     * @brief Aplica @p fold se nenhuma entrada dele foi substituída e nada
+     * foi dobrado desde planFold()
+     * @return false se o plano ficou velho (nada muda)
+     */
+    bool commitFold(const Fold &fold);
+
+    size_t folded() const { return folded_; }
+
+  private:
+    std::vector<CodeTracking> entries_;
+    std::vector<bool> live_;
+    std::vector<size_t> order_; // entrada de cada posição do header
+    std::vector<size_t> slot_;  // posição de cada entrada
+    std::unordered_map<std::string, size_t> byKey_; // entrada viva da chave
+    std::string text_;
+    uint64_t generation_ = 0;
+    size_t folded_ = 0; // posições [0, folded_) estão no PCH
+
+    // Estado do último arquivo gravado, para o modo append
+    std::filesystem::path writtenPath_;
+    size_t writtenBytes_ = 0;
+    bool rewrite_ = true;
+};
+
+} // namespace analysis
@@ -0,0 +1,162 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace analysis {
+
+/**
+ * @brief Categoria de uma entrada do REPL
+ */
+enum class InputKind {
+    Empty,        // só espaços e comentários
+    Include,      // uma única diretiva #include
+    Preprocessor, // outras diretivas (#define, #if...)
+    Declaration,  // vai para o escopo global
+    Statement,    // vai para dentro de exec()
+    Expression,   // statement sem ';' final
+};
+
+std::string_view inputKindName(InputKind kind);
+
+enum class TokenKind : uint8_t {
+    End,
+    Identifier, // inclui palavras-chave
+    Number,
+    String, // inclui raw strings e prefixos u8/u/U/L
+    Char,
+    Punct,
+    Directive, // linha de pré-processador inteira, com continuações
+};
+
+struct Token {
+    TokenKind kind = TokenKind::End;
+    std::string_view text;
+
+    bool is(std::string_view punct) const {
+        return kind == TokenKind::Punct && text == punct;
+    }
+};
+
+/**
+ * @brief Tokenizador léxico de C++, sem pré-processamento
+ *
+ * Pula espaços e comentários e entende literais (incluindo raw strings e
+ * separadores de dígitos), então chaves dentro de strings ou comentários
+ * não contam. As tabelas de caracteres e palavras-chave são montadas em
+ * tempo de compilação.
+ */
+class Tokenizer {
+  public:
+    explicit Tokenizer(std::string_view source) : src_(source) {}
+
+    Token next();
+
+    /**
+     * @brief A entrada terminou dentro de um comentário de bloco, de uma raw
+     * string ou depois de uma continuação de linha
+     */
+    bool unterminated() const { return unterminated_; }
+
+  private:
+    void skipSpaceAndComments();
+    Token lexDirective(size_t begin);
+    Token lexIdentifier(size_t begin);
+    Token lexNumber(size_t begin);
+    Token lexQuoted(size_t begin, char quote);
+    Token lexRawString(size_t begin);
+    Token lexPunct(size_t begin);
+
+    std::string_view src_;
+    size_t pos_ = 0;
+    bool lineStart_ = true;
+    bool unterminated_ = false;
+};
+
+struct InputClassification {
+    InputKind kind = InputKind::Empty;
+
+    // Nada aberto: (){}[], comentário de bloco, raw string, continuação de
+    // linha, nem class/struct/namespace/template ainda sem corpo
+    bool complete = true;
+
+    // Declaração que não gera código: só definições de tipo, alias, enum,
+    // template (primário) ou static_assert
+    bool typeOnly = false;
+
+    // Tipos definidos por uma entrada typeOnly, na ordem (struct, enum,
+    // alias, template de classe, concept); declarações sem nome simples não
+    // entram
+    std::vector<std::string_view> typeNames;
+
+    // Alvo do #include, sem "" ou <>; vazio se mal formado
+    std::string_view includeTarget;
+    bool systemInclude = false;
+
+    bool isDeclaration() const {
+        return kind == InputKind::Declaration ||
+               kind == InputKind::Preprocessor || kind == InputKind::Include;
+    }
+    bool isExecutable() const {
+        return kind == InputKind::Statement || kind == InputKind::Expression;
+    }
+};
+
+/**
+ * @brief Classifica a entrada numa passada linear do tokenizador
+ *
+ * Só o começo da primeira construção decide a categoria: palavra-chave de
+ * declaração ou de tipo, ou um nome de tipo (qualificado, com argumentos de
+ * template) seguido de um declarador, é declaração; palavra-chave de
+ * controle é statement; o resto é código executável.
+ */
+InputClassification classifyInput(std::string_view input);
+
+/**
+ * @brief Junta linhas até formar uma entrada completa
+ *
+ * Usado pela continuação do prompt e pelo modo script (-r). Cada linha é
+ * tokenizada uma vez: o scan retoma do fim da última linha que não deixou
+ * comentário ou raw string aberto.
+ */
+class InputAccumulator {
+  public:
+    void append(std::string_view line);
+
+    bool empty() const { return text_.empty(); }
+    bool complete() const;
+    const std::string &text() const { return text_; }
+    size_t lines() const { return lines_; }
+
+    /**
+     * @brief Devolve o texto acumulado e recomeça
+     */
+    std::string take();
+
+  private:
+    struct Balance {
+        int parens = 0;
+        int braces = 0;
+        int brackets = 0;
+        bool seenToken = false;
+        bool needsBody = false; // começou com class/struct/template...
+        char last = 0;          // último token, se for pontuação simples
+
+        void feed(const Token &token);
+        bool complete() const;
+    };
+
+    friend InputClassification classifyInput(std::string_view input);
+
+    std::string text_;
+    size_t lines_ = 0;
+    size_t scanned_ = 0; // fim do trecho já tokenizado sem pendências
+    Balance committed_;  // estado em scanned_
+    Balance current_;    // estado no fim de text_
+    bool unterminated_ = false;
+};
+
+} // namespace analysis
@@ -0,0 +1,76 @@
+#pragma once
+
+#include "analysis/input_classifier.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace analysis {
+
+/**
+ * @brief Lote de blocos de um script (ou colagem) compilado como um TU
+ */
+struct SnippetBatch {
+    enum class Kind {
+        Declarations, // escopo global, analisado como uma definição
+        Statements,   // corpos concatenados dentro de um único exec()
+    };
+
+    Kind kind = Kind::Declarations;
+    std::string code; // sem o prefixo de includes do REPL
+    size_t snippets = 0;
+    int64_t firstLine = 0;
+    int64_t lastLine = 0;
+};
+
+/**
+ * @brief Agrupa blocos consecutivos do mesmo tipo num único TU
+ *
+ * Um lote só tem declarações ou só código executável: uma declaração depois
+ * de statements fecha o lote, senão o inicializador dinâmico dela rodaria no
+ * dlopen, antes dos statements que vieram primeiro no script. Cada bloco
+ * ganha uma diretiva #line com a linha original, para os diagnósticos
+ * apontarem para o script.
+ */
+class SnippetBatcher {
+  public:
+    /**
+     * @param lineFile Arquivo citado nas diretivas #line; vazio só renumera
+     * as linhas e mantém o nome do fonte gerado
+     */
+    explicit SnippetBatcher(std::string lineFile = {});
+
+    /**
+     * @brief Declarações e código executável entram em lotes; diretivas,
+     * comandos e entradas vazias são executados sozinhos
+     */
+    static bool batchable(const InputClassification &input);
+
+    /**
+     * @brief O bloco pode entrar no lote pendente sem trocar de tipo
+     */
+    bool accepts(const InputClassification &input) const;
+
+    /**
+     * @brief Acrescenta @p block, que começa na linha @p line do original
+     */
+    void add(std::string_view block, int64_t line,
+             const InputClassification &input);
+
+    bool empty() const { return batch_.snippets == 0; }
+    size_t size() const { return batch_.snippets; }
+
+    /**
+     * @brief Devolve o lote pendente (statements já dentro de exec()) e
+     * recomeça
+     */
+    SnippetBatch take();
+
+  private:
+    std::string lineFile_;
+    SnippetBatch batch_;
+};
+
+} // namespace analysis
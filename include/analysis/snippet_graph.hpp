@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace analysis {
+
+/**
+ * @brief Identificadores citados em @p code (tokens, sem pré-processamento)
+ *
+ * Inclui palavras-chave e os próprios nomes declarados; quem consulta cruza
+ * com nomes declarados, que nunca são palavras-chave.
+ */
+std::unordered_set<std::string> referencedNames(std::string_view code);
+
+/**
+ * @brief Nomes que @p code declara no escopo global (estimativa léxica)
+ *
+ * Usado para unidades que ainda não passaram pela análise da AST: o nome é
+ * o último identificador antes do primeiro '(', '=', '[', '{', ':' ou ';'
+ * de cada declaração. Namespaces e extern "C" são transparentes, cabeçalhos
+ * de template e using namespace são ignorados.
+ */
+std::vector<std::string> declaredNames(std::string_view code);
+
+/**
+ * @brief Grafo de dependências entre trechos já avaliados
+ *
+ * Cada nó é uma unidade (repl_N, fonte do #batch_eval...) com os nomes que a
+ * análise da AST registrou no decl_amalgama.hpp e os identificadores que o
+ * fonte cita. Uma unidade depende da última unidade anterior que declarou um
+ * nome citado por ela. Reavaliar uma unidade com o mesmo nome substitui o nó.
+ */
+class SnippetGraph {
+  public:
+    struct Node {
+        std::string unit;
+        std::vector<std::string> provides;
+        std::unordered_set<std::string> uses;
+        std::vector<std::string> dependsOn; // resolvido no registro
+    };
+
+    /**
+     * @brief Registra a unidade @p unit, que acabou de ser analisada
+     */
+    void record(const std::string &unit, std::string_view code,
+                std::vector<std::string> provides);
+
+    /**
+     * @brief Unidades que declararam @p name, da mais antiga para a atual
+     */
+    std::vector<std::string> providersOf(std::string_view name) const;
+
+    /**
+     * @brief Unidades anteriores à última declaração de @p name que o citam,
+     * e o que depende delas (transitivamente), na ordem de avaliação
+     *
+     * São as que ficaram compiladas contra a definição antiga.
+     */
+    std::vector<std::string> affectedBy(std::string_view name) const;
+
+    const Node *find(std::string_view unit) const;
+    const std::vector<Node> &nodes() const { return nodes_; }
+    size_t size() const { return nodes_.size(); }
+    bool empty() const { return nodes_.empty(); }
+    void clear();
+
+    /**
+     * @brief Agrupa unidades pendentes em ondas que compilam em paralelo
+     *
+     * A unidade i espera a j se cita um nome que j declara e ela mesma não
+     * declara. Cada onda só depende das anteriores; um ciclo vai inteiro para
+     * a última onda. Os índices de cada onda seguem a ordem de @p codes.
+     */
+    static std::vector<std::vector<size_t>>
+    parallelWaves(const std::vector<std::string> &codes);
+
+  private:
+    std::vector<Node> nodes_;
+    std::unordered_map<std::string, size_t> index_;
+};
+
+} // namespace analysis
@@ -1,10 +1,19 @@
 #pragma once
 
+#include <charconv>
+#include <format>
 #include <iostream>
 #include <string>
 #include <string_view>
 
+#include "analysis/ast_context.hpp"
 #include "commands/command_registry.hpp"
+#include "execution/jobserver.hpp"
+#include "execution/memory_admission.hpp"
+#include "execution/memory_artifacts.hpp"
+#include "execution/speculative_compiler.hpp"
+#include "execution/task_scheduler.hpp"
+#include "execution/workspace.hpp"
 #include "repl.hpp"
 #include "utility/Strutils.hpp"
 #include <unordered_set>
@@ -250,6 +259,322 @@ inline void registerReplCommands(ReplCtxView *) {
                                  : "Async PCH rebuild disabled\n");
             return true;
         });
+
+    // Select how the compiler frontend is run
+    commands::registry().registerPrefix(
+        "#backend", "Compiler backend: inprocess|external|status",
+        [](std::string_view arg, commands::CommandContextBase &) {
+            std::string a(Strutils::trim(arg));
+            Strutils::to_lower(a);
+
+            if (a.empty() || a == "status") {
+                std::cout << (inprocess_compiler_backend_enabled()
+                                  ? "Compiler backend: in-process\n"
+                                  : "Compiler backend: external\n");
+                return true;
+            }
+
+            if (a == "inprocess" || a == "in-process") {
+                if (!set_inprocess_compiler_backend(true)) {
+                    std::cerr << "In-process backend not available (built "
+                                 "without Clang libraries)\n";
+                    return true;
+                }
+                std::cout << "Compiler backend: in-process\n";
+            } else if (a == "external") {
+                set_inprocess_compiler_backend(false);
+                std::cout << "Compiler backend: external\n";
+            } else {
+                std::cerr << "Usage: #backend inprocess|external|status\n";
+            }
+            return true;
+        });
+
+    // On-disk artifact cache (compiled snippets shared across sessions)
+    commands::registry().registerPrefix(
+        "#cache", "Artifact cache: on|off|status|clear",
+        [](std::string_view arg, commands::CommandContextBase &) {
+            std::string a(Strutils::trim(arg));
+            Strutils::to_lower(a);
+
+            if (a.empty() || a == "status") {
+                std::cout << artifact_cache_status();
+            } else if (a == "on") {
+                if (set_artifact_cache_enabled(true)) {
+                    std::cout << "Artifact cache: enabled\n";
+                }
+            } else if (a == "off") {
+                set_artifact_cache_enabled(false);
+                std::cout << "Artifact cache: disabled\n";
+            } else if (a == "clear") {
+                clear_artifact_cache();
+                std::cout << "Artifact cache cleared\n";
+            } else {
+                std::cerr << "Usage: #cache on|off|status|clear\n";
+            }
+            return true;
+        });
+
+    // Eval artifacts (sources, libraries, logs) kept in memfds instead of
+    // the working directory
+    commands::registry().registerPrefix(
+        "#diskless", "In-memory eval artifacts: on|off|status",
+        [](std::string_view arg, commands::CommandContextBase &) {
+            std::string a(Strutils::trim(arg));
+            Strutils::to_lower(a);
+            auto &artifacts = execution::MemoryArtifacts::instance();
+
+            if (a.empty() || a == "status") {
+                std::cout << std::format(
+                    "Diskless mode: {} ({} memfds, {} bytes)\n",
+                    artifacts.enabled() ? "on" : "off", artifacts.count(),
+                    artifacts.bytes());
+            } else if (a == "on") {
+                if (artifacts.setEnabled(true)) {
+                    std::cout << "Diskless mode: enabled\n";
+                }
+            } else if (a == "off") {
+                artifacts.setEnabled(false);
+                std::cout << "Diskless mode: disabled\n";
+            } else {
+                std::cerr << "Usage: #diskless on|off|status\n";
+            }
+            return true;
+        });
+
+    // Per-session artifact directory (sharded, garbage collected)
+    commands::registry().registerPrefix(
+        "#workspace", "Session artifact directory: status|gc",
+        [](std::string_view arg, commands::CommandContextBase &) {
+            std::string a(Strutils::trim(arg));
+            Strutils::to_lower(a);
+            auto &workspace = execution::Workspace::instance();
+
+            if (!workspace.enabled()) {
+                std::cout << "Workspace: disabled (artifacts in the current "
+                             "directory)\n";
+                return true;
+            }
+
+            if (a == "gc") {
+                workspace.advance();
+                workspace.drain();
+            } else if (!a.empty() && a != "status") {
+                std::cerr << "Usage: #workspace status|gc\n";
+                return true;
+            }
+
+            const auto stats = workspace.stats();
+            std::cout << std::format(
+                "Workspace: {}{}\n"
+                "  files: {} ({:.1f} KiB)\n"
+                "  tracked: {}, loaded/retained: {}, pending deletes: {}\n"
+                "  deleted: {}, generation: {}\n",
+                stats.root.string(), stats.tmpfs ? " (tmpfs)" : "",
+                stats.files, static_cast<double>(stats.bytes) / 1024.0,
+                stats.tracked, stats.retained, stats.pendingDeletes,
+                stats.deleted, stats.generation);
+            return true;
+        });
+
+    // Parallel jobs of the eval pipeline (compiles, AST dumps, loads)
+    commands::registry().registerPrefix(
+        "#jobs", "Show or set parallel eval jobs: [N] (0 = auto)",
+        [](std::string_view arg, commands::CommandContextBase &) {
+            auto a = Strutils::trim(arg);
+            auto &scheduler = execution::TaskScheduler::instance();
+            auto &jobserver = execution::Jobserver::instance();
+
+            if (!a.empty()) {
+                size_t jobs = 0;
+                auto [ptr, ec] =
+                    std::from_chars(a.data(), a.data() + a.size(), jobs);
+                if (ec != std::errc{} || ptr != a.data() + a.size()) {
+                    std::cerr << "Usage: #jobs [N]\n";
+                    return true;
+                }
+                scheduler.setConcurrency(jobs);
+                // Servidor: os compiladores filhos seguem o novo limite
+                if (jobserver.mode() == execution::Jobserver::Mode::Server) {
+                    jobserver.serve(scheduler.concurrency());
+                }
+            }
+
+            std::cout << std::format("Parallel jobs: {}\n",
+                                     scheduler.concurrency());
+            switch (jobserver.mode()) {
+            case execution::Jobserver::Mode::Client:
+                std::cout << std::format(
+                    "Jobserver: client of make{}\n",
+                    jobserver.limit() > 0
+                        ? std::format(" (-j{})", jobserver.limit())
+                        : std::string{});
+                break;
+            case execution::Jobserver::Mode::Server:
+                std::cout << std::format("Jobserver: serving {}\n",
+                                         jobserver.makeflags());
+                break;
+            case execution::Jobserver::Mode::Disabled:
+                std::cout << "Jobserver: off\n";
+                break;
+            }
+            return true;
+        });
+
+    // Memory-aware admission of compiler processes
+    commands::registry().registerPrefix(
+        "#admission", "Memory admission for compile jobs: on|off|status",
+        [](std::string_view arg, commands::CommandContextBase &) {
+            std::string a(Strutils::trim(arg));
+            Strutils::to_lower(a);
+            auto &admission = execution::MemoryAdmission::instance();
+
+            if (a == "on" || a == "off") {
+                admission.setEnabled(a == "on");
+            } else if (!a.empty() && a != "status") {
+                std::cerr << "Usage: #admission on|off|status\n";
+                return true;
+            }
+
+            constexpr double kMiB = 1024.0 * 1024.0;
+            const auto stats = admission.stats();
+            std::cout << std::format(
+                "Memory admission: {}\n"
+                "  available: {:.0f} MiB, reserved by running jobs: {:.0f} "
+                "MiB, headroom: {:.0f} MiB\n"
+                "  running: {}, queued: {}, admitted: {} ({} delayed)\n",
+                stats.enabled ? "on" : "off",
+                static_cast<double>(stats.available) / kMiB,
+                static_cast<double>(stats.reserved) / kMiB,
+                static_cast<double>(stats.headroom) / kMiB, stats.running,
+                stats.queued, stats.admitted, stats.delayed);
+
+            for (size_t i = 0; i < execution::kJobKindCount; ++i) {
+                std::cout << std::format(
+                    "  {:<9} estimate {:.0f} MiB, peak {:.0f} MiB ({} "
+                    "samples)\n",
+                    execution::jobKindName(static_cast<execution::JobKind>(i)),
+                    static_cast<double>(stats.estimate[i]) / kMiB,
+                    static_cast<double>(stats.peak[i]) / kMiB,
+                    stats.samples[i]);
+            }
+            return true;
+        });
+    // Compilação especulativa da linha durante pausas na digitação
+    commands::registry().registerPrefix(
+        "#speculate", "Speculative compile while typing: on|off|status",
+        [](std::string_view arg, commands::CommandContextBase &) {
+            std::string a(Strutils::trim(arg));
+            Strutils::to_lower(a);
+            auto &speculative = execution::SpeculativeCompiler::instance();
+
+            if (a == "on" || a == "off") {
+                speculative.setEnabled(a == "on");
+            } else if (!a.empty() && a != "status") {
+                std::cerr << "Usage: #speculate on|off|status\n";
+                return true;
+            }
+
+            const auto stats = speculative.stats();
+            const size_t claims = stats.hits + stats.misses;
+            std::cout << std::format(
+                "Speculative compile: {}\n"
+                "  started: {}, hits: {}, misses: {} ({:.0f}% hit rate)\n"
+                "  cancelled while typing: {}, failed builds: {}{}\n",
+                stats.enabled ? "on" : "off", stats.started, stats.hits,
+                stats.misses,
+                claims ? 100.0 * static_cast<double>(stats.hits) /
+                             static_cast<double>(claims)
+                       : 0.0,
+                stats.cancelled, stats.failed,
+                stats.running ? ", one running" : "");
+            return true;
+        });
+
+    // Scripts e colagens em lotes: um TU por sequência de blocos
+    commands::registry().registerPrefix(
+        "#batchmode", "Batch script/paste blocks into one unit: on|off|status",
+        [](std::string_view arg, commands::CommandContextBase &) {
+            std::string a(Strutils::trim(arg));
+            Strutils::to_lower(a);
+
+            if (a == "on" || a == "off") {
+                set_batch_mode(a == "on");
+            } else if (!a.empty() && a != "status") {
+                std::cerr << "Usage: #batchmode on|off|status\n";
+                return true;
+            }
+
+            std::cout << std::format("Batch mode: {}\n",
+                                     batch_mode_enabled() ? "on" : "off");
+            return true;
+        });
+
+    // Declarações só de tipo validadas com -fsyntax-only, sem codegen
+    commands::registry().registerPrefix(
+        "#declfast", "Declaration-only fast path: on|off|status",
+        [](std::string_view arg, commands::CommandContextBase &base) {
+            auto &ctx =
+                static_cast<commands::BasicContext<ReplCtxView> &>(base).data;
+            if (!ctx.replStatePtr) {
+                return false;
+            }
+
+            std::string a(Strutils::trim(arg));
+            Strutils::to_lower(a);
+
+            if (a == "on" || a == "off") {
+                ctx.replStatePtr->declarationFastPath = a == "on";
+            } else if (!a.empty() && a != "status") {
+                std::cerr << "Usage: #declfast on|off|status\n";
+                return true;
+            }
+
+            std::cout << std::format(
+                "Declaration fast path: {}\n",
+                ctx.replStatePtr->declarationFastPath ? "on" : "off");
+            return true;
+        });
+
+    // Grafo de dependências: quem declara e quem cita cada nome
+    commands::registry().registerPrefix(
+        "#deps", "Snippet dependencies: #deps [name]",
+        [](std::string_view arg, commands::CommandContextBase &) {
+            const std::string name(Strutils::trim(arg));
+            const auto graph = analysis::AstContext::snippetGraph();
+
+            auto join = [](const auto &names) {
+                std::string out;
+                for (const auto &n : names) {
+                    out += out.empty() ? n : ", " + n;
+                }
+                return out.empty() ? std::string("-") : out;
+            };
+
+            if (name.empty()) {
+                if (graph.empty()) {
+                    std::cout << "No analyzed snippets\n";
+                }
+                for (const auto &node : graph.nodes()) {
+                    std::cout << std::format(
+                        "  {}: declares {}; depends on {}\n", node.unit,
+                        join(node.provides), join(node.dependsOn));
+                }
+                return true;
+            }
+
+            const auto providers = graph.providersOf(name);
+            if (providers.empty()) {
+                std::cout << std::format("{} is not declared by any snippet\n",
+                                         name);
+                return true;
+            }
+            std::cout << std::format(
+                "{} declared by: {}\n"
+                "Built against an older definition: {}\n",
+                name, join(providers), join(graph.affectedBy(name)));
+            return true;
+        });
 }
 
 inline bool handleReplCommand(std::string_view line, ReplCtxView view) {
@@ -0,0 +1,193 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Forward declarations
+struct VarDecl;
+
+namespace analysis {
+struct CodeTracking;
+} // namespace analysis
+
+namespace compiler {
+
+/**
+ * @brief Hash de 128 bits (FNV-1a) usado para endereçar artefatos
+ *
+ * Estável entre processos e versões do cpprepl, ao contrário de std::hash.
+ * Cada campo é prefixado pelo rótulo e pelo tamanho para que concatenações
+ * diferentes não colidam ("ab"+"c" != "a"+"bc").
+ */
+class ArtifactHasher {
+  public:
+    ArtifactHasher &update(std::string_view data);
+    ArtifactHasher &field(std::string_view label, std::string_view data);
+
+    /**
+     * @brief Conteúdo de um arquivo (ou um marcador se não existir)
+     */
+    ArtifactHasher &file(std::string_view label,
+                         const std::filesystem::path &path);
+
+    std::string hex() const;
+
+  private:
+    unsigned __int128 state_ =
+        (static_cast<unsigned __int128>(0x6c62272e07bb0142ULL) << 64) |
+        0x62b821756295c58dULL;
+};
+
+/**
+ * @brief Dependências de uma regra de make (saída do -MMD): "alvo: dep dep \"
+ */
+std::vector<std::string> parseDepFile(std::string_view text);
+
+/**
+ * @brief Lista gravada ao lado de uma entrada: "<hash> <caminho>" por linha,
+ * com o hash do conteúdo atual de cada arquivo
+ */
+std::string formatDependencies(const std::vector<std::string> &paths);
+
+/**
+ * @brief Confere uma lista de formatDependencies() com o disco
+ * @return std::nullopt se nenhum arquivo mudou; senão, todos os caminhos da
+ * lista
+ */
+std::optional<std::vector<std::string>>
+changedDependencies(std::string_view list);
+
+/**
+ * @brief Chave derivada de @p key para o conteúdo atual de @p paths
+ *
+ * Uma entrada cujas dependências mudaram continua valendo para o conteúdo
+ * antigo; a versão nova vai para esta variante em vez de sobrescrevê-la.
+ */
+std::string dependencyVariant(const std::string &key,
+                              const std::vector<std::string> &paths);
+
+/**
+ * @brief Cache em disco de bibliotecas compiladas, compartilhado entre sessões
+ *
+ * Cada entrada é um diretório imutável em <root>/objects/<aa>/<chave>/ com a
+ * biblioteca gerada, as VarDecl extraídas da AST e os registros que a análise
+ * acrescentou ao decl_amalgama.hpp. Assim um acerto evita tanto a compilação
+ * quanto o dump da AST. Falhas de compilação também são guardadas (só os
+ * diagnósticos), para que o mesmo erro seja reexibido sem chamar o clang.
+ *
+ * Publicação: a entrada é montada em <root>/tmp/ e movida com rename(2) para
+ * o destino final, então vários REPLs podem ler e escrever ao mesmo tempo sem
+ * nunca ver uma entrada pela metade. Quem perde a corrida descarta a sua cópia.
+ *
+ * Headers incluídos pelo fonte não entram na chave: a entrada guarda a lista
+ * do -MMD com o hash de cada um, e lookup() segue para a variante do conteúdo
+ * atual quando algum mudou (o mesmo esquema do PchStore).
+ *
+ * Despejo: LRU pela data de modificação do arquivo meta (atualizada em cada
+ * acerto), disparado quando o uso em disco passa de maxBytes.
+ */
+class ArtifactCache {
+  public:
+    struct Entry {
+        bool success = false;
+        std::string sourceName; // fonte que originou a entrada (repl_N.cpp)
+        std::string diagnostics;
+        std::vector<VarDecl> variables;
+        std::vector<analysis::CodeTracking> snippets;
+        // Nomes que a análise registrou no grafo de dependências (variáveis,
+        // funções e tipos)
+        std::vector<std::string> provides;
+        // Headers lidos pelo compile (-MMD) que não estão na chave
+        std::vector<std::string> dependencies;
+    };
+
+    struct Stats {
+        uint64_t hits = 0;
+        uint64_t failureHits = 0;
+        uint64_t misses = 0;
+        uint64_t stores = 0;
+        uint64_t evictions = 0;
+    };
+
+    explicit ArtifactCache(std::filesystem::path root,
+                           uint64_t maxBytes = defaultMaxBytes());
+    ~ArtifactCache();
+
+    ArtifactCache(const ArtifactCache &) = delete;
+    ArtifactCache &operator=(const ArtifactCache &) = delete;
+
+    /**
+     * @brief $CPPREPL_CACHE_DIR, $XDG_CACHE_HOME/cpprepl ou ~/.cache/cpprepl
+     */
+    static std::filesystem::path defaultRoot();
+
+    /**
+     * @brief $CPPREPL_CACHE_MAX_MB (padrão: 512 MiB)
+     */
+    static uint64_t defaultMaxBytes();
+
+    /**
+     * @brief Procura uma entrada cujas dependências não mudaram
+     * @param key Chave (ArtifactHasher::hex())
+     * @param libraryOut Onde copiar a biblioteca em caso de acerto com sucesso
+     * @param missKey Recebe a chave onde publicar em caso de falta (a própria
+     * @p key ou uma variante dela)
+     * @return Entrada encontrada; std::nullopt em caso de falta ou de entrada
+     * ilegível (tratada como falta)
+     */
+    std::optional<Entry> lookup(const std::string &key,
+                                const std::filesystem::path &libraryOut,
+                                std::string *missKey = nullptr);
+
+    /**
+     * @brief Publica uma entrada
+     * @param library Biblioteca gerada (ignorada se !entry.success)
+     * @return true se a entrada está disponível no cache ao final
+     */
+    bool store(const std::string &key, const Entry &entry,
+               const std::filesystem::path &library);
+
+    /**
+     * @brief Remove entradas menos usadas até o uso ficar abaixo do limite
+     * @return Número de entradas removidas
+     */
+    size_t evictToLimit();
+
+    /**
+     * @brief Remove todas as entradas
+     */
+    void clear();
+
+    uint64_t diskUsage() const;
+    uint64_t maxBytes() const { return maxBytes_; }
+    Stats stats() const;
+    const std::filesystem::path &root() const { return root_; }
+
+  private:
+    std::filesystem::path entryDir(const std::string &key) const;
+    std::filesystem::path makeTempDir();
+    void discard(const std::filesystem::path &dir);
+
+    std::filesystem::path root_;
+    uint64_t maxBytes_;
+
+    // Uso aproximado: recalculado do disco na primeira escrita e a cada
+    // despejo, somado localmente entre um e outro
+    mutable std::mutex usageMutex_;
+    std::optional<uint64_t> approxUsage_;
+
+    std::atomic<uint64_t> hits_{0};
+    std::atomic<uint64_t> failureHits_{0};
+    std::atomic<uint64_t> misses_{0};
+    std::atomic<uint64_t> stores_{0};
+    std::atomic<uint64_t> evictions_{0};
+    std::atomic<uint64_t> tempCounter_{0};
+};
+
+} // namespace compiler
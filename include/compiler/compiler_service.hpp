@@ -1,8 +1,15 @@
 #pragma once
 
+#include "analysis/declaration_store.hpp"
+#include "compiler/pch_layers.hpp"
+#include "execution/cancellation.hpp"
+#include "execution/memory_admission.hpp"
+#include <filesystem>
 #include <functional>
+#include <future>
 #include <memory>
 #include <string>
+#include <string_view>
 #include <thread>
 #include <vector>
 
@@ -14,10 +21,15 @@ struct ReplState;
 namespace analysis {
 class AstContext;
 class ClangAstAnalyzerAdapter;
+struct CodeTracking;
 } // namespace analysis
 
 namespace compiler {
 
+class InProcessClangBackend;
+class ArtifactCache;
+class PchStore;
+
 /**
  * @brief Errors that can occur during compilation operations
  */
@@ -28,7 +40,8 @@ enum class CompilerError {
     LinkingFailed,
     PrecompiledHeaderFailed,
     FileWriteFailed,
-    SystemCommandFailed
+    SystemCommandFailed,
+    Cancelled // Ctrl-C ou falha de um job irmão
 };
 
 /**
@@ -64,6 +77,14 @@ struct CompilationResult {
     bool success() const { return returnCode == 0; }
 };
 
+/**
+ * @brief How the frontend is invoked for compile/PCH jobs
+ */
+enum class CompilerBackend {
+    External, // spawn clang++ for every job (default)
+    InProcess // drive clang::CompilerInstance inside the REPL process
+};
+
 /**
  * @brief Service responsible for all compilation operations in the REPL
  *
@@ -91,8 +112,36 @@ class CompilerService {
     VarMergeCallback varMergeCallback_;
 
     // Configuration for parallel processing
-    mutable size_t maxThreads_ =
-        0; // 0 = auto-detect based on hardware_concurrency
+    mutable size_t maxThreads_ = 0; // 0 = concorrência do TaskScheduler
+
+    // Frontend backend selection (in-process requires Clang libraries)
+    CompilerBackend backend_ = CompilerBackend::External;
+    std::shared_ptr<InProcessClangBackend> inProcess_;
+
+    // Cache de artefatos entre sessões (nullptr = desativado)
+    std::shared_ptr<ArtifactCache> artifactCache_;
+
+    // Camadas de PCH encadeadas (precompiledheader_layerN.hpp.pch)
+    std::shared_ptr<PchLayerStack> pchLayers_;
+
+    // PCHs persistentes entre sessões (nullptr = gerar no diretório atual)
+    std::shared_ptr<PchStore> pchStore_;
+
+    // Declarações da sessão dobradas no PCH a partir deste tamanho do
+    // decl_amalgama.hpp (CPPREPL_DECL_FOLD_BYTES; 0 = desligado)
+    mutable size_t declFoldBytes_ = 64 * 1024;
+
+    // Camada de declarações gerada em segundo plano, à espera da adoção
+    struct DeclarationFold {
+        PchLayerStack::Plan plan;
+        analysis::DeclarationStore::Fold fold;
+        bool built = false;
+    };
+
+    // Jobs em segundo plano (últimos membros: o destrutor espera os jobs
+    // antes de destruir o resto)
+    mutable std::future<DeclarationFold> declFold_;
+    mutable std::future<void> pchFlatten_;
 
   public:
     /**
@@ -126,11 +175,48 @@ class CompilerService {
                                          std::string_view extra_args = {},
                                          std::string_view pchFile = {}) const;
 
+    /**
+     * @brief Semantic check of a source against the current PCH, no codegen
+     *
+     * Used by the declaration fast path: snippets that only declare types,
+     * aliases or templates are validated with -fsyntax-only and go straight
+     * to decl_amalgama.hpp, skipping the object, the link and dlopen.
+     *
+     * @param compiler Compiler command
+     * @param name Source name (without extension)
+     * @param ext Source file extension
+     * @param std C++ standard
+     * @return CompilerResult<int> - 0 when the source is well-formed
+     */
+    CompilerResult<int> checkSyntax(const std::string &compiler,
+                                    const std::string &name,
+                                    const std::string &ext = ".cpp",
+                                    const std::string &std = "gnu++20") const;
+
+    /**
+     * @brief Same build as buildLibraryOnly(), for the speculative compiler
+     *
+     * Runs off the main thread while the user is still typing: compiler
+     * output is captured and dropped, and the jobs follow @p cancel instead
+     * of the current eval's token.
+     *
+     * @param compiler Compiler command
+     * @param name Library name (source is name.cpp)
+     * @param cancel Kills the compiler and linker when cancelled
+     * @return CompilerResult<int> - 0 when lib<name>.so is ready
+     */
+    CompilerResult<int>
+    buildLibraryInBackground(const std::string &compiler,
+                             const std::string &name,
+                             const execution::CancellationToken &cancel) const;
+
     /**
      * @brief Build library with full AST analysis and variable extraction
      *
      * Equivalent to the original buildLibAndDumpAST() function.
-     * This is the most complete build operation.
+     * This is the most complete build operation. With the in-process backend
+     * a single frontend run emits both the object and the AST; otherwise the
+     * library build and the AST dump run concurrently.
      *
      * @param compiler Compiler command
      * @param name Library name
@@ -157,6 +243,19 @@ class CompilerService {
         const std::string &compiler = "clang++",
         std::shared_ptr<analysis::AstContext> context = nullptr) const;
 
+    /**
+     * @brief Move declarações estáveis do decl_amalgama.hpp para o PCH
+     *
+     * Chamado pelo REPL no começo de cada eval, quando nenhuma compilação
+     * está em andamento: adota a camada que ficou pronta (índice do PCH e
+     * decl_amalgama.hpp trocam juntos) e, se o header passou do limite,
+     * começa a gerar a próxima em segundo plano. Assim cada snippet só
+     * reprocessa textualmente as declarações recentes.
+     *
+     * @return true se uma camada foi adotada nesta chamada
+     */
+    bool foldSessionDeclarations(const std::string &compiler = "clang++") const;
+
     CompilerResult<void> buildCustomPCH(
         const std::string &compiler, const std::string &header,
         const std::string &outputPchFile,
@@ -226,37 +325,150 @@ class CompilerService {
 
     /**
      * @brief Set maximum number of threads for parallel operations
-     * @param maxThreads Maximum threads (0 = auto-detect from
-     * hardware_concurrency)
+     * @param maxThreads Maximum threads (0 = the shared task scheduler's
+     * concurrency, see #jobs)
      */
     void setMaxThreads(size_t maxThreads) const { maxThreads_ = maxThreads; }
 
     /**
      * @brief Get effective number of threads for parallel operations
-     * @return Number of threads that will be used
-     */
-    size_t getEffectiveThreadCount() const {
-        if (maxThreads_ == 0) {
-            auto hwThreads = std::thread::hardware_concurrency();
-            return hwThreads > 0 ? hwThreads : 4; // fallback to 4 threads
-        }
-        return maxThreads_;
+     * @return maxThreads, or the shared task scheduler's concurrency when 0
+     */
+    size_t getEffectiveThreadCount() const;
+
+    // === Backend Configuration ===
+
+    /**
+     * @brief Select the frontend backend
+     * @param backend Desired backend
+     * @return false if InProcess was requested but is not available in this
+     * build (the service keeps using External)
+     */
+    bool setBackend(CompilerBackend backend);
+
+    CompilerBackend backend() const { return backend_; }
+
+    /**
+     * @brief true when compile jobs are served by the in-process frontend
+     */
+    bool usingInProcessBackend() const;
+
+    // === Artifact Cache ===
+
+    /**
+     * @brief Attach (or detach with nullptr) the on-disk artifact cache
+     *
+     * Only single-source builds with AST analysis (the REPL eval path) are
+     * cached.
+     */
+    void setArtifactCache(std::shared_ptr<ArtifactCache> cache) {
+        artifactCache_ = std::move(cache);
+    }
+
+    std::shared_ptr<ArtifactCache> artifactCache() const {
+        return artifactCache_;
+    }
+
+    // === PCH Store ===
+
+    /**
+     * @brief Attach (or detach with nullptr) the persistent PCH store
+     *
+     * With a store, PCH layers and custom PCHs are looked up by content key
+     * before compiling, so returning to a known include set is instant.
+     */
+    void setPchStore(std::shared_ptr<PchStore> store) {
+        pchStore_ = std::move(store);
     }
 
+    std::shared_ptr<PchStore> pchStore() const { return pchStore_; }
+
+    /**
+     * @brief Content key for compiling @p source with the current state
+     *
+     * Hashes the source text, decl_amalgama.hpp as currently held by
+     * AstContext, the PCH inputs, the compiler identity, the standard and
+     * every BuildSettings flag. Headers the source includes are not part of
+     * the key: ArtifactCache checks each entry's -MMD list instead.
+     */
+    std::string artifactKey(const std::string &compiler,
+                            const std::string &std,
+                            const std::string &source) const;
+
+    /**
+     * @brief artifactKey() for a source that only exists in memory
+     */
+    std::string artifactKeyForText(const std::string &compiler,
+                                   const std::string &std,
+                                   std::string_view text) const;
+
     static bool checkIncludeExists(const BuildSettings &settings,
                                    const std::string &includePath);
 
     const BuildSettings *buildSettings() const { return buildSettings_; }
 
+    /**
+     * @brief Flags -include-pch/-include para o PCH atual
+     *
+     * Sem nenhuma camada gerada, só o -include textual do índice.
+     */
+    std::string pchIncludeFlags() const;
+
   private:
     // === Internal Helper Methods ===
 
     /**
      * @brief Generate include precompiled header flag based on file extension
      * @param ext File extension
+     * @param std Standard of the compile; the PCH layers are gnu++20 only
      * @return Include flag string (empty for .c files)
      */
-    std::string getPrecompiledHeaderFlag(const std::string &ext) const;
+    std::string getPrecompiledHeaderFlag(const std::string &ext,
+                                         const std::string &std = "gnu++20")
+        const;
+
+    /**
+     * @brief PCH a usar nas compilações (topo da pilha de camadas)
+     * @return precompiledheader.hpp.pch enquanto nenhuma camada foi gerada
+     */
+    std::string currentPchPath() const;
+
+    /**
+     * @brief Escreve o .hpp de uma camada e gera o .pch (encadeado no pai)
+     *
+     * Com PchStore, procura a camada pela chave antes e grava plan.layer.dir.
+     */
+    CompilerResult<void> buildPchLayer(const std::string &compiler,
+                                       PchLayerStack::Plan &plan) const;
+
+    /**
+     * @brief Generate one PCH (optionally chained on @p parentPch)
+     * @param stored Built for the PchStore (-fno-pch-timestamp)
+     * @param depFile When set, receives the -MMD user header list
+     */
+    CompilerResult<void> compilePch(const std::string &compiler,
+                                    const std::string &header,
+                                    const std::string &outputPch,
+                                    const std::string &parentPch, bool stored,
+                                    const std::string &depFile = {}) const;
+
+    /**
+     * @brief PchStore key: header text, compiler identity, -std, -D/-I flags,
+     * parent PCH and the contents of @p inputs
+     */
+    std::string pchKey(const std::string &compiler, std::string_view headerPath,
+                       std::string_view headerText, std::string_view parentPch,
+                       const std::vector<std::string> &inputs) const;
+
+    /**
+     * @brief Regrava precompiledheader.hpp e remove camadas aposentadas
+     */
+    bool publishPchLayers() const;
+
+    /**
+     * @brief Reconstrói a pilha como uma camada única (job em segundo plano)
+     */
+    void flattenPchLayers(const std::string &compiler) const;
 
     /**
      * @brief Build command string for compilation
@@ -276,9 +488,51 @@ class CompilerService {
     /**
      * @brief Execute system command and return result
      * @param command Command to execute
+     * @param kind Job type for memory admission (compile, link, ...)
+     * @param cancel Kills the process when cancelled (default: the current
+     * eval's build)
      * @return CompilerResult<int> - Return code or error
      */
-    CompilerResult<int> executeCommand(const std::string &command) const;
+    CompilerResult<int> executeCommand(
+        const std::string &command,
+        execution::JobKind kind = execution::JobKind::Compile,
+        const execution::CancellationToken &cancel =
+            execution::currentEvalToken()) const;
+
+    /**
+     * @brief Compile one source to an object with the in-process frontend
+     * @param compiler Compiler name (driver argv[0])
+     * @param std Language standard
+     * @param flags Extra flags (whitespace separated)
+     * @param inputFile Source file
+     * @param outputObject Object file to write; empty runs -fsyntax-only
+     * @param logPath Where diagnostics are written (same as the external
+     * path's .log files); empty prints them to stderr
+     * @param astJson When non-null, also receives the -ast-dump=json output
+     * produced by the same frontend run
+     * @param declRecords When non-null (and astJson is null), receives the
+     * cpprepl-decls records instead of the JSON dump
+     * @param declHeader decl_amalgama.hpp served to the frontend; null takes
+     * a snapshot of AstContext now
+     * @return CompilerResult<int> - 0 on success
+     */
+    CompilerResult<int> compileObjectInProcess(
+        const std::string &compiler, const std::string &std,
+        const std::string &flags, const std::string &inputFile,
+        const std::string &outputObject, const std::string &logPath = {},
+        std::string *astJson = nullptr, std::string *declRecords = nullptr,
+        const std::string *declHeader = nullptr) const;
+
+    /**
+     * @brief Re-add the decl_amalgama records of a cached build to AstContext
+     * @param snippets Records captured when the entry was built
+     * @param cachedSource Source name the records refer to
+     * @param source Source name of the current evaluation
+     */
+    static void
+    replayCachedSnippets(const std::vector<analysis::CodeTracking> &snippets,
+                         const std::string &cachedSource,
+                         const std::string &source);
 
     /**
      * @brief Concatenate filenames with spaces for linking
@@ -294,6 +548,29 @@ class CompilerService {
     std::string getIncludeDirectoriesStr() const;
     std::string getPreprocessorDefinitionsStr() const;
 
+    /**
+     * @brief Caminhos dos artefatos (memfd no modo diskless, ou workspace da
+     * sessão)
+     *
+     * sourcePath() devolve o caminho físico de um fonte gerado (ou o próprio
+     * nome); outputPath() reserva um caminho novo para a saída.
+     */
+    std::string sourcePath(const std::string &name) const;
+    std::string outputPath(const std::string &name, bool library) const;
+
+    /**
+     * @brief Flags extras para compilar/linkar com fonte e saída fora do
+     * diretório atual
+     */
+    std::string artifactCompileFlags() const;
+    std::string disklessLinkFlags() const;
+
+    /**
+     * @brief Grava o .log de diagnósticos como artefato do eval
+     */
+    void writeLogFile(const std::string &logPath,
+                      std::string_view content) const;
+
     /**
      * @brief Read contents of a log file
      * @param logPath Path to the log file
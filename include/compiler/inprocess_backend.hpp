@@ -0,0 +1,125 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace compiler {
+
+/**
+ * @brief Backend de compilação que roda o frontend do Clang dentro do processo
+ *
+ * Em vez de lançar um novo clang++ para cada snippet (fork/exec + releitura
+ * do PCH do disco), este backend monta um clang::CompilerInstance a partir
+ * dos mesmos argumentos do driver e emite o objeto diretamente. O cache de
+ * módulos em memória (onde o ASTReader guarda o buffer do PCH) é mantido entre
+ * avaliações e só é descartado quando o PCH é reconstruído.
+ *
+ * Só está disponível quando o projeto é compilado com as bibliotecas do Clang
+ * (CLANG_COMPLETION_ENABLED); caso contrário isAvailable() retorna false e o
+ * CompilerService continua usando processos externos.
+ */
+class InProcessClangBackend {
+  public:
+    /**
+     * @brief Resultado de uma invocação do frontend
+     */
+    struct Result {
+        int returnCode = -1;
+        std::string diagnostics;
+
+        bool success() const { return returnCode == 0; }
+    };
+
+    /**
+     * @brief Arquivo servido a partir da memória em vez do disco
+     */
+    struct RemappedFile {
+        std::string path;
+        std::string contents;
+    };
+
+    InProcessClangBackend();
+    ~InProcessClangBackend();
+
+    InProcessClangBackend(const InProcessClangBackend &) = delete;
+    InProcessClangBackend &operator=(const InProcessClangBackend &) = delete;
+
+    /**
+     * @brief Indica se o binário foi compilado com suporte ao frontend Clang
+     */
+    static bool isAvailable();
+
+    /**
+     * @brief Compila um TU para objeto (equivalente a clang++ -c)
+     *
+     * @param args Argumentos no formato do driver, começando pelo nome do
+     * compilador (ex.: {"clang++", "-std=gnu++20", "-c", "a.cpp", "-o",
+     * "a.o"})
+     * @param remapped Arquivos cujo conteúdo deve vir da memória (ex.:
+     * decl_amalgama.hpp já mantido pelo AstContext)
+     * @return Código de retorno e diagnósticos capturados
+     */
+    Result compileToObject(const std::vector<std::string> &args,
+                           const std::vector<RemappedFile> &remapped = {});
+
+    /**
+     * @brief Compila para objeto e emite o dump JSON da AST no mesmo parse
+     *
+     * Substitui a dupla "clang++ -c" + "clang++ -Xclang -ast-dump=json
+     * -fsyntax-only": um único frontend gera o objeto e o JSON que o
+     * ContextualAstAnalyzer consome.
+     *
+     * @param astJson Recebe o JSON (mesmo formato de -ast-dump=json)
+     */
+    Result compileToObjectWithAst(const std::vector<std::string> &args,
+                                  std::string &astJson,
+                                  const std::vector<RemappedFile> &remapped = {});
+
+    /**
+     * @brief Compila para objeto e exporta as declarações no mesmo parse
+     *
+     * Variante enxuta de compileToObjectWithAst: em vez do JSON completo,
+     * gera os registros de analysis/decl_export.hpp.
+     *
+     * @param declRecords Recebe os registros (mesmo formato do plugin)
+     */
+    Result compileToObjectWithDecls(
+        const std::vector<std::string> &args, std::string &declRecords,
+        const std::vector<RemappedFile> &remapped = {});
+
+    /**
+     * @brief Gera um PCH (equivalente a clang++ -x c++-header ... -o x.pch)
+     *
+     * Invalida o cache de PCH em memória após a geração.
+     */
+    Result generatePch(const std::vector<std::string> &args);
+
+    /**
+     * @brief Só análise semântica, sem codegen (equivalente a -fsyntax-only)
+     *
+     * Usado pelo caminho rápido de declarações: valida o snippet contra o PCH
+     * e o decl_amalgama.hpp atuais sem emitir objeto.
+     */
+    Result checkSyntax(const std::vector<std::string> &args,
+                       const std::vector<RemappedFile> &remapped = {});
+
+    /**
+     * @brief Descarta os buffers de PCH mantidos em memória
+     *
+     * Deve ser chamado sempre que um PCH for reconstruído por fora.
+     */
+    void invalidatePchCache();
+
+    /**
+     * @brief Número de compilações atendidas pelo backend
+     */
+    uint64_t compilationCount() const;
+
+  private:
+    struct Impl;
+    std::unique_ptr<Impl> impl_;
+};
+
+} // namespace compiler
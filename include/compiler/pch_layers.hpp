@@ -0,0 +1,153 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace compiler {
+
+/**
+ * @brief Pilha de PCHs encadeados (precompiledheader_layerN.hpp.pch)
+ *
+ * Em vez de regenerar o PCH inteiro a cada #include novo, cada camada contém
+ * só os includes que ainda não estavam pré-compilados e é gerada com
+ * -include-pch da camada anterior. O custo de um include novo passa a ser o
+ * parse daquele header.
+ *
+ * precompiledheader.hpp vira um índice que inclui as camadas em ordem (todas
+ * com #pragma once, então com o PCH do topo nada é reprocessado). Quando a
+ * pilha passa de maxLayers, o CompilerService reconstrói uma camada única em
+ * segundo plano e a troca aqui se nada foi empilhado nesse meio tempo.
+ *
+ * Uma camada também pode carregar declarações da sessão tiradas do
+ * decl_amalgama.hpp (planDeclarations). Achatamentos e reconstruções levam
+ * essas declarações adiante, depois de todos os includes.
+ *
+ * A classe só decide nomes e conteúdo; quem compila é o CompilerService.
+ * Thread-safe.
+ */
+class PchLayerStack {
+  public:
+    using Include = std::pair<std::string, bool>; // caminho, include <...>
+
+    struct Layer {
+        uint64_t id = 0;
+        bool base = false; // camada base carrega o preâmbulo
+        std::vector<Include> includes;
+        std::string declarations; // dobradas do decl_amalgama.hpp
+        std::string dir; // entrada do PchStore; vazio = diretório de trabalho
+
+        std::string header() const;
+        std::string pch() const;
+
+        /**
+         * @brief Arquivos pertencem ao PchStore (não apagar ao aposentar)
+         */
+        bool stored() const { return !dir.empty(); }
+    };
+
+    struct Plan {
+        enum class Kind {
+            UpToDate, // nada novo para pré-compilar
+            Append,   // nova camada sobre o PCH do topo
+            Rebuild   // includes não são extensão da pilha: camada base nova
+        };
+
+        Kind kind = Kind::UpToDate;
+        Layer layer;
+        std::string parentPch; // vazio para camadas base
+        uint64_t baseTopId = 0; // topo quando o plano foi feito (0 = vazia)
+    };
+
+    static constexpr std::string_view kIndexHeader = "precompiledheader.hpp";
+
+    explicit PchLayerStack(std::string preamble, size_t maxLayers = 4);
+
+    /**
+     * @brief Decide o que gerar para chegar a @p includes (ordem de inserção)
+     */
+    Plan plan(const std::vector<Include> &includes);
+
+    /**
+     * @brief Plano de achatamento: uma camada base com todos os includes
+     */
+    Plan planFlatten();
+
+    /**
+     * @brief Plano de uma camada só com @p declarations sobre o topo
+     * @return UpToDate se a pilha está vazia ou não há declarações
+     */
+    Plan planDeclarations(std::string declarations);
+
+    /**
+     * @brief Registra uma camada gerada com sucesso
+     * @return false se a pilha mudou desde o plano (camada descartada)
+     */
+    bool commit(const Plan &plan);
+
+    /**
+     * @brief Conteúdo do arquivo .hpp de uma camada
+     */
+    std::string layerSource(const Layer &layer) const;
+
+    /**
+     * @brief Conteúdo de precompiledheader.hpp (inclui as camadas em ordem)
+     */
+    std::string indexSource() const;
+
+    /**
+     * @brief Texto equivalente à pilha achatada (independe da história)
+     *
+     * Usado na chave do cache de artefatos, que não deve mudar só porque a
+     * sessão empilhou as camadas em outra ordem de tempo.
+     */
+    std::string combinedSource() const;
+
+    /**
+     * @brief PCH do topo da pilha (vazio se nenhuma camada foi gerada)
+     */
+    std::string topPch() const;
+
+    /**
+     * @brief Id da camada do topo (0 = vazia), comparável a Plan::baseTopId
+     */
+    uint64_t topId() const;
+
+    size_t depth() const;
+
+    /**
+     * @brief Tamanho das declarações da sessão já pré-compiladas
+     */
+    size_t declarationBytes() const;
+
+    bool needsFlatten() const;
+
+    /**
+     * @brief Camadas substituídas que já podem ser apagadas do disco
+     *
+     * As camadas trocadas num commit ficam reservadas até o commit seguinte,
+     * para não remover um PCH que uma compilação em andamento ainda vai abrir.
+     */
+    std::vector<Layer> takeRetired();
+
+    /**
+     * @brief Serializa plano -> geração -> commit entre chamadores
+     */
+    std::mutex &buildMutex() { return buildMutex_; }
+
+  private:
+    mutable std::mutex mutex_;
+    std::mutex buildMutex_;
+    std::string preamble_;
+    size_t maxLayers_;
+    uint64_t nextId_ = 1;
+    std::vector<Layer> layers_;
+    std::vector<Layer> retiring_; // substituídas no último commit
+    std::vector<Layer> retired_;  // liberadas para remoção
+};
+
+} // namespace compiler
@@ -0,0 +1,138 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace compiler {
+
+/**
+ * @brief Repositório persistente de PCHs endereçado por conteúdo
+ *
+ * Cada PCH gerado pelo REPL (camadas do precompiledheader.hpp e PCHs
+ * avulsos como printerOutput.hpp.pch) vive em <root>/<família>/<chave>/,
+ * onde a chave cobre o texto do header, a identidade do compilador, o -std e
+ * as flags de pré-processador/include. Voltar a um conjunto de includes já
+ * visto, nesta ou em outra sessão, reaproveita o PCH sem compilar nada.
+ *
+ * A família separa modos de linguagem (gnu++20, c, cpp2...) para que o
+ * despejo e a listagem de um modo não interfiram nos outros.
+ *
+ * Os PCHs são gerados com -fno-pch-timestamp: o header de entrada é regravado
+ * com conteúdo idêntico por quem perder uma corrida, e o clang só compara o
+ * tamanho. O .pch é publicado por último (rename), então uma entrada só é
+ * considerada válida quando ele existe.
+ *
+ * Headers do usuário incluídos indiretamente não estão na chave: a entrada
+ * guarda em deps a lista do -MMD com o hash de cada um. Se algum mudou, a
+ * entrada vale para o conteúdo antigo e a chave segue para uma variante
+ * derivada do conteúdo atual, sem sobrescrever o PCH de outra sessão.
+ */
+class PchStore {
+  public:
+    struct Stats {
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        uint64_t evictions = 0;
+    };
+
+    explicit PchStore(std::filesystem::path root,
+                      uint64_t maxBytes = defaultMaxBytes());
+
+    PchStore(const PchStore &) = delete;
+    PchStore &operator=(const PchStore &) = delete;
+
+    /**
+     * @brief <raiz do cache de artefatos>/pch
+     */
+    static std::filesystem::path defaultRoot();
+
+    /**
+     * @brief $CPPREPL_PCH_STORE_MAX_MB (padrão: 2048 MiB)
+     */
+    static uint64_t defaultMaxBytes();
+
+    /**
+     * @brief Procura uma entrada completa cujas dependências não mudaram
+     * @param pchName Nome do .pch dentro da entrada (marcador de conclusão)
+     * @param missKey Recebe a chave onde gerar o PCH em caso de falta (a
+     * própria @p key ou uma variante dela)
+     * @return Diretório da entrada, ou vazio se não existir
+     */
+    std::filesystem::path lookup(std::string_view family,
+                                 const std::string &key,
+                                 std::string_view pchName,
+                                 std::string *missKey = nullptr);
+
+    /**
+     * @brief Cria (se preciso) o diretório de uma entrada a ser gerada
+     * @return Diretório da entrada, ou vazio em caso de erro
+     */
+    std::filesystem::path prepare(std::string_view family,
+                                  const std::string &key);
+
+    /**
+     * @brief Grava um arquivo da entrada com rename(2) (conteúdo completo ou
+     * nada)
+     */
+    static bool writeFile(const std::filesystem::path &path,
+                          std::string_view contents);
+
+    /**
+     * @brief Nome temporário para o compilador gerar @p finalPath
+     */
+    std::filesystem::path tempPathFor(const std::filesystem::path &finalPath);
+
+    /**
+     * @brief Grava em deps os headers de @p depFile (saída do -MMD) com o
+     * hash do conteúdo; chamar antes de publish()
+     */
+    static bool recordDeps(const std::filesystem::path &entryDir,
+                           const std::filesystem::path &depFile);
+
+    /**
+     * @brief Publica o .pch gerado em @p built como @p finalPath
+     */
+    bool publish(const std::filesystem::path &built,
+                 const std::filesystem::path &finalPath);
+
+    /**
+     * @brief Remove entradas menos usadas até caber no limite
+     *
+     * Entradas usadas na última hora nunca são removidas: podem ser o PCH
+     * (ou o pai de uma camada) de uma sessão aberta.
+     */
+    size_t evictToLimit();
+
+    uint64_t diskUsage() const;
+    size_t entryCount() const;
+    uint64_t maxBytes() const { return maxBytes_; }
+    Stats stats() const;
+    const std::filesystem::path &root() const { return root_; }
+
+  private:
+    std::filesystem::path entryDir(std::string_view family,
+                                   const std::string &key) const;
+
+    std::filesystem::path root_;
+    uint64_t maxBytes_;
+
+    // Uso aproximado: recalculado do disco na primeira publicação e a cada
+    // despejo, somado localmente entre um e outro. Acima do limite só com
+    // entradas em uso, o despejo espera um pouco antes de varrer de novo
+    mutable std::mutex usageMutex_;
+    std::optional<uint64_t> approxUsage_;
+    std::chrono::steady_clock::time_point nextEviction_{};
+
+    std::atomic<uint64_t> hits_{0};
+    std::atomic<uint64_t> misses_{0};
+    std::atomic<uint64_t> evictions_{0};
+    std::atomic<uint64_t> tempCounter_{0};
+};
+
+} // namespace compiler
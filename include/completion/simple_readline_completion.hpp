@@ -11,6 +11,10 @@
 struct VarDecl;
 struct ReplState;
 
+namespace execution {
+class SymbolIndex;
+}
+
 namespace completion {
 
 /**
@@ -36,13 +40,17 @@ class SimpleReadlineCompletion {
     // Context management from REPL state
     void updateFromReplState(const ReplState &state) noexcept;
 
+    // Variáveis e funções vêm direto do índice (consulta por prefixo)
+    void setSymbolIndex(const execution::SymbolIndex *symbols) noexcept {
+        symbols_ = symbols;
+    }
+
     // Query interface
     [[nodiscard]] std::vector<std::string>
     getCompletions(std::string_view prefix) const noexcept;
 
   private:
-    std::unordered_set<std::string> variables_;
-    std::unordered_set<std::string> functions_;
+    const execution::SymbolIndex *symbols_ = nullptr;
     std::unordered_set<std::string> keywords_;
     std::unordered_set<std::string> replCommands_;
 
@@ -65,7 +73,9 @@ class SimpleReadlineCompletion {
  */
 class SimpleCompletionScope {
   public:
-    explicit SimpleCompletionScope(const ReplState &replState) noexcept;
+    explicit SimpleCompletionScope(
+        const ReplState &replState,
+        const execution::SymbolIndex *symbols = nullptr) noexcept;
     ~SimpleCompletionScope() noexcept;
 
     // Non-copyable, movable
@@ -0,0 +1,195 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <sys/types.h>
+#include <utility>
+#include <vector>
+
+namespace execution {
+
+/**
+ * @brief Cancelamento cooperativo dos jobs de compilação
+ *
+ * Os tokens formam uma árvore: eval (Ctrl-C) -> build (falha de uma fonte)
+ * -> job (AST + compile da mesma fonte). Cancelar um nó cancela os
+ * descendentes, nunca o pai.
+ *
+ * Processos lançados com um token (ProcessOptions::cancel) rodam no próprio
+ * grupo de processos, registrado no token e em todos os ancestrais; cancel()
+ * manda SIGTERM para os grupos registrados no nó, o que alcança também os
+ * processos dos descendentes. Esperas que não são processos (token do
+ * jobserver) registram um eventfd, que cancel() sinaliza. Só usa atômicos,
+ * kill() e write(): pode ser chamado de dentro de um handler de sinal.
+ *
+ * Um token construído por padrão é inerte: nunca é cancelado.
+ */
+class CancellationToken {
+    struct State;
+
+  public:
+    /**
+     * @brief Registro de um grupo de processos; desfeito no destrutor
+     */
+    class ProcessGroup {
+      public:
+        ProcessGroup() = default;
+        ~ProcessGroup() { reset(); }
+
+        ProcessGroup(ProcessGroup &&other) noexcept
+            : slots_(std::move(other.slots_)), full_(other.full_) {
+            other.slots_.clear();
+        }
+        ProcessGroup &operator=(ProcessGroup &&other) noexcept;
+        ProcessGroup(const ProcessGroup &) = delete;
+        ProcessGroup &operator=(const ProcessGroup &) = delete;
+
+        /**
+         * @brief false se a tabela de algum nó estava cheia: cancel() não
+         * alcançaria o grupo
+         */
+        bool registered() const noexcept { return !full_; }
+
+        void reset() noexcept;
+
+      private:
+        friend class CancellationToken;
+        std::vector<std::pair<std::shared_ptr<State>, size_t>> slots_;
+        bool full_ = false;
+    };
+
+    /**
+     * @brief Registro de um eventfd acordado por cancel(); desfeito no
+     * destrutor
+     */
+    class Wakeup {
+      public:
+        Wakeup() = default;
+        ~Wakeup() { reset(); }
+
+        Wakeup(Wakeup &&other) noexcept
+            : slots_(std::move(other.slots_)), full_(other.full_) {
+            other.slots_.clear();
+        }
+        Wakeup &operator=(Wakeup &&other) noexcept;
+        Wakeup(const Wakeup &) = delete;
+        Wakeup &operator=(const Wakeup &) = delete;
+
+        /**
+         * @brief false se a tabela de algum nó estava cheia: quem espera
+         * precisa conferir cancelled() por conta própria
+         */
+        bool registered() const noexcept { return !full_; }
+
+        void reset() noexcept;
+
+      private:
+        friend class CancellationToken;
+        std::vector<std::pair<std::shared_ptr<State>, size_t>> slots_;
+        bool full_ = false;
+    };
+
+    CancellationToken() = default;
+
+    /**
+     * @brief Raiz nova, independente
+     */
+    static CancellationToken create();
+
+    /**
+     * @brief Filho: cancelado junto com este token (ou sozinho)
+     */
+    CancellationToken child() const;
+
+    bool cancellable() const { return state_ != nullptr; }
+    bool cancelled() const noexcept;
+
+    /**
+     * @brief Cancela este nó e os descendentes; async-signal-safe
+     */
+    void cancel() const noexcept;
+
+    /**
+     * @brief Registra o grupo @p pgid; se o token já foi cancelado, o grupo
+     * é morto na hora
+     *
+     * As tabelas têm tamanho fixo (o handler de sinal não pode alocar): sem
+     * vaga em algum nó, nada fica registrado e registered() devolve false.
+     */
+    ProcessGroup track(pid_t pgid) const;
+
+    /**
+     * @brief Registra o eventfd @p fd: cancel() escreve nele; se o token já
+     * foi cancelado, é sinalizado na hora
+     *
+     * Sem vaga em algum nó, como em track(), registered() devolve false.
+     */
+    Wakeup watch(int fd) const;
+
+  private:
+    static constexpr size_t kMaxGroups = 128;
+    static constexpr size_t kMaxWakeups = 64;
+
+    struct State : std::enable_shared_from_this<State> {
+        std::shared_ptr<State> parent;
+        std::atomic<bool> cancelled{false};
+        std::array<std::atomic<pid_t>, kMaxGroups> groups{};
+        std::array<std::atomic<int>, kMaxWakeups> wakeups{}; // fd + 1
+    };
+
+    static void cancelState(State &state) noexcept;
+
+    explicit CancellationToken(std::shared_ptr<State> state)
+        : state_(std::move(state)) {}
+
+    std::shared_ptr<State> state_;
+
+    friend class EvalCancellationScope;
+};
+
+/**
+ * @brief Fase de build de um eval: Ctrl-C cancela os jobs em vez de lançar
+ * exceção
+ *
+ * Escopos aninhados viram filhos do escopo externo. O escopo ativo é um só
+ * no processo (o handler de Ctrl-C o lê de qualquer thread) e pertence à
+ * thread que abriu o mais externo, a do REPL: só ela publica escopos
+ * aninhados. Um escopo aberto em outra thread (tarefa do TaskScheduler)
+ * vira filho do ativo sem substituí-lo. Outras threads só chamam current()
+ * enquanto o escopo que o publicou existe, ou seja, em tarefas esperadas
+ * dentro dele; fora disso, recebem o token pronto de quem as disparou.
+ */
+class EvalCancellationScope {
+  public:
+    EvalCancellationScope();
+    ~EvalCancellationScope();
+
+    EvalCancellationScope(const EvalCancellationScope &) = delete;
+    EvalCancellationScope &operator=(const EvalCancellationScope &) = delete;
+
+    const CancellationToken &token() const { return token_; }
+    bool cancelled() const { return token_.cancelled(); }
+
+    static CancellationToken current();
+    static bool cancelCurrent() noexcept;
+
+  private:
+    CancellationToken token_;
+    CancellationToken::State *previous_ = nullptr;
+    bool published_ = false;
+};
+
+/**
+ * @brief Token do escopo de build ativo (inerte fora de um escopo)
+ */
+CancellationToken currentEvalToken();
+
+/**
+ * @brief Cancela o escopo de build ativo; async-signal-safe
+ * @return false se nenhum build está em andamento
+ */
+bool cancelCurrentEval() noexcept;
+
+} // namespace execution
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "../repl.hpp"
+#include "symbol_index.hpp"
 #include "symbol_resolver.hpp"
 #include <mutex>
 #include <shared_mutex>
@@ -8,20 +9,15 @@
 #include <unordered_map>
 
 namespace execution {
-// Forward declaration
-struct wrapperFn {
-    void *fnptr;
-    void **wrap_ptrfn;
-};
 
 // Estado global centralizado - OBRIGATÓRIO para dlopen/dlsym e assembly inline
 struct GlobalExecutionState {
     // Estado compartilhado necessário para execução dinâmica
     std::string lastLibrary;
     std::unordered_map<std::string, uintptr_t> symbolsToResolve;
-    std::unordered_map<std::string, wrapperFn> fnNames;
 
-    std::unordered_map<std::string, std::string> existingFunctions;
+    // Índice de todos os símbolos da sessão (execução, completion, printers)
+    SymbolIndex symbols;
 
     // Configuração global para resolução de símbolos via trampolines
     SymbolResolver::WrapperConfig wrapperConfig;
@@ -38,9 +34,6 @@ struct GlobalExecutionState {
     std::string getLastLibrary() const;
     void clearSymbolsToResolve();
     void addSymbolToResolve(const std::string &symbol, uintptr_t address);
-    bool hasFnName(const std::string &mangledName) const;
-    wrapperFn &getFnName(const std::string &mangledName);
-    void setFnName(const std::string &mangledName, const wrapperFn &fn);
 
     // Métodos para gerenciar configuração de wrappers
     SymbolResolver::WrapperConfig &getWrapperConfig();
@@ -49,7 +42,7 @@ struct GlobalExecutionState {
     friend GlobalExecutionState &getGlobalExecutionState();
 
   private:
-    GlobalExecutionState() = default;
+    GlobalExecutionState();
     ~GlobalExecutionState() = default;
     GlobalExecutionState(const GlobalExecutionState &) = delete;
     GlobalExecutionState &operator=(const GlobalExecutionState &) = delete;
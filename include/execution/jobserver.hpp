@@ -0,0 +1,142 @@
+#pragma once
+
+#include "execution/cancellation.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <filesystem>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace execution {
+
+/**
+ * @brief Cliente e servidor do jobserver do GNU make
+ *
+ * Cliente: quando o REPL roda sob make/ninja (MAKEFLAGS com
+ * --jobserver-auth=fifo:PATH ou --jobserver-auth=R,W), cada compilador
+ * lançado precisa de um token do make; o processo já tem um token
+ * implícito, e os demais são bytes lidos do pipe/fifo e devolvidos ao fim
+ * do job. Assim o REPL divide os núcleos com o build externo em vez de somar
+ * hardware_concurrency a ele.
+ *
+ * Servidor: sem make por cima, o REPL cria um fifo com os tokens do limite
+ * de jobs (#jobs) e exporta MAKEFLAGS para os filhos. Ferramentas que
+ * respeitam o protocolo (make chamado por comandos customizados, gcc
+ * -flto=auto) ficam dentro do mesmo limite.
+ *
+ * CPPREPL_JOBSERVER=0 desliga os dois modos.
+ */
+class Jobserver {
+  public:
+    enum class Mode { Disabled, Client, Server };
+
+    struct Auth {
+        std::string fifo; // vazio = par de descritores herdado
+        int readFd = -1;
+        int writeFd = -1;
+        size_t jobs = 0; // -jN do MAKEFLAGS (0 = não informado)
+    };
+
+    /**
+     * @brief Permissão para um processo filho; devolvida no destrutor
+     */
+    class Token {
+      public:
+        Token() = default;
+        ~Token() { release(); }
+
+        Token(Token &&other) noexcept { *this = std::move(other); }
+        Token &operator=(Token &&other) noexcept;
+        Token(const Token &) = delete;
+        Token &operator=(const Token &) = delete;
+
+        bool valid() const { return owner_ != nullptr; }
+        bool implicit() const { return implicit_; }
+        void release();
+
+      private:
+        friend class Jobserver;
+        Token(Jobserver *owner, bool implicit, char byte)
+            : owner_(owner), implicit_(implicit), byte_(byte) {}
+
+        Jobserver *owner_ = nullptr;
+        bool implicit_ = false;
+        char byte_ = '+';
+    };
+
+    static Jobserver &instance();
+
+    /**
+     * @brief Extrai o --jobserver-auth (ou --jobserver-fds) de @p makeflags
+     */
+    static std::optional<Auth> parseMakeflags(std::string_view makeflags);
+
+    /**
+     * @brief Cliente se @p makeflags tiver um jobserver válido; senão fica
+     * desligado até serve()
+     */
+    explicit Jobserver(std::string_view makeflags);
+    ~Jobserver();
+
+    Jobserver(const Jobserver &) = delete;
+    Jobserver &operator=(const Jobserver &) = delete;
+
+    Mode mode() const;
+
+    /**
+     * @brief Limite de jobs conhecido (-jN do make ou o do servidor); 0 se
+     * desconhecido
+     */
+    size_t limit() const;
+
+    /**
+     * @brief Bloqueia até haver um token (Disabled: devolve um inválido na
+     * hora)
+     *
+     * A espera acorda quando o token implícito é devolvido e quando @p cancel
+     * é cancelado; cancelado, devolve um token inválido.
+     */
+    Token acquire(const CancellationToken &cancel = {});
+
+    /**
+     * @brief Passa a servir @p slots tokens num fifo em @p dir e exporta
+     * MAKEFLAGS; já servindo, só ajusta o total. Sem efeito como cliente.
+     *
+     * @p dir vazio usa o workspace da sessão (ou o diretório temporário).
+     */
+    bool serve(size_t slots, const std::filesystem::path &dir = {});
+
+    /**
+     * @brief MAKEFLAGS para processos filhos (vazio se desligado)
+     */
+    std::string makeflags() const;
+
+  private:
+    void putBack(char byte);
+    void wakeWaiters();
+    Token waitForToken(int fd, const CancellationToken &cancel);
+    bool writeTokens(size_t count);
+    void drainFreeTokens();
+    std::string makeflagsLocked() const;
+
+    mutable std::mutex mutex_;
+    Mode mode_ = Mode::Disabled;
+    int readFd_ = -1;
+    int writeFd_ = -1;
+    bool ownsFds_ = false;
+    int pollFd_ = -1;          // leitor O_NONBLOCK próprio do mesmo pipe/fifo
+    std::vector<int> waiters_; // eventfds dos acquire() bloqueados
+    std::string fifo_;
+    size_t jobs_ = 0;
+    size_t debt_ = 0; // tokens a recolher depois de um serve() menor
+    std::string baseMakeflags_;
+    std::atomic<bool> implicitFree_{true};
+    bool autoServe_ = false; // instance(): servidor no primeiro acquire()
+    std::once_flag autoServeOnce_;
+};
+
+} // namespace execution
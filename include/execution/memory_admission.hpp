@@ -0,0 +1,160 @@
+#pragma once
+
+#include <array>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <optional>
+#include <string_view>
+#include <sys/types.h>
+
+namespace execution {
+
+/**
+ * @brief Tipos de job com perfis de memória distintos
+ */
+enum class JobKind { AstDump, Compile, Link };
+
+constexpr size_t kJobKindCount = 3;
+
+std::string_view jobKindName(JobKind kind);
+
+/**
+ * @brief Controle de admissão por memória para os processos do compilador
+ *
+ * Um clang que carrega um PCH grande passa de centenas de MB; com um job por
+ * núcleo (mais o dump de AST de cada fonte), máquinas grandes iam para o
+ * swap. Cada job pede admissão antes de lançar o processo: ele entra se a
+ * estimativa para o seu tipo couber na folga, que é a memória disponível
+ * (MemAvailable do /proc/meminfo, ou o limite do cgroup se menor) menos uma
+ * margem fixa e menos o que os jobs já admitidos ainda devem crescer
+ * (estimativa - RSS atual do processo). Se não couber, o job espera.
+ *
+ * A estimativa por tipo começa num valor conservador e acompanha o pico de
+ * RSS observado (wait4) dos jobs terminados. Com nenhum job rodando, o
+ * próximo sempre entra, para nunca travar.
+ *
+ * CPPREPL_ADMISSION=0 desliga.
+ */
+class MemoryAdmission {
+  public:
+    static constexpr uint64_t kSafetyMargin = 256ull << 20;
+
+    using Probe = std::function<std::optional<uint64_t>()>;
+
+    struct Stats {
+        bool enabled = true;
+        uint64_t available = 0; // medido agora (meminfo/cgroup)
+        uint64_t reserved = 0;  // crescimento ainda esperado dos admitidos
+        int64_t headroom = 0;   // available - margem - reserved
+        size_t running = 0;
+        size_t queued = 0;
+        size_t admitted = 0; // total na sessão
+        size_t delayed = 0;  // quantos tiveram de esperar
+        std::array<uint64_t, kJobKindCount> estimate{};
+        std::array<uint64_t, kJobKindCount> peak{};
+        std::array<size_t, kJobKindCount> samples{};
+    };
+
+  private:
+    struct Job {
+        JobKind kind;
+        pid_t pid = -1;
+    };
+
+  public:
+    /**
+     * @brief Vaga admitida; devolvida no destrutor
+     */
+    class Ticket {
+      public:
+        Ticket() = default;
+        ~Ticket() { release(); }
+
+        Ticket(Ticket &&other) noexcept { *this = std::move(other); }
+        Ticket &operator=(Ticket &&other) noexcept;
+        Ticket(const Ticket &) = delete;
+        Ticket &operator=(const Ticket &) = delete;
+
+        bool valid() const { return owner_ != nullptr; }
+
+        /**
+         * @brief Processo do job, para descontar o RSS já em uso
+         */
+        void attach(pid_t pid);
+
+        /**
+         * @brief Registra o pico de RSS (KiB, ru_maxrss) e devolve a vaga
+         */
+        void finish(long peakRssKb);
+
+        void release();
+
+      private:
+        friend class MemoryAdmission;
+        Ticket(MemoryAdmission *owner, std::list<Job>::iterator job)
+            : owner_(owner), job_(job) {}
+
+        MemoryAdmission *owner_ = nullptr;
+        std::list<Job>::iterator job_;
+    };
+
+    static MemoryAdmission &instance();
+
+    /**
+     * @param probe Memória disponível em bytes (padrão: availableMemory)
+     */
+    explicit MemoryAdmission(Probe probe = availableMemory);
+
+    MemoryAdmission(const MemoryAdmission &) = delete;
+    MemoryAdmission &operator=(const MemoryAdmission &) = delete;
+
+    bool enabled() const;
+    void setEnabled(bool enabled);
+
+    /**
+     * @brief Bloqueia até o job caber na folga de memória
+     */
+    Ticket admit(JobKind kind);
+
+    uint64_t estimate(JobKind kind) const;
+
+    /**
+     * @brief Pico de RSS de um job terminado (ajusta a estimativa do tipo)
+     */
+    void record(JobKind kind, uint64_t peakBytes);
+
+    Stats stats() const;
+
+    /**
+     * @brief Menor entre MemAvailable e a folga do cgroup (v2 ou v1)
+     */
+    static std::optional<uint64_t> availableMemory();
+
+    static std::optional<uint64_t> parseMeminfo(std::string_view meminfo,
+                                                std::string_view key);
+
+  private:
+    static uint64_t residentBytes(pid_t pid);
+
+    int64_t headroomLocked(uint64_t available, uint64_t *reserved) const;
+    void finishJob(std::list<Job>::iterator job, long peakRssKb);
+    void recordLocked(JobKind kind, uint64_t peakBytes);
+
+    Probe probe_;
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    bool enabled_ = true;
+    std::list<Job> running_;
+    size_t queued_ = 0;
+    size_t admitted_ = 0;
+    size_t delayed_ = 0;
+    std::array<uint64_t, kJobKindCount> estimate_;
+    std::array<uint64_t, kJobKindCount> peak_{};
+    std::array<size_t, kJobKindCount> samples_{};
+};
+
+} // namespace execution
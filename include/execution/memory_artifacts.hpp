@@ -0,0 +1,98 @@
+#pragma once
+
+#include <cstddef>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace execution {
+
+/**
+ * @brief Artefatos do eval guardados em memfd em vez do diretório atual
+ *
+ * Modo "diskless": repl_N.cpp, libs, .log e .decls viram memfds, vistos pelo
+ * compilador e pelo dlopen como /proc/<pid>/fd/N. O pid do REPL (e não
+ * /proc/self) permite que o compilador, o cc1 e o linker abram o mesmo memfd
+ * sem herdar o descritor.
+ *
+ * Bibliotecas nunca são fechadas: o dlopen identifica objetos pelo caminho,
+ * e reaproveitar o número do fd devolveria a biblioteca antiga. Os demais
+ * artefatos são temporários e fechados em release() ou ao serem recriados.
+ *
+ * Ligado por CPPREPL_DISKLESS=1 ou pelo comando #diskless.
+ */
+class MemoryArtifacts {
+  public:
+    enum class Kind {
+        Transient, // fontes, logs, saídas do plugin
+        Library    // carregada com dlopen; o memfd fica aberto
+    };
+
+    static MemoryArtifacts &instance();
+
+    MemoryArtifacts(const MemoryArtifacts &) = delete;
+    MemoryArtifacts &operator=(const MemoryArtifacts &) = delete;
+
+    bool enabled() const;
+
+    /**
+     * @brief Liga/desliga o modo; ao ligar, sobe o limite de descritores.
+     * Ao desligar, os nomes voltam a apontar para o disco
+     * @return false se memfd não estiver disponível
+     */
+    bool setEnabled(bool enable);
+
+    /**
+     * @brief Cria um memfd novo para @p name (com @p content) e devolve o
+     * caminho em /proc
+     */
+    std::optional<std::string> create(const std::string &name,
+                                      std::string_view content = {},
+                                      Kind kind = Kind::Transient);
+
+    /**
+     * @brief Caminho do memfd de @p name, ou @p name se não for um artefato
+     * em memória
+     */
+    std::string resolve(const std::string &name) const;
+
+    bool contains(const std::string &name) const;
+
+    /**
+     * @brief Fecha um artefato temporário (bibliotecas são mantidas)
+     */
+    void release(const std::string &name);
+
+    /**
+     * @brief Fecha os temporários de um eval (repl_N.cpp, repl_N.log, ...)
+     */
+    void releaseStem(std::string_view stem);
+
+    static bool isMemoryPath(std::string_view path);
+
+    size_t count() const;
+    size_t bytes() const;
+
+  private:
+    MemoryArtifacts();
+
+    struct Artifact {
+        int fd = -1;
+        std::string path;
+        Kind kind = Kind::Transient;
+    };
+
+    static std::string normalize(std::string_view name);
+    void retireLocked(Artifact &artifact);
+
+    mutable std::mutex mutex_;
+    bool enabled_ = false;
+    std::unordered_map<std::string, Artifact> artifacts_;
+    // Bibliotecas substituídas por um memfd novo com o mesmo nome
+    std::vector<int> retiredLibraries_;
+};
+
+} // namespace execution
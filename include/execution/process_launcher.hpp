@@ -0,0 +1,134 @@
+#pragma once
+
+#include "execution/cancellation.hpp"
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <sys/types.h>
+#include <vector>
+
+namespace execution {
+
+int memfd_create_compat(const char *name, unsigned flags);
+
+/**
+ * @brief memfd que recebe a saída de um processo filho, mapeado depois do
+ * término
+ *
+ * Nada passa por pipe nem pelo disco: o filho escreve direto no memfd (via
+ * dup2) e o REPL lê o resultado com um único mmap.
+ */
+class MemfdCapture {
+  public:
+    MemfdCapture() = default;
+    ~MemfdCapture();
+
+    MemfdCapture(MemfdCapture &&other) noexcept;
+    MemfdCapture &operator=(MemfdCapture &&other) noexcept;
+    MemfdCapture(const MemfdCapture &) = delete;
+    MemfdCapture &operator=(const MemfdCapture &) = delete;
+
+    /**
+     * @brief Cria o memfd (MFD_CLOEXEC: só o filho que recebe o dup2 herda)
+     * @return errno em caso de falha, 0 caso contrário
+     */
+    int open(const char *name);
+
+    /**
+     * @brief Mapeia o conteúdo escrito até agora (chamar após o waitpid)
+     * @return errno em caso de falha, 0 caso contrário
+     */
+    int map();
+
+    std::string_view view() const;
+    size_t size() const { return len_; }
+    int fd() const { return fd_; }
+    bool valid() const { return fd_ >= 0; }
+
+  private:
+    void reset() noexcept;
+
+    int fd_ = -1;
+    void *addr_ = nullptr;
+    size_t len_ = 0;
+};
+
+/**
+ * @brief Destino de stdout/stderr do filho
+ */
+enum class Stream {
+    Inherit,  // mesmo descritor do REPL
+    Capture,  // memfd, lido em ProcessResult::out()/err()
+    File,     // arquivo (outPath/errPath); "/dev/null" descarta
+    ToStdout  // só para stderr: mesmo destino do stdout (2>&1)
+};
+
+struct ProcessOptions {
+    Stream out = Stream::Capture;
+    Stream err = Stream::Inherit;
+    std::string outPath;
+    std::string errPath;
+    bool appendOut = false;
+    bool appendErr = false;
+    std::string inPath; // vazio = herda o stdin
+    // Chamado com o pid logo após o spawn, antes da espera
+    std::function<void(pid_t)> onSpawn;
+    // Cancelável: o filho ganha o próprio grupo de processos, registrado no
+    // token; já cancelado = nem lança (ECANCELED)
+    CancellationToken cancel;
+};
+
+struct ProcessResult {
+    /**
+     * @brief Status bruto do waitpid (mesmo formato de system()/pclose())
+     *
+     * Falha ao criar o processo vira exit 127, como no shell.
+     */
+    int status = -1;
+    int spawnError = 0; // errno do posix_spawn; 0 = o filho rodou
+    long peakRssKb = 0; // ru_maxrss do wait4 (inclui os netos esperados)
+    bool cancelled = false; // token cancelado antes do fim do processo
+    MemfdCapture outCapture;
+    MemfdCapture errCapture;
+
+    std::string_view out() const { return outCapture.view(); }
+    std::string_view err() const { return errCapture.view(); }
+
+    bool exited() const;
+    int exitCode() const; // -1 se morreu por sinal ou não rodou
+    bool success() const { return spawnError == 0 && status == 0; }
+};
+
+/**
+ * @brief Executa @p argv sem shell e espera o término
+ *
+ * posix_spawnp (na glibc, clone(CLONE_VM|CLONE_VFORK)): o custo não cresce
+ * com o número de bibliotecas mapeadas no REPL, ao contrário do fork() de
+ * system()/popen(). A máscara de sinais e SIGPIPE/SIGINT voltam ao padrão no
+ * filho.
+ */
+ProcessResult runProcess(const std::vector<std::string> &argv,
+                         const ProcessOptions &opts = {});
+
+/**
+ * @brief Divide uma linha de comando em argv, sem shell
+ *
+ * Entende aspas simples/duplas, barra invertida e os redirecionamentos que o
+ * REPL usa (<, >, >>, 2>, 2>>, 2>&1, &>), que vão para @p opts.
+ *
+ * @return false se a linha precisa de um shell de verdade (pipes, $, globs,
+ * ;, &&, ...)
+ */
+bool parseCommandLine(std::string_view command, std::vector<std::string> &argv,
+                      ProcessOptions &opts);
+
+/**
+ * @brief Executa uma linha de comando; usa /bin/sh -c só se parseCommandLine
+ * recusar a linha
+ */
+ProcessResult runCommandLine(std::string_view command,
+                             ProcessOptions opts = {});
+
+} // namespace execution
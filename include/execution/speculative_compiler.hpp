@@ -0,0 +1,107 @@
+#pragma once
+
+#include "execution/cancellation.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <optional>
+#include <string>
+
+namespace execution {
+
+/**
+ * @brief Compilação especulativa da linha que ainda está sendo digitada
+ *
+ * Depois de uma pausa na digitação o REPL gera o fonte que a linha atual
+ * viraria e chama speculate(); o build roda em segundo plano contra o PCH
+ * atual. No Enter, claim() com a mesma chave devolve a biblioteca já pronta
+ * (esperando o job, se ainda estiver rodando) e o eval vai direto para o
+ * dlopen. Chave diferente é miss: o job é cancelado.
+ *
+ * A chave deve cobrir tudo que muda o resultado do build (fonte, PCH,
+ * decl_amalgama.hpp); o SpeculativeCompiler só compara. Há no máximo um job
+ * vivo: especular outra chave cancela e espera o anterior, para que nenhum
+ * compilador especulativo continue lendo headers que o próximo eval reescreve.
+ *
+ * Desligado por padrão; CPPREPL_SPECULATE=1 liga.
+ */
+class SpeculativeCompiler {
+  public:
+    /**
+     * @brief Compila @p source como a biblioteca lib<name>.so
+     *
+     * Roda fora da thread principal e não deve escrever no terminal.
+     * @return true se a biblioteca ficou pronta
+     */
+    using Build =
+        std::function<bool(const std::string &name, const std::string &source,
+                           const CancellationToken &cancel)>;
+
+    struct Stats {
+        bool enabled = false;
+        size_t started = 0;
+        size_t hits = 0;
+        size_t misses = 0;    // Enter com outra linha (ou build falho)
+        size_t cancelled = 0; // descartados sem claim (linha mudou)
+        size_t failed = 0;    // build especulativo não compilou
+        bool running = false;
+    };
+
+    static SpeculativeCompiler &instance();
+
+    SpeculativeCompiler();
+    ~SpeculativeCompiler();
+
+    SpeculativeCompiler(const SpeculativeCompiler &) = delete;
+    SpeculativeCompiler &operator=(const SpeculativeCompiler &) = delete;
+
+    void setBuild(Build build);
+
+    void setEnabled(bool enabled);
+    bool enabled() const;
+
+    /**
+     * @brief Começa a compilar @p source para @p key
+     *
+     * Mesma chave do job atual não faz nada; outra chave cancela o atual.
+     */
+    void speculate(const std::string &key, std::string source);
+
+    /**
+     * @brief Nome da biblioteca pronta para @p key, ou nullopt (miss)
+     *
+     * Espera o job se ele ainda estiver rodando; o Ctrl-C do eval atual
+     * (EvalCancellationScope) cancela a espera. O job é consumido em
+     * qualquer caso.
+     */
+    std::optional<std::string> claim(const std::string &key);
+
+    /**
+     * @brief Cancela e espera o job atual, se houver
+     */
+    void cancel();
+
+    Stats stats() const;
+
+  private:
+    struct Job {
+        std::string key;
+        std::string name;
+        CancellationToken cancel;
+        std::future<bool> done;
+    };
+
+    void retire(Job &job);
+
+    mutable std::mutex mutex_;
+    Build build_;
+    bool enabled_ = false;
+    uint64_t sequence_ = 0;
+    std::optional<Job> job_;
+    Stats stats_;
+};
+
+} // namespace execution
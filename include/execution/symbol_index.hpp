@@ -0,0 +1,87 @@
+#pragma once
+
+#include "../repl.hpp"
+#include <cstdint>
+#include <optional>
+#include <set>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace execution {
+
+/**
+ * @brief Registro de um símbolo conhecido pelo REPL
+ */
+struct SymbolRecord {
+    VarDecl decl;
+    std::string demangledName; // __cxa_demangle, ou o próprio nome
+    std::string library;       // .so que definiu por último
+    uintptr_t address = 0;     // endereço carregado (0 até o dlopen)
+    int64_t generation = 0;    // replCounter do eval que definiu
+    bool wrapped = false;      // já tem trampoline exportado
+};
+
+/**
+ * @brief Índice único dos símbolos da sessão
+ *
+ * Chaveado pelo nome mangled (ou pelo nome, se a declaração não tiver
+ * mangled). Buscas por chave são O(1); buscas por prefixo do nome usam um
+ * conjunto ordenado, O(log n + k). A ordem de inserção é preservada para o
+ * printall.
+ *
+ * Substitui replState.varsNames/allTheVariables e os mapas de funções do
+ * GlobalExecutionState; o custo por eval é proporcional só às declarações
+ * do eval, não ao tamanho da sessão.
+ */
+class SymbolIndex {
+  public:
+    /**
+     * @brief Adiciona ou atualiza a declaração
+     * @return true se o símbolo ainda não existia
+     */
+    bool add(const VarDecl &decl, int64_t generation,
+             std::string_view library = {});
+
+    /**
+     * @brief Registra o endereço carregado de um símbolo já indexado
+     */
+    void setAddress(std::string_view mangledName, uintptr_t address);
+
+    void markWrapped(std::string_view mangledName);
+    bool isWrapped(std::string_view mangledName) const;
+
+    bool contains(std::string_view mangledName) const;
+    bool containsName(std::string_view name) const;
+    std::optional<SymbolRecord> find(std::string_view mangledName) const;
+
+    /**
+     * @brief Símbolos cujo nome começa com @p prefix, em ordem alfabética
+     */
+    std::vector<SymbolRecord> withPrefix(std::string_view prefix,
+                                         size_t limit = SIZE_MAX) const;
+
+    /**
+     * @brief Declarações em ordem de inserção
+     */
+    std::vector<VarDecl> declarations() const;
+
+    size_t size() const;
+
+  private:
+    static std::string keyOf(const VarDecl &decl);
+
+    SymbolRecord *findLocked(std::string_view mangledName);
+    const SymbolRecord *findLocked(std::string_view mangledName) const;
+
+    mutable std::shared_mutex mutex_;
+    std::vector<SymbolRecord> records_;
+    std::unordered_map<std::string, size_t> byKey_;
+    // (nome, índice) para consultas por prefixo
+    std::set<std::pair<std::string, size_t>> byName_;
+};
+
+} // namespace execution
@@ -1,5 +1,7 @@
 #pragma once
 
+#include "execution/symbol_index.hpp"
+#include "execution/trampoline_arena.hpp"
 #include "utility/library_introspection.hpp"
 #include <cstdint>
 #include <string>
@@ -40,6 +42,11 @@ class SymbolResolver {
         std::unordered_map<std::string, uintptr_t> symbolOffsets;
         std::unordered_map<std::string, WrapperInfo> functionWrappers;
 
+        // Arena de trampolines (opcional); sem ela usa o wrapper_*.c
+        TrampolineArena *arena = nullptr;
+        // Handles dos .so de símbolos exportados pela arena, por nome do eval
+        std::unordered_map<std::string, void *> wrapperHandles;
+
         WrapperConfig() = default;
         WrapperConfig(const WrapperConfig &) = delete;
         WrapperConfig &operator=(const WrapperConfig &) = delete;
@@ -61,15 +68,23 @@ class SymbolResolver {
      * @param name Nome base para o arquivo de wrapper
      * @param vars Lista de declarações de variáveis/funções
      * @param config Configuração de wrappers (será preenchida)
-     * @param existingFunctions Funções já processadas (para evitar duplicação)
+     * @param symbols Índice da sessão (funções que já têm wrapper são puladas)
      * @return Pair de Mapa de nomes mangles para nomes de função e um bool que
      * indica se novos wrappers foram criados
      */
     static std::pair<std::unordered_map<std::string, std::string>, bool>
     prepareFunctionWrapper(
         const std::string &name, const std::vector<VarDecl> &vars,
-        WrapperConfig &config,
-        const std::unordered_map<std::string, std::string> &existingFunctions);
+        WrapperConfig &config, const SymbolIndex &symbols);
+
+    /**
+     * @brief Abre a biblioteca de wrappers de um eval
+     *
+     * Devolve o handle gerado pela arena de trampolines, se houver, ou faz
+     * dlopen do libwrapper_<name>.so compilado.
+     */
+    static void *openWrapperLibrary(const std::string &name,
+                                    WrapperConfig &config);
 
     /**
      * @brief Preenche ponteiros de wrapper após carregamento da biblioteca
@@ -0,0 +1,161 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <tbb/global_control.h>
+#include <tbb/parallel_for.h>
+#include <tbb/parallel_invoke.h>
+#include <tbb/task_arena.h>
+#include <tbb/task_group.h>
+#include <type_traits>
+#include <utility>
+
+namespace execution {
+
+/**
+ * @brief Agendador único do pipeline de eval (arena TBB persistente)
+ *
+ * Substitui os std::async espalhados: compilações, dumps de AST, preparo de
+ * wrappers/printers e carga de bibliotecas rodam como tarefas numa única
+ * tbb::task_arena, cujo tamanho é o limite de jobs em paralelo. Não há
+ * criação de threads por eval.
+ *
+ * As tarefas de compilação bloqueiam esperando o processo filho; a
+ * concorrência da arena é, na prática, o número de compiladores rodando ao
+ * mesmo tempo. Por isso ela pode ser maior que o número de núcleos
+ * (CPPREPL_JOBS ou #jobs).
+ *
+ * Esperas aninhadas (um job que dispara subtarefas) usam
+ * this_task_arena::isolate: a thread que espera só executa as próprias
+ * subtarefas, e não outro job inteiro no meio da espera.
+ */
+class TaskScheduler {
+  public:
+    static TaskScheduler &instance();
+
+    /**
+     * @param concurrency Jobs em paralelo (0 = CPPREPL_JOBS, -jN do make ou
+     * hardware_concurrency)
+     */
+    explicit TaskScheduler(size_t concurrency = 0);
+
+    size_t concurrency() const;
+
+    /**
+     * @brief Troca o limite; tarefas já disparadas terminam na arena antiga
+     */
+    void setConcurrency(size_t concurrency);
+
+    std::shared_ptr<tbb::task_arena> arena() const;
+
+    /**
+     * @brief Executa @p fn na arena e devolve o resultado (bloqueia)
+     */
+    template <typename Fn> decltype(auto) execute(Fn &&fn) {
+        auto a = arena();
+        return a->execute([&]() -> decltype(auto) {
+            return tbb::this_task_arena::isolate(std::forward<Fn>(fn));
+        });
+    }
+
+    /**
+     * @brief Roda as funções em paralelo e espera todas
+     */
+    template <typename... Fns> void parallelInvoke(Fns &&...fns) {
+        execute([&] { tbb::parallel_invoke(std::forward<Fns>(fns)...); });
+    }
+
+    /**
+     * @brief fn(i) para i em [0, count), um job por índice
+     * @param maxConcurrency Limite próprio deste laço (0 = o da arena)
+     */
+    template <typename Fn>
+    void parallelFor(size_t count, Fn &&fn, size_t maxConcurrency = 0) {
+        auto body = [&] {
+            tbb::parallel_for(
+                tbb::blocked_range<size_t>(0, count, 1),
+                [&](const tbb::blocked_range<size_t> &range) {
+                    for (size_t i = range.begin(); i != range.end(); ++i) {
+                        fn(i);
+                    }
+                },
+                tbb::simple_partitioner{});
+        };
+
+        if (maxConcurrency == 0 || maxConcurrency >= concurrency()) {
+            execute(body);
+            return;
+        }
+
+        // Arena menor e temporária; não mexe no limite global
+        tbb::task_arena limited(static_cast<int>(maxConcurrency));
+        limited.execute([&] { tbb::this_task_arena::isolate(body); });
+    }
+
+    /**
+     * @brief Dispara @p fn em segundo plano; o resultado sai no future
+     */
+    template <typename Fn>
+    auto submit(Fn &&fn) -> std::future<std::invoke_result_t<Fn>> {
+        using R = std::invoke_result_t<Fn>;
+        auto task =
+            std::make_shared<std::packaged_task<R()>>(std::forward<Fn>(fn));
+        auto future = task->get_future();
+        arena()->enqueue([task] { (*task)(); });
+        return future;
+    }
+
+  private:
+    static size_t defaultConcurrency();
+
+    mutable std::mutex mutex_;
+    size_t concurrency_ = 0;
+    std::shared_ptr<tbb::task_arena> arena_;
+    // Permite mais workers que núcleos quando os jobs são processos externos
+    std::unique_ptr<tbb::global_control> parallelism_;
+};
+
+/**
+ * @brief Um estágio do DAG do eval: tarefas disparadas agora, esperadas
+ * depois
+ *
+ * run() não bloqueia; wait() bloqueia até todas terminarem e repassa a
+ * primeira exceção. O destrutor espera o que ficou pendente.
+ */
+class TaskGroup {
+  public:
+    explicit TaskGroup(TaskScheduler &scheduler = TaskScheduler::instance())
+        : arena_(scheduler.arena()) {}
+
+    ~TaskGroup() {
+        if (pending_) {
+            arena_->execute([&] { group_.wait(); });
+        }
+    }
+
+    TaskGroup(const TaskGroup &) = delete;
+    TaskGroup &operator=(const TaskGroup &) = delete;
+
+    template <typename Fn> void run(Fn &&fn) {
+        pending_ = true;
+        arena_->execute([&] { group_.run(std::forward<Fn>(fn)); });
+    }
+
+    void wait() {
+        if (!pending_) {
+            return;
+        }
+        pending_ = false;
+        arena_->execute([&] { group_.wait(); });
+    }
+
+  private:
+    std::shared_ptr<tbb::task_arena> arena_;
+    tbb::task_group group_;
+    bool pending_ = false;
+};
+
+} // namespace execution
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace execution {
+
+/**
+ * @brief Trampolines de função gerados em tempo de execução
+ *
+ * Substitui o wrapper_*.c compilado a cada eval. Cada função ganha:
+ *   - entrada: jmp *slot
+ *   - stub lazy: salva registradores (inclusive xmm0-7), chama o resolvedor
+ *     (loadfnToPtr) com &slot e o nome, restaura e salta para *slot
+ * e um slot que começa apontando para o stub lazy, como o <nome>_ptr do
+ * wrapper compilado.
+ *
+ * O código vive num memfd mapeado duas vezes (RW para escrever, RX para
+ * executar), então nenhuma página é executável e gravável ao mesmo tempo e
+ * nada é alterado sob uma thread que esteja executando um trampoline.
+ *
+ * Para que as bibliotecas do REPL liguem os símbolos aos trampolines, o
+ * exportSymbols() gera em memória um .so mínimo cuja .dynsym tem os nomes
+ * como símbolos absolutos (SHN_ABS) e o carrega com RTLD_GLOBAL: a mesma
+ * interposição que o libwrapper_*.so fazia, sem compilador.
+ *
+ * Só x86-64; available() é false em outras arquiteturas ou se a arena não
+ * puder ser criada, e o chamador volta para o wrapper compilado.
+ */
+class TrampolineArena {
+  public:
+    using Resolver = void (*)(void **slot, const char *name);
+
+    struct Trampoline {
+        std::string name;
+        void *entry = nullptr;
+        void **slot = nullptr;
+    };
+
+    struct Symbol {
+        std::string name;
+        uintptr_t address = 0;
+        bool function = true;
+        size_t size = 0;
+    };
+
+    explicit TrampolineArena(size_t capacity = 16 * 1024 * 1024);
+    ~TrampolineArena();
+
+    TrampolineArena(const TrampolineArena &) = delete;
+    TrampolineArena &operator=(const TrampolineArena &) = delete;
+
+    bool available() const { return exec_ != nullptr; }
+
+    /**
+     * @brief Gera entrada + stub lazy + slot para @p name
+     * @return nullopt se a arena não estiver disponível ou estiver cheia
+     */
+    std::optional<Trampoline> emit(std::string_view name, Resolver resolver);
+
+    /**
+     * @brief Exporta <nome> -> entrada e <nome>_ptr -> slot para o dynamic
+     * linker
+     * @return Handle do dlopen, ou nullptr (ex.: glibc < 2.28, que soma a
+     * base da biblioteca a símbolos absolutos)
+     */
+    void *exportSymbols(const std::vector<Trampoline> &trampolines,
+                        const std::string &soname);
+
+    /**
+     * @brief Imagem ELF de um .so que só define símbolos absolutos
+     */
+    static std::string buildAbsoluteSymbolObject(
+        const std::vector<Symbol> &symbols, const std::string &soname);
+
+    size_t codeBytesUsed() const;
+    size_t trampolineCount() const;
+
+  private:
+    mutable std::mutex mutex_;
+    size_t capacity_ = 0;
+    unsigned char *reserve_ = nullptr; // RX em [0, cap), RW em [cap, 2cap)
+    unsigned char *exec_ = nullptr;
+    unsigned char *write_ = nullptr;
+    size_t codeUsed_ = 0;
+    size_t dataUsed_ = 0;
+    size_t count_ = 0;
+};
+
+} // namespace execution
@@ -0,0 +1,151 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace execution {
+
+/**
+ * @brief Diretório da sessão para os artefatos do eval
+ *
+ * Em vez de repl_N.cpp, libs, wrappers, .log e .decls irem para o diretório
+ * atual, cada sessão ganha <base>/cpprepl-<uid>/session-<pid>, dividido em
+ * subdiretórios (shards) pelo hash do nome. A base é um tmpfs quando
+ * possível ($XDG_RUNTIME_DIR, /dev/shm; montagens noexec são ignoradas
+ * porque o dlopen precisa mapear as libs como executáveis).
+ *
+ * Cada place() gera um caminho físico novo para o nome lógico; a versão
+ * anterior fica superada. A cada eval (advance()), versões superadas e
+ * artefatos com mais de keepGenerations evals de idade são removidos por uma
+ * thread em segundo plano, exceto bibliotecas ainda carregadas no processo
+ * (conferido por dispositivo/inode via dl_iterate_phdr), que ficam até
+ * serem descarregadas. resolve() continua achando um artefato velho até ele
+ * ser apagado de fato.
+ *
+ * O diretório da sessão é apagado no fim do processo; sessões de processos
+ * que já morreram são removidas na inicialização. CPPREPL_WORKSPACE=0
+ * desliga (artefatos voltam para o diretório atual) e CPPREPL_WORKSPACE=<dir>
+ * escolhe a base.
+ */
+class Workspace {
+  public:
+    static constexpr size_t kDefaultKeepGenerations = 8;
+
+    struct Stats {
+        std::filesystem::path root;
+        bool tmpfs = false;
+        size_t files = 0;          // arquivos no diretório da sessão
+        uintmax_t bytes = 0;       // espaço ocupado por eles
+        size_t tracked = 0;        // artefatos vivos conhecidos
+        size_t retained = 0;       // superados, mas ainda carregados
+        size_t pendingDeletes = 0; // aguardando a thread de remoção
+        size_t deleted = 0;        // removidos nesta sessão
+        int64_t generation = 0;
+    };
+
+    static Workspace &instance();
+
+    /**
+     * @brief Workspace em @p base (vazio = desligado)
+     */
+    explicit Workspace(const std::filesystem::path &base,
+                       size_t keepGenerations = kDefaultKeepGenerations);
+    ~Workspace();
+
+    Workspace(const Workspace &) = delete;
+    Workspace &operator=(const Workspace &) = delete;
+
+    bool enabled() const { return !root_.empty(); }
+    const std::filesystem::path &root() const { return root_; }
+
+    /**
+     * @brief Caminho físico novo para @p name; a versão anterior do mesmo
+     * nome fica superada
+     */
+    std::string place(const std::string &name);
+
+    /**
+     * @brief Caminho físico atual de @p name, ou @p name se não estiver no
+     * workspace
+     */
+    std::string resolve(const std::string &name) const;
+
+    /**
+     * @brief Fecha a geração (um eval) e agenda a coleta em segundo plano
+     */
+    void advance();
+
+    /**
+     * @brief Espera a thread de remoção esvaziar a fila
+     */
+    void drain();
+
+    Stats stats() const;
+
+  private:
+    struct Entry {
+        std::string path;
+        int64_t generation = 0;
+        bool collecting = false; // já na fila por idade
+    };
+
+    static std::filesystem::path defaultBase();
+    static void removeStaleSessions(const std::filesystem::path &userDir);
+
+    std::filesystem::path shardFor(std::string_view name);
+    void worker();
+
+    std::filesystem::path root_;
+    bool tmpfs_ = false;
+    size_t keepGenerations_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    std::condition_variable idle_;
+    int64_t generation_ = 0;
+    uint64_t sequence_ = 0;
+    std::unordered_map<std::string, Entry> current_; // nome lógico -> atual
+    std::unordered_map<std::string, std::string> aged_; // caminho -> nome
+    std::vector<std::string> superseded_;
+    std::vector<std::string> retained_; // carregados na última coleta
+    std::vector<std::string> queue_;
+    std::vector<bool> shards_;
+    size_t deleted_ = 0;
+    bool busy_ = false;
+    bool stopping_ = false;
+    std::thread worker_;
+};
+
+/**
+ * @brief Caminho atual do artefato @p name: memfd (modo diskless),
+ * workspace da sessão ou o próprio nome
+ */
+std::string artifactPath(const std::string &name);
+
+/**
+ * @brief Reserva o caminho de saída de um artefato novo (compilador/linker)
+ */
+std::string newArtifactPath(const std::string &name, bool library);
+
+/**
+ * @brief Grava um artefato gerado (fonte, log) e devolve o caminho usado
+ */
+std::optional<std::string> writeArtifact(const std::string &name,
+                                         std::string_view content);
+
+/**
+ * @brief Fim de um eval: fecha os memfds temporários de @p stem e avança a
+ * geração do workspace
+ */
+void finishEvalArtifacts(std::string_view stem);
+
+} // namespace execution
@@ -0,0 +1,78 @@
+#pragma once
+
+#include "library_introspection.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace utility {
+
+/**
+ * @brief Leitor em processo da tabela de símbolos dinâmicos de um ELF64
+ *
+ * Substitui o "nm -D --defined-only": mapeia o .so, percorre .dynsym/.dynstr
+ * e classifica cada símbolo com a mesma letra que o nm usaria. Buscas de um
+ * único símbolo usam a tabela .gnu.hash (ou .hash, ou varredura linear).
+ *
+ * Só lê o arquivo; endereços são st_value (offset no DSO), como no nm.
+ */
+class ElfDynamicSymbols {
+  public:
+    explicit ElfDynamicSymbols(const std::string &path);
+    ~ElfDynamicSymbols();
+
+    ElfDynamicSymbols(const ElfDynamicSymbols &) = delete;
+    ElfDynamicSymbols &operator=(const ElfDynamicSymbols &) = delete;
+
+    /**
+     * @brief Arquivo é um ELF64 nativo com .dynsym legível
+     */
+    bool valid() const { return symtab_ != nullptr; }
+
+    /**
+     * @brief Arquivo começa com o magic ELF (mesmo que não seja suportado)
+     */
+    bool isElf() const { return isElf_; }
+
+    /**
+     * @brief Símbolos definidos (equivalente a nm -D --defined-only)
+     */
+    std::vector<SymbolDef> definedSymbols() const;
+
+    /**
+     * @brief Procura um símbolo definido pelo nome (sem versão)
+     */
+    std::optional<SymbolDef> find(std::string_view name) const;
+
+    size_t symbolCount() const { return symbolCount_; }
+
+  private:
+    const void *symbol(size_t index) const;
+    std::string_view symbolName(const void *sym) const;
+    std::optional<SymbolDef> toDef(const void *sym) const;
+    char typeLetter(const void *sym) const;
+
+    std::optional<SymbolDef> findGnuHash(std::string_view name) const;
+    std::optional<SymbolDef> findSysvHash(std::string_view name) const;
+
+    const unsigned char *base_ = nullptr;
+    size_t size_ = 0;
+    bool isElf_ = false;
+
+    const unsigned char *symtab_ = nullptr;
+    size_t symbolCount_ = 0;
+    const char *strtab_ = nullptr;
+    size_t strtabSize_ = 0;
+    const unsigned char *sections_ = nullptr;
+    size_t sectionCount_ = 0;
+    const uint32_t *gnuHash_ = nullptr;
+    size_t gnuHashSize_ = 0;
+    const uint32_t *sysvHash_ = nullptr;
+    size_t sysvHashSize_ = 0;
+};
+
+} // namespace utility
@@ -15,14 +15,23 @@ struct SymbolDef {
 };
 
 /**
- * @brief Extracts function declarations from a built library using nm command
+ * @brief Extracts function declarations (nm type 'T') from a built library
  * @param path Path to the library file
  * @return Vector of VarDecl representing the function symbols found
  */
 auto getBuiltFileDecls(const std::string &path) -> std::vector<VarDecl>;
 
+/**
+ * @brief Símbolos definidos em .dynsym, lidos em processo (ElfDynamicSymbols)
+ */
 auto getAllBuiltFileDecls(const std::string &path) -> std::vector<SymbolDef>;
 
+/**
+ * @brief Mesmo resultado via "nm -D --defined-only" (fallback e referência
+ * para benchmarks)
+ */
+auto getAllBuiltFileDeclsNm(const std::string &path) -> std::vector<SymbolDef>;
+
 /**
  * @brief Gets the start address of a library in memory
  * @param library_name Path to the library file
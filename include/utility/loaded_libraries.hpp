@@ -0,0 +1,94 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace utility {
+
+/**
+ * @brief Registro em processo das bibliotecas carregadas
+ *
+ * Substitui a leitura de /proc/self/maps: cada dlopen do REPL registra o
+ * handle (dlinfo RTLD_DI_LINKMAP) e o dlclose remove a entrada. Buscas de
+ * base e de símbolo são consultas em tabelas hash; o caminho consultado é
+ * associado ao arquivo por dispositivo/inode (como filesystem::equivalent)
+ * só na primeira vez.
+ *
+ * Se a biblioteca não estiver registrada (ex.: trampoline chamado por um
+ * construtor antes de o dlopen retornar), a tabela é reconstruída uma vez
+ * via dl_iterate_phdr.
+ */
+class LoadedLibraries {
+  public:
+    /**
+     * @brief Registra a biblioteca de um handle do dlopen
+     */
+    void registerHandle(void *handle);
+
+    /**
+     * @brief Remove a biblioteca do handle; chamar antes do dlclose
+     */
+    void unregisterHandle(void *handle);
+
+    /**
+     * @brief Reconstrói a tabela com tudo que está carregado agora
+     */
+    void refresh();
+
+    /**
+     * @brief Endereço de carga (l_addr) da biblioteca
+     */
+    std::optional<uintptr_t> baseAddress(std::string_view path);
+
+    /**
+     * @brief Endereço em memória de um símbolo de .dynsym da biblioteca
+     */
+    std::optional<uintptr_t> symbolAddress(std::string_view path,
+                                           std::string_view symbol);
+
+    size_t size() const;
+
+  private:
+    struct FileId {
+        uint64_t dev = 0;
+        uint64_t ino = 0;
+        bool operator==(const FileId &) const = default;
+    };
+
+    struct FileIdHash {
+        size_t operator()(const FileId &id) const {
+            return std::hash<uint64_t>{}(id.dev * 0x9e3779b97f4a7c15ULL ^
+                                         id.ino);
+        }
+    };
+
+    struct Entry {
+        std::string path;
+        uintptr_t base = 0;
+        // Offsets de símbolos já resolvidos (st_value)
+        std::unordered_map<std::string, uintptr_t> symbols;
+    };
+
+    static std::optional<FileId> fileIdOf(const char *path);
+
+    std::shared_ptr<Entry> lookup(std::string_view path);
+    std::shared_ptr<Entry> lookupLocked(std::string_view path) const;
+
+    mutable std::shared_mutex mutex_;
+    std::unordered_map<FileId, std::shared_ptr<Entry>, FileIdHash> entries_;
+    std::unordered_map<void *, FileId> handles_;
+    // Caminho como consultado -> arquivo
+    std::unordered_map<std::string, FileId> aliases_;
+};
+
+/**
+ * @brief Instância usada pelo REPL
+ */
+LoadedLibraries &loadedLibraries();
+
+} // namespace utility
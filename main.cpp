@@ -1,5 +1,6 @@
 #include "stdafx.hpp"
 
+#include "analysis/input_classifier.hpp"
 #include "repl.hpp"
 #include "utility/assembly_info.hpp"
 #include "utility/eval_scope_exit.hpp"
@@ -16,40 +17,10 @@
 #include <ucontext.h>
 #include <unistd.h>
 
-#include "utility/file_raii.hpp"
+#include "execution/process_launcher.hpp"
 
 using namespace std;
 
-// Funções auxiliares para processamento multilinha
-int countChar(const std::string &str, char c) {
-    return std::count(str.begin(), str.end(), c);
-}
-
-bool isMultilineStart(const std::string &line) {
-    // Remove espaços e verifica patterns que tipicamente iniciam blocos
-    // multilinhas
-    std::string trimmed = line;
-    trimmed.erase(0, trimmed.find_first_not_of(" \t"));
-
-    // Patterns que indicam início de definição multilinha
-    return trimmed.starts_with("class ") || trimmed.starts_with("struct ") ||
-           trimmed.starts_with("enum ") || trimmed.starts_with("namespace ") ||
-           trimmed.starts_with("template") ||
-           (trimmed.find('{') != std::string::npos &&
-            trimmed.find('}') == std::string::npos) ||
-           (trimmed.find('(') != std::string::npos &&
-            countChar(trimmed, '(') > countChar(trimmed, ')'));
-}
-
-bool isCompleteStatement(const std::string &line) {
-    // Verifica se é uma declaração completa em uma linha
-    return line.ends_with(";") || line.ends_with("}") ||
-           (countChar(line, '{') > 0 &&
-            countChar(line, '{') == countChar(line, '}')) ||
-           (countChar(line, '(') > 0 &&
-            countChar(line, '(') == countChar(line, ')'));
-}
-
 void showVersion() {
     std::cout << std::format(
         "C++ REPL v1.0.0 - Interactive C++ Development Environment\n");
@@ -71,6 +42,9 @@ void showUsage(const char *programName) {
     std::cout << "  -s, --safe              Enable signal handlers for crash "
                  "protection\n";
     std::cout << "  -r, --run FILE          Execute REPL commands from file\n";
+    std::cout << "  -b, --batch             Compile consecutive declarations/"
+                 "statements of\n"
+                 "                          a script (or paste) as one unit\n";
     std::cout << "  -v, --verbose           Increase verbosity level (can be "
                  "repeated: -vvv)\n";
     std::cout << "  -q, --quiet             Suppress all non-error output\n\n";
@@ -147,18 +121,11 @@ void segfaultHandler(int sig) {
     }
 
     // get line from addr
-    std::string cmd = std::format(
-        "addr2line -e {} {:p}", info.dli_fname,
-        reinterpret_cast<void *>((char *)addr - (char *)info.dli_fbase));
-    auto fp = utility::make_popen(cmd.c_str(), "r");
-    if (fp) {
-        char *line = nullptr;
-        size_t len = 0;
-        ssize_t read;
-        while ((read = getline(&line, &len, fp.get())) != -1) {
-            message += line;
-        }
-    }
+    auto addr2line = execution::runProcess(
+        {"addr2line", "-e", info.dli_fname,
+         std::format("{:p}", reinterpret_cast<void *>((char *)addr -
+                                                      (char *)info.dli_fbase))});
+    message += addr2line.out();
 
     // printf("addr: %p  base: %p %d %p\n", addr, info.dli_fbase, getpid(),
     // (void*)((char*)addr - (char*)info.dli_fbase));
@@ -168,20 +135,15 @@ void segfaultHandler(int sig) {
         static_cast<uintptr_t>((char *)addr - (char *)info.dli_fbase));
 
     // get instruction
-    std::string instrCmd = std::format(
-        "objdump -d {} -j .text -l --start-address={:p} --stop-address={:p}",
-        info.dli_fname,
-        reinterpret_cast<void *>((char *)addr - (char *)info.dli_fbase),
-        reinterpret_cast<void *>((char *)addr - (char *)info.dli_fbase + 1));
-    auto fp2 = utility::make_popen(instrCmd.c_str(), "r");
-    if (fp2) {
-        char *line = nullptr;
-        size_t len = 0;
-        ssize_t read;
-        while ((read = getline(&line, &len, fp2.get())) != -1) {
-            message += line;
-        }
-    }
+    auto objdump = execution::runProcess(
+        {"objdump", "-d", info.dli_fname, "-j", ".text", "-l",
+         std::format("--start-address={:p}",
+                     reinterpret_cast<void *>((char *)addr -
+                                              (char *)info.dli_fbase)),
+         std::format("--stop-address={:p}",
+                     reinterpret_cast<void *>((char *)addr -
+                                              (char *)info.dli_fbase + 1))});
+    message += objdump.out();
 
     class uniqueptr_free {
       public:
@@ -233,13 +195,14 @@ int main(int argc, char **argv) {
                                            {"version", no_argument, 0, 'V'},
                                            {"safe", no_argument, 0, 's'},
                                            {"run", required_argument, 0, 'r'},
+                                           {"batch", no_argument, 0, 'b'},
                                            {"verbose", no_argument, 0, 'v'},
                                            {"quiet", no_argument, 0, 'q'},
                                            {0, 0, 0, 0}};
 
     int c;
     int option_index = 0;
-    while ((c = getopt_long(argc, argv, "hVsqr:v", long_options,
+    while ((c = getopt_long(argc, argv, "hVsqr:vb", long_options,
                             &option_index)) != -1) {
         switch (c) {
         case 'h': {
@@ -260,6 +223,9 @@ int main(int argc, char **argv) {
         case 'r': {
             scriptFile = optarg;
         } break;
+        case 'b': {
+            set_batch_mode(true);
+        } break;
         case 'v': {
             localVerbosityLevel++;
         } break;
@@ -316,125 +282,66 @@ int main(int argc, char **argv) {
 
         std::string line;
         int lineNumber = 0;
-        std::string currentBlock; // Acumula blocos multilinhas
-        int braceCount = 0;
-        int parenCount = 0;
-        bool insideMultilineBlock = false;
+        // Acumula blocos multilinhas até o tokenizador considerá-los completos
+        analysis::InputAccumulator currentBlock;
+        // Com --batch, blocos consecutivos viram um único TU
+        ReplBatchRunner runner(scriptFile);
 
         try {
             while (std::getline(file, line)) {
                 lineNumber++;
 
                 // Skip empty lines and comments only if not inside a block
-                if (!insideMultilineBlock &&
+                if (currentBlock.empty() &&
                     (line.empty() || line.starts_with("//"))) {
                     continue;
                 }
 
-                // Processar linha atual
-                std::string trimmedLine = line;
-                // Remove espaços no início e fim
-                trimmedLine.erase(0, trimmedLine.find_first_not_of(" \t"));
-                trimmedLine.erase(trimmedLine.find_last_not_of(" \t") + 1);
-
-                // Detectar início de bloco multilinha
-                if (!insideMultilineBlock) {
-                    // Verifica se é início de definição multilinha
-                    if (isMultilineStart(trimmedLine)) {
-                        insideMultilineBlock = true;
-                        currentBlock = line;
-                        braceCount =
-                            countChar(line, '{') - countChar(line, '}');
-                        parenCount =
-                            countChar(line, '(') - countChar(line, ')');
-
-                        if (localVerbosityLevel >= 3) {
-                            std::cout << std::format(
-                                "🔄 Starting multiline block at line {}\n",
-                                lineNumber);
-                        }
-
-                        // Se a linha já está balanceada, processa imediatamente
-                        if (braceCount == 0 && parenCount == 0 &&
-                            isCompleteStatement(trimmedLine)) {
-                            insideMultilineBlock = false;
-
-                            if (localVerbosityLevel >= 2) {
-                                std::cout << std::format(
-                                    ":{}: {}\n", lineNumber, currentBlock);
-                            }
-
-                            if (!extExecRepl(currentBlock)) {
-                                if (localVerbosityLevel >= 1) {
-                                    std::cout
-                                        << std::format("📋 Script execution "
-                                                       "completed at line {}\n",
-                                                       lineNumber);
-                                }
-                                break;
-                            }
-                            currentBlock.clear();
-                        }
-                        continue;
+                currentBlock.append(line);
+                if (!currentBlock.complete()) {
+                    if (currentBlock.lines() == 1 && localVerbosityLevel >= 3) {
+                        std::cout << std::format(
+                            "🔄 Starting multiline block at line {}\n",
+                            lineNumber);
                     }
+                    continue;
                 }
 
-                if (insideMultilineBlock) {
-                    // Continua acumulando o bloco
-                    currentBlock += "\n" + line;
-                    braceCount += countChar(line, '{') - countChar(line, '}');
-                    parenCount += countChar(line, '(') - countChar(line, ')');
-
-                    // Verifica se o bloco está completo
-                    if (braceCount <= 0 && parenCount <= 0) {
-                        insideMultilineBlock = false;
-
-                        if (localVerbosityLevel >= 2) {
-                            std::cout << std::format(
-                                ":{}-{}: {}\n",
-                                lineNumber - std::count(currentBlock.begin(),
-                                                        currentBlock.end(),
-                                                        '\n'),
-                                lineNumber, currentBlock);
-                        }
-
-                        if (!extExecRepl(currentBlock)) {
-                            if (localVerbosityLevel >= 1) {
-                                std::cout
-                                    << std::format("📋 Script execution "
-                                                   "completed at line {}\n",
-                                                   lineNumber);
-                            }
-                            break;
-                        }
-                        currentBlock.clear();
-                        braceCount = 0;
-                        parenCount = 0;
-                    }
-                } else {
-                    // Linha simples - processa normalmente
-                    if (localVerbosityLevel >= 2) {
-                        std::cout << std::format(":{}: {}\n", lineNumber, line);
+                const size_t blockLines = currentBlock.lines();
+                const std::string block = currentBlock.take();
+
+                if (localVerbosityLevel >= 2) {
+                    if (blockLines > 1) {
+                        std::cout << std::format(
+                            ":{}-{}: {}\n", lineNumber - blockLines + 1,
+                            lineNumber, block);
+                    } else {
+                        std::cout
+                            << std::format(":{}: {}\n", lineNumber, block);
                     }
+                }
 
-                    if (!extExecRepl(line)) {
-                        if (localVerbosityLevel >= 1) {
-                            std::cout << std::format(
-                                "📋 Script execution completed at line {}\n",
-                                lineNumber);
-                        }
-                        break;
+                const int64_t firstLine =
+                    lineNumber - static_cast<int64_t>(blockLines) + 1;
+                if (!runner.feed(block, firstLine)) {
+                    if (localVerbosityLevel >= 1) {
+                        std::cout << std::format(
+                            "📋 Script execution completed at line {}\n",
+                            lineNumber);
                     }
+                    break;
                 }
             }
 
+            runner.flush();
+
             // Se saiu do loop mas ainda tinha um bloco incompleto
-            if (insideMultilineBlock && !currentBlock.empty()) {
+            if (!currentBlock.empty()) {
                 if (localVerbosityLevel >= 1) {
                     std::cout << std::format("⚠️  Warning: Incomplete multiline "
                                              "block at end of script\n");
-                    std::cout
-                        << std::format("🔍 Block content:\n{}\n", currentBlock);
+                    std::cout << std::format("🔍 Block content:\n{}\n",
+                                             currentBlock.text());
                 }
             }
 
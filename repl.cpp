@@ -6,18 +6,29 @@
 #include "analysis/ast_analyzer.hpp"
 #include "analysis/ast_context.hpp"
 #include "analysis/clang_ast_adapter.hpp"
+#include "analysis/input_classifier.hpp"
+#include "compiler/artifact_cache.hpp"
+#include "compiler/pch_store.hpp"
 #include "compiler/compiler_service.hpp"
 #include "completion/simple_readline_completion.hpp"
+#include "execution/cancellation.hpp"
 #include "execution/execution_engine.hpp"
+#include "execution/memory_artifacts.hpp"
+#include "execution/process_launcher.hpp"
+#include "execution/speculative_compiler.hpp"
 #include "execution/symbol_resolver.hpp"
+#include "execution/task_scheduler.hpp"
+#include "execution/workspace.hpp"
 #include "repl.hpp"
 #include "simdjson.h"
 #include "utility/Strutils.hpp"
 #include "utility/assembly_info.hpp"
 #include "utility/file_raii.hpp"
 #include "utility/library_introspection.hpp"
+#include "utility/loaded_libraries.hpp"
 #include "utility/quote.hpp"
 #include "utility/system_exec.hpp"
+#include "utility/thread_priority.hpp"
 #include <algorithm>
 #include <chrono>
 #include <cstddef>
@@ -38,6 +49,7 @@
 #include <libnotify/notify.h>
 #endif
 #include <mutex>
+#include <optional>
 #include <readline/history.h>
 #include <readline/readline.h>
 #include <regex>
@@ -73,18 +85,10 @@ static std::string_view trim(const std::string_view str) noexcept {
 }
 
 // Callback para merge de variáveis no CompilerService
-static void mergeVarsCallback(const std::vector<VarDecl> &vars) {
-    for (const auto &var : vars) {
-        if (replState.varsNames.find(var.name) == replState.varsNames.end()) {
-            replState.varsNames.insert(var.name);
-            replState.allTheVariables.push_back(var);
-        }
-    }
+void mergeVars(const std::vector<VarDecl> &vars);
 
-    // Atualizar completion com novo contexto
-    if (completionScope) {
-        completionScope->updateContext(replState);
-    }
+static void mergeVarsCallback(const std::vector<VarDecl> &vars) {
+    mergeVars(vars);
 }
 
 // Instância global do CompilerService
@@ -239,6 +243,26 @@ static void initCompilerService() {
             nullptr, // AstContext será definido quando necessário
             mergeVarsCallback);
         detectLldVersionAndSetFuseLd();
+
+        if (const char *env = std::getenv("CPPREPL_CACHE");
+            !env || std::string_view(env) != "0") {
+            set_artifact_cache_enabled(true);
+        }
+
+        // PCHs reaproveitados entre sessões e conjuntos de includes
+        if (const char *env = std::getenv("CPPREPL_PCH_STORE");
+            !env || std::string_view(env) != "0") {
+            std::error_code ec;
+            auto root = compiler::PchStore::defaultRoot();
+            std::filesystem::create_directories(root, ec);
+            if (!ec) {
+                compilerService->setPchStore(
+                    std::make_shared<compiler::PchStore>(root));
+            } else if (verbosityLevel >= 1) {
+                std::cerr << std::format("⚠️  PCH store disabled: {} ({})\n",
+                                         root.string(), ec.message());
+            }
+        }
     }
 }
 
@@ -333,53 +357,60 @@ int build_precompiledheader(
 
 // moved into replState
 
-bool printVarsFilePrepare(const std::string &filename,
-                          const std::vector<VarDecl> &vars) {
-    std::fstream printerOutput(filename, std::ios::out | std::ios::trunc);
-
-    if (!printerOutput.is_open()) {
+/**
+ * @brief Grava um fonte gerado pelo REPL
+ *
+ * O conteúdo vai para um memfd (modo diskless) ou para o workspace da
+ * sessão; o compilador recebe o caminho via execution::artifactPath.
+ */
+static bool writeGeneratedSource(const std::string &filename,
+                                 std::string_view content) {
+    if (!execution::writeArtifact(filename, content)) {
         std::cerr << std::format("Cannot open file for writing: {}\n",
                                  filename);
         return false;
     }
+    return true;
+}
 
-    printerOutput << "#include \"printerOutput.hpp\"\n\n" << std::endl;
-    printerOutput << "#include \"decl_amalgama.hpp\"\n\n" << std::endl;
+bool printVarsFilePrepare(const std::string &filename,
+                          const std::vector<VarDecl> &vars) {
+    std::string printerOutput = "#include \"printerOutput.hpp\"\n\n\n"
+                                "#include \"decl_amalgama.hpp\"\n\n\n";
 
     for (const auto &var : vars) {
-        // std::cout << __LINE__ << var.kind << std::endl;
-        /*std::cout << var.qualType << "   " << var.type << "   " << var.name
-                  << std::endl;*/
         if (var.kind == "VarDecl") {
-            printerOutput << std::format("extern \"C\" void printvar_{}() {{\n",
+            printerOutput += std::format("extern \"C\" void printvar_{}() {{\n",
                                          var.name);
-            printerOutput << std::format("  printdata({}, \"{}\", \"{}\");\n",
+            printerOutput += std::format("  printdata({}, \"{}\", \"{}\");\n",
                                          var.name, var.name, var.qualType);
-            printerOutput << "}\n";
+            printerOutput += "}\n";
         }
     }
 
-    printerOutput << "void printall() {\n";
+    printerOutput += "void printall() {\n";
 
     for (const auto &var : vars) {
-        // std::cout << __LINE__ << var.kind << std::endl;
         if (var.kind == "VarDecl") {
-            printerOutput << std::format("printdata({}, \"{}\", \"{}\");\n",
+            printerOutput += std::format("printdata({}, \"{}\", \"{}\");\n",
                                          var.name, var.name, var.qualType);
         }
     }
 
-    printerOutput << "}\n";
-
-    printerOutput.close();
+    printerOutput += "}\n";
 
-    return true;
+    return writeGeneratedSource(filename, printerOutput);
 }
 
 int buildPrinterOutputLib(const std::string &name) {
-    int buildLibRes = onlyBuildLib("clang++", name, ".cpp", "gnu++20",
-                                   buildSettings.getExtraLinkerFlags(),
-                                   "-include printerOutput.hpp");
+    // Depois de um #return, printerOutput.hpp está nas camadas do PCH: o
+    // topo cobre o printer e o decl_amalgama.hpp. Antes disso, o PCH próprio
+    // do printer (o decl_amalgama.hpp é lido como texto)
+    const bool layered = analysis::AstContext::getIncludedFiles().contains(
+        "printerOutput.hpp");
+    int buildLibRes = onlyBuildLib(
+        "clang++", name, ".cpp", "gnu++20", buildSettings.getExtraLinkerFlags(),
+        layered ? std::string_view{} : "-include printerOutput.hpp");
 
     if (buildLibRes != 0) {
         std::cerr << std::format("buildLibRes != 0: {}\n", name);
@@ -391,8 +422,9 @@ int buildPrinterOutputLib(const std::string &name) {
 
 void *loadPrinterForVars(const std::string &name,
                          const std::vector<VarDecl> &vars) {
-    void *handlep =
-        dlopen(std::format("./lib{}.so", name).c_str(), RTLD_NOW | RTLD_GLOBAL);
+    const auto libraryPath =
+        execution::artifactPath(std::format("./lib{}.so", name));
+    void *handlep = dlopen(libraryPath.c_str(), RTLD_NOW | RTLD_GLOBAL);
     if (!handlep) {
         std::cerr << std::format("Cannot open library: {}\n", dlerror());
         return handlep;
@@ -407,11 +439,19 @@ void *loadPrinterForVars(const std::string &name,
                 std::cerr << std::format(
                     "Cannot load symbol 'printvar_{}': {}\n", var.name,
                     dlerror());
+                utility::loadedLibraries().unregisterHandle(handlep);
                 dlclose(handlep);
                 return handlep;
             }
 
             replState.varPrinterAddresses[var.name] = printvar;
+
+            // A completion lê só o SymbolIndex: todo nome com printer
+            // precisa estar nele
+            auto &symbols = execution::getGlobalExecutionState().symbols;
+            if (!symbols.containsName(var.name)) {
+                symbols.add(var, replCounter);
+            }
         }
     }
 
@@ -429,6 +469,7 @@ std::string prepareAndSavePrinterOutput(const std::vector<VarDecl> &vars) {
     printVarsFilePrepare(std::format("{}.cpp", name), vars);
 
     int buildLibRes = buildPrinterOutputLib(name);
+    execution::MemoryArtifacts::instance().releaseStem(name);
 
     if (buildLibRes != 0) {
         return "";
@@ -442,25 +483,22 @@ void savePrintAllVarsLibrary(const std::vector<VarDecl> &vars) {
         return;
     }
 
-    std::fstream printerOutput("printerOutput.cpp",
-                               std::ios::out | std::ios::trunc);
-
-    printerOutput << "#include \"printerOutput.hpp\"\n\n" << std::endl;
-    printerOutput << "#include \"decl_amalgama.hpp\"\n\n" << std::endl;
-
-    printerOutput << "void printall() {\n";
+    std::string printerOutput = "#include \"printerOutput.hpp\"\n\n\n"
+                                "#include \"decl_amalgama.hpp\"\n\n\n"
+                                "void printall() {\n";
 
     for (const auto &var : vars) {
-        // std::cout << __LINE__ << var.kind << std::endl;
         if (var.kind == "VarDecl") {
-            printerOutput << std::format("printdata({}, \"{}\", \"{}\");\n",
+            printerOutput += std::format("printdata({}, \"{}\", \"{}\");\n",
                                          var.name, var.name, var.qualType);
         }
     }
 
-    printerOutput << "}\n";
+    printerOutput += "}\n";
 
-    printerOutput.close();
+    if (!writeGeneratedSource("printerOutput.cpp", printerOutput)) {
+        return;
+    }
 
     onlyBuildLib("clang++", "printerOutput");
 }
@@ -473,11 +511,9 @@ struct wrapperFn {
 // MOVED: fnNames moved to execution::GlobalExecutionState
 
 void mergeVars(const std::vector<VarDecl> &vars) {
+    auto &symbols = execution::getGlobalExecutionState().symbols;
     for (const auto &var : vars) {
-        if (replState.varsNames.find(var.name) == replState.varsNames.end()) {
-            replState.varsNames.insert(var.name);
-            replState.allTheVariables.push_back(var);
-        }
+        symbols.add(var, replCounter);
     }
 
     // Atualizar completion
@@ -506,18 +542,21 @@ auto analyzeCustomCommands(
         std::string purefilename = path.filename().string();
         purefilename = purefilename.substr(0, purefilename.find_last_of('.'));
 
-        std::string logname = std::format("{}.log", purefilename);
+        std::string logname =
+            execution::newArtifactPath(std::format("{}.log", purefilename),
+                                       false);
         std::string cmd = namecmd.second;
 
         // Adiciona flags padrão se necessário
         if ((namecmd.second.find("-std=gnu++20") != std::string::npos ||
              namecmd.second.find("-std=") == std::string::npos) &&
             namecmd.second.find("-fvisibility=hidden") == std::string::npos) {
-            cmd += " -std=gnu++20 -include precompiledheader.hpp";
+            cmd += " -std=gnu++20 " + compilerService->pchIncludeFlags();
         }
 
         // Adiciona flags para análise AST e redirecionamento para JSON
-        std::string jsonFile = std::format("{}_ast.json", purefilename);
+        std::string jsonFile = execution::newArtifactPath(
+            std::format("{}_ast.json", purefilename), false);
         cmd += " -Xclang -ast-dump=json -fsyntax-only";
         cmd += std::format(" 2>{} > {}", logname, jsonFile);
 
@@ -590,7 +629,8 @@ auto buildLibAndDumpASTWithoutPrint(std::string compiler,
 }
 
 int runPrintAll() {
-    void *handlep = dlopen("./libprinterOutput.so", RTLD_NOW | RTLD_GLOBAL);
+    const auto libraryPath = execution::artifactPath("./libprinterOutput.so");
+    void *handlep = dlopen(libraryPath.c_str(), RTLD_NOW | RTLD_GLOBAL);
     if (!handlep) {
         std::cerr << std::format("Cannot open library: {}\n", dlerror());
         return EXIT_FAILURE;
@@ -600,12 +640,14 @@ int runPrintAll() {
     if (!printall) {
         std::cerr << std::format("Cannot load symbol 'printall': {}\n",
                                  dlerror());
+        utility::loadedLibraries().unregisterHandle(handlep);
         dlclose(handlep);
         return EXIT_FAILURE;
     }
 
     printall();
 
+    utility::loadedLibraries().unregisterHandle(handlep);
     dlclose(handlep);
 
     return EXIT_SUCCESS;
@@ -634,10 +676,15 @@ bool prepareFunctionWrapper(
     bool wrapperCreated = false;
 
     std::tie(functions, wrapperCreated) =
-        execution::SymbolResolver::prepareFunctionWrapper(
-            name, vars, config, state.existingFunctions);
+        execution::SymbolResolver::prepareFunctionWrapper(name, vars, config,
+                                                          state.symbols);
 
-    state.existingFunctions.insert(functions.begin(), functions.end());
+    for (const auto &var : vars) {
+        if (functions.contains(var.mangledName)) {
+            state.symbols.add(var, replCounter);
+            state.symbols.markWrapped(var.mangledName);
+        }
+    }
     return wrapperCreated;
 }
 
@@ -646,10 +693,19 @@ void fillWrapperPtrs(
     void *handlewp, void *handle) {
 
     // Usar a configuração global persistente
-    auto &config = execution::getGlobalExecutionState().getWrapperConfig();
+    auto &state = execution::getGlobalExecutionState();
+    auto &config = state.getWrapperConfig();
 
     execution::SymbolResolver::fillWrapperPtrs(functions, handlewp, handle,
                                                config);
+
+    for (const auto &[mangledName, _] : functions) {
+        auto it = config.functionWrappers.find(mangledName);
+        if (it != config.functionWrappers.end() && it->second.fnptr) {
+            state.symbols.setAddress(
+                mangledName, reinterpret_cast<uintptr_t>(it->second.fnptr));
+        }
+    }
 }
 
 // moved into replState
@@ -699,20 +755,33 @@ auto prepareWrapperAndLoadCodeLib(const CompilerCodeCfg &cfg,
     -> EvalResult {
     std::unordered_map<std::string, std::string> functions;
 
-    auto asyncPrepare = std::async(std::launch::async, [&]() {
-        // Preparar print functions em background
-        return prepareAndSavePrinterOutput(vars);
-    });
+    // Os builds do printer e do wrapper também respondem ao Ctrl-C
+    std::optional<execution::EvalCancellationScope> buildScope(std::in_place);
+
+    // DAG do eval: o printer compila em paralelo com wrapper + dlopen; o
+    // printer carrega em paralelo com o exec e só a impressão espera por ele
+    std::string printerName;
+    execution::TaskGroup printerStage;
+    printerStage.run(
+        [&] { printerName = prepareAndSavePrinterOutput(vars); });
 
     bool wrapperCreated =
         prepareFunctionWrapper(cfg.repl_name, vars, functions);
 
+    if (buildScope->cancelled()) {
+        printerStage.wait();
+        std::cout << "⚠️  Build interrupted\n";
+        EvalResult result;
+        result.success = false;
+        return result;
+    }
+
     void *handlewp = nullptr;
 
     if (!functions.empty() && wrapperCreated) {
-        handlewp =
-            dlopen(std::format("./libwrapper_{}.so", cfg.repl_name).c_str(),
-                   RTLD_NOW | RTLD_GLOBAL);
+        handlewp = execution::SymbolResolver::openWrapperLibrary(
+            cfg.repl_name,
+            execution::getGlobalExecutionState().getWrapperConfig());
 
         if (!handlewp) {
             std::cerr << std::format("Cannot wrapper library: {}\n", dlerror());
@@ -729,7 +798,8 @@ auto prepareWrapperAndLoadCodeLib(const CompilerCodeCfg &cfg,
 
     auto load_start = std::chrono::steady_clock::now();
 
-    auto libraryPath = std::format("./lib{}.so", cfg.repl_name);
+    auto libraryPath =
+        execution::artifactPath(std::format("./lib{}.so", cfg.repl_name));
     execution::getGlobalExecutionState().setLastLibrary(libraryPath);
 
     resolveSymbolOffsetsFromLib(functions, symbols);
@@ -748,9 +818,15 @@ auto prepareWrapperAndLoadCodeLib(const CompilerCodeCfg &cfg,
         result.success = false;
         return result;
     }
+    utility::loadedLibraries().registerHandle(handle);
 
     execution::getGlobalExecutionState().clearSymbolsToResolve();
 
+    for (const auto &var : vars) {
+        execution::getGlobalExecutionState().symbols.add(var, replCounter,
+                                                         libraryPath);
+    }
+
     auto load_end = std::chrono::steady_clock::now();
 
     std::cout << "load time: "
@@ -758,29 +834,23 @@ auto prepareWrapperAndLoadCodeLib(const CompilerCodeCfg &cfg,
                      load_end - load_start)
                      .count()
               << "us" << std::endl;
-    auto printerName = asyncPrepare.get();
+    printerStage.wait();
+    buildScope.reset();
 
     auto eval = [functions = std::move(functions), handlewp = handlewp,
                  handle = handle, vars = std::move(vars),
                  printerName = std::move(printerName)]() mutable {
-        auto asyncFill = std::async(std::launch::async, [&]() {
-            // Preencher ponteiros de funções wrapper em background
-            fillWrapperPtrs(functions, handlewp, handle);
-        });
-
-        auto loadPrinter = std::async(std::launch::async, [&]() {
-            // Carregar biblioteca de print em background
-            if (printerName.empty()) {
-                return;
-            }
-            auto handlep = loadPrinterForVars(printerName, vars);
-            if (!handlep) {
-                std::cerr << "Failed to load printer library\n";
-            }
-        });
+        execution::TaskGroup printerLoad;
+        if (!printerName.empty()) {
+            printerLoad.run([&] {
+                if (!loadPrinterForVars(printerName, vars)) {
+                    std::cerr << "Failed to load printer library\n";
+                }
+            });
+        }
 
-        asyncFill.get();
-        loadPrinter.get();
+        // O exec depende só dos ponteiros dos wrappers
+        fillWrapperPtrs(functions, handlewp, handle);
 
         void (*execv)() = (void (*)())dlsym(handle, "_Z4execv");
         if (execv || (execv = (void (*)())dlsym(handle, "exec"))) {
@@ -830,6 +900,8 @@ auto prepareWrapperAndLoadCodeLib(const CompilerCodeCfg &cfg,
                       << "us" << std::endl;
         }
 
+        printerLoad.wait();
+
         for (const auto &var : vars) {
             if (var.kind != "VarDecl") {
                 continue;
@@ -885,8 +957,8 @@ bool loadPrebuilt(const std::string &path) {
     void *handlewp = nullptr;
 
     if (!functions.empty()) {
-        handlewp = dlopen(std::format("./libwrapper_{}.so", filename).c_str(),
-                          RTLD_NOW | RTLD_GLOBAL);
+        handlewp = execution::SymbolResolver::openWrapperLibrary(
+            filename, execution::getGlobalExecutionState().getWrapperConfig());
 
         if (!handlewp) {
             std::cerr << std::format("Cannot wrapper library: {}\n", dlerror());
@@ -902,11 +974,16 @@ bool loadPrebuilt(const std::string &path) {
         // g++  -Wl,--whole-archive base64.cc.o -Wl,--no-whole-archive -shared
         // -o teste.o
         library = std::format("./{}.so", filename);
-        std::string cmd = std::format(
-            "g++ -Wl,--whole-archive {} -Wl,--no-whole-archive -shared -o {}",
-            path, library);
-        std::cout << cmd << std::endl;
-        system(cmd.c_str());
+        const std::vector<std::string> argv{
+            "g++",    "-Wl,--whole-archive", path, "-Wl,--no-whole-archive",
+            "-shared", "-o",                 library};
+        std::string shown;
+        for (const auto &arg : argv) {
+            shown += shown.empty() ? "" : " ";
+            shown += arg;
+        }
+        std::cout << shown << std::endl;
+        execution::runProcess(argv, {.out = execution::Stream::Inherit});
     }
 
     auto load_start = std::chrono::steady_clock::now();
@@ -923,6 +1000,7 @@ bool loadPrebuilt(const std::string &path) {
                   << " Cannot open library: " << dlerror() << '\n';
         return false;
     }
+    utility::loadedLibraries().registerHandle(handle);
 
     execution::getGlobalExecutionState().clearSymbolsToResolve();
 
@@ -945,18 +1023,47 @@ auto compileAndRunCode(CompilerCodeCfg &&cfg) -> EvalResult {
 
     auto now = std::chrono::steady_clock::now();
 
-    if (cfg.sourcesList.empty()) {
-        if (cfg.analyze) {
-            std::tie(vars, returnCode) = buildLibAndDumpASTWithoutPrint(
-                cfg.compiler, cfg.repl_name,
-                {std::format("{}.cpp", cfg.repl_name)}, cfg.std);
+    auto build = [&] {
+        if (cfg.sourcesList.empty()) {
+            if (cfg.analyze) {
+                std::tie(vars, returnCode) = buildLibAndDumpASTWithoutPrint(
+                    cfg.compiler, cfg.repl_name,
+                    {std::format("{}.cpp", cfg.repl_name)}, cfg.std);
+            } else {
+                returnCode = onlyBuildLib(cfg.compiler, cfg.repl_name,
+                                          "." + cfg.extension, cfg.std);
+            }
         } else {
-            onlyBuildLib(cfg.compiler, cfg.repl_name, "." + cfg.extension,
-                         cfg.std);
+            std::tie(vars, returnCode) = buildLibAndDumpASTWithoutPrint(
+                cfg.compiler, cfg.repl_name, cfg.sourcesList, cfg.std);
         }
-    } else {
-        std::tie(vars, returnCode) = buildLibAndDumpASTWithoutPrint(
-            cfg.compiler, cfg.repl_name, cfg.sourcesList, cfg.std);
+    };
+
+    // Ctrl-C durante o build cancela os jobs do compilador em vez de lançar
+    // exceção no meio deles
+    bool interrupted = false;
+    if (!cfg.prebuilt) {
+        execution::EvalCancellationScope buildScope;
+        build();
+
+        // O código pode depender de um header que só entra no PCH novo:
+        // espera o rebuild em andamento e tenta mais uma vez
+        if (returnCode != 0 && !buildScope.cancelled() &&
+            pch_rebuild_in_flight()) {
+            std::cout << "⏳ Waiting for precompiled header rebuild and "
+                         "retrying...\n";
+            wait_for_pch_rebuild_if_running();
+            vars.clear();
+            returnCode = 0;
+            build();
+        }
+        interrupted = buildScope.cancelled();
+    }
+
+    if (interrupted) {
+        // Não é erro do PCH: não força o rebuild
+        std::cout << "⚠️  Build interrupted\n";
+        return {};
     }
 
     if (returnCode != 0) {
@@ -966,17 +1073,23 @@ auto compileAndRunCode(CompilerCodeCfg &&cfg) -> EvalResult {
 
     auto end = std::chrono::steady_clock::now();
 
-    auto alldecls =
-        utility::getAllBuiltFileDecls(std::format("./lib{}.so", cfg.repl_name));
+    auto alldecls = utility::getAllBuiltFileDecls(
+        execution::artifactPath(std::format("./lib{}.so", cfg.repl_name)));
+
+    // Reserva antes: knownMangled guarda views para as strings de vars
+    vars.reserve(vars.size() + alldecls.size());
+    std::unordered_set<std::string_view> knownMangled;
+    knownMangled.reserve(vars.size());
+    for (const auto &var : vars) {
+        knownMangled.insert(var.mangledName);
+    }
 
     for (const auto &decl : alldecls) {
         if (decl.libSection != 'T') {
             continue;
         }
 
-        if (std::find_if(vars.begin(), vars.end(), [&](const VarDecl &varInst) {
-                return varInst.mangledName == decl.nativeName;
-            }) == vars.end()) {
+        if (!knownMangled.contains(decl.nativeName)) {
             VarDecl var{.name = decl.nativeName,
                         .mangledName = decl.nativeName,
                         .kind = "FunctionDecl"};
@@ -1002,125 +1115,227 @@ auto compileAndRunCode(CompilerCodeCfg &&cfg) -> EvalResult {
                                         std::move(alldecls));
 }
 
-// Função para identificar se o código é uma definição ou código executável
-bool isDefinitionCode(const std::string &code) {
-    // Remove comentários e espaços em branco para análise
-    std::string trimmed = code;
-
-    // Remove comentários de linha
-    size_t pos = 0;
-    while ((pos = trimmed.find("//", pos)) != std::string::npos) {
-        size_t end = trimmed.find('\n', pos);
-        if (end == std::string::npos)
-            end = trimmed.length();
-        trimmed.erase(pos, end - pos);
-    }
-
-    // Remove comentários de bloco
-    pos = 0;
-    while ((pos = trimmed.find("/*", pos)) != std::string::npos) {
-        size_t end = trimmed.find("*/", pos + 2);
-        if (end == std::string::npos)
-            break;
-        trimmed.erase(pos, end + 2 - pos);
+// moved into replState
+
+/**
+ * @brief Dispara o rebuild pendente do PCH
+ *
+ * Em segundo plano (com prioridade rebaixada) quando #pchasync está ligado,
+ * síncrono caso contrário. Não faz nada se já há um rebuild em andamento: o
+ * flag continua marcado e o próximo comando tenta de novo.
+ */
+static void schedulePchRebuild(bool background = true) {
+    if (!replState.shouldRecompilePrecompiledHeader ||
+        replState.pchRebuildFuture.valid()) {
+        return;
     }
 
-    // Remove espaços em branco extras
-    trimmed = std::regex_replace(trimmed, std::regex(R"(\s+)"), " ");
-    trimmed = std::regex_replace(trimmed, std::regex(R"(^\s+|\s+$)"), "");
+    // O rebuild lê o conjunto de includes ao começar; includes adicionados
+    // depois disso marcam o flag de novo
+    replState.shouldRecompilePrecompiledHeader = false;
+    analysis::AstContext::includesChanged = false;
 
-    if (trimmed.empty())
-        return false;
+    if (!background || !replState.asyncPrecompiledHeaderRebuild) {
+        std::cout << "🔨 Rebuilding precompiled header...\n";
+        if (build_precompiledheader() != 0) {
+            replState.shouldRecompilePrecompiledHeader = true;
+            return;
+        }
+        std::cout << "✅ Precompiled header rebuilt successfully\n";
+        return;
+    }
 
-    // Patterns para definições (global scope)
-    std::vector<std::regex> definitionPatterns = {
-        // Declarações de classe/struct/enum
-        std::regex(R"(^\s*(class|struct|enum|union)\s+\w+)"),
-        std::regex(R"(^\s*(template\s*<[^>]*>\s*)?(class|struct)\s+\w+)"),
-
-        // Declarações de namespace
-        std::regex(R"(^\s*namespace\s+\w+)"),
-        std::regex(R"(^\s*using\s+namespace\s+)"),
-        std::regex(R"(^\s*using\s+\w+\s*=)"),
-
-        // Declarações de função (incluindo templates)
-        std::regex(
-            R"(^\s*(template\s*<[^>]*>\s*)?[\w:]+\s+\w+\s*\([^)]*\)\s*(const\s*)?(noexcept\s*)?(\s*->\s*[\w:]+)?\s*[{;])"),
-
-        // Declarações de variáveis globais (com tipos explícitos)
-        std::regex(
-            R"(^\s*(extern\s+)?(const\s+|constexpr\s+)?(static\s+)?[\w:]+\s+\w+(\s*=.*)?;)"),
-        std::regex(
-            R"(^\s*(auto|int|float|double|char|bool|string|std::[\w:]+)\s+\w+(\s*=.*)?;)"),
-
-        // Typedef e type aliases
-        std::regex(R"(^\s*typedef\s+)"),
-        std::regex(R"(^\s*using\s+\w+\s*=\s*)"),
-
-        // Forward declarations
-        std::regex(R"(^\s*(class|struct|enum)\s+\w+\s*;)"),
-
-        // Preprocessor directives (exceto #eval, #return, etc.)
-        std::regex(
-            R"(^\s*#(define|undef|ifdef|ifndef|if|else|elif|endif|include)\s)"),
-    };
+    try {
+        replState.pchRebuildFuture = std::async(std::launch::async, [] {
+            utility::lowerCurrentThreadPriority();
+            return build_precompiledheader();
+        });
+    } catch (const std::system_error &e) {
+        std::cerr << std::format("❌ Error: Could not start "
+                                 "precompiled header rebuild: {}\n",
+                                 e.what());
+        replState.shouldRecompilePrecompiledHeader = true;
+    } catch (const std::exception &e) {
+        std::cerr << std::format("❌ Error: Exception starting "
+                                 "precompiled header rebuild: {}\n",
+                                 e.what());
+        replState.shouldRecompilePrecompiledHeader = true;
+    } catch (...) {
+        std::cerr << "❌ Error: Unknown error starting precompiled "
+                     "header rebuild\n";
+        replState.shouldRecompilePrecompiledHeader = true;
+    }
+}
 
-    // Verifica se corresponde a algum pattern de definição
-    for (const auto &pattern : definitionPatterns) {
-        if (std::regex_search(trimmed, pattern)) {
-            return true;
-        }
+// Código executável vai para dentro de exec()
+static std::string wrapExecutable(std::string_view code) {
+    return std::format("void exec() {{ {}; }}\n", code);
+}
+
+// Prefixo do fonte gravado por execRepl quando addIncludes está ligado
+static constexpr std::string_view kReplSourcePrefix =
+    "#include \"precompiledheader.hpp\"\n\n"
+    "#include \"decl_amalgama.hpp\"\n\n";
+
+// Linha em que o código começa dentro de replSourceWithIncludes
+static constexpr int64_t kReplSourceFirstLine =
+    std::ranges::count(kReplSourcePrefix, '\n') + 1;
+
+static std::string replSourceWithIncludes(std::string_view code) {
+    return std::format("{}{}\n", kReplSourcePrefix, code);
+}
+
+// Mesma chave do cache de artefatos: fonte, decl_amalgama.hpp, entradas do
+// PCH e flags. O fonte ainda não foi gravado: a chave sai do texto
+static std::string speculationKey(const std::string &source) {
+    return compilerService->artifactKeyForText("clang++", "gnu++20", source);
+}
+
+/**
+ * @brief Estado da digitação no prompt principal, lido pelo rl_event_hook
+ */
+struct SpeculationInput {
+    static constexpr auto kPause = std::chrono::milliseconds(300);
+
+    bool active = false; // só no prompt principal, não na continuação
+    std::string buffer;
+    std::string speculated;
+    std::chrono::steady_clock::time_point lastChange;
+
+    void reset(bool activate) {
+        active = activate;
+        buffer.clear();
+        speculated.clear();
+        lastChange = std::chrono::steady_clock::now();
     }
+};
 
-    // Patterns para código executável (statements)
-    std::vector<std::regex> executablePatterns = {
-        // Chamadas de função simples
-        std::regex(R"(^\s*\w+\s*\([^)]*\)\s*;?\s*$)"),
+static SpeculationInput speculationInput;
 
-        // Expressões de atribuição
-        std::regex(R"(^\s*\w+\s*[+\-*/%&|^]?=)"),
+// Fonte que execRepl geraria para a linha, se ela for código executável
+// simples; declarações mexem no AstContext e ficam de fora
+static std::optional<std::string> speculativeSource(std::string_view line) {
+    line = trim(line);
+    if (line.empty() || line == "exit" || replState.useCpp2 ||
+        replState.shouldRecompilePrecompiledHeader) {
+        return std::nullopt;
+    }
 
-        // Estruturas de controle
-        std::regex(
-            R"(^\s*(if|for|while|do|switch|try|catch|throw|return)\s*[\(\{])"),
+    const auto input = analysis::classifyInput(line);
+    if (!input.complete || !input.isExecutable() ||
+        execution::getGlobalExecutionState().symbols.containsName(
+            std::string(line))) {
+        return std::nullopt;
+    }
+    return replSourceWithIncludes(wrapExecutable(line));
+}
 
-        // Operadores de incremento/decremento
-        std::regex(R"(^\s*(\+\+\w+|\w+\+\+|--\w+|\w+--)\s*;?\s*$)"),
+/**
+ * @brief rl_event_hook: chamado pelo readline enquanto espera uma tecla
+ *
+ * Depois de SpeculationInput::kPause sem mudança no buffer, começa a
+ * compilar a linha em segundo plano.
+ */
+static int speculationHook() {
+    auto &input = speculationInput;
+    auto &speculative = execution::SpeculativeCompiler::instance();
+    if (!input.active || !speculative.enabled()) {
+        return 0;
+    }
 
-        // Expressões cout/printf
-        std::regex(R"(^\s*(std::)?(cout|printf|scanf|cin)\s*[<<>>])"),
+    const std::string_view buffer(rl_line_buffer, rl_end);
+    const auto now = std::chrono::steady_clock::now();
+    if (buffer != input.buffer) {
+        input.buffer = buffer;
+        input.lastChange = now;
+        return 0;
+    }
+    if (now - input.lastChange < SpeculationInput::kPause ||
+        input.buffer == input.speculated) {
+        return 0;
+    }
 
-        // Statements simples sem declaração de tipo
-        std::regex(R"(^\s*\w+(\.\w+|\[\w*\])*\s*[+\-*/%&|^<>=!])")};
+    input.speculated = input.buffer;
+    if (auto source = speculativeSource(input.buffer)) {
+        speculative.speculate(speculationKey(*source), std::move(*source));
+    }
+    return 0;
+}
 
-    // Se corresponde a pattern executável, não é definição
-    for (const auto &pattern : executablePatterns) {
-        if (std::regex_search(trimmed, pattern)) {
-            return false;
+// Caminho rápido para declarações que não geram código: o fonte já escrito
+// em replName.cpp é só validado contra o PCH e o decl_amalgama.hpp atuais.
+// typeName (vazio em static_assert, using namespace...) entra com a mesma
+// chave e no mesmo grafo que a análise completa usaria
+static bool declareTypeOnly(const std::string &line,
+                            const std::string &replName,
+                            const std::string &compiler,
+                            const std::string &typeName) {
+    initCompilerService();
+
+    const auto start = std::chrono::steady_clock::now();
+    compiler::CompilerResult<int> result;
+    {
+        execution::EvalCancellationScope buildScope;
+        result = compilerService->checkSyntax(compiler, replName);
+
+        // Mesmo retry de compileAndRunCode: o tipo pode depender de um
+        // header que só entra no PCH em reconstrução
+        if (!result && !buildScope.cancelled() && pch_rebuild_in_flight()) {
+            wait_for_pch_rebuild_if_running();
+            result = compilerService->checkSyntax(compiler, replName);
         }
     }
+    execution::finishEvalArtifacts(replName);
 
-    // Casos especiais: se contém apenas expressões/statements sem declarações
-    // e não termina em ';' ou '{}', provavelmente é código executável
-    if (!std::regex_search(trimmed, std::regex(R"([;{}]\s*$)")) &&
-        std::regex_search(trimmed,
-                          std::regex(R"(\w+\s*[+\-*/%<>=!]|\w+\s*\()"))) {
+    if (result.error == compiler::CompilerError::Cancelled) {
+        std::cerr << "⚠️  Build interrupted\n";
         return false;
     }
+    if (!result) {
+        if (verbosityLevel >= 1) {
+            std::cout << "❌ Command execution failed\n";
+        }
+        return false;
+    }
+
+    analysis::AstContext context;
+    const auto source = std::format("{}.cpp", replName);
+    std::vector<std::string> provides;
+    if (typeName.empty()) {
+        context.addLineDirective(kReplSourceFirstLine, source);
+        context.addDeclaration(line);
+    } else {
+        // Como ContextualAstAnalyzer::addSourceDefinition: redefinir o tipo
+        // substitui a entrada em vez de acumular
+        context.addEntity(std::format("record:{}", typeName), line,
+                          kReplSourceFirstLine, source);
+        provides.push_back(typeName);
+    }
+    context.saveHeaderToFile("decl_amalgama.hpp");
+    analysis::AstContext::reportStaleSnippets(
+        analysis::AstContext::recordSnippetDependencies(replName, line,
+                                                        std::move(provides)));
 
-    // Se chegou até aqui e não foi identificado como executável,
-    // provavelmente é uma definição
+    if (verbosityLevel >= 1) {
+        std::cout << std::format(
+            "⚡ Declaration-only fast path: {} in {}ms\n", replName,
+            std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::steady_clock::now() - start)
+                .count());
+    }
     return true;
 }
 
-// moved into replState
-
 auto execRepl(std::string_view lineview, int64_t &i) -> bool {
     lineview = trim(lineview);
-    // If a precompiled header rebuild is running asynchronously, wait for it
-    // before starting to process the next command. This ensures commands see
-    // a consistent state.
-    wait_for_pch_rebuild_if_running();
+    // Um rebuild assíncrono do PCH não bloqueia o próximo comando: as
+    // compilações usam o PCH atual até a troca, e compileAndRunCode espera e
+    // tenta de novo só se a compilação falhar com o rebuild em andamento.
+    reap_pch_rebuild_if_done();
+    // Antes de o eval compilar qualquer coisa: troca declarações antigas do
+    // decl_amalgama.hpp pela camada do PCH gerada em segundo plano
+    initCompilerService();
+    compilerService->foldSessionDeclarations();
     std::string line(lineview);
     if (line == "exit") {
         return false;
@@ -1140,98 +1355,72 @@ auto execRepl(std::string_view lineview, int64_t &i) -> bool {
      * If this is multiline, this must be a code block, not just an include
      * directive
      */
-    if (line.starts_with("#include") &&
-        line.find_first_of('\n') == std::string::npos) {
-        std::regex includePattern(R"(#include\s*["<]([^">]+)[">])");
-        std::smatch match;
-
-        if (std::regex_search(line, match, includePattern)) {
-            if (match.size() > 1) {
-                std::string fileName = match[1].str();
-                if (verbosityLevel >= 1) {
-                    std::cout
-                        << std::format("📁 Including file: {}\n", fileName);
-                }
+    const auto include = line.starts_with("#include")
+                             ? analysis::classifyInput(line)
+                             : analysis::InputClassification{};
+    if (include.kind == analysis::InputKind::Include) {
+        if (include.includeTarget.empty()) {
+            std::cerr << "❌ Error: Invalid include syntax. Use: #include "
+                         "<header> or #include \"header\"\n";
+            return true;
+        }
 
-                std::filesystem::path p(fileName);
+        std::string fileName(include.includeTarget);
+        if (verbosityLevel >= 1) {
+            std::cout << std::format("📁 Including file: {}\n", fileName);
+        }
 
-                try {
-                    p = std::filesystem::absolute(
-                        std::filesystem::canonical(p));
+        std::filesystem::path p(fileName);
 
-                    if (verbosityLevel >= 2) {
-                        std::cout << std::format("   → Resolved path: {}\n",
-                                                 p.string());
-                    }
-                } catch (const std::filesystem::filesystem_error &e) {
-                    if (verbosityLevel >= 2) {
-                        std::cout << std::format(
-                            "   ⚠️  Warning: Could not canonicalize path - {}\n",
-                            e.what());
-                    }
+        try {
+            p = std::filesystem::absolute(std::filesystem::canonical(p));
 
-                    if (!compilerService->checkIncludeExists(buildSettings,
-                                                             p.string())) {
-                        std::cerr << std::format(
-                            "❌ Error: Included file does not exist: {}\n",
-                            p.string());
-                        return true;
-                    }
-                }
+            if (verbosityLevel >= 2) {
+                std::cout << std::format("   → Resolved path: {}\n",
+                                         p.string());
+            }
+        } catch (const std::filesystem::filesystem_error &e) {
+            if (verbosityLevel >= 2) {
+                std::cout << std::format(
+                    "   ⚠️  Warning: Could not canonicalize path - {}\n",
+                    e.what());
+            }
 
-                bool isSystemHeader = line.find('<') != std::string::npos &&
-                                      line.find('>') != std::string::npos;
+            if (!compilerService->checkIncludeExists(buildSettings,
+                                                     p.string())) {
+                std::cerr << std::format(
+                    "❌ Error: Included file does not exist: {}\n",
+                    p.string());
+                return true;
+            }
+        }
 
-                if (p.filename() != "decl_amalgama.hpp" &&
-                    p.filename() != "printerOutput.hpp") {
-                    // TODO: Implementar recompilação baseada em contexto AST
-                    bool addedHeader = analysis::AstContext::addInclude(
-                        p.string(), isSystemHeader);
+        bool isSystemHeader = include.systemInclude;
 
-                    /*if (addedHeader) {
-                        analysis::AstContext::staticSaveHeaderToFile(
-                            "decl_amalgama.hpp");
-                    }*/
+        if (p.filename() != "decl_amalgama.hpp" &&
+            p.filename() != "printerOutput.hpp") {
+            // TODO: Implementar recompilação baseada em contexto AST
+            bool addedHeader =
+                analysis::AstContext::addInclude(p.string(), isSystemHeader);
 
-                    replState.shouldRecompilePrecompiledHeader = addedHeader;
+            /*if (addedHeader) {
+                analysis::AstContext::staticSaveHeaderToFile(
+                    "decl_amalgama.hpp");
+            }*/
 
-                    if (replState.shouldRecompilePrecompiledHeader &&
-                        verbosityLevel >= 2) {
-                        std::cout
-                            << "   🔄 Marked for precompiled header rebuild\n";
-                    }
-                }
-            } else {
-                std::cerr << "❌ Error: Could not parse include directive\n";
-                return true;
+            if (addedHeader) {
+                replState.shouldRecompilePrecompiledHeader = true;
             }
-        } else {
-            std::cerr << "❌ Error: Invalid include syntax. Use: #include "
-                         "<header> or #include \"header\"\n";
-            return true;
-        }
 
-        if (replState.shouldRecompilePrecompiledHeader &&
-            replState.asyncPrecompiledHeaderRebuild &&
-            !replState.pchRebuildFuture.valid()) {
-            try {
-                replState.pchRebuildFuture =
-                    std::async(std::launch::async,
-                               []() { return build_precompiledheader(); });
-            } catch (const std::system_error &e) {
-                std::cerr << std::format("❌ Error: Could not start "
-                                         "precompiled header rebuild: {}\n",
-                                         e.what());
-            } catch (const std::exception &e) {
-                std::cerr << std::format("❌ Error: Exception starting "
-                                         "precompiled header rebuild: {}\n",
-                                         e.what());
-            } catch (...) {
-                std::cerr << "❌ Error: Unknown error starting precompiled "
-                             "header rebuild\n";
+            if (addedHeader && verbosityLevel >= 2) {
+                std::cout << "   🔄 Marked for precompiled header rebuild\n";
             }
         }
 
+        if (replState.asyncPrecompiledHeaderRebuild) {
+            schedulePchRebuild();
+        }
+
         return true;
     }
 
@@ -1241,21 +1430,20 @@ auto execRepl(std::string_view lineview, int64_t &i) -> bool {
             analysis::AstContext::addInclude("printerOutput.hpp", false);
 
         if (addedHeader) {
+            // #return sempre depende de printerOutput.hpp: não adianta
+            // compilar contra o PCH antigo
+            wait_for_pch_rebuild_if_running();
             replState.shouldRecompilePrecompiledHeader = true;
+            schedulePchRebuild(/*background=*/false);
         }
     }
 
-    if (replState.shouldRecompilePrecompiledHeader) {
-        std::cout << "🔨 Rebuilding precompiled header...\n";
-        build_precompiledheader();
-        replState.shouldRecompilePrecompiledHeader = false;
-        analysis::AstContext::includesChanged = false;
-        std::cout << "✅ Precompiled header rebuilt successfully\n";
-    }
+    schedulePchRebuild();
 
     if (line == "printall") {
         std::cout << "📊 Printing all variables...\n";
-        savePrintAllVarsLibrary(replState.allTheVariables);
+        savePrintAllVarsLibrary(
+            execution::getGlobalExecutionState().symbols.declarations());
         runPrintAll();
         return true;
     }
@@ -1268,7 +1456,7 @@ auto execRepl(std::string_view lineview, int64_t &i) -> bool {
 
     // command parsing handled above
 
-    if (replState.varsNames.contains(line)) {
+    if (execution::getGlobalExecutionState().symbols.containsName(line)) {
         auto it = replState.varPrinterAddresses.find(line);
 
         if (it != replState.varPrinterAddresses.end()) {
@@ -1284,17 +1472,14 @@ auto execRepl(std::string_view lineview, int64_t &i) -> bool {
         std::cout << std::format("🔧 Generating printer for variable: {}\n",
                                  line);
 
-        std::fstream printerOutput("printerOutput.cpp",
-                                   std::ios::out | std::ios::trunc);
-
-        printerOutput << "#include \"printerOutput.hpp\"\n\n" << std::endl;
-        printerOutput << "#include \"decl_amalgama.hpp\"\n\n" << std::endl;
-
-        printerOutput << "void printall() {\n";
-        printerOutput << std::format("    printdata({});\n", line);
-        printerOutput << "}\n";
-
-        printerOutput.close();
+        writeGeneratedSource(
+            "printerOutput.cpp",
+            std::format("#include \"printerOutput.hpp\"\n\n\n"
+                        "#include \"decl_amalgama.hpp\"\n\n\n"
+                        "void printall() {{\n"
+                        "    printdata({});\n"
+                        "}}\n",
+                        line));
 
         std::cout << "📦 Building printer library...\n";
         onlyBuildLib("clang++", "printerOutput");
@@ -1355,7 +1540,7 @@ auto execRepl(std::string_view lineview, int64_t &i) -> bool {
             }
         } else {
             // Detecção inteligente: definição vs código executável
-            /*if (isDefinitionCode(line)) {
+            /*if (analysis::classifyInput(line).isDeclaration()) {
                 // É uma definição - adiciona ao escopo global sem exec()
                 if (verbosityLevel >= 2) {
                     std::cout << "🔧 Detected global definition\n";
@@ -1401,11 +1586,16 @@ auto execRepl(std::string_view lineview, int64_t &i) -> bool {
 
     // Se chegou até aqui e não foi processado por comando especial,
     // aplica detecção inteligente para código normal
+    bool typeOnly = false;
+    std::vector<std::string> typeNames;
     if (cfg.fileWrap && !line.starts_with("#eval") &&
         !line.starts_with("#lazyeval") && !line.starts_with("#return") &&
         !line.starts_with("#batch_eval")) {
 
-        if (isDefinitionCode(line)) {
+        if (const auto input = analysis::classifyInput(line);
+            input.isDeclaration()) {
+            typeOnly = input.typeOnly;
+            typeNames.assign(input.typeNames.begin(), input.typeNames.end());
             // É uma definição - mantém no escopo global
             if (verbosityLevel >= 2) {
                 std::cout << "🔧 Global definition detected\n";
@@ -1424,7 +1614,7 @@ auto execRepl(std::string_view lineview, int64_t &i) -> bool {
                     "⚡ Code: {}\n",
                     line.length() > 40 ? line.substr(0, 37) + "..." : line);
             }
-            line = std::format("void exec() {{ {}; }}\n", line);
+            line = wrapExecutable(line);
             cfg.analyze = false;
         }
     }
@@ -1476,7 +1666,27 @@ auto execRepl(std::string_view lineview, int64_t &i) -> bool {
 
     cfg.repl_name = std::format("repl_{}", i++);
 
-    if (cfg.fileWrap) {
+    // A mesma linha já foi compilada durante a digitação: vai direto para o
+    // dlopen; qualquer outra entrada descarta o job especulativo
+    if (auto &speculative = execution::SpeculativeCompiler::instance();
+        speculative.enabled()) {
+        if (cfg.fileWrap && cfg.addIncludes && !cfg.analyze &&
+            !cfg.use_cpp2 && cfg.extension == "cpp") {
+            if (auto name = speculative.claim(
+                    speculationKey(replSourceWithIncludes(line)))) {
+                if (verbosityLevel >= 1) {
+                    std::cout << std::format("⚡ Speculative build hit: {}\n",
+                                             *name);
+                }
+                cfg.repl_name = std::move(*name);
+                cfg.prebuilt = true;
+            }
+        } else {
+            speculative.cancel();
+        }
+    }
+
+    if (cfg.fileWrap && !cfg.prebuilt) {
         std::string fileName = std::format(
             "{}.{}", cfg.repl_name, (cfg.use_cpp2 ? "cpp2" : cfg.extension));
 
@@ -1484,26 +1694,31 @@ auto execRepl(std::string_view lineview, int64_t &i) -> bool {
             std::cout << std::format("📝 Writing source to: {}\n", fileName);
         }
 
-        std::fstream replOutput(fileName, std::ios::out | std::ios::trunc);
+        const std::string replOutput =
+            cfg.addIncludes ? replSourceWithIncludes(line) : line + '\n';
 
-        if (cfg.addIncludes) {
-            replOutput << "#include \"precompiledheader.hpp\"\n\n";
-            replOutput << "#include \"decl_amalgama.hpp\"\n\n";
+        // O cppfront lê o .cpp2 do disco
+        if (cfg.use_cpp2) {
+            std::ofstream(fileName, std::ios::out | std::ios::trunc)
+                << replOutput;
+        } else {
+            writeGeneratedSource(fileName, replOutput);
         }
-
-        replOutput << line << std::endl;
-        replOutput.close();
     }
 
     if (cfg.use_cpp2) {
-        std::string cppfrontCmd =
-            std::format("./cppfront {}.cpp2", cfg.repl_name);
+        std::vector<std::string> cppfrontCmd{
+            "./cppfront", std::format("{}.cpp2", cfg.repl_name)};
 
         if (verbosityLevel >= 1) {
-            std::cout << std::format("🔄 Running cppfront: {}\n", cppfrontCmd);
+            std::cout << std::format("🔄 Running cppfront: {} {}\n",
+                                     cppfrontCmd[0], cppfrontCmd[1]);
         }
 
-        int cppfrontres = system(cppfrontCmd.c_str());
+        int cppfrontres =
+            execution::runProcess(cppfrontCmd,
+                                  {.out = execution::Stream::Inherit})
+                .status;
 
         if (cppfrontres != 0) {
             std::cerr << std::format(
@@ -1513,12 +1728,28 @@ auto execRepl(std::string_view lineview, int64_t &i) -> bool {
         }
     }
 
+    // Só tipos/alias/templates: -fsyntax-only e direto para o
+    // decl_amalgama.hpp, sem objeto, link, wrappers ou dlopen
+    // (rebuild do PCH pendente e ainda não disparado fica no caminho normal;
+    // vários tipos numa entrada passam pela análise, que dá uma chave a cada
+    // um)
+    if (typeOnly && typeNames.size() <= 1 && replState.declarationFastPath &&
+        cfg.addIncludes && !cfg.use_cpp2 && cfg.extension == "cpp" &&
+        !replState.shouldRecompilePrecompiledHeader) {
+        return declareTypeOnly(line, cfg.repl_name, cfg.compiler,
+                               typeNames.empty() ? std::string{}
+                                                 : typeNames.front());
+    }
+
     if (verbosityLevel >= 1) {
         std::cout << std::format("🚀 Compiling and executing: {}\n",
                                  cfg.repl_name);
     }
 
+    const auto replName = cfg.repl_name;
     auto evalRes = compileAndRunCode(std::move(cfg));
+    // Fonte, objeto e logs do eval; a biblioteca continua carregada
+    execution::finishEvalArtifacts(replName);
 
     if (evalRes.success && evalRes.exec) {
         replState.evalResults.insert_or_assign(line, evalRes);
@@ -1532,6 +1763,131 @@ auto execRepl(std::string_view lineview, int64_t &i) -> bool {
     return true;
 }
 
+// Um lote do SnippetBatcher: o mesmo build de uma linha do REPL, mas o código
+// já vem embrulhado (statements dentro de exec()) e com as diretivas #line
+static bool execReplBatch(const analysis::SnippetBatch &batch) {
+    reap_pch_rebuild_if_done();
+    initCompilerService();
+    compilerService->foldSessionDeclarations();
+    if (!replState.shouldRecompilePrecompiledHeader) {
+        replState.shouldRecompilePrecompiledHeader =
+            analysis::AstContext::includesChanged;
+        analysis::AstContext::includesChanged = false;
+    }
+    schedulePchRebuild();
+
+    CompilerCodeCfg cfg;
+    cfg.analyze = batch.kind == analysis::SnippetBatch::Kind::Declarations;
+    cfg.repl_name = std::format("repl_{}", replCounter++);
+
+    if (verbosityLevel >= 1) {
+        std::cout << std::format(
+            "📦 Batch {}: {} {} (lines {}-{})\n", cfg.repl_name,
+            batch.snippets, cfg.analyze ? "declarations" : "statements",
+            batch.firstLine, batch.lastLine);
+    }
+
+    if (!writeGeneratedSource(std::format("{}.cpp", cfg.repl_name),
+                              replSourceWithIncludes(batch.code))) {
+        return false;
+    }
+
+    const auto replName = cfg.repl_name;
+    auto evalRes = compileAndRunCode(std::move(cfg));
+    execution::finishEvalArtifacts(replName);
+    return evalRes.success;
+}
+
+// #line precisa de um caminho que o analisador de AST aceite (dentro do
+// diretório de trabalho); fora dele, só as linhas são renumeradas
+static std::string batchLineFile(std::string_view sourceFile) {
+    if (sourceFile.empty()) {
+        return {};
+    }
+
+    std::error_code ec;
+    const auto path = std::filesystem::canonical(sourceFile, ec);
+    const auto cwd = std::filesystem::current_path(ec);
+    if (ec || !path.string().starts_with(cwd.string())) {
+        return {};
+    }
+    return path.string();
+}
+
+ReplBatchRunner::ReplBatchRunner(std::string_view sourceFile)
+    : batcher_(batchLineFile(sourceFile)) {}
+
+bool ReplBatchRunner::feed(std::string_view block, int64_t line) {
+    if (!replState.batchMode) {
+        return extExecRepl(block);
+    }
+
+    const auto input = analysis::classifyInput(block);
+    const auto trimmed = trim(block);
+    if (!analysis::SnippetBatcher::batchable(input) || trimmed == "exit" ||
+        execution::getGlobalExecutionState().symbols.containsName(
+            std::string(trimmed))) {
+        flush();
+        return extExecRepl(block);
+    }
+
+    if (!batcher_.accepts(input)) {
+        flush();
+    }
+    batcher_.add(block, line, input);
+    return true;
+}
+
+void ReplBatchRunner::flush() {
+    if (batcher_.empty()) {
+        return;
+    }
+
+    // Em qualquer verbosidade: o lote inteiro deixou de rodar
+    const auto batch = batcher_.take();
+    if (!execReplBatch(batch)) {
+        std::cerr << std::format("❌ Batch failed (lines {}-{})\n",
+                                 batch.firstLine, batch.lastLine);
+    }
+}
+
+// Colagem com várias linhas (bracketed paste): separa em blocos completos e
+// manda pelo mesmo caminho do modo script
+static bool execPastedText(std::string_view text) {
+    ReplBatchRunner runner;
+    analysis::InputAccumulator block;
+    int64_t lineNumber = 0;
+    int64_t blockStart = 0;
+
+    size_t begin = 0;
+    while (begin <= text.size()) {
+        size_t end = text.find('\n', begin);
+        if (end == std::string_view::npos) {
+            end = text.size();
+        }
+        const auto line = text.substr(begin, end - begin);
+        begin = end + 1;
+        ++lineNumber;
+
+        if (block.empty() && trim(line).empty()) {
+            continue;
+        }
+        if (block.empty()) {
+            blockStart = lineNumber;
+        }
+        block.append(line);
+        if (block.complete() && !runner.feed(block.take(), blockStart)) {
+            return false;
+        }
+    }
+
+    if (!block.empty() && !runner.feed(block.take(), blockStart)) {
+        return false;
+    }
+    runner.flush();
+    return true;
+}
+
 int __attribute__((visibility("default"))) (*bootstrapProgram)(
     int argc, char **argv) = nullptr;
 
@@ -1567,8 +1923,8 @@ auto compileAndRunCodeCustom(
                      .count()
               << "ms" << std::endl;
 
-    auto alldecls =
-        utility::getAllBuiltFileDecls(std::format("./lib{}.so", cfg.repl_name));
+    auto alldecls = utility::getAllBuiltFileDecls(
+        execution::artifactPath(std::format("./lib{}.so", cfg.repl_name)));
 
     return prepareWrapperAndLoadCodeLib(cfg, std::move(vars),
                                         std::move(alldecls));
@@ -1577,6 +1933,13 @@ auto compileAndRunCodeCustom(
 int ctrlcounter = 0;
 
 void handleCtrlC(const segvcatch::hardware_exception_info &info) {
+    // Durante um build, só cancela os jobs do compilador: a exceção
+    // atravessaria threads do scheduler e deixaria processos órfãos
+    if (execution::cancelCurrentEval()) {
+        std::cout << "Ctrl-C pressed, cancelling build" << std::endl;
+        return;
+    }
+
     std::cout << "Ctrl-C pressed" << std::endl;
 
     if (ctrlcounter == 0) {
@@ -1601,6 +1964,9 @@ void repl() {
         perror("Failed to read history");
     }
 
+    // Pausas na digitação disparam a compilação especulativa (#speculate)
+    rl_event_hook = speculationHook;
+
     // Mostrar comando de boas-vindas automaticamente apenas se verbosidade >= 1
     if (verbosityLevel >= 1) {
         std::cout
@@ -1618,7 +1984,9 @@ void repl() {
         try {
             // Prompt mais amigável com indicador de linha
             std::string prompt = std::format("C++[{}]>>> ", promptCounter);
+            speculationInput.reset(true);
             char *input = readline(prompt.c_str());
+            speculationInput.reset(false);
 
             if (input == nullptr) {
                 std::cout << "\n👋 Goodbye! Thanks for using C++ REPL.\n";
@@ -1634,6 +2002,26 @@ void repl() {
                 continue;
             }
 
+            // Entrada incompleta ((){}[] abertos, class sem corpo...):
+            // continua lendo; uma linha vazia envia o que já foi digitado
+            analysis::InputAccumulator pending;
+            pending.append(line);
+            while (!pending.complete()) {
+                std::string continuation =
+                    std::format("C++[{}]... ", promptCounter);
+                char *more = readline(continuation.c_str());
+                if (more == nullptr) {
+                    break;
+                }
+                std::string next = more;
+                free(more);
+                if (next.empty()) {
+                    break;
+                }
+                pending.append(next);
+            }
+            line = pending.take();
+
         } catch (const segvcatch::interrupted_by_the_user &e) {
             if (verbosityLevel >= 1) {
                 std::cout << "\n⚠️  Interrupted by user (Ctrl-C)\n";
@@ -1649,7 +2037,9 @@ void repl() {
         auto start_time = std::chrono::steady_clock::now();
 
         try {
-            if (!extExecRepl(line)) {
+            const bool pasted =
+                replState.batchMode && line.find('\n') != std::string::npos;
+            if (!(pasted ? execPastedText(line) : extExecRepl(line))) {
                 break;
             }
 
@@ -1722,9 +2112,23 @@ void initRepl() {
 
     repl_commands::registerReplCommands(&view);
 
+    // Build especulativo: mesmo comando do onlyBuildLib, sem saída no
+    // terminal e cancelável pela digitação
+    execution::SpeculativeCompiler::instance().setBuild(
+        [](const std::string &name, const std::string &source,
+           const execution::CancellationToken &cancel) {
+            if (!execution::writeArtifact(std::format("{}.cpp", name),
+                                          source)) {
+                return false;
+            }
+            return compilerService
+                ->buildLibraryInBackground("clang++", name, cancel)
+                .success();
+        });
+
     // Inicializar completion com estado atual do REPL
-    completionScope =
-        std::make_unique<completion::SimpleCompletionScope>(replState);
+    completionScope = std::make_unique<completion::SimpleCompletionScope>(
+        replState, &execution::getGlobalExecutionState().symbols);
 
     // Criar um contexto AST inicial para inicializar o arquivo
     // decl_amalgama.hpp
@@ -1736,6 +2140,7 @@ void initRepl() {
 }
 
 void shutdownRepl() {
+    execution::SpeculativeCompiler::instance().cancel();
     if (completionScope) {
         completionScope.reset();
     }
@@ -1754,17 +2159,96 @@ void set_async_pch_rebuild(bool enabled) noexcept {
     }
 }
 
+void set_batch_mode(bool enabled) noexcept { replState.batchMode = enabled; }
+
+bool batch_mode_enabled() noexcept { return replState.batchMode; }
+
+bool set_inprocess_compiler_backend(bool enabled) {
+    initCompilerService();
+    return compilerService->setBackend(enabled
+                                           ? compiler::CompilerBackend::InProcess
+                                           : compiler::CompilerBackend::External);
+}
+
+bool inprocess_compiler_backend_enabled() noexcept {
+    return compilerService && compilerService->usingInProcessBackend();
+}
+
+bool set_artifact_cache_enabled(bool enabled) {
+    initCompilerService();
+    if (!enabled) {
+        compilerService->setArtifactCache(nullptr);
+        return true;
+    }
+
+    if (!compilerService->artifactCache()) {
+        std::error_code ec;
+        auto root = compiler::ArtifactCache::defaultRoot();
+        std::filesystem::create_directories(root, ec);
+        if (ec) {
+            std::cerr << std::format("⚠️  Artifact cache disabled: {} ({})\n",
+                                     root.string(), ec.message());
+            return false;
+        }
+        compilerService->setArtifactCache(
+            std::make_shared<compiler::ArtifactCache>(root));
+    }
+    return true;
+}
+
+bool artifact_cache_enabled() noexcept {
+    return compilerService && compilerService->artifactCache();
+}
+
+std::string artifact_cache_status() {
+    std::string pchStatus = "PCH store: disabled\n";
+    if (auto store = compilerService ? compilerService->pchStore() : nullptr) {
+        auto stats = store->stats();
+        pchStatus = std::format(
+            "PCH store: {}\n"
+            "  entries: {}, usage: {:.1f} MiB / {} MiB\n"
+            "  hits: {}, misses: {}, evicted: {}\n",
+            store->root().string(), store->entryCount(),
+            static_cast<double>(store->diskUsage()) / (1024.0 * 1024.0),
+            store->maxBytes() / (1024 * 1024), stats.hits, stats.misses,
+            stats.evictions);
+    }
+
+    if (!artifact_cache_enabled()) {
+        return "Artifact cache: disabled\n" + pchStatus;
+    }
+
+    auto cache = compilerService->artifactCache();
+    auto stats = cache->stats();
+    return std::format(
+        "Artifact cache: {}\n"
+        "  usage: {:.1f} MiB / {} MiB\n"
+        "  hits: {} (failures replayed: {}), misses: {}, stored: {}, "
+        "evicted: {}\n",
+        cache->root().string(),
+        static_cast<double>(cache->diskUsage()) / (1024.0 * 1024.0),
+        cache->maxBytes() / (1024 * 1024), stats.hits, stats.failureHits,
+        stats.misses, stats.stores, stats.evictions) +
+           pchStatus;
+}
+
+void clear_artifact_cache() {
+    if (artifact_cache_enabled()) {
+        compilerService->artifactCache()->clear();
+    }
+}
+
 void wait_for_pch_rebuild_if_running() noexcept {
     try {
         if (replState.pchRebuildFuture.valid()) {
             // Wait for completion, but swallow exceptions to avoid crashing
             try {
-                replState.pchRebuildFuture.get();
-
-                replState.shouldRecompilePrecompiledHeader = false;
-                analysis::AstContext::includesChanged = false;
+                if (replState.pchRebuildFuture.get() != 0) {
+                    replState.shouldRecompilePrecompiledHeader = true;
+                }
             } catch (...) {
-                // ignore - rebuild may have failed
+                // rebuild failed: try again on the next command
+                replState.shouldRecompilePrecompiledHeader = true;
             }
         }
     } catch (...) {
@@ -1772,6 +2256,21 @@ void wait_for_pch_rebuild_if_running() noexcept {
     }
 }
 
+bool pch_rebuild_in_flight() noexcept {
+    return replState.pchRebuildFuture.valid();
+}
+
+void reap_pch_rebuild_if_done() noexcept {
+    try {
+        if (replState.pchRebuildFuture.valid() &&
+            replState.pchRebuildFuture.wait_for(std::chrono::seconds(0)) ==
+                std::future_status::ready) {
+            wait_for_pch_rebuild_if_running();
+        }
+    } catch (...) {
+    }
+}
+
 void initNotifications(std::string_view appName) {
 #ifndef NUSELIBNOTIFY
     if (notify_is_initted()) {
@@ -1,5 +1,7 @@
 #pragma once
 
+#include "analysis/snippet_batcher.hpp"
+
 #include <any>
 #include <functional>
 #include <future>
@@ -14,6 +16,7 @@ extern int
                                                                char **argv);
 
 extern int verbosityLevel;
+extern int64_t replCounter;
 
 struct EvalResult {
     std::string libpath;
@@ -55,6 +58,7 @@ struct CompilerCodeCfg {
     bool fileWrap = true;
     bool lazyEval = false;
     bool use_cpp2 = false;
+    bool prebuilt = false; // lib já compilada pela especulação
 };
 
 struct BuildSettings {
@@ -101,8 +105,7 @@ struct ReplState {
     bool useCpp2 = false;
     bool shouldRecompilePrecompiledHeader = false;
 
-    std::unordered_set<std::string> varsNames;
-    std::vector<VarDecl> allTheVariables;
+    // Nomes/declarações ficam no execution::SymbolIndex
     std::unordered_map<std::string, void (*)()> varPrinterAddresses;
     std::unordered_map<std::string, EvalResult> evalResults;
     std::vector<std::function<bool()>> lazyEvalFns;
@@ -111,6 +114,10 @@ struct ReplState {
     bool asyncPrecompiledHeaderRebuild = true;
     std::future<int>
         pchRebuildFuture; // valid() == true if a rebuild is in progress
+    // Declarações só de tipo pulam codegen/link/dlopen (#declfast)
+    bool declarationFastPath = true;
+    // Script (-r) e colagens agrupam blocos num único TU (#batchmode)
+    bool batchMode = false;
 };
 
 auto analyzeCustomCommands(
@@ -132,8 +139,64 @@ void addIncludeDirectory(const std::string &dir);
 void set_async_pch_rebuild(bool enabled) noexcept;
 
 // Wait for any in-progress async PCH rebuild to finish (no-op if none).
+// A failed rebuild leaves the recompile flag set so the next command retries.
 void wait_for_pch_rebuild_if_running() noexcept;
 
+// True while an async PCH rebuild is running. Compiles keep using the
+// current PCH meanwhile; the new one is swapped in atomically when ready.
+bool pch_rebuild_in_flight() noexcept;
+
+// Collect a finished async rebuild without blocking (no-op if still running).
+void reap_pch_rebuild_if_done() noexcept;
+
+// Switch compile jobs between spawning clang++ and the in-process Clang
+// frontend. Returns false when the in-process backend is not available.
+bool set_inprocess_compiler_backend(bool enabled);
+bool inprocess_compiler_backend_enabled() noexcept;
+
+// On-disk artifact cache shared across sessions (enabled by default, disable
+// with CPPREPL_CACHE=0). Status is a human-readable summary.
+bool set_artifact_cache_enabled(bool enabled);
+bool artifact_cache_enabled() noexcept;
+std::string artifact_cache_status();
+void clear_artifact_cache();
+
+// Batch mode for scripts (-r) and multi-line pastes: runs of consecutive
+// declarations or statements are compiled as one translation unit.
+void set_batch_mode(bool enabled) noexcept;
+bool batch_mode_enabled() noexcept;
+
+/**
+ * @brief Envia os blocos de um script ao REPL, em lotes no modo batch
+ *
+ * Sem o modo batch, cada bloco vai direto para extExecRepl. Com ele,
+ * declarações e statements consecutivos se acumulam num
+ * analysis::SnippetBatcher; diretivas, comandos, "exit" e nomes de variáveis
+ * (que imprimem o valor) fecham o lote e rodam sozinhos, na ordem.
+ */
+class ReplBatchRunner {
+  public:
+    /**
+     * @param sourceFile Script citado nas diretivas #line; vazio (colagem)
+     * só renumera as linhas
+     */
+    explicit ReplBatchRunner(std::string_view sourceFile = {});
+
+    /**
+     * @brief Executa ou acumula @p block, que começa na linha @p line
+     * @return false se o bloco encerrou o REPL ("exit")
+     */
+    bool feed(std::string_view block, int64_t line);
+
+    /**
+     * @brief Compila e executa o lote pendente
+     */
+    void flush();
+
+  private:
+    analysis::SnippetBatcher batcher_;
+};
+
 std::any getResultRepl(std::string cmd);
 
 int ext_build_precompiledheader();
@@ -0,0 +1,189 @@
+#include "decl_export_consumer.hpp"
+
+#include "analysis/decl_export.hpp"
+#include <clang/AST/ASTContext.h>
+#include <clang/AST/Decl.h>
+#include <clang/AST/DeclCXX.h>
+#include <clang/Basic/SourceManager.h>
+#include <clang/Lex/Lexer.h>
+#include <llvm/ADT/SmallString.h>
+#include <llvm/Support/FileSystem.h>
+
+namespace analysis::decl_export {
+
+namespace {
+
+const char *storageClassName(clang::StorageClass sc) {
+    switch (sc) {
+    case clang::SC_None:
+        return "";
+    case clang::SC_Extern:
+        return "extern";
+    case clang::SC_Static:
+        return "static";
+    case clang::SC_PrivateExtern:
+        return "__private_extern__";
+    case clang::SC_Auto:
+        return "auto";
+    case clang::SC_Register:
+        return "register";
+    }
+    return "";
+}
+
+} // namespace
+
+DeclExportConsumer::DeclExportConsumer(Sink sink) : sink_(std::move(sink)) {
+    llvm::SmallString<256> cwd;
+    if (!llvm::sys::fs::current_path(cwd)) {
+        llvm::SmallString<256> real;
+        if (!llvm::sys::fs::real_path(cwd, real)) {
+            cwd = real;
+        }
+        cwd_ = cwd.str().str();
+    }
+}
+
+DeclExportConsumer::~DeclExportConsumer() = default;
+
+void DeclExportConsumer::Initialize(clang::ASTContext &ctx) {
+    ctx_ = &ctx;
+    names_ = std::make_unique<clang::ASTNameGenerator>(ctx);
+    out_.assign(kMagic);
+    out_ += '\n';
+}
+
+bool DeclExportConsumer::fileAccepted(const clang::Decl *decl) {
+    const auto &sm = ctx_->getSourceManager();
+    auto loc = sm.getSpellingLoc(decl->getLocation());
+    if (loc.isInvalid()) {
+        return false;
+    }
+    if (sm.isInMainFile(loc)) {
+        return true;
+    }
+
+    // Mesmo critério do analisador JSON: o arquivo (presumido, respeitando
+    // #line) precisa estar dentro do diretório de trabalho
+    auto fid = sm.getFileID(loc);
+    auto [it, inserted] = acceptedFiles_.try_emplace(fid.getHashValue(), false);
+    if (inserted) {
+        auto presumed = sm.getPresumedLoc(loc);
+        llvm::SmallString<256> real;
+        if (presumed.isValid() && !cwd_.empty() &&
+            !llvm::sys::fs::real_path(presumed.getFilename(), real)) {
+            it->second = llvm::StringRef(real).starts_with(cwd_);
+        }
+    }
+    return it->second;
+}
+
+void DeclExportConsumer::noteInclude(const clang::Decl *decl) {
+    const auto &sm = ctx_->getSourceManager();
+    auto loc = sm.getSpellingLoc(decl->getLocation());
+    if (loc.isInvalid() || sm.isInMainFile(loc)) {
+        return;
+    }
+
+    auto includeLoc = sm.getIncludeLoc(sm.getFileID(loc));
+    if (includeLoc.isInvalid() || !sm.isInMainFile(includeLoc)) {
+        return;
+    }
+
+    auto presumed = sm.getPresumedLoc(loc);
+    if (presumed.isValid() && includes_.insert(presumed.getFilename()).second) {
+        appendInclude(out_, presumed.getFilename());
+    }
+}
+
+void DeclExportConsumer::exportDecl(const clang::Decl *decl, bool nested) {
+    using clang::Decl;
+
+    const auto kind = decl->getKind();
+    if (kind != Decl::Var && kind != Decl::Function &&
+        kind != Decl::CXXMethod && kind != Decl::CXXRecord &&
+        kind != Decl::Record) {
+        return;
+    }
+
+    const auto *named = llvm::cast<clang::NamedDecl>(decl);
+    if (!named->getDeclName() || decl->isImplicit()) {
+        return;
+    }
+
+    if (nested ? (kind != Decl::CXXMethod && kind != Decl::Var)
+               : !fileAccepted(decl)) {
+        return;
+    }
+
+    const auto &sm = ctx_->getSourceManager();
+    auto spelling = sm.getSpellingLoc(decl->getLocation());
+    auto presumed = sm.getPresumedLoc(spelling);
+    if (presumed.isInvalid()) {
+        return;
+    }
+
+    DeclRecord rec;
+    rec.kind = std::string(decl->getDeclKindName()) + "Decl";
+    rec.name = named->getNameAsString();
+    rec.file = presumed.getFilename();
+    rec.line = presumed.getLine();
+
+    if (const auto *record = llvm::dyn_cast<clang::RecordDecl>(decl)) {
+        if (!record->isCompleteDefinition()) {
+            return;
+        }
+
+        auto range = decl->getSourceRange();
+        auto begin = sm.getSpellingLoc(range.getBegin());
+        auto end = sm.getSpellingLoc(range.getEnd());
+        if (begin.isValid() && end.isValid() &&
+            sm.getFileID(begin) == sm.getFileID(end)) {
+            rec.beginOffset = sm.getFileOffset(begin);
+            rec.endOffset =
+                sm.getFileOffset(end) +
+                clang::Lexer::MeasureTokenLength(end, sm, ctx_->getLangOpts());
+        }
+        appendDecl(out_, rec);
+
+        // Métodos definidos na classe (o JSON descia em "inner")
+        for (const auto *member : record->decls()) {
+            exportDecl(member, true);
+        }
+        return;
+    }
+
+    const auto *value = llvm::cast<clang::ValueDecl>(decl);
+    const auto &policy = ctx_->getPrintingPolicy();
+    auto split = value->getType().split();
+    rec.qualType = clang::QualType::getAsString(split, policy);
+    auto desugared = value->getType().getSplitDesugaredType();
+    if (desugared != split) {
+        rec.desugaredQualType = clang::QualType::getAsString(desugared, policy);
+    }
+    rec.mangledName = names_->getName(decl);
+
+    if (const auto *var = llvm::dyn_cast<clang::VarDecl>(decl)) {
+        rec.storageClass = storageClassName(var->getStorageClass());
+    } else if (const auto *fn = llvm::dyn_cast<clang::FunctionDecl>(decl)) {
+        rec.storageClass = storageClassName(fn->getStorageClass());
+    }
+
+    appendDecl(out_, rec);
+}
+
+bool DeclExportConsumer::HandleTopLevelDecl(clang::DeclGroupRef group) {
+    for (const auto *decl : group) {
+        noteInclude(decl);
+        exportDecl(decl, false);
+    }
+    return true;
+}
+
+void DeclExportConsumer::HandleTranslationUnit(clang::ASTContext &) {
+    if (sink_) {
+        sink_(std::move(out_));
+    }
+}
+
+} // namespace analysis::decl_export
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <clang/AST/ASTConsumer.h>
+#include <clang/AST/Mangle.h>
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace clang {
+class ASTContext;
+class Decl;
+class NamedDecl;
+} // namespace clang
+
+namespace analysis::decl_export {
+
+/**
+ * @brief ASTConsumer que gera o formato de linha de decl_export.hpp
+ *
+ * Compilado tanto no plugin (libcpprepl_decl_export.so, carregado pelo
+ * clang++ externo via -fplugin) quanto no backend in-process, para que os dois
+ * caminhos produzam exatamente os mesmos registros.
+ *
+ * Aplica o mesmo recorte que o ContextualAstAnalyzer aplicava ao JSON:
+ * declarações de nível superior do arquivo principal ou de arquivos dentro do
+ * diretório de trabalho, mais os métodos de classes definidas ali.
+ */
+class DeclExportConsumer : public clang::ASTConsumer {
+  public:
+    using Sink = std::function<void(std::string &&records)>;
+
+    explicit DeclExportConsumer(Sink sink);
+    ~DeclExportConsumer() override;
+
+    void Initialize(clang::ASTContext &ctx) override;
+    bool HandleTopLevelDecl(clang::DeclGroupRef group) override;
+    void HandleTranslationUnit(clang::ASTContext &ctx) override;
+
+  private:
+    void exportDecl(const clang::Decl *decl, bool nested);
+    void noteInclude(const clang::Decl *decl);
+    bool fileAccepted(const clang::Decl *decl);
+
+    Sink sink_;
+    clang::ASTContext *ctx_ = nullptr;
+    std::unique_ptr<clang::ASTNameGenerator> names_;
+    std::string out_;
+    std::string cwd_;
+    std::unordered_set<std::string> includes_;
+    std::unordered_map<unsigned, bool> acceptedFiles_; // FileID hash -> ok
+};
+
+} // namespace analysis::decl_export
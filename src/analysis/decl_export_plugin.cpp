@@ -0,0 +1,77 @@
+// Plugin do clang que substitui o -ast-dump=json no caminho de avaliação.
+//
+// Uso (o CompilerService monta isso sozinho):
+//   clang++ ... -fplugin=libcpprepl_decl_export.so \
+//       -fplugin-arg-cpprepl-decls-out=repl_N.decls
+//
+// Roda junto com a ação principal (AddAfterMainAction), então a mesma
+// invocação que gera a biblioteca também exporta as declarações.
+
+#include "decl_export_consumer.hpp"
+
+#include "analysis/decl_export.hpp"
+#include <clang/Frontend/CompilerInstance.h>
+#include <clang/Frontend/FrontendPluginRegistry.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/raw_ostream.h>
+
+namespace {
+
+class DeclExportAction : public clang::PluginASTAction {
+  protected:
+    std::unique_ptr<clang::ASTConsumer>
+    CreateASTConsumer(clang::CompilerInstance &ci,
+                      llvm::StringRef inFile) override {
+        std::string path =
+            outPath_.empty() ? (inFile + ".decls").str() : outPath_;
+        auto &diags = ci.getDiagnostics();
+
+        return std::make_unique<analysis::decl_export::DeclExportConsumer>(
+            [path, &diags](std::string &&records) {
+                // Grava em .tmp e renomeia: o REPL nunca lê um arquivo
+                // parcial. Um memfd do REPL (/proc/<pid>/fd/N) não pode ser
+                // renomeado; é gravado no lugar, e o REPL só lê depois que o
+                // compilador termina.
+                const bool inPlace =
+                    llvm::StringRef(path).starts_with("/proc/");
+                const std::string tmp = inPlace ? path : path + ".tmp";
+                std::error_code ec;
+                {
+                    llvm::raw_fd_ostream os(tmp, ec);
+                    if (!ec) {
+                        os << records;
+                    }
+                }
+                if (!ec && !inPlace) {
+                    ec = llvm::sys::fs::rename(tmp, path);
+                }
+                if (ec) {
+                    diags.Report(diags.getCustomDiagID(
+                        clang::DiagnosticsEngine::Warning,
+                        "cpprepl-decls: could not write '%0': %1"))
+                        << path << ec.message();
+                }
+            });
+    }
+
+    bool ParseArgs(const clang::CompilerInstance &,
+                   const std::vector<std::string> &args) override {
+        for (const auto &arg : args) {
+            if (llvm::StringRef(arg).starts_with("out=")) {
+                outPath_ = arg.substr(4);
+            }
+        }
+        return true;
+    }
+
+    ActionType getActionType() override { return AddAfterMainAction; }
+
+  private:
+    std::string outPath_;
+};
+
+} // namespace
+
+static clang::FrontendPluginRegistry::Add<DeclExportAction>
+    registerDeclExport(analysis::decl_export::kPluginName.data(),
+                       "export REPL declarations in cpprepl line format");
@@ -0,0 +1,181 @@
+#include "analysis/declaration_store.hpp"
+
+#include <algorithm>
+#include <format>
+#include <fstream>
+#include <system_error>
+
+namespace analysis {
+
+namespace {
+
+// Diretivas que continuam no header depois de dobradas: includes são
+// pulados pelo guarda que o PCH já conhece
+bool keptWhenFolded(const CodeTracking &entry) {
+    return entry.key.empty() && (entry.codeSnippet.starts_with("#include") ||
+                                 entry.codeSnippet.starts_with("#pragma"));
+}
+
+bool isLineDirective(const CodeTracking &entry) {
+    return entry.key.empty() && entry.codeSnippet.starts_with("#line");
+}
+
+} // namespace
+
+std::string DeclarationStore::render(const CodeTracking &entry) {
+    if (entry.key.empty() || entry.line < 0) {
+        return entry.codeSnippet;
+    }
+    return std::format("#line {} \"{}\"\n{}", entry.line, entry.filename,
+                       entry.codeSnippet);
+}
+
+bool DeclarationStore::add(CodeTracking entry) {
+    if (!entry.key.empty()) {
+        if (auto it = byKey_.find(entry.key); it != byKey_.end()) {
+            if (entries_[it->second].codeSnippet == entry.codeSnippet) {
+                return false; // redeclaração: a primeira #line continua
+            }
+            // Redefinição: a versão nova fica no lugar da antiga, antes de
+            // quem depende dela; dobrada, a antiga já está no PCH
+            const size_t previous = it->second;
+            const size_t slot = slot_[previous];
+            live_[previous] = false;
+            byKey_.erase(it);
+            if (slot >= folded_) {
+                order_[slot] = entries_.size();
+                slot_.push_back(slot);
+            } else {
+                slot_.push_back(order_.size());
+                order_.push_back(entries_.size());
+            }
+            entries_.push_back(std::move(entry));
+            live_.push_back(true);
+            rebuild();
+            return true;
+        }
+        byKey_.emplace(entry.key, entries_.size());
+    }
+
+    text_ += render(entry);
+    slot_.push_back(order_.size());
+    order_.push_back(entries_.size());
+    entries_.push_back(std::move(entry));
+    live_.push_back(true);
+    ++generation_;
+    return true;
+}
+
+void DeclarationStore::rebuild() {
+    // entries() editado por fora: sem posição, as entradas novas vão para o
+    // fim
+    std::erase_if(order_, [this](size_t i) { return i >= entries_.size(); });
+    for (size_t i = std::min(slot_.size(), entries_.size());
+         i < entries_.size(); ++i) {
+        order_.push_back(i);
+    }
+    slot_.assign(entries_.size(), 0);
+    for (size_t slot = 0; slot < order_.size(); ++slot) {
+        slot_[order_[slot]] = slot;
+    }
+    folded_ = std::min(folded_, order_.size());
+    live_.resize(entries_.size(), true);
+
+    byKey_.clear();
+    text_.clear();
+    for (size_t slot = 0; slot < order_.size(); ++slot) {
+        const size_t i = order_[slot];
+        if (!live_[i]) {
+            continue;
+        }
+        if (!entries_[i].key.empty()) {
+            byKey_[entries_[i].key] = i;
+        }
+        if (slot >= folded_ || keptWhenFolded(entries_[i])) {
+            text_ += render(entries_[i]);
+        }
+    }
+    ++generation_;
+    rewrite_ = true;
+}
+
+bool DeclarationStore::writeTo(const std::filesystem::path &path) {
+    std::error_code ec;
+    auto target = std::filesystem::absolute(path, ec);
+    if (ec) {
+        target = path;
+    }
+
+    // Append só se o arquivo ainda é exatamente o que foi gravado
+    const bool append = !rewrite_ && target == writtenPath_ &&
+                        writtenBytes_ <= text_.size() &&
+                        std::filesystem::file_size(target, ec) ==
+                            writtenBytes_ &&
+                        !ec;
+    if (append && writtenBytes_ == text_.size()) {
+        return true;
+    }
+
+    std::ofstream out(target, append ? std::ios::out | std::ios::app |
+                                           std::ios::binary
+                                     : std::ios::out | std::ios::trunc |
+                                           std::ios::binary);
+    if (!out.is_open()) {
+        return false;
+    }
+    const size_t from = append ? writtenBytes_ : 0;
+    out.write(text_.data() + from,
+              static_cast<std::streamsize>(text_.size() - from));
+    out.flush();
+    if (!out.good()) {
+        writtenPath_.clear();
+        return false;
+    }
+
+    writtenPath_ = target;
+    writtenBytes_ = text_.size();
+    rewrite_ = false;
+    return true;
+}
+
+DeclarationStore::Fold DeclarationStore::planFold(size_t minBytes,
+                                                  size_t keepRecent) const {
+    Fold fold;
+    if (text_.size() < minBytes || order_.size() <= keepRecent) {
+        return fold;
+    }
+
+    // Um #line avulso vale para a entrada seguinte: não separa os dois
+    size_t end = order_.size() - keepRecent;
+    while (end > folded_ && isLineDirective(entries_[order_[end - 1]])) {
+        --end;
+    }
+
+    fold.begin = folded_;
+    fold.end = end;
+    for (size_t slot = folded_; slot < end; ++slot) {
+        const size_t i = order_[slot];
+        if (live_[i] && !keptWhenFolded(entries_[i])) {
+            fold.folded.push_back(i);
+            fold.text += render(entries_[i]);
+        }
+    }
+    if (fold.text.size() < minBytes / 2) {
+        return {}; // o grosso do header ainda é recente
+    }
+    return fold;
+}
+
+bool DeclarationStore::commitFold(const Fold &fold) {
+    if (fold.empty() || fold.begin != folded_ || fold.end > order_.size() ||
+        !std::ranges::all_of(fold.folded,
+                             [this](size_t i) { return live_[i]; })) {
+        return false;
+    }
+
+    folded_ = fold.end;
+    rebuild();
+    return true;
+}
+
+} // namespace analysis
@@ -0,0 +1,812 @@
+#include "analysis/input_classifier.hpp"
+
+#include <algorithm>
+#include <array>
+#include <span>
+#include <utility>
+#include <vector>
+
+namespace analysis {
+
+namespace {
+
+enum CharClass : uint8_t {
+    kSpace = 1,
+    kIdentStart = 2, // letras, '_' e bytes UTF-8
+    kDigit = 4,
+};
+
+constexpr auto kCharClass = [] {
+    std::array<uint8_t, 256> table{};
+    for (const unsigned char c : std::string_view(" \t\n\r\f\v")) {
+        table[c] = kSpace;
+    }
+    for (int c = 0; c < 256; ++c) {
+        if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_' ||
+            c >= 0x80) {
+            table[c] = kIdentStart;
+        }
+        if (c >= '0' && c <= '9') {
+            table[c] = kDigit;
+        }
+    }
+    return table;
+}();
+
+bool is(char c, uint8_t cls) {
+    return (kCharClass[static_cast<unsigned char>(c)] & cls) != 0;
+}
+
+enum class Keyword : uint8_t {
+    None,
+    Declaration, // introduz uma declaração
+    Type,        // tipo fundamental: o que vem depois é um declarador
+    Qualifier,   // const/volatile: no começo ou entre tipo e declarador
+    Statement,
+    Expression,
+};
+
+struct KeywordEntry {
+    std::string_view word;
+    Keyword kind;
+};
+
+// Ordenada para busca binária
+constexpr std::array kKeywords = std::to_array<KeywordEntry>({
+    {"alignas", Keyword::Declaration},
+    {"alignof", Keyword::Expression},
+    {"asm", Keyword::Statement},
+    {"auto", Keyword::Type},
+    {"bool", Keyword::Type},
+    {"break", Keyword::Statement},
+    {"case", Keyword::Statement},
+    {"char", Keyword::Type},
+    {"char16_t", Keyword::Type},
+    {"char32_t", Keyword::Type},
+    {"char8_t", Keyword::Type},
+    {"class", Keyword::Declaration},
+    {"co_await", Keyword::Expression},
+    {"co_return", Keyword::Statement},
+    {"co_yield", Keyword::Statement},
+    {"concept", Keyword::Declaration},
+    {"const", Keyword::Qualifier},
+    {"const_cast", Keyword::Expression},
+    {"consteval", Keyword::Declaration},
+    {"constexpr", Keyword::Declaration},
+    {"constinit", Keyword::Declaration},
+    {"continue", Keyword::Statement},
+    {"decltype", Keyword::Type},
+    {"default", Keyword::Statement},
+    {"delete", Keyword::Statement},
+    {"do", Keyword::Statement},
+    {"double", Keyword::Type},
+    {"dynamic_cast", Keyword::Expression},
+    {"enum", Keyword::Declaration},
+    {"explicit", Keyword::Declaration},
+    {"export", Keyword::Declaration},
+    {"extern", Keyword::Declaration},
+    {"false", Keyword::Expression},
+    {"float", Keyword::Type},
+    {"for", Keyword::Statement},
+    {"friend", Keyword::Declaration},
+    {"goto", Keyword::Statement},
+    {"if", Keyword::Statement},
+    {"import", Keyword::Declaration},
+    {"inline", Keyword::Declaration},
+    {"int", Keyword::Type},
+    {"long", Keyword::Type},
+    {"module", Keyword::Declaration},
+    {"namespace", Keyword::Declaration},
+    {"new", Keyword::Expression},
+    {"noexcept", Keyword::Expression},
+    {"nullptr", Keyword::Expression},
+    {"reinterpret_cast", Keyword::Expression},
+    {"requires", Keyword::Expression},
+    {"return", Keyword::Statement},
+    {"short", Keyword::Type},
+    {"signed", Keyword::Type},
+    {"sizeof", Keyword::Expression},
+    {"static", Keyword::Declaration},
+    {"static_assert", Keyword::Declaration},
+    {"static_cast", Keyword::Expression},
+    {"struct", Keyword::Declaration},
+    {"switch", Keyword::Statement},
+    {"template", Keyword::Declaration},
+    {"this", Keyword::Expression},
+    {"thread_local", Keyword::Declaration},
+    {"throw", Keyword::Statement},
+    {"true", Keyword::Expression},
+    {"try", Keyword::Statement},
+    {"typedef", Keyword::Declaration},
+    {"typeid", Keyword::Expression},
+    {"union", Keyword::Declaration},
+    {"unsigned", Keyword::Type},
+    {"using", Keyword::Declaration},
+    {"virtual", Keyword::Declaration},
+    {"void", Keyword::Type},
+    {"volatile", Keyword::Qualifier},
+    {"wchar_t", Keyword::Type},
+    {"while", Keyword::Statement},
+});
+
+static_assert(std::ranges::is_sorted(kKeywords, {}, &KeywordEntry::word));
+
+// Declarações que só terminam com corpo ou ';'
+constexpr std::array<std::string_view, 6> kBodyKeywords{
+    "class", "enum", "namespace", "struct", "template", "union"};
+
+constexpr std::array<std::string_view, 21> kTwoCharPunct{
+    "::", "->", "<<", ">>", "&&", "||", "++", "--", "==", "!=", "<=",
+    ">=", "+=", "-=", "*=", "/=", "%=", "&=", "|=", "^=", ".*"};
+
+Keyword keywordOf(const Token &token) {
+    if (token.kind != TokenKind::Identifier) {
+        return Keyword::None;
+    }
+    auto it = std::ranges::lower_bound(kKeywords, token.text, {},
+                                       &KeywordEntry::word);
+    return it != kKeywords.end() && it->word == token.text ? it->kind
+                                                           : Keyword::None;
+}
+
+bool isRawPrefix(std::string_view text) {
+    return text == "R" || text == "u8R" || text == "uR" || text == "UR" ||
+           text == "LR";
+}
+
+bool isEncodingPrefix(std::string_view text) {
+    return text == "u8" || text == "u" || text == "U" || text == "L";
+}
+
+// Primeira construção com mais tokens que isso é tratada como código
+constexpr size_t kLeadTokens = 128;
+
+/**
+ * @return Índice depois do '>' que fecha o '<' em @p i, ou npos se não
+ * fechar antes de um ';' (então era um "menor que")
+ */
+size_t skipTemplateArgs(std::span<const Token> tokens, size_t i) {
+    int angles = 0;
+    int nested = 0;
+    for (; i < tokens.size(); ++i) {
+        const Token &tok = tokens[i];
+        if (tok.kind != TokenKind::Punct) {
+            continue;
+        }
+        if (tok.is("(") || tok.is("[") || tok.is("{")) {
+            ++nested;
+        } else if (tok.is(")") || tok.is("]") || tok.is("}")) {
+            if (--nested < 0) {
+                return std::string_view::npos;
+            }
+        } else if (nested > 0) {
+            continue;
+        } else if (tok.is(";")) {
+            return std::string_view::npos;
+        } else if (tok.is("<")) {
+            ++angles;
+        } else if (tok.is(">") || tok.is(">>")) {
+            angles -= tok.text.size() == 1 ? 1 : 2;
+            if (angles <= 0) {
+                return i + 1;
+            }
+        }
+    }
+    return std::string_view::npos;
+}
+
+// nome-de-tipo [cv * & &&]... declarador
+bool looksLikeDeclaration(std::span<const Token> tokens) {
+    auto at = [&](size_t k) {
+        return k < tokens.size() ? tokens[k] : Token{};
+    };
+
+    size_t i = at(0).is("::") ? 1 : 0;
+    while (true) {
+        const Token name = at(i);
+        const Keyword kw = keywordOf(name);
+        if (name.kind != TokenKind::Identifier ||
+            (kw != Keyword::None && kw != Keyword::Type)) {
+            return false;
+        }
+        ++i;
+        if (at(i).is("<")) {
+            i = skipTemplateArgs(tokens, i);
+            if (i == std::string_view::npos) {
+                return false;
+            }
+        }
+        if (!at(i).is("::")) {
+            break;
+        }
+        ++i;
+    }
+
+    while (at(i).is("*") || at(i).is("&") || at(i).is("&&") ||
+           keywordOf(at(i)) == Keyword::Qualifier) {
+        ++i;
+    }
+
+    const Token declarator = at(i);
+    return declarator.kind == TokenKind::Identifier &&
+           keywordOf(declarator) == Keyword::None;
+}
+
+InputKind classifyLead(std::span<const Token> tokens) {
+    switch (keywordOf(tokens[0])) {
+    case Keyword::Declaration:
+    case Keyword::Type:
+    case Keyword::Qualifier:
+        return InputKind::Declaration;
+    case Keyword::Statement:
+        return InputKind::Statement;
+    case Keyword::Expression:
+        return InputKind::Expression;
+    case Keyword::None:
+        break;
+    }
+    return looksLikeDeclaration(tokens) ? InputKind::Declaration
+                                        : InputKind::Expression;
+}
+
+// "#include <x>" ou "#include "x""; false se não for #include
+bool parseInclude(std::string_view directive, InputClassification &result) {
+    directive.remove_prefix(1); // '#'
+    auto skipSpace = [&] {
+        while (!directive.empty() && is(directive.front(), kSpace)) {
+            directive.remove_prefix(1);
+        }
+    };
+    skipSpace();
+    if (!directive.starts_with("include") ||
+        (directive.size() > 7 && is(directive[7], kIdentStart | kDigit))) {
+        return false;
+    }
+    directive.remove_prefix(7);
+    skipSpace();
+
+    if (directive.empty() || (directive[0] != '<' && directive[0] != '"')) {
+        return true;
+    }
+    const char close = directive[0] == '<' ? '>' : '"';
+    const size_t end = directive.find(close, 1);
+    if (end != std::string_view::npos && end > 1) {
+        result.includeTarget = directive.substr(1, end - 1);
+        result.systemInclude = close == '>';
+    }
+    return true;
+}
+
+/**
+ * @brief Acompanha as construções de nível superior e diz se todas são só
+ * definições de tipo, alias, enum ou template (nada que gere código)
+ *
+ * Conservador: qualquer forma não reconhecida (função, variável,
+ * especialização explícita, namespace, diretiva...) desliga. Também guarda
+ * o nome de cada tipo definido; formas sem nome simples (struct anônima,
+ * nome qualificado, typedef de ponteiro para função) não entram.
+ */
+class TypeOnlyScan {
+  public:
+    void feed(const Token &tok, int depthBefore) {
+        if (tok.kind == TokenKind::Directive) {
+            typeOnly_ = false;
+            return;
+        }
+        if (depthBefore != 0) {
+            return;
+        }
+
+        if (shape_ == Shape::None) {
+            if (!tok.is(";")) {
+                start(tok);
+            }
+            return;
+        }
+
+        ++tokens_;
+        if (tok.is(";")) {
+            // class-key sem corpo só vale como "struct Nome;"
+            if (shape_ == Shape::ClassKey && !afterBody_ && tokens_ != 2) {
+                typeOnly_ = false;
+            }
+            // "struct Nome;" só declara: não é a definição do tipo
+            const bool declaresOnly =
+                shape_ == Shape::ClassKey
+                    ? !afterBody_
+                    : shape_ == Shape::Template && isClassKey(keyword_);
+            if (!declaresOnly) {
+                finishName();
+            }
+            shape_ = Shape::None;
+            return;
+        }
+
+        switch (shape_) {
+        case Shape::ClassKey:
+            // "} var;" declara uma variável; '(' é uma função
+            if (afterBody_ || tok.is("(")) {
+                typeOnly_ = false;
+            }
+            break;
+        case Shape::Template:
+            // "template <>" e "template class X<int>;" geram código
+            if ((tokens_ == 1 && !tok.is("<")) ||
+                (tokens_ == 2 && tok.is(">"))) {
+                typeOnly_ = false;
+            }
+            if (angles_ > 0 || tokens_ == 1) {
+                // Parâmetros do template: o nome vem depois do '>'
+                angles_ += tok.is("<") ? 1 : 0;
+                angles_ -= tok.is(">") ? 1 : tok.is(">>") ? 2 : 0;
+                return;
+            }
+            if (keyword_ == "template") {
+                keyword_ = tok.text; // class, using, concept ou o retorno
+                naming_ = isClassKey(keyword_) || keyword_ == "using" ||
+                          keyword_ == "concept";
+                return;
+            }
+            break;
+        default:
+            break;
+        }
+
+        trackName(tok);
+    }
+
+    /**
+     * @brief Chamado quando um '}' fecha um bloco de nível superior
+     */
+    void closedBody() {
+        if (shape_ == Shape::ClassKey) {
+            afterBody_ = true;
+        } else if (shape_ == Shape::Template) {
+            // Template de classe ou de função termina no '}'
+            if (isClassKey(keyword_)) {
+                finishName();
+            }
+            shape_ = Shape::None;
+        }
+    }
+
+    bool typeOnly() const { return typeOnly_ && seen_; }
+
+    std::vector<std::string_view> takeNames() { return std::move(names_); }
+
+  private:
+    enum class Shape { None, ClassKey, Alias, Template };
+
+    static bool isClassKey(std::string_view word) {
+        return word == "class" || word == "struct" || word == "union";
+    }
+
+    void start(const Token &tok) {
+        seen_ = true;
+        tokens_ = 0;
+        afterBody_ = false;
+        angles_ = 0;
+        keyword_ = tok.text;
+        name_ = {};
+        naming_ = false;
+        afterName_ = false;
+        if (tok.kind != TokenKind::Identifier) {
+            typeOnly_ = false;
+            shape_ = Shape::Alias; // só espera o ';'
+        } else if (tok.text == "class" || tok.text == "struct" ||
+                   tok.text == "union" || tok.text == "enum") {
+            shape_ = Shape::ClassKey;
+            naming_ = true;
+        } else if (tok.text == "template") {
+            shape_ = Shape::Template;
+        } else {
+            typeOnly_ = typeOnly_ &&
+                        (tok.text == "using" || tok.text == "typedef" ||
+                         tok.text == "static_assert");
+            shape_ = Shape::Alias;
+            naming_ = tok.text == "using";
+        }
+    }
+
+    void trackName(const Token &tok) {
+        const bool isIdent = tok.kind == TokenKind::Identifier;
+        if (keyword_ == "typedef") {
+            // O nome é o último identificador antes do ';'
+            name_ = isIdent ? tok.text : std::string_view{};
+            return;
+        }
+
+        if (afterName_) {
+            afterName_ = false;
+            // "A::B", especialização parcial "S<T*>" ou "using namespace"
+            const bool assigns = keyword_ == "using" || keyword_ == "concept";
+            if (tok.is("::") || tok.is("<") || (assigns && !tok.is("="))) {
+                name_ = {};
+            }
+            return;
+        }
+
+        if (!naming_) {
+            return;
+        }
+        if (!isIdent) {
+            // Atributos ([[...]]) vêm antes do nome; '{' é tipo anônimo
+            naming_ = tok.is("[");
+            return;
+        }
+        if (keyword_ == "enum" && tokens_ == 1 &&
+            (tok.text == "class" || tok.text == "struct")) {
+            return;
+        }
+        if (tok.text == "alignas") {
+            return;
+        }
+        name_ = tok.text;
+        naming_ = false;
+        afterName_ = true;
+    }
+
+    void finishName() {
+        if (!name_.empty()) {
+            names_.push_back(name_);
+        }
+        name_ = {};
+        naming_ = false;
+        afterName_ = false;
+    }
+
+    Shape shape_ = Shape::None;
+    size_t tokens_ = 0;
+    int angles_ = 0;
+    bool afterBody_ = false;
+    bool seen_ = false;
+    bool typeOnly_ = true;
+
+    std::string_view keyword_; // palavra que abre a construção atual
+    std::string_view name_;
+    bool naming_ = false;    // o próximo identificador é o nome
+    bool afterName_ = false; // o token anterior foi o nome
+    std::vector<std::string_view> names_;
+};
+
+} // namespace
+
+std::string_view inputKindName(InputKind kind) {
+    switch (kind) {
+    case InputKind::Empty:
+        return "empty";
+    case InputKind::Include:
+        return "include";
+    case InputKind::Preprocessor:
+        return "preprocessor";
+    case InputKind::Declaration:
+        return "declaration";
+    case InputKind::Statement:
+        return "statement";
+    case InputKind::Expression:
+        return "expression";
+    }
+    return "unknown";
+}
+
+void Tokenizer::skipSpaceAndComments() {
+    while (pos_ < src_.size()) {
+        const char c = src_[pos_];
+        if (c == '\n') {
+            lineStart_ = true;
+            ++pos_;
+        } else if (is(c, kSpace)) {
+            ++pos_;
+        } else if (c == '\\') {
+            // Continuação de linha
+            size_t next = pos_ + 1;
+            while (next < src_.size() && (src_[next] == ' ' ||
+                                          src_[next] == '\t' ||
+                                          src_[next] == '\r')) {
+                ++next;
+            }
+            if (next >= src_.size()) {
+                unterminated_ = true;
+                pos_ = next;
+            } else if (src_[next] == '\n') {
+                pos_ = next + 1;
+            } else {
+                return;
+            }
+        } else if (src_.substr(pos_, 2) == "//") {
+            const size_t end = src_.find('\n', pos_);
+            pos_ = end == std::string_view::npos ? src_.size() : end;
+        } else if (src_.substr(pos_, 2) == "/*") {
+            const size_t end = src_.find("*/", pos_ + 2);
+            if (end == std::string_view::npos) {
+                unterminated_ = true;
+                pos_ = src_.size();
+            } else {
+                pos_ = end + 2;
+            }
+        } else {
+            return;
+        }
+    }
+}
+
+Token Tokenizer::next() {
+    skipSpaceAndComments();
+    if (pos_ >= src_.size()) {
+        return {};
+    }
+
+    const size_t begin = pos_;
+    const char c = src_[pos_];
+    const bool lineStart = std::exchange(lineStart_, false);
+
+    if (c == '#' && lineStart) {
+        return lexDirective(begin);
+    }
+    if (is(c, kIdentStart)) {
+        return lexIdentifier(begin);
+    }
+    if (is(c, kDigit) ||
+        (c == '.' && pos_ + 1 < src_.size() && is(src_[pos_ + 1], kDigit))) {
+        return lexNumber(begin);
+    }
+    if (c == '"' || c == '\'') {
+        return lexQuoted(begin, c);
+    }
+    return lexPunct(begin);
+}
+
+Token Tokenizer::lexDirective(size_t begin) {
+    // Até o fim da linha lógica
+    while (pos_ < src_.size()) {
+        const size_t end = src_.find('\n', pos_);
+        if (end == std::string_view::npos) {
+            pos_ = src_.size();
+            break;
+        }
+        size_t last = end;
+        while (last > pos_ &&
+               (src_[last - 1] == ' ' || src_[last - 1] == '\r' ||
+                src_[last - 1] == '\t')) {
+            --last;
+        }
+        pos_ = end;
+        if (last == begin || src_[last - 1] != '\\') {
+            break;
+        }
+        ++pos_;
+    }
+    if (src_.substr(begin, pos_ - begin).ends_with('\\')) {
+        unterminated_ = true;
+    }
+    return {TokenKind::Directive, src_.substr(begin, pos_ - begin)};
+}
+
+Token Tokenizer::lexIdentifier(size_t begin) {
+    while (pos_ < src_.size() && is(src_[pos_], kIdentStart | kDigit)) {
+        ++pos_;
+    }
+    const auto text = src_.substr(begin, pos_ - begin);
+    if (pos_ < src_.size()) {
+        if (src_[pos_] == '"' && isRawPrefix(text)) {
+            return lexRawString(begin);
+        }
+        if ((src_[pos_] == '"' || src_[pos_] == '\'') &&
+            isEncodingPrefix(text)) {
+            return lexQuoted(begin, src_[pos_]);
+        }
+    }
+    return {TokenKind::Identifier, text};
+}
+
+Token Tokenizer::lexNumber(size_t begin) {
+    // pp-number: 1'000, 0x1p-3, 1.5e+10f, 42ull
+    while (pos_ < src_.size()) {
+        const char c = src_[pos_];
+        const char prev = src_[pos_ - 1];
+        if (is(c, kIdentStart | kDigit) || c == '.') {
+            ++pos_;
+        } else if (c == '\'' && pos_ + 1 < src_.size() &&
+                   is(src_[pos_ + 1], kIdentStart | kDigit)) {
+            pos_ += 2;
+        } else if ((c == '+' || c == '-') &&
+                   (prev == 'e' || prev == 'E' || prev == 'p' ||
+                    prev == 'P')) {
+            ++pos_;
+        } else {
+            break;
+        }
+    }
+    return {TokenKind::Number, src_.substr(begin, pos_ - begin)};
+}
+
+Token Tokenizer::lexQuoted(size_t begin, char quote) {
+    // pos_ está nas aspas (depois de um eventual prefixo)
+    ++pos_;
+    while (pos_ < src_.size()) {
+        const char c = src_[pos_];
+        if (c == '\\') {
+            pos_ += 2;
+        } else if (c == quote) {
+            ++pos_;
+            break;
+        } else if (c == '\n') {
+            break; // literal sem fechar: o compilador reclama
+        } else {
+            ++pos_;
+        }
+    }
+    pos_ = std::min(pos_, src_.size());
+    return {quote == '"' ? TokenKind::String : TokenKind::Char,
+            src_.substr(begin, pos_ - begin)};
+}
+
+Token Tokenizer::lexRawString(size_t begin) {
+    // R"delim( ... )delim"
+    const size_t open = src_.find('(', pos_ + 1);
+    if (open == std::string_view::npos || open - pos_ - 1 > 16) {
+        return lexQuoted(begin, '"');
+    }
+    const auto delimiter = src_.substr(pos_ + 1, open - pos_ - 1);
+
+    for (size_t close = src_.find(')', open + 1);
+         close != std::string_view::npos; close = src_.find(')', close + 1)) {
+        const size_t quote = close + 1 + delimiter.size();
+        if (quote < src_.size() && src_[quote] == '"' &&
+            src_.substr(close + 1, delimiter.size()) == delimiter) {
+            pos_ = quote + 1;
+            return {TokenKind::String, src_.substr(begin, pos_ - begin)};
+        }
+    }
+
+    unterminated_ = true;
+    pos_ = src_.size();
+    return {TokenKind::String, src_.substr(begin)};
+}
+
+Token Tokenizer::lexPunct(size_t begin) {
+    size_t length = 1;
+    if (src_.substr(pos_, 3) == "...") {
+        length = 3;
+    } else if (std::ranges::find(kTwoCharPunct, src_.substr(pos_, 2)) !=
+               kTwoCharPunct.end()) {
+        length = 2;
+    }
+    pos_ += length;
+    return {TokenKind::Punct, src_.substr(begin, length)};
+}
+
+void InputAccumulator::Balance::feed(const Token &token) {
+    if (token.kind == TokenKind::Directive) {
+        return;
+    }
+    if (!seenToken) {
+        seenToken = true;
+        needsBody = token.kind == TokenKind::Identifier &&
+                    std::ranges::find(kBodyKeywords, token.text) !=
+                        kBodyKeywords.end();
+    }
+
+    last = 0;
+    if (token.kind != TokenKind::Punct || token.text.size() != 1) {
+        return;
+    }
+    last = token.text[0];
+    switch (last) {
+    case '(':
+        ++parens;
+        break;
+    case ')':
+        --parens;
+        break;
+    case '{':
+        ++braces;
+        break;
+    case '}':
+        --braces;
+        break;
+    case '[':
+        ++brackets;
+        break;
+    case ']':
+        --brackets;
+        break;
+    default:
+        break;
+    }
+}
+
+bool InputAccumulator::Balance::complete() const {
+    // Fechamentos a mais não seguram a entrada: o compilador reporta
+    return parens <= 0 && braces <= 0 && brackets <= 0 &&
+           (!needsBody || last == ';' || last == '}');
+}
+
+void InputAccumulator::append(std::string_view line) {
+    if (!text_.empty()) {
+        text_ += '\n';
+    }
+    text_ += line;
+    ++lines_;
+
+    // Retoma do último ponto sem comentário/raw string aberto
+    Balance balance = committed_;
+    Tokenizer tokenizer(std::string_view(text_).substr(scanned_));
+    for (Token tok = tokenizer.next(); tok.kind != TokenKind::End;
+         tok = tokenizer.next()) {
+        balance.feed(tok);
+    }
+
+    current_ = balance;
+    unterminated_ = tokenizer.unterminated();
+    if (!unterminated_) {
+        committed_ = balance;
+        scanned_ = text_.size();
+    }
+}
+
+bool InputAccumulator::complete() const {
+    return !unterminated_ && current_.complete();
+}
+
+std::string InputAccumulator::take() {
+    std::string text = std::move(text_);
+    *this = InputAccumulator{};
+    return text;
+}
+
+InputClassification classifyInput(std::string_view input) {
+    InputClassification result;
+    Tokenizer tokenizer(input);
+    InputAccumulator::Balance balance;
+
+    std::array<Token, kLeadTokens> lead;
+    size_t leadCount = 0;
+    size_t directives = 0;
+    std::string_view firstDirective;
+
+    TypeOnlyScan typeOnly;
+
+    for (Token tok = tokenizer.next(); tok.kind != TokenKind::End;
+         tok = tokenizer.next()) {
+        const int depth = balance.parens + balance.braces + balance.brackets;
+        typeOnly.feed(tok, depth);
+        balance.feed(tok);
+        if (depth == 1 && tok.is("}") && balance.braces == 0) {
+            typeOnly.closedBody();
+        }
+
+        if (tok.kind == TokenKind::Directive) {
+            if (directives++ == 0) {
+                firstDirective = tok.text;
+            }
+        } else if (leadCount < lead.size()) {
+            lead[leadCount++] = tok;
+        }
+    }
+
+    result.complete = !tokenizer.unterminated() && balance.complete();
+
+    if (leadCount == 0) {
+        if (directives == 1 && parseInclude(firstDirective, result)) {
+            result.kind = InputKind::Include;
+        } else if (directives > 0) {
+            result.kind = InputKind::Preprocessor;
+        }
+        return result;
+    }
+
+    result.kind = classifyLead(std::span(lead.data(), leadCount));
+    if (result.kind == InputKind::Expression &&
+        (balance.last == ';' || balance.last == '}')) {
+        result.kind = InputKind::Statement;
+    }
+    result.typeOnly = result.kind == InputKind::Declaration &&
+                      result.complete && typeOnly.typeOnly();
+    if (result.typeOnly) {
+        result.typeNames = typeOnly.takeNames();
+    }
+    return result;
+}
+
+} // namespace analysis
@@ -0,0 +1,63 @@
+#include "analysis/snippet_batcher.hpp"
+
+#include <format>
+#include <utility>
+
+namespace analysis {
+
+SnippetBatcher::SnippetBatcher(std::string lineFile)
+    : lineFile_(std::move(lineFile)) {}
+
+bool SnippetBatcher::batchable(const InputClassification &input) {
+    return input.complete && (input.kind == InputKind::Declaration ||
+                              input.isExecutable());
+}
+
+bool SnippetBatcher::accepts(const InputClassification &input) const {
+    if (empty()) {
+        return true;
+    }
+    const auto kind = input.kind == InputKind::Declaration
+                          ? SnippetBatch::Kind::Declarations
+                          : SnippetBatch::Kind::Statements;
+    return kind == batch_.kind;
+}
+
+void SnippetBatcher::add(std::string_view block, int64_t line,
+                         const InputClassification &input) {
+    if (empty()) {
+        batch_.kind = input.kind == InputKind::Declaration
+                          ? SnippetBatch::Kind::Declarations
+                          : SnippetBatch::Kind::Statements;
+        batch_.firstLine = line;
+    }
+
+    if (lineFile_.empty()) {
+        batch_.code += std::format("#line {}\n", line);
+    } else {
+        batch_.code += std::format("#line {} \"{}\"\n", line, lineFile_);
+    }
+    batch_.code += block;
+
+    // Mesmo ';' que o execRepl acrescenta, numa linha própria para não cair
+    // dentro de um comentário no fim do bloco
+    batch_.code +=
+        batch_.kind == SnippetBatch::Kind::Statements ? "\n;\n" : "\n";
+
+    size_t lines = 1;
+    for (const char c : block) {
+        lines += c == '\n';
+    }
+    batch_.lastLine = line + static_cast<int64_t>(lines) - 1;
+    ++batch_.snippets;
+}
+
+SnippetBatch SnippetBatcher::take() {
+    SnippetBatch batch = std::exchange(batch_, SnippetBatch{});
+    if (batch.kind == SnippetBatch::Kind::Statements && batch.snippets > 0) {
+        batch.code = std::format("void exec() {{\n{}}}\n", batch.code);
+    }
+    return batch;
+}
+
+} // namespace analysis
@@ -0,0 +1,353 @@
+#include "analysis/snippet_graph.hpp"
+
+#include "analysis/input_classifier.hpp"
+
+#include <algorithm>
+#include <array>
+#include <utility>
+
+namespace analysis {
+
+namespace {
+
+// Palavras que aparecem antes do declarador mas nunca são o nome declarado.
+// Ordenada para busca binária
+constexpr auto kNotNames = std::to_array<std::string_view>({
+    "alignas", "auto", "bool", "char", "char16_t", "char32_t", "char8_t",
+    "class", "concept", "const", "consteval", "constexpr", "constinit",
+    "decltype", "double", "enum", "explicit", "export", "extern", "final",
+    "float", "friend", "inline", "int", "long", "mutable", "noexcept",
+    "override", "register", "requires", "short", "signed", "static",
+    "static_assert", "struct", "thread_local", "typedef", "typename", "union",
+    "unsigned", "virtual", "void", "volatile", "wchar_t",
+});
+
+static_assert(std::ranges::is_sorted(kNotNames));
+
+bool notAName(std::string_view word) {
+    return std::ranges::binary_search(kNotNames, word);
+}
+
+std::vector<Token> tokenize(std::string_view code) {
+    std::vector<Token> tokens;
+    Tokenizer tokenizer(code);
+    for (Token tok = tokenizer.next(); tok.kind != TokenKind::End;
+         tok = tokenizer.next()) {
+        if (tok.kind != TokenKind::Directive) {
+            tokens.push_back(tok);
+        }
+    }
+    return tokens;
+}
+
+bool isIdentifier(const std::vector<Token> &tokens, size_t i,
+                  std::string_view text) {
+    return i < tokens.size() && tokens[i].kind == TokenKind::Identifier &&
+           tokens[i].text == text;
+}
+
+bool isPunct(const std::vector<Token> &tokens, size_t i,
+             std::string_view text) {
+    return i < tokens.size() && tokens[i].is(text);
+}
+
+/**
+ * @return Índice do token depois do '>' que fecha o cabeçalho de template
+ * que começa em @p i (o '<')
+ */
+size_t skipTemplateHeader(const std::vector<Token> &tokens, size_t i) {
+    int angles = 0;
+    int nested = 0;
+    for (; i < tokens.size(); ++i) {
+        const Token &tok = tokens[i];
+        if (tok.is("(") || tok.is("[") || tok.is("{")) {
+            ++nested;
+        } else if (tok.is(")") || tok.is("]") || tok.is("}")) {
+            --nested;
+        } else if (nested > 0) {
+            continue;
+        } else if (tok.is("<")) {
+            ++angles;
+        } else if (tok.is(">") || tok.is(">>")) {
+            angles -= tok.text.size() == 1 ? 1 : 2;
+            if (angles <= 0) {
+                return i + 1;
+            }
+        }
+    }
+    return i;
+}
+
+} // namespace
+
+std::unordered_set<std::string> referencedNames(std::string_view code) {
+    std::unordered_set<std::string> names;
+    Tokenizer tokenizer(code);
+    for (Token tok = tokenizer.next(); tok.kind != TokenKind::End;
+         tok = tokenizer.next()) {
+        if (tok.kind == TokenKind::Identifier) {
+            names.emplace(tok.text);
+        }
+    }
+    return names;
+}
+
+std::vector<std::string> declaredNames(std::string_view code) {
+    const auto tokens = tokenize(code);
+
+    std::vector<std::string> names;
+    int nested = 0; // (), [] e corpos; namespace e extern "C" não contam
+    int angles = 0; // argumentos de template no tipo, antes do declarador
+    std::string_view candidate;
+    bool named = false;
+
+    auto declare = [&] {
+        if (named || candidate.empty()) {
+            return;
+        }
+        if (std::ranges::find(names, candidate) == names.end()) {
+            names.emplace_back(candidate);
+        }
+        named = true;
+    };
+    auto reset = [&] {
+        candidate = {};
+        named = false;
+        angles = 0;
+    };
+
+    for (size_t i = 0; i < tokens.size(); ++i) {
+        const Token &tok = tokens[i];
+
+        if (nested > 0) {
+            if (tok.is("(") || tok.is("[") || tok.is("{")) {
+                ++nested;
+            } else if (tok.is(")") || tok.is("]") || tok.is("}")) {
+                if (--nested == 0 && tok.is("}")) {
+                    reset(); // fim do corpo de função ou classe
+                }
+            }
+            continue;
+        }
+
+        if (tok.kind == TokenKind::Identifier) {
+            if (tok.text == "template" && isPunct(tokens, i + 1, "<")) {
+                i = skipTemplateHeader(tokens, i + 1) - 1;
+            } else if (tok.text == "namespace") {
+                std::string_view alias;
+                size_t j = i + 1;
+                while (j < tokens.size() &&
+                       (tokens[j].kind == TokenKind::Identifier ||
+                        tokens[j].is("::"))) {
+                    if (tokens[j].kind == TokenKind::Identifier) {
+                        alias = tokens[j].text;
+                    }
+                    ++j;
+                }
+                if (isPunct(tokens, j, "{")) {
+                    reset();
+                    i = j;
+                } else {
+                    candidate = alias; // namespace fs = std::filesystem;
+                    i = j - 1;
+                }
+            } else if (tok.text == "extern" && i + 1 < tokens.size() &&
+                       tokens[i + 1].kind == TokenKind::String) {
+                if (isPunct(tokens, i + 2, "{")) {
+                    reset();
+                    i += 2;
+                } else {
+                    ++i; // extern "C" <declaração>
+                }
+            } else if (tok.text == "using" &&
+                       isIdentifier(tokens, i + 1, "namespace")) {
+                while (i < tokens.size() && !tokens[i].is(";")) {
+                    ++i;
+                }
+                reset();
+            } else if (tok.text == "operator") {
+                named = true; // operadores não são citados pelo nome
+            } else if (!notAName(tok.text)) {
+                candidate = tok.text;
+            }
+            continue;
+        }
+
+        if (!named && tok.is("<")) {
+            ++angles;
+        } else if (!named && (tok.is(">") || tok.is(">>"))) {
+            angles = std::max(angles - static_cast<int>(tok.text.size()), 0);
+        } else if (angles > 0 && tok.is(",")) {
+            continue; // std::map<K, V>
+        } else if (tok.is("(") || tok.is("[") || tok.is("{")) {
+            declare();
+            ++nested;
+        } else if (tok.is("=") || tok.is(":")) {
+            declare();
+        } else if (tok.is(";") || tok.is(",")) {
+            declare();
+            reset();
+        } else if (tok.is("}")) {
+            reset(); // fecha namespace ou extern "C"
+        }
+    }
+
+    return names;
+}
+
+void SnippetGraph::record(const std::string &unit, std::string_view code,
+                          std::vector<std::string> provides) {
+    if (auto it = index_.find(unit); it != index_.end()) {
+        nodes_.erase(nodes_.begin() + static_cast<std::ptrdiff_t>(it->second));
+        index_.clear();
+        for (size_t i = 0; i < nodes_.size(); ++i) {
+            index_.emplace(nodes_[i].unit, i);
+        }
+    }
+
+    Node node;
+    node.unit = unit;
+    node.provides = std::move(provides);
+    node.uses = referencedNames(code);
+
+    std::vector<size_t> providers;
+    for (const auto &name : node.uses) {
+        if (std::ranges::find(node.provides, name) != node.provides.end()) {
+            continue;
+        }
+        for (size_t i = nodes_.size(); i-- > 0;) {
+            if (std::ranges::find(nodes_[i].provides, name) !=
+                nodes_[i].provides.end()) {
+                providers.push_back(i);
+                break;
+            }
+        }
+    }
+    std::ranges::sort(providers);
+    const auto [first, last] = std::ranges::unique(providers);
+    providers.erase(first, last);
+    for (const size_t i : providers) {
+        node.dependsOn.push_back(nodes_[i].unit);
+    }
+
+    index_.emplace(unit, nodes_.size());
+    nodes_.push_back(std::move(node));
+}
+
+std::vector<std::string>
+SnippetGraph::providersOf(std::string_view name) const {
+    std::vector<std::string> units;
+    for (const auto &node : nodes_) {
+        if (std::ranges::find(node.provides, name) != node.provides.end()) {
+            units.push_back(node.unit);
+        }
+    }
+    return units;
+}
+
+std::vector<std::string> SnippetGraph::affectedBy(std::string_view name) const {
+    size_t latest = nodes_.size();
+    for (size_t i = nodes_.size(); i-- > 0;) {
+        if (std::ranges::find(nodes_[i].provides, name) !=
+            nodes_[i].provides.end()) {
+            latest = i;
+            break;
+        }
+    }
+    if (latest == nodes_.size()) {
+        return {};
+    }
+
+    // dependsOn só aponta para trás: uma passada em ordem fecha o conjunto
+    const std::string key(name);
+    std::unordered_set<std::string> stale;
+    std::vector<std::string> units;
+    for (size_t i = 0; i < nodes_.size(); ++i) {
+        if (i == latest) {
+            continue;
+        }
+        const auto &node = nodes_[i];
+        const bool providesName =
+            std::ranges::find(node.provides, name) != node.provides.end();
+        const bool direct =
+            i < latest && !providesName && node.uses.contains(key);
+        const bool indirect =
+            std::ranges::any_of(node.dependsOn, [&](const std::string &dep) {
+                return stale.contains(dep);
+            });
+        if (direct || indirect) {
+            stale.insert(node.unit);
+            units.push_back(node.unit);
+        }
+    }
+    return units;
+}
+
+const SnippetGraph::Node *SnippetGraph::find(std::string_view unit) const {
+    auto it = index_.find(std::string(unit));
+    return it == index_.end() ? nullptr : &nodes_[it->second];
+}
+
+void SnippetGraph::clear() {
+    nodes_.clear();
+    index_.clear();
+}
+
+std::vector<std::vector<size_t>>
+SnippetGraph::parallelWaves(const std::vector<std::string> &codes) {
+    const size_t n = codes.size();
+    std::vector<std::vector<std::string>> declared(n);
+    std::vector<std::unordered_set<std::string>> uses(n);
+    for (size_t i = 0; i < n; ++i) {
+        declared[i] = declaredNames(codes[i]);
+        uses[i] = referencedNames(codes[i]);
+    }
+
+    std::vector<std::vector<size_t>> deps(n);
+    for (size_t i = 0; i < n; ++i) {
+        for (size_t j = 0; j < n; ++j) {
+            if (i == j) {
+                continue;
+            }
+            const bool needs =
+                std::ranges::any_of(declared[j], [&](const std::string &name) {
+                    return uses[i].contains(name) &&
+                           std::ranges::find(declared[i], name) ==
+                               declared[i].end();
+                });
+            if (needs) {
+                deps[i].push_back(j);
+            }
+        }
+    }
+
+    std::vector<std::vector<size_t>> waves;
+    std::vector<bool> done(n, false);
+    size_t remaining = n;
+    while (remaining > 0) {
+        std::vector<size_t> wave;
+        for (size_t i = 0; i < n; ++i) {
+            if (!done[i] && std::ranges::all_of(deps[i], [&](size_t j) {
+                    return done[j];
+                })) {
+                wave.push_back(i);
+            }
+        }
+        if (wave.empty()) {
+            // Ciclo: compila o resto junto, como antes do grafo
+            for (size_t i = 0; i < n; ++i) {
+                if (!done[i]) {
+                    wave.push_back(i);
+                }
+            }
+        }
+        for (const size_t i : wave) {
+            done[i] = true;
+        }
+        remaining -= wave.size();
+        waves.push_back(std::move(wave));
+    }
+    return waves;
+}
+
+} // namespace analysis
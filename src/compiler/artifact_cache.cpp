@@ -0,0 +1,582 @@
+#include "compiler/artifact_cache.hpp"
+
+#include "../../repl.hpp"
+#include "analysis/ast_context.hpp"
+#include "execution/memory_artifacts.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <system_error>
+#include <unistd.h>
+
+namespace compiler {
+
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr std::string_view kMetaMagic = "cpprepl-artifact 3";
+constexpr const char *kMetaFile = "meta";
+constexpr const char *kLibraryFile = "lib.so";
+constexpr const char *kDepsFile = "deps";
+
+// Variantes seguidas por lookup() antes de desistir
+constexpr int kMaxVariants = 8;
+
+// Campos são gravados como "<tamanho>\n<bytes>\n" para aceitar qualquer
+// conteúdo (quebras de linha em tipos, diagnósticos, etc.)
+void writeField(std::ostream &out, std::string_view value) {
+    out << value.size() << '\n';
+    out.write(value.data(), static_cast<std::streamsize>(value.size()));
+    out << '\n';
+}
+
+bool readField(std::istream &in, std::string &value) {
+    size_t size = 0;
+    if (!(in >> size) || in.get() != '\n') {
+        return false;
+    }
+    value.resize(size);
+    in.read(value.data(), static_cast<std::streamsize>(size));
+    return in.good() && in.get() == '\n';
+}
+
+bool readNumber(std::istream &in, int64_t &value) {
+    std::string text;
+    if (!readField(in, text)) {
+        return false;
+    }
+    char *end = nullptr;
+    value = std::strtoll(text.c_str(), &end, 10);
+    return end && *end == '\0';
+}
+
+bool writeMeta(const fs::path &path, const ArtifactCache::Entry &entry) {
+    std::ofstream out(path, std::ios::out | std::ios::binary);
+    if (!out.is_open()) {
+        return false;
+    }
+
+    out << kMetaMagic << '\n';
+    writeField(out, entry.success ? "ok" : "fail");
+    writeField(out, entry.sourceName);
+    writeField(out, entry.diagnostics);
+
+    writeField(out, std::to_string(entry.variables.size()));
+    for (const auto &var : entry.variables) {
+        writeField(out, var.name);
+        writeField(out, var.mangledName);
+        writeField(out, var.type);
+        writeField(out, var.qualType);
+        writeField(out, var.kind);
+        writeField(out, var.file);
+        writeField(out, std::to_string(var.line));
+    }
+
+    writeField(out, std::to_string(entry.snippets.size()));
+    for (const auto &snippet : entry.snippets) {
+        writeField(out, snippet.codeSnippet);
+        writeField(out, snippet.filename);
+        writeField(out, std::to_string(snippet.line));
+        writeField(out, std::to_string(snippet.column));
+        writeField(out, snippet.key);
+    }
+
+    writeField(out, std::to_string(entry.provides.size()));
+    for (const auto &name : entry.provides) {
+        writeField(out, name);
+    }
+
+    out.flush();
+    return out.good();
+}
+
+std::optional<ArtifactCache::Entry> readMeta(const fs::path &path) {
+    std::ifstream in(path, std::ios::in | std::ios::binary);
+    if (!in.is_open()) {
+        return std::nullopt;
+    }
+
+    std::string magic;
+    if (!std::getline(in, magic) || magic != kMetaMagic) {
+        return std::nullopt;
+    }
+
+    ArtifactCache::Entry entry;
+    std::string status;
+    if (!readField(in, status) || !readField(in, entry.sourceName) ||
+        !readField(in, entry.diagnostics)) {
+        return std::nullopt;
+    }
+    entry.success = status == "ok";
+
+    int64_t count = 0;
+    if (!readNumber(in, count) || count < 0) {
+        return std::nullopt;
+    }
+    entry.variables.resize(static_cast<size_t>(count));
+    for (auto &var : entry.variables) {
+        int64_t line = 0;
+        if (!readField(in, var.name) || !readField(in, var.mangledName) ||
+            !readField(in, var.type) || !readField(in, var.qualType) ||
+            !readField(in, var.kind) || !readField(in, var.file) ||
+            !readNumber(in, line)) {
+            return std::nullopt;
+        }
+        var.line = static_cast<int>(line);
+    }
+
+    if (!readNumber(in, count) || count < 0) {
+        return std::nullopt;
+    }
+    entry.snippets.resize(static_cast<size_t>(count));
+    for (auto &snippet : entry.snippets) {
+        if (!readField(in, snippet.codeSnippet) ||
+            !readField(in, snippet.filename) ||
+            !readNumber(in, snippet.line) || !readNumber(in, snippet.column) ||
+            !readField(in, snippet.key)) {
+            return std::nullopt;
+        }
+    }
+
+    if (!readNumber(in, count) || count < 0) {
+        return std::nullopt;
+    }
+    entry.provides.resize(static_cast<size_t>(count));
+    for (auto &name : entry.provides) {
+        if (!readField(in, name)) {
+            return std::nullopt;
+        }
+    }
+
+    return entry;
+}
+
+uint64_t directorySize(const fs::path &dir) {
+    uint64_t total = 0;
+    std::error_code ec;
+    for (fs::recursive_directory_iterator it(dir, ec), end; !ec && it != end;
+         it.increment(ec)) {
+        std::error_code fec;
+        if (it->is_regular_file(fec)) {
+            auto size = it->file_size(fec);
+            if (!fec) {
+                total += size;
+            }
+        }
+    }
+    return total;
+}
+
+} // namespace
+
+// ArtifactHasher ---------------------------------------------------------
+
+ArtifactHasher &ArtifactHasher::update(std::string_view data) {
+    constexpr unsigned __int128 prime =
+        (static_cast<unsigned __int128>(0x0000000001000000ULL) << 64) |
+        0x000000000000013BULL;
+    for (unsigned char c : data) {
+        state_ ^= c;
+        state_ *= prime;
+    }
+    return *this;
+}
+
+ArtifactHasher &ArtifactHasher::field(std::string_view label,
+                                      std::string_view data) {
+    update(label);
+    update(std::format(":{}:", data.size()));
+    return update(data);
+}
+
+ArtifactHasher &ArtifactHasher::file(std::string_view label,
+                                     const fs::path &path) {
+    std::ifstream in(path, std::ios::in | std::ios::binary);
+    if (!in.is_open()) {
+        return field(label, "<missing>");
+    }
+    std::string contents((std::istreambuf_iterator<char>(in)),
+                         std::istreambuf_iterator<char>());
+    return field(label, contents);
+}
+
+std::string ArtifactHasher::hex() const {
+    return std::format("{:016x}{:016x}", static_cast<uint64_t>(state_ >> 64),
+                       static_cast<uint64_t>(state_));
+}
+
+// Dependências -----------------------------------------------------------
+
+std::vector<std::string> parseDepFile(std::string_view text) {
+    std::vector<std::string> deps;
+    size_t pos = text.find(": ");
+    if (pos == std::string_view::npos) {
+        return deps;
+    }
+    pos += 2;
+
+    std::string current;
+    auto flush = [&] {
+        if (!current.empty()) {
+            deps.push_back(std::move(current));
+            current.clear();
+        }
+    };
+    for (; pos < text.size(); ++pos) {
+        const char c = text[pos];
+        if (c == '\\' && pos + 1 < text.size()) {
+            const char next = text[pos + 1];
+            if (next == '\n') {
+                ++pos; // continuação de linha
+                flush();
+                continue;
+            }
+            if (next == ' ' || next == '#') {
+                current += next;
+                ++pos;
+                continue;
+            }
+        }
+        if (c == '$' && pos + 1 < text.size() && text[pos + 1] == '$') {
+            current += '$';
+            ++pos;
+            continue;
+        }
+        if (c == ' ' || c == '\t' || c == '\n' || c == '\r') {
+            flush();
+            if (c == '\n') {
+                break; // uma regra só
+            }
+            continue;
+        }
+        current += c;
+    }
+    flush();
+    return deps;
+}
+
+std::string formatDependencies(const std::vector<std::string> &paths) {
+    std::string list;
+    for (const auto &path : paths) {
+        list += std::format("{} {}\n", ArtifactHasher().file("dep", path).hex(),
+                            path);
+    }
+    return list;
+}
+
+std::optional<std::vector<std::string>>
+changedDependencies(std::string_view list) {
+    std::vector<std::string> paths;
+    bool changed = false;
+    while (!list.empty()) {
+        const size_t end = list.find('\n');
+        const auto line = list.substr(0, end);
+        list.remove_prefix(end == std::string_view::npos ? list.size()
+                                                         : end + 1);
+
+        const size_t space = line.find(' ');
+        if (space == std::string_view::npos) {
+            continue;
+        }
+        std::string path(line.substr(space + 1));
+        changed = changed || ArtifactHasher().file("dep", path).hex() !=
+                                 line.substr(0, space);
+        paths.push_back(std::move(path));
+    }
+    if (!changed) {
+        return std::nullopt;
+    }
+    return paths;
+}
+
+std::string dependencyVariant(const std::string &key,
+                              const std::vector<std::string> &paths) {
+    ArtifactHasher hasher;
+    hasher.field("variant", key);
+    for (const auto &path : paths) {
+        hasher.file(path, path);
+    }
+    return hasher.hex();
+}
+
+// ArtifactCache ----------------------------------------------------------
+
+ArtifactCache::ArtifactCache(fs::path root, uint64_t maxBytes)
+    : root_(std::move(root)), maxBytes_(maxBytes) {}
+
+ArtifactCache::~ArtifactCache() = default;
+
+fs::path ArtifactCache::defaultRoot() {
+    if (const char *dir = std::getenv("CPPREPL_CACHE_DIR"); dir && *dir) {
+        return dir;
+    }
+    if (const char *xdg = std::getenv("XDG_CACHE_HOME"); xdg && *xdg) {
+        return fs::path(xdg) / "cpprepl";
+    }
+    if (const char *home = std::getenv("HOME"); home && *home) {
+        return fs::path(home) / ".cache" / "cpprepl";
+    }
+    return fs::temp_directory_path() / "cpprepl-cache";
+}
+
+uint64_t ArtifactCache::defaultMaxBytes() {
+    uint64_t mb = 512;
+    if (const char *env = std::getenv("CPPREPL_CACHE_MAX_MB"); env && *env) {
+        char *end = nullptr;
+        auto value = std::strtoull(env, &end, 10);
+        if (end && *end == '\0' && value > 0) {
+            mb = value;
+        }
+    }
+    return mb * 1024 * 1024;
+}
+
+fs::path ArtifactCache::entryDir(const std::string &key) const {
+    return root_ / "objects" / key.substr(0, 2) / key;
+}
+
+fs::path ArtifactCache::makeTempDir() {
+    auto dir = root_ / "tmp" /
+               std::format("{}.{}", getpid(),
+                           tempCounter_.fetch_add(1, std::memory_order_relaxed));
+    std::error_code ec;
+    fs::remove_all(dir, ec);
+    fs::create_directories(dir, ec);
+    return ec ? fs::path{} : dir;
+}
+
+void ArtifactCache::discard(const fs::path &dir) {
+    // Tira a entrada do lugar atomicamente antes de apagar, para que um
+    // leitor concorrente veja a entrada inteira ou nenhuma
+    auto trash = makeTempDir();
+    std::error_code ec;
+    if (!trash.empty()) {
+        fs::remove(trash, ec);
+        fs::rename(dir, trash, ec);
+        if (!ec) {
+            fs::remove_all(trash, ec);
+            return;
+        }
+    }
+    fs::remove_all(dir, ec);
+}
+
+std::optional<ArtifactCache::Entry>
+ArtifactCache::lookup(const std::string &key, const fs::path &libraryOut,
+                      std::string *missKey) {
+    std::string current = key;
+    fs::path dir;
+    std::optional<Entry> entry;
+    for (int variant = 0; variant < kMaxVariants; ++variant) {
+        dir = entryDir(current);
+        entry = readMeta(dir / kMetaFile);
+        if (!entry) {
+            break;
+        }
+
+        // Header incluído editado: a variante do conteúdo atual
+        std::ifstream in(dir / kDepsFile, std::ios::in | std::ios::binary);
+        const std::string list((std::istreambuf_iterator<char>(in)),
+                               std::istreambuf_iterator<char>());
+        if (auto changed = changedDependencies(list)) {
+            current = dependencyVariant(current, *changed);
+            entry.reset();
+            continue;
+        }
+        break;
+    }
+
+    if (!entry) {
+        misses_.fetch_add(1, std::memory_order_relaxed);
+        if (missKey != nullptr) {
+            *missKey = std::move(current);
+        }
+        return std::nullopt;
+    }
+
+    if (entry->success) {
+        // Copia para um nome temporário e renomeia: o dlopen nunca vê uma
+        // biblioteca parcial
+        std::error_code ec;
+        auto partial = libraryOut;
+        // Um memfd novo (modo diskless) ainda não foi aberto pelo dlopen e
+        // não pode ser renomeado: copia direto
+        if (!execution::MemoryArtifacts::isMemoryPath(libraryOut.native())) {
+            partial += std::format(".{}.part", getpid());
+        }
+        fs::copy_file(dir / kLibraryFile, partial,
+                      fs::copy_options::overwrite_existing, ec);
+        if (!ec && partial != libraryOut) {
+            fs::rename(partial, libraryOut, ec);
+        }
+        if (ec) {
+            if (partial != libraryOut) {
+                fs::remove(partial, ec);
+            }
+            misses_.fetch_add(1, std::memory_order_relaxed);
+            if (missKey != nullptr) {
+                *missKey = std::move(current);
+            }
+            return std::nullopt;
+        }
+        hits_.fetch_add(1, std::memory_order_relaxed);
+    } else {
+        failureHits_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // Marca como usado recentemente (LRU)
+    std::error_code ec;
+    fs::last_write_time(dir / kMetaFile, fs::file_time_type::clock::now(), ec);
+
+    return entry;
+}
+
+bool ArtifactCache::store(const std::string &key, const Entry &entry,
+                          const fs::path &library) {
+    const auto finalDir = entryDir(key);
+    std::error_code ec;
+    if (fs::exists(finalDir / kMetaFile, ec)) {
+        return true;
+    }
+
+    auto tmp = makeTempDir();
+    if (tmp.empty()) {
+        return false;
+    }
+
+    if (entry.success) {
+        fs::copy_file(library, tmp / kLibraryFile,
+                      fs::copy_options::overwrite_existing, ec);
+        if (ec) {
+            fs::remove_all(tmp, ec);
+            return false;
+        }
+    }
+
+    if (!entry.dependencies.empty()) {
+        std::ofstream deps(tmp / kDepsFile, std::ios::out | std::ios::binary);
+        deps << formatDependencies(entry.dependencies);
+        if (!deps.flush()) {
+            fs::remove_all(tmp, ec);
+            return false;
+        }
+    }
+
+    // meta por último: uma entrada sem meta nunca é considerada válida
+    if (!writeMeta(tmp / kMetaFile, entry)) {
+        fs::remove_all(tmp, ec);
+        return false;
+    }
+
+    const uint64_t entrySize = directorySize(tmp);
+
+    fs::create_directories(finalDir.parent_path(), ec);
+    fs::rename(tmp, finalDir, ec);
+    if (ec) {
+        // Outro processo publicou a mesma chave primeiro (ENOTEMPTY/EEXIST)
+        fs::remove_all(tmp, ec);
+        return fs::exists(finalDir / kMetaFile, ec);
+    }
+
+    stores_.fetch_add(1, std::memory_order_relaxed);
+
+    bool overLimit = false;
+    {
+        std::scoped_lock lock(usageMutex_);
+        if (!approxUsage_) {
+            approxUsage_ = directorySize(root_ / "objects");
+        } else {
+            *approxUsage_ += entrySize;
+        }
+        overLimit = *approxUsage_ > maxBytes_;
+    }
+
+    if (overLimit) {
+        evictToLimit();
+    }
+
+    return true;
+}
+
+size_t ArtifactCache::evictToLimit() {
+    struct Candidate {
+        fs::path dir;
+        fs::file_time_type lastUse;
+        uint64_t size;
+    };
+
+    std::vector<Candidate> candidates;
+    uint64_t total = 0;
+    std::error_code ec;
+
+    for (fs::directory_iterator fan(root_ / "objects", ec), end;
+         !ec && fan != end; fan.increment(ec)) {
+        std::error_code dec;
+        for (fs::directory_iterator it(fan->path(), dec); !dec && it != end;
+             it.increment(dec)) {
+            std::error_code tec;
+            auto lastUse = fs::last_write_time(it->path() / kMetaFile, tec);
+            if (tec) {
+                lastUse = fs::file_time_type::min();
+            }
+            auto size = directorySize(it->path());
+            total += size;
+            candidates.push_back({it->path(), lastUse, size});
+        }
+    }
+
+    // Remove até 90% do limite para não despejar a cada nova entrada
+    const uint64_t target = maxBytes_ / 10 * 9;
+    size_t removed = 0;
+
+    if (total > maxBytes_) {
+        std::sort(candidates.begin(), candidates.end(),
+                  [](const Candidate &a, const Candidate &b) {
+                      return a.lastUse < b.lastUse;
+                  });
+
+        for (const auto &candidate : candidates) {
+            if (total <= target) {
+                break;
+            }
+            discard(candidate.dir);
+            total -= std::min(total, candidate.size);
+            ++removed;
+        }
+    }
+
+    evictions_.fetch_add(removed, std::memory_order_relaxed);
+
+    std::scoped_lock lock(usageMutex_);
+    approxUsage_ = total;
+    return removed;
+}
+
+void ArtifactCache::clear() {
+    std::error_code ec;
+    for (fs::directory_iterator fan(root_ / "objects", ec), end;
+         !ec && fan != end; fan.increment(ec)) {
+        discard(fan->path());
+    }
+
+    std::scoped_lock lock(usageMutex_);
+    approxUsage_ = 0;
+}
+
+uint64_t ArtifactCache::diskUsage() const {
+    return directorySize(root_ / "objects");
+}
+
+ArtifactCache::Stats ArtifactCache::stats() const {
+    return {.hits = hits_.load(std::memory_order_relaxed),
+            .failureHits = failureHits_.load(std::memory_order_relaxed),
+            .misses = misses_.load(std::memory_order_relaxed),
+            .stores = stores_.load(std::memory_order_relaxed),
+            .evictions = evictions_.load(std::memory_order_relaxed)};
+}
+
+} // namespace compiler
@@ -3,14 +3,29 @@
 #include "../../repl.hpp"
 #include "analysis/ast_context.hpp"
 #include "analysis/clang_ast_adapter.hpp"
-
-#include "execution/spawn_to_mem_fd.hpp"
+#include "analysis/decl_export.hpp"
+#include "analysis/snippet_graph.hpp"
+#include "compiler/artifact_cache.hpp"
+#include "compiler/inprocess_backend.hpp"
+#include "compiler/pch_layers.hpp"
+#include "compiler/pch_store.hpp"
+
+#include "execution/cancellation.hpp"
+#include "execution/jobserver.hpp"
+#include "execution/memory_admission.hpp"
+#include "execution/memory_artifacts.hpp"
+#include "execution/process_launcher.hpp"
+#include "execution/task_scheduler.hpp"
+#include "execution/workspace.hpp"
 #include "utility/system_exec.hpp"
+#include "utility/thread_priority.hpp"
 #include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cerrno>
 #include <chrono>
 #include <cstdlib>
 #include <cstring>
-#include <execution>
 #include <filesystem>
 #include <format>
 #include <fstream>
@@ -20,13 +35,68 @@
 #include <mutex>
 #include <sstream>
 #include <stdexcept>
+#include <sys/wait.h>
 #include <unistd.h>
+#include <unordered_map>
+#include <unordered_set>
 
 // Forward declaration for helper function from repl.cpp
 extern int verbosityLevel;
 
 namespace compiler {
 
+namespace {
+
+// Divide uma string de flags (no formato que já montamos para o shell) em
+// argumentos individuais. As flags geradas aqui não usam aspas.
+void appendSplitFlags(std::vector<std::string> &args, std::string_view flags) {
+    size_t i = 0;
+    while (i < flags.size()) {
+        while (i < flags.size() && std::isspace((unsigned char)flags[i])) {
+            ++i;
+        }
+        size_t b = i;
+        while (i < flags.size() && !std::isspace((unsigned char)flags[i])) {
+            ++i;
+        }
+        if (i > b) {
+            args.emplace_back(flags.substr(b, i - b));
+        }
+    }
+}
+
+// Um processo do compilador: token do jobserver, depois admissão por
+// memória; o pico de RSS medido calibra a estimativa do tipo de job.
+// @p launch recebe as ProcessOptions já com o callback de spawn e o token de
+// cancelamento; job já cancelado nem espera vaga, e cancelar durante a
+// espera pelo token desiste dela.
+template <typename Launch>
+execution::ProcessResult
+runCompilerJob(execution::JobKind kind,
+               const execution::CancellationToken &cancel, Launch &&launch) {
+    execution::ProcessOptions opts;
+    opts.cancel = cancel;
+    if (cancel.cancelled()) {
+        return launch(std::move(opts)); // falha com ECANCELED
+    }
+
+    auto token = execution::Jobserver::instance().acquire(cancel);
+    if (cancel.cancelled()) {
+        return launch(std::move(opts));
+    }
+    auto ticket = execution::MemoryAdmission::instance().admit(kind);
+    opts.onSpawn = [&ticket](pid_t pid) { ticket.attach(pid); };
+    auto res = launch(std::move(opts));
+    ticket.finish(res.peakRssKb);
+    return res;
+}
+
+// Entradas mais novas do decl_amalgama.hpp que nunca são dobradas: são as
+// que o usuário ainda costuma redefinir
+constexpr size_t kDeclFoldKeepRecent = 32;
+
+} // namespace
+
 CompilerService::CompilerService(
     const BuildSettings *buildSettings,
     std::shared_ptr<analysis::AstContext> astContext,
@@ -36,23 +106,360 @@ CompilerService::CompilerService(
     if (!buildSettings_) {
         throw std::invalid_argument("BuildSettings cannot be null");
     }
+
+    size_t maxLayers = 4;
+    if (const char *env = std::getenv("CPPREPL_PCH_MAX_LAYERS")) {
+        maxLayers = std::max(1L, std::strtol(env, nullptr, 10));
+    }
+    pchLayers_ = std::make_shared<PchLayerStack>(
+        "#include <any>\n\n"
+        "extern int (*bootstrapProgram)(int argc, char **argv);\n"
+        "extern std::any lastReplResult;\n\n",
+        maxLayers);
+
+    if (const char *env = std::getenv("CPPREPL_DECL_FOLD_BYTES")) {
+        declFoldBytes_ = std::max(0L, std::strtol(env, nullptr, 10));
+    }
+
+    if (const char *env = std::getenv("CPPREPL_INPROCESS");
+        env && std::string_view(env) == "1") {
+        setBackend(CompilerBackend::InProcess);
+    }
+}
+
+bool CompilerService::setBackend(CompilerBackend backend) {
+    if (backend == CompilerBackend::InProcess &&
+        !InProcessClangBackend::isAvailable()) {
+        backend_ = CompilerBackend::External;
+        return false;
+    }
+
+    if (backend == CompilerBackend::InProcess && !inProcess_) {
+        inProcess_ = std::make_shared<InProcessClangBackend>();
+    }
+
+    backend_ = backend;
+    return true;
+}
+
+bool CompilerService::usingInProcessBackend() const {
+    return backend_ == CompilerBackend::InProcess && inProcess_;
+}
+
+size_t CompilerService::getEffectiveThreadCount() const {
+    if (maxThreads_ == 0) {
+        return execution::TaskScheduler::instance().concurrency();
+    }
+    return maxThreads_;
+}
+
+CompilerResult<int> CompilerService::compileObjectInProcess(
+    const std::string &compiler, const std::string &std,
+    const std::string &flags, const std::string &inputFile,
+    const std::string &outputObject, const std::string &logPath,
+    std::string *astJson, std::string *declRecords,
+    const std::string *declHeader) const {
+    CompilerResult<int> result;
+
+    std::vector<std::string> args;
+    args.reserve(16 + buildSettings_->includeDirectories.size() +
+                 buildSettings_->preprocessorDefinitions.size());
+    args.push_back(compiler);
+    args.push_back("-std=" + std);
+    appendSplitFlags(args, flags);
+    for (const auto &def : buildSettings_->preprocessorDefinitions) {
+        args.push_back("-D" + def);
+    }
+    for (const auto &inc : buildSettings_->includeDirectories) {
+        args.push_back("-I" + inc);
+    }
+    if (outputObject.empty()) {
+        args.push_back("-fsyntax-only");
+        args.push_back(inputFile);
+    } else {
+        args.push_back("-c");
+        args.push_back(inputFile);
+        args.push_back("-o");
+        args.push_back(outputObject);
+    }
+
+    // decl_amalgama.hpp é servido a partir do AstContext, que já tem o
+    // conteúdo em memória
+    std::vector<InProcessClangBackend::RemappedFile> remapped;
+    std::error_code ec;
+    auto amalgama = std::filesystem::absolute("decl_amalgama.hpp", ec);
+    if (!ec && std::filesystem::exists(amalgama, ec)) {
+        remapped.push_back(
+            {.path = amalgama.string(),
+             .contents = declHeader != nullptr
+                             ? *declHeader
+                             : analysis::AstContext::snapshotOutputHeader()});
+    }
+
+    InProcessClangBackend::Result res;
+    if (outputObject.empty()) {
+        res = inProcess_->checkSyntax(args, remapped);
+    } else if (astJson) {
+        res = inProcess_->compileToObjectWithAst(args, *astJson, remapped);
+    } else if (declRecords) {
+        res = inProcess_->compileToObjectWithDecls(args, *declRecords, remapped);
+    } else {
+        res = inProcess_->compileToObject(args, remapped);
+    }
+    result.value = res.returnCode;
+
+    if (!res.diagnostics.empty()) {
+        if (logPath.empty()) {
+            std::cerr << res.diagnostics;
+        } else {
+            std::ofstream(logPath, std::ios::out | std::ios::trunc)
+                << res.diagnostics;
+        }
+    }
+
+    if (!res.success()) {
+        result.error = CompilerError::BuildFailed;
+    }
+
+    return result;
 }
 
 bool CompilerService::checkIncludeExists(const BuildSettings &settings,
                                          const std::string &includePath) {
-    auto includeDirsArgs = settings.getIncludeDirectoriesStr();
-    std::string command = std::format("clang++ -x c++ -E -P {} - < /dev/null "
-                                      "-include {} 2>/dev/null",
-                                      includeDirsArgs, includePath);
-    auto [output, returnCode] = utility::runProgramGetOutput(command);
-    return returnCode == 0;
+    std::vector<std::string> args{"clang++", "-x", "c++", "-E", "-P"};
+    appendSplitFlags(args, settings.getIncludeDirectoriesStr());
+    args.insert(args.end(), {"-", "-include", includePath});
+
+    auto res = execution::runProcess(args, {.out = execution::Stream::File,
+                                            .err = execution::Stream::File,
+                                            .outPath = "/dev/null",
+                                            .errPath = "/dev/null",
+                                            .inPath = "/dev/null"});
+    return res.success();
+}
+
+namespace {
+
+// Família no PchStore: os PCHs do REPL são sempre gerados com -std=gnu++20
+constexpr std::string_view kPchFamily = "gnu++20";
+
+// CPPREPL_AST_JSON=1 mantém o caminho antigo (-ast-dump=json) nos dois
+// backends
+bool forceAstJson() {
+    const char *env = std::getenv("CPPREPL_AST_JSON");
+    return env && std::string_view(env) == "1";
+}
+
+/**
+ * @brief Caminho do plugin cpprepl-decls utilizável por este compilador
+ *
+ * Ordem: $CPPREPL_DECL_PLUGIN, depois o plugin construído junto com o REPL.
+ * O plugin só funciona com o clang da mesma versão que o compilou, então
+ * cada compilador é testado uma vez com -fsyntax-only. Vazio = usar o
+ * -ast-dump=json (também forçado com CPPREPL_AST_JSON=1).
+ */
+const std::string &declExportPlugin(const std::string &compiler) {
+    static std::mutex mutex;
+    static std::unordered_map<std::string, std::string> plugins;
+
+    std::scoped_lock lock(mutex);
+    auto it = plugins.find(compiler);
+    if (it != plugins.end()) {
+        return it->second;
+    }
+
+    std::string plugin;
+    if (!forceAstJson()) {
+        if (const char *env = std::getenv("CPPREPL_DECL_PLUGIN")) {
+            plugin = env;
+        }
+#ifdef CPPREPL_DECL_PLUGIN_PATH
+        if (plugin.empty()) {
+            plugin = CPPREPL_DECL_PLUGIN_PATH;
+        }
+#endif
+    }
+
+    std::error_code ec;
+    if (!plugin.empty() && std::filesystem::exists(plugin, ec)) {
+        auto [output, rc] = utility::runProgramGetOutput(
+            {compiler, "-fplugin=" + plugin, "-fsyntax-only", "-x", "c++",
+             "/dev/null"},
+            true);
+        if (rc != 0) {
+            if (::verbosityLevel >= 1) {
+                std::cerr << std::format(
+                    "cpprepl-decls plugin unusable with {}, using "
+                    "-ast-dump=json: {}\n",
+                    compiler, output);
+            }
+            plugin.clear();
+        }
+    } else {
+        plugin.clear();
+    }
+
+    return plugins.emplace(compiler, std::move(plugin)).first->second;
+}
+
+std::string readWholeFile(const std::string &path) {
+    std::ifstream in(path, std::ios::binary);
+    return {std::istreambuf_iterator<char>(in),
+            std::istreambuf_iterator<char>()};
+}
+
+// Identidade do compilador: a saída de --version muda com qualquer
+// atualização do toolchain (e junto com ela os headers do sistema)
+const std::string &compilerIdentity(const std::string &compiler) {
+    static std::mutex mutex;
+    static std::unordered_map<std::string, std::string> identities;
+
+    std::scoped_lock lock(mutex);
+    auto it = identities.find(compiler);
+    if (it == identities.end()) {
+        auto [output, rc] =
+            utility::runProgramGetOutput({compiler, "--version"}, true);
+        it = identities.emplace(compiler, std::format("{}|{}", rc, output))
+                 .first;
+    }
+    return it->second;
+}
+
+// Headers da saída do -MMD que a chave do artefato não cobre: fora o
+// próprio fonte, os headers gerados pelo REPL (entram na chave pelo
+// conteúdo) e os PCHs
+std::vector<std::string> headerDependencies(std::string_view depText,
+                                            const std::string &source) {
+    std::error_code ec;
+    const auto canonicalSource = std::filesystem::weakly_canonical(source, ec);
+
+    std::vector<std::string> headers;
+    for (const auto &dep : parseDepFile(depText)) {
+        const auto path = std::filesystem::weakly_canonical(dep, ec);
+        if (ec || dep == source || path == canonicalSource) {
+            continue;
+        }
+        const auto file = path.filename();
+        if (file == "precompiledheader.hpp" || file == "decl_amalgama.hpp" ||
+            path.extension() == ".pch" || path.extension() == ".gch") {
+            continue;
+        }
+        headers.push_back(path.string());
+    }
+    std::sort(headers.begin(), headers.end());
+    headers.erase(std::unique(headers.begin(), headers.end()), headers.end());
+    return headers;
+}
+
+std::vector<std::string>
+sortedFlags(const std::unordered_set<std::string> &flags) {
+    std::vector<std::string> result(flags.begin(), flags.end());
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
+} // namespace
+
+std::string CompilerService::artifactKey(const std::string &compiler,
+                                         const std::string &std,
+                                         const std::string &source) const {
+    std::string text;
+    if (std::ifstream in(sourcePath(source), std::ios::in | std::ios::binary);
+        in) {
+        text.assign(std::istreambuf_iterator<char>(in),
+                    std::istreambuf_iterator<char>());
+    }
+    return artifactKeyForText(compiler, std, text);
+}
+
+std::string CompilerService::artifactKeyForText(const std::string &compiler,
+                                                const std::string &std,
+                                                std::string_view text) const {
+    ArtifactHasher hasher;
+    hasher.field("version", "cpprepl-artifact-2");
+    hasher.field("compiler", compilerIdentity(compiler));
+    hasher.field("backend", usingInProcessBackend() ? "inprocess" : "external");
+    hasher.field("std", std);
+
+    // unordered_set não tem ordem estável entre sessões
+    for (const auto &def : sortedFlags(buildSettings_->preprocessorDefinitions)) {
+        hasher.field("D", def);
+    }
+    for (const auto &inc : sortedFlags(buildSettings_->includeDirectories)) {
+        hasher.field("I", inc);
+    }
+    for (const auto &lib : sortedFlags(buildSettings_->linkLibraries)) {
+        hasher.field("l", lib);
+    }
+    for (const auto &flag : sortedFlags(buildSettings_->extraLinkerFlags)) {
+        hasher.field("ldflag", flag);
+    }
+
+    hasher.field("source", text);
+
+    // O que o TU vê além do próprio texto: declarações acumuladas e o PCH
+    hasher.field("decl_amalgama",
+                 analysis::AstContext::snapshotOutputHeader());
+    if (pchLayers_->depth() > 0) {
+        hasher.field("pch", pchLayers_->combinedSource());
+    } else {
+        hasher.file("pch", "precompiledheader.hpp");
+    }
+
+    // Headers incluídos não entram: o cache confere a lista do -MMD de cada
+    // entrada
+    return hasher.hex();
+}
+
+void CompilerService::replayCachedSnippets(
+    const std::vector<analysis::CodeTracking> &snippets,
+    const std::string &cachedSource, const std::string &source) {
+    analysis::AstContext context;
+
+    for (const auto &snippet : snippets) {
+        // Entidades (com chave) e os registros avulsos: include, #line e
+        // declaração
+        if (!snippet.key.empty()) {
+            std::string_view decl = snippet.codeSnippet;
+            if (decl.ends_with('\n')) {
+                decl.remove_suffix(1);
+            }
+            context.addEntity(snippet.key, std::string(decl), snippet.line,
+                              snippet.filename == cachedSource
+                                  ? source
+                                  : snippet.filename);
+        } else if (snippet.codeSnippet.starts_with("#include") &&
+                   !snippet.filename.empty()) {
+            analysis::AstContext::addInclude(
+                snippet.filename, snippet.codeSnippet.starts_with("#include <"));
+        } else if (snippet.line >= 0) {
+            context.addLineDirective(snippet.line, snippet.filename == cachedSource
+                                                       ? source
+                                                       : snippet.filename);
+        } else {
+            std::string_view decl = snippet.codeSnippet;
+            if (decl.ends_with('\n')) {
+                decl.remove_suffix(1);
+            }
+            context.addDeclaration(std::string(decl));
+        }
+    }
 }
 
 // === Helper Methods ===
 
 std::string
-CompilerService::getPrecompiledHeaderFlag(const std::string &ext) const {
-    return (ext == ".c") ? "" : " -include precompiledheader.hpp";
+CompilerService::getPrecompiledHeaderFlag(const std::string &ext,
+                                          const std::string &std) const {
+    if (ext == ".c") {
+        return "";
+    }
+    // O índice sem o .pch do topo reprocessaria todas as camadas como
+    // texto; outro -std não pode usar as camadas (clang recusa o PCH)
+    if (std != kPchFamily) {
+        return " -include precompiledheader.hpp";
+    }
+    return " " + pchIncludeFlags();
 }
 
 std::string CompilerService::getLinkLibrariesStr() const {
@@ -67,6 +474,43 @@ std::string CompilerService::getPreprocessorDefinitionsStr() const {
     return buildSettings_->getPreprocessorDefinitionsStr();
 }
 
+std::string CompilerService::sourcePath(const std::string &name) const {
+    return execution::artifactPath(name);
+}
+
+std::string CompilerService::outputPath(const std::string &name,
+                                        bool library) const {
+    return execution::newArtifactPath(name, library);
+}
+
+std::string CompilerService::artifactCompileFlags() const {
+    // Fonte em memfd ou no workspace da sessão: os #include "..." precisam
+    // continuar achando o diretório atual (decl_amalgama.hpp, headers do
+    // usuário)
+    return execution::MemoryArtifacts::instance().enabled() ||
+                   execution::Workspace::instance().enabled()
+               ? " -iquote ."
+               : "";
+}
+
+std::string CompilerService::disklessLinkFlags() const {
+    // O lld grava num temporário e renomeia, o que falha em /proc; bfd e
+    // gold escrevem direto no caminho
+    if (!execution::MemoryArtifacts::instance().enabled() ||
+        buildSettings_->getExtraLinkerFlags().find("-fuse-ld=lld") ==
+            std::string::npos) {
+        return "";
+    }
+    return " -Wl,--no-mmap-output-file";
+}
+
+void CompilerService::writeLogFile(const std::string &logPath,
+                                   std::string_view content) const {
+    if (!execution::writeArtifact(logPath, content)) {
+        std::cerr << std::format("Cannot write log: {}\n", logPath);
+    }
+}
+
 std::string CompilerService::buildCompileCommand(
     const std::string &compiler, const std::string &std,
     const std::string &flags, const std::string &inputFile,
@@ -78,17 +522,27 @@ std::string CompilerService::buildCompileCommand(
 }
 
 CompilerResult<int>
-CompilerService::executeCommand(const std::string &command) const {
+CompilerService::executeCommand(
+    const std::string &command, execution::JobKind kind,
+    const execution::CancellationToken &cancel) const {
     if (verbosityLevel >= 2) {
         std::cout << "Executing: " << command << std::endl;
     }
 
-    int result = system(command.c_str());
+    // Sem shell para linhas simples; saída vai direto para o terminal
+    auto res = runCompilerJob(kind, cancel, [&](auto opts) {
+        opts.out = execution::Stream::Inherit;
+        opts.err = execution::Stream::Inherit;
+        return execution::runCommandLine(command, std::move(opts));
+    });
+    const int result = res.status;
 
     CompilerResult<int> compilerResult;
     compilerResult.value = result;
 
-    if (result != 0) {
+    if (res.cancelled) {
+        compilerResult.error = CompilerError::Cancelled;
+    } else if (result != 0) {
         compilerResult.error = CompilerError::SystemCommandFailed;
         std::cerr << std::format("Command failed with code: {}", result)
                   << std::endl;
@@ -115,11 +569,12 @@ CompilerService::concatenateNames(const std::vector<std::string> &names) const {
 }
 
 std::string CompilerService::readLogFile(const std::string &logPath) const {
-    if (!std::filesystem::exists(logPath)) {
+    const auto path = sourcePath(logPath);
+    if (!std::filesystem::exists(path)) {
         return "";
     }
 
-    std::ifstream logFile(logPath);
+    std::ifstream logFile(path);
     if (!logFile.is_open()) {
         return "";
     }
@@ -230,80 +685,225 @@ CompilerResult<int> CompilerService::buildLibraryOnly(
     const std::string &ext, const std::string &std, std::string_view extra_args,
     std::string_view pchFile) const {
     std::string includePrecompiledHeader =
-        pchFile.empty() ? getPrecompiledHeaderFlag(ext) : std::string(pchFile);
+        (pchFile.empty() ? getPrecompiledHeaderFlag(ext, std)
+                         : std::string(pchFile)) +
+        artifactCompileFlags();
+    const auto source = sourcePath(std::format("{}{}", name, ext));
+    const auto library = outputPath(std::format("lib{}.so", name), true);
+
+    if (usingInProcessBackend()) {
+        // Frontend em processo; só o link continua sendo externo
+        auto object = outputPath(std::format("{}.o", name), false);
+        auto objRes = compileObjectInProcess(
+            compiler, std, std::format("{} -g -fPIC", includePrecompiledHeader),
+            source, object);
+        if (!objRes) {
+            return objRes;
+        }
+
+        return executeCommand(
+            std::format("{} -shared -g -Wl,--export-dynamic{} {} {} {} -o {}",
+                        compiler, disklessLinkFlags(), object,
+                        getLinkLibrariesStr(), extra_args, library));
+    }
 
     auto cmd =
-        std::format("{} -std={} -shared {} {} {} -g -Wl,--export-dynamic -fPIC "
-                    "{}{} {} {} -o lib{}.so",
+        std::format("{} -std={} -shared {} {} {} -g -Wl,--export-dynamic{} "
+                    "-fPIC {} {} {} -o {}",
                     compiler, std, includePrecompiledHeader,
                     getIncludeDirectoriesStr(), getPreprocessorDefinitionsStr(),
-                    name, ext, getLinkLibrariesStr(), extra_args, name);
+                    disklessLinkFlags(), source, getLinkLibrariesStr(),
+                    extra_args, library);
 
     return executeCommand(cmd);
 }
 
+CompilerResult<int> CompilerService::checkSyntax(const std::string &compiler,
+                                                 const std::string &name,
+                                                 const std::string &ext,
+                                                 const std::string &std) const {
+    const auto flags =
+        getPrecompiledHeaderFlag(ext, std) + artifactCompileFlags();
+    const auto source = sourcePath(std::format("{}{}", name, ext));
+
+    if (usingInProcessBackend()) {
+        return compileObjectInProcess(compiler, std, flags, source, {});
+    }
+
+    auto cmd = std::format("{} -std={} -fsyntax-only {} {} {} {}", compiler,
+                           std, flags, getIncludeDirectoriesStr(),
+                           getPreprocessorDefinitionsStr(), source);
+    return executeCommand(cmd, execution::JobKind::AstDump);
+}
+
+CompilerResult<int> CompilerService::buildLibraryInBackground(
+    const std::string &compiler, const std::string &name,
+    const execution::CancellationToken &cancel) const {
+    const auto flags =
+        getPrecompiledHeaderFlag(".cpp") + artifactCompileFlags();
+    const auto source = sourcePath(std::format("{}.cpp", name));
+    const auto library = outputPath(std::format("lib{}.so", name), true);
+
+    // Saída capturada e descartada: o usuário ainda está digitando
+    auto run = [&](const std::string &cmd, execution::JobKind kind) {
+        auto res = runCompilerJob(kind, cancel, [&](auto opts) {
+            opts.out = execution::Stream::Capture;
+            opts.err = execution::Stream::Capture;
+            return execution::runCommandLine(cmd, std::move(opts));
+        });
+        CompilerResult<int> result;
+        result.value = res.status;
+        if (res.cancelled) {
+            result.error = CompilerError::Cancelled;
+        } else if (!res.success()) {
+            result.error = CompilerError::SystemCommandFailed;
+        }
+        return result;
+    };
+
+    if (usingInProcessBackend()) {
+        const auto object = outputPath(std::format("{}.o", name), false);
+        auto objRes = compileObjectInProcess(
+            compiler, "gnu++20", flags + " -g -fPIC", source, object,
+            "/dev/null");
+        if (!objRes || cancel.cancelled()) {
+            return objRes;
+        }
+        return run(std::format(
+                       "{} -shared -g -Wl,--export-dynamic{} {} {} -o {}",
+                       compiler, disklessLinkFlags(), object,
+                       getLinkLibrariesStr(), library),
+                   execution::JobKind::Link);
+    }
+
+    return run(std::format("{} -std=gnu++20 -shared {} {} {} -g "
+                           "-Wl,--export-dynamic{} -fPIC {} {} -o {}",
+                           compiler, flags, getIncludeDirectoriesStr(),
+                           getPreprocessorDefinitionsStr(),
+                           disklessLinkFlags(), source, getLinkLibrariesStr(),
+                           library),
+               execution::JobKind::Compile);
+}
+
 CompilerResult<std::vector<VarDecl>> CompilerService::buildLibraryWithAST(
     const std::string &compiler, const std::string &name,
     const std::string &ext, const std::string &std) const {
     CompilerResult<std::vector<VarDecl>> result;
 
-    std::string includePrecompiledHeader = getPrecompiledHeaderFlag(ext);
+    std::string includePrecompiledHeader =
+        getPrecompiledHeaderFlag(ext, std) + artifactCompileFlags();
+    const std::string source = sourcePath(std::format("{}{}", name, ext));
+    const std::string library = outputPath(std::format("lib{}.so", name), true);
 
-    // First build - compile to shared library
-    auto cmd =
-        std::format("{} -std={} -shared {} {} {} -g -Wl,--export-dynamic -fPIC "
-                    "{}{} {} -o lib{}.so",
-                    compiler, std, includePrecompiledHeader,
-                    getIncludeDirectoriesStr(), getPreprocessorDefinitionsStr(),
-                    name, ext, getLinkLibrariesStr(), name);
+    analysis::ClangAstAnalyzerAdapter analyzer;
+    analyzer.setSnippetUnit(name);
+    std::vector<VarDecl> vars;
+    int ares = -1;
+
+    if (usingInProcessBackend()) {
+        // Um único frontend: objeto + JSON da AST no mesmo parse
+        std::string astJson;
+        const auto object = outputPath(std::format("{}.o", name), false);
+        auto objRes =
+            compileObjectInProcess(compiler, std, includePrecompiledHeader +
+                                                      " -g -fPIC",
+                                   source, object, {}, &astJson);
+        if (!objRes) {
+            result.error = CompilerError::BuildFailed;
+            return result;
+        }
 
-    auto buildResult = executeCommand(cmd);
-    if (!buildResult) {
-        result.error = CompilerError::BuildFailed;
-        return result;
-    }
+        auto linkRes = executeCommand(
+            std::format("{} -shared -g -Wl,--export-dynamic{} {} {} {} -o {}",
+                        compiler, disklessLinkFlags(), object,
+                        getLinkLibrariesStr(),
+                        buildSettings_->getExtraLinkerFlags(), library),
+            execution::JobKind::Link);
+        if (!linkRes) {
+            result.error = CompilerError::BuildFailed;
+            return result;
+        }
 
-    // Second build - AST dump
-    cmd = std::format(
-        "{} -std={} -fcolor-diagnostics -fPIC -Xclang -ast-dump=json {} {} {} "
-        "-fsyntax-only {}{} -o lib{}.so > {}.json",
-        compiler, std, includePrecompiledHeader, getIncludeDirectoriesStr(),
-        getPreprocessorDefinitionsStr(), name, ext, name, name);
+        ares = analyzer.analyzeJson(astJson, source, vars);
+    } else {
+        // Biblioteca e dump da AST em paralelo: o caminho crítico passa a
+        // ser a mais lenta das duas execuções, e não a soma de três
+        auto cmd = std::format(
+            "{} -std={} -shared {} {} {} -g -Wl,--export-dynamic{} -fPIC "
+            "{} {} -o {}",
+            compiler, std, includePrecompiledHeader,
+            getIncludeDirectoriesStr(), getPreprocessorDefinitionsStr(),
+            disklessLinkFlags(), source, getLinkLibrariesStr(), library);
+
+        std::vector<std::string> astCmd{compiler, "-std=" + std,
+                                        "-fcolor-diagnostics", "-fPIC",
+                                        "-Xclang", "-ast-dump=json"};
+        appendSplitFlags(astCmd, includePrecompiledHeader);
+        appendSplitFlags(astCmd, getIncludeDirectoriesStr());
+        appendSplitFlags(astCmd, getPreprocessorDefinitionsStr());
+        astCmd.push_back("-fsyntax-only");
+        astCmd.push_back(source);
+
+        // A falha de um dos dois mata o outro
+        const auto cancel = execution::currentEvalToken().child();
+        CompilerResult<int> buildRes;
+        execution::ProcessResult astRes;
+        execution::TaskScheduler::instance().parallelInvoke(
+            [&] {
+                buildRes =
+                    executeCommand(cmd, execution::JobKind::Compile, cancel);
+                if (!buildRes) {
+                    cancel.cancel();
+                }
+            },
+            [&] {
+                astRes = runCompilerJob(execution::JobKind::AstDump, cancel,
+                                        [&](auto opts) {
+                                            return execution::runProcess(
+                                                astCmd, std::move(opts));
+                                        });
+                if (!astRes.success()) {
+                    cancel.cancel();
+                }
+            });
 
-    auto astResult = executeCommand(cmd);
-    if (!astResult) {
-        result.error = CompilerError::AstAnalysisFailed;
-        return result;
+        if (execution::currentEvalToken().cancelled()) {
+            result.error = CompilerError::Cancelled;
+            return result;
+        }
+
+        if (!buildRes && buildRes.error != CompilerError::Cancelled) {
+            result.error = CompilerError::BuildFailed;
+            return result;
+        }
+
+        if (!astRes.success()) {
+            result.error = CompilerError::AstAnalysisFailed;
+            return result;
+        }
+
+        ares = analyzer.analyzeJson(astRes.out(), source, vars);
     }
 
-    // Analyze AST
-    analysis::ClangAstAnalyzerAdapter analyzer;
-    std::vector<VarDecl> vars;
-    int ares = analyzer.analyzeFile(std::format("{}.json", name),
-                                    std::format("{}.cpp", name), vars);
     if (ares != 0) {
         result.error = CompilerError::AstAnalysisFailed;
         return result;
     }
+    analysis::AstContext::reportStaleSnippets(
+        analyzer.getAnalyzer().staleSnippets());
+
+    // Com o fonte em memfd, as declarações apontam para /proc/<pid>/fd/N
+    for (auto &var : vars) {
+        if (var.file == source) {
+            var.file = std::format("{}{}", name, ext);
+        }
+    }
 
     // Merge variables using callback if provided
     if (varMergeCallback_) {
         varMergeCallback_(vars);
     }
 
-    // Third build - final library with proper settings
-    cmd = std::format(
-        "{}{} {} -std=gnu++20 -shared -include precompiledheader.hpp -g "
-        "-Wl,--export-dynamic -fPIC {}.cpp {} -o lib{}.so",
-        compiler, getPreprocessorDefinitionsStr(), getIncludeDirectoriesStr(),
-        name, getLinkLibrariesStr(), name);
-
-    auto finalBuildResult = executeCommand(cmd);
-    if (!finalBuildResult) {
-        result.error = CompilerError::BuildFailed;
-        return result;
-    }
-
     auto context = analyzer.getContext();
     // Salva o header se houve mudanças
     if (context->hasHeaderChanged()) {
@@ -319,49 +919,113 @@ CompilerResult<void> CompilerService::buildPrecompiledHeader(
     std::shared_ptr<analysis::AstContext> context) const {
     CompilerResult<void> result;
 
-    // Use provided context or fall back to member
-    auto contextToUse = context ? context : astContext_;
+    std::unique_lock buildLock(pchLayers_->buildMutex());
 
-    try {
-        std::fstream precompHeader("precompiledheader.hpp",
-                                   std::ios::out | std::ios::trunc);
-
-        precompHeader << "#pragma once\n\n" << std::endl;
-        precompHeader << "#include <any>\n" << std::endl;
-        precompHeader
-            << "extern int (*bootstrapProgram)(int argc, char **argv);\n";
-        precompHeader << "extern std::any lastReplResult;\n";
-
-        // Se temos um contexto, usar os includes dele
-        /*if (contextToUse) {
-            precompHeader << contextToUse->getOutputHeader() << std::endl;
-        }*/
-
-        for (const auto &inc : analysis::AstContext::getIncludedFiles()) {
-            if (inc.second) {
-                precompHeader << std::format("#include <{}>\n", inc.first);
-            } else {
-                precompHeader << std::format("#include \"{}\"\n", inc.first);
-            }
+    // Headers do usuário relativos ao diretório de trabalho viram absolutos:
+    // a camada pode morar no PchStore, longe daqui
+    auto includes = analysis::AstContext::getOrderedIncludes();
+    for (auto &[path, system] : includes) {
+        std::error_code ec;
+        if (!system && std::filesystem::path(path).is_relative() &&
+            std::filesystem::exists(path, ec)) {
+            path = std::filesystem::absolute(path, ec).string();
         }
+    }
+
+    // Só o que ainda não está pré-compilado vira uma camada nova
+    auto plan = pchLayers_->plan(includes);
+    if (plan.kind == PchLayerStack::Plan::Kind::UpToDate) {
+        return result;
+    }
 
-        precompHeader.flush();
-        precompHeader.close();
+    result = buildPchLayer(compiler, plan);
+    if (!result) {
+        return result;
+    }
 
-    } catch (const std::exception &e) {
-        std::cerr << std::format("Failed to write precompiled header: {}\n",
-                                 e.what());
+    if (!pchLayers_->commit(plan) || !publishPchLayers()) {
         result.error = CompilerError::FileWriteFailed;
         return result;
     }
 
+    if (verbosityLevel >= 2) {
+        std::cout << std::format("PCH layer {} ({} includes, depth {})\n",
+                                 plan.layer.id, plan.layer.includes.size(),
+                                 pchLayers_->depth());
+    }
+
+    // Achata a pilha em segundo plano; as compilações seguem usando o topo
+    if (pchLayers_->needsFlatten() &&
+        (!pchFlatten_.valid() ||
+         pchFlatten_.wait_for(std::chrono::seconds(0)) ==
+             std::future_status::ready)) {
+        pchFlatten_ = std::async(std::launch::async, [this, compiler] {
+            utility::lowerCurrentThreadPriority();
+            flattenPchLayers(compiler);
+        });
+    }
+
+    return result;
+}
+
+CompilerResult<void>
+CompilerService::compilePch(const std::string &compiler,
+                            const std::string &header,
+                            const std::string &outputPch,
+                            const std::string &parentPch, bool stored,
+                            const std::string &depFile) const {
+    CompilerResult<void> result;
+
+    if (usingInProcessBackend()) {
+        std::vector<std::string> args{compiler, "-fPIC", "-x", "c++-header",
+                                      "-std=gnu++20"};
+        for (const auto &def : buildSettings_->preprocessorDefinitions) {
+            args.push_back("-D" + def);
+        }
+        for (const auto &inc : buildSettings_->includeDirectories) {
+            args.push_back("-I" + inc);
+        }
+        if (!parentPch.empty()) {
+            args.insert(args.end(),
+                        {"-Xclang", "-include-pch", "-Xclang", parentPch});
+        }
+        if (stored) {
+            args.insert(args.end(), {"-Xclang", "-fno-pch-timestamp"});
+        }
+        if (!depFile.empty()) {
+            args.insert(args.end(), {"-MMD", "-MF", depFile});
+        }
+        args.insert(args.end(), {"-o", outputPch, header});
+
+        auto pchRes = inProcess_->generatePch(args);
+        if (!pchRes.success()) {
+            std::cerr << pchRes.diagnostics;
+            result.error = CompilerError::PrecompiledHeaderFailed;
+        }
+        return result;
+    }
+
+    std::string extra;
+    if (!parentPch.empty()) {
+        extra = std::format(" -Xclang -include-pch -Xclang {}", parentPch);
+    }
+    if (stored) {
+        extra += " -Xclang -fno-pch-timestamp";
+    }
+    if (!depFile.empty()) {
+        extra += std::format(" -MMD -MF {}", depFile);
+    }
+
     std::string cmd = std::format(
-        "{}{} {} -fPIC -x c++-header -std=gnu++20 -o precompiledheader.hpp.pch "
-        "precompiledheader.hpp",
-        compiler, getPreprocessorDefinitionsStr(), getIncludeDirectoriesStr());
+        "{}{} {} -fPIC -x c++-header -std=gnu++20{} -o {} {}", compiler,
+        getPreprocessorDefinitionsStr(), getIncludeDirectoriesStr(), extra,
+        outputPch, header);
 
     auto cmdResult = executeCommand(cmd);
-    if (!cmdResult) {
+    if (inProcess_) {
+        inProcess_->invalidatePchCache();
+    }
+    if (!cmdResult || cmdResult.value != 0) {
         result.error = CompilerError::PrecompiledHeaderFailed;
         return result;
     }
@@ -369,6 +1033,265 @@ CompilerResult<void> CompilerService::buildPrecompiledHeader(
     return result;
 }
 
+std::string CompilerService::pchKey(const std::string &compiler,
+                                    std::string_view headerPath,
+                                    std::string_view headerText,
+                                    std::string_view parentPch,
+                                    const std::vector<std::string> &inputs) const {
+    ArtifactHasher hasher;
+    hasher.field("kind", "pch");
+    hasher.field("compiler", compilerIdentity(compiler));
+    hasher.field("std", kPchFamily);
+    for (const auto &def : sortedFlags(buildSettings_->preprocessorDefinitions)) {
+        hasher.field("D", def);
+    }
+    for (const auto &inc : sortedFlags(buildSettings_->includeDirectories)) {
+        hasher.field("I", inc);
+    }
+    hasher.field("path", headerPath);
+    hasher.field("header", headerText);
+    hasher.field("parent", parentPch);
+    for (const auto &input : inputs) {
+        hasher.file(input, input);
+    }
+    return hasher.hex();
+}
+
+CompilerResult<void>
+CompilerService::buildPchLayer(const std::string &compiler,
+                               PchLayerStack::Plan &plan) const {
+    CompilerResult<void> result;
+    const auto source = pchLayers_->layerSource(plan.layer);
+
+    if (pchStore_) {
+        // Headers do usuário entram na chave pelo conteúdo: editar um deles
+        // leva a outra entrada em vez de um PCH que o clang rejeitaria. Os
+        // incluídos por eles são conferidos pela lista de deps da entrada
+        std::vector<std::string> userHeaders;
+        for (const auto &[path, system] : plan.layer.includes) {
+            if (!system) {
+                userHeaders.push_back(path);
+            }
+        }
+        auto key =
+            pchKey(compiler, "layer", source, plan.parentPch, userHeaders);
+
+        if (auto dir =
+                pchStore_->lookup(kPchFamily, key, "layer.hpp.pch", &key);
+            !dir.empty()) {
+            plan.layer.dir = dir.string();
+            return result;
+        }
+
+        if (auto dir = pchStore_->prepare(kPchFamily, key); !dir.empty()) {
+            plan.layer.dir = dir.string();
+            if (!PchStore::writeFile(plan.layer.header(), source)) {
+                std::cerr << std::format(
+                    "Failed to write precompiled header: {}\n",
+                    plan.layer.header());
+                result.error = CompilerError::FileWriteFailed;
+                return result;
+            }
+
+            const auto built = pchStore_->tempPathFor(plan.layer.pch());
+            const auto deps = pchStore_->tempPathFor(dir / "deps.d");
+            result = compilePch(compiler, plan.layer.header(), built.string(),
+                                plan.parentPch, true, deps.string());
+            std::error_code ec;
+            if (!result) {
+                std::filesystem::remove(built, ec);
+            } else {
+                PchStore::recordDeps(dir, deps);
+                if (!pchStore_->publish(built, plan.layer.pch())) {
+                    result.error = CompilerError::FileWriteFailed;
+                }
+            }
+            std::filesystem::remove(deps, ec);
+            return result;
+        }
+    }
+
+    // Sem repositório: camada no diretório de trabalho
+    const auto header = plan.layer.header();
+    try {
+        std::fstream layerHeader(header, std::ios::out | std::ios::trunc);
+        layerHeader << source;
+        layerHeader.close();
+        if (!layerHeader) {
+            throw std::runtime_error(header);
+        }
+    } catch (const std::exception &e) {
+        std::cerr << std::format("Failed to write precompiled header: {}\n",
+                                 e.what());
+        result.error = CompilerError::FileWriteFailed;
+        return result;
+    }
+
+    return compilePch(compiler, header, plan.layer.pch(), plan.parentPch,
+                      false);
+}
+
+bool CompilerService::publishPchLayers() const {
+    // Índice trocado com rename(2): quem está lendo vê o antigo ou o novo
+    const std::string index(PchLayerStack::kIndexHeader);
+    const std::string tmp = std::format("{}.tmp", index);
+    {
+        std::ofstream out(tmp, std::ios::out | std::ios::trunc);
+        out << pchLayers_->indexSource();
+        if (!out) {
+            std::cerr << std::format("Failed to write {}\n", tmp);
+            return false;
+        }
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(tmp, index, ec);
+    if (ec) {
+        std::cerr << std::format("Failed to publish {}: {}\n", index,
+                                 ec.message());
+        return false;
+    }
+
+    // PCH monolítico de versões antigas: o driver o usaria implicitamente
+    // para -include precompiledheader.hpp, e ele não bate mais com o índice
+    std::filesystem::remove(std::format("{}.pch", index), ec);
+
+    for (const auto &layer : pchLayers_->takeRetired()) {
+        if (layer.stored()) {
+            continue; // compartilhada com outras sessões
+        }
+        std::filesystem::remove(layer.header(), ec);
+        std::filesystem::remove(layer.pch(), ec);
+    }
+    return true;
+}
+
+void CompilerService::flattenPchLayers(const std::string &compiler) const {
+    auto plan = pchLayers_->planFlatten();
+    if (plan.kind == PchLayerStack::Plan::Kind::UpToDate) {
+        return;
+    }
+
+    // Gerado sem segurar buildMutex: camadas novas podem ser empilhadas
+    // enquanto isso, e nesse caso o resultado é descartado
+    if (buildPchLayer(compiler, plan)) {
+        std::unique_lock buildLock(pchLayers_->buildMutex());
+        if (pchLayers_->commit(plan)) {
+            publishPchLayers();
+            if (verbosityLevel >= 2) {
+                std::cout << std::format(
+                    "PCH layers flattened into layer {}\n", plan.layer.id);
+            }
+            return;
+        }
+    }
+
+    if (!plan.layer.stored()) {
+        std::error_code ec;
+        std::filesystem::remove(plan.layer.header(), ec);
+        std::filesystem::remove(plan.layer.pch(), ec);
+    }
+}
+
+bool CompilerService::foldSessionDeclarations(
+    const std::string &compiler) const {
+    bool adopted = false;
+
+    if (declFold_.valid()) {
+        // Um rebuild do PCH em andamento segura buildMutex: adota depois,
+        // sem travar o prompt
+        std::unique_lock buildLock(pchLayers_->buildMutex(), std::try_to_lock);
+        if (!buildLock.owns_lock() ||
+            declFold_.wait_for(std::chrono::seconds(0)) !=
+                std::future_status::ready) {
+            return false;
+        }
+
+        DeclarationFold job;
+        try {
+            job = declFold_.get();
+        } catch (const std::exception &e) {
+            std::cerr << std::format("Declaration fold failed: {}\n",
+                                     e.what());
+        }
+
+        // Com buildMutex ninguém empilha camadas: se o topo ainda é o do
+        // plano, o commit da pilha não falha depois de o header mudar
+        if (job.built && pchLayers_->topId() == job.plan.baseTopId &&
+            analysis::AstContext::commitDeclarationFold(job.fold)) {
+            pchLayers_->commit(job.plan);
+            publishPchLayers();
+            analysis::AstContext::staticSaveHeaderToFile("decl_amalgama.hpp");
+            adopted = true;
+
+            if (verbosityLevel >= 2) {
+                std::cout << std::format(
+                    "Session declarations folded into PCH layer {} "
+                    "({} KiB)\n",
+                    job.plan.layer.id, job.fold.text.size() / 1024);
+            }
+        } else if (job.plan.kind != PchLayerStack::Plan::Kind::UpToDate) {
+            if (!job.built) {
+                // Declarações que não compilam sozinhas num header: não
+                // adianta tentar de novo a cada eval
+                declFoldBytes_ = 0;
+                if (verbosityLevel >= 1) {
+                    std::cout << "Declaration folding disabled: the PCH "
+                                 "layer failed to build\n";
+                }
+            }
+            if (!job.plan.layer.stored()) {
+                std::error_code ec;
+                std::filesystem::remove(job.plan.layer.header(), ec);
+                std::filesystem::remove(job.plan.layer.pch(), ec);
+            }
+        }
+    }
+
+    if (declFoldBytes_ == 0 || pchLayers_->depth() == 0) {
+        return adopted;
+    }
+
+    auto fold = analysis::AstContext::planDeclarationFold(declFoldBytes_,
+                                                          kDeclFoldKeepRecent);
+    if (fold.empty()) {
+        return adopted;
+    }
+    auto plan = pchLayers_->planDeclarations(fold.text);
+    if (plan.kind == PchLayerStack::Plan::Kind::UpToDate) {
+        return adopted;
+    }
+
+    try {
+        DeclarationFold job{std::move(plan), std::move(fold)};
+        declFold_ = std::async(
+            std::launch::async,
+            [this, compiler, job = std::move(job)]() mutable {
+                utility::lowerCurrentThreadPriority();
+                job.built =
+                    static_cast<bool>(buildPchLayer(compiler, job.plan));
+                return std::move(job);
+            });
+    } catch (const std::system_error &e) {
+        std::cerr << std::format("Could not start declaration fold: {}\n",
+                                 e.what());
+    }
+    return adopted;
+}
+
+std::string CompilerService::currentPchPath() const {
+    auto top = pchLayers_->topPch();
+    return top.empty() ? "precompiledheader.hpp.pch" : top;
+}
+
+std::string CompilerService::pchIncludeFlags() const {
+    if (pchLayers_->depth() == 0) {
+        return std::format("-include {}", PchLayerStack::kIndexHeader);
+    }
+    return std::format("-Xclang -include-pch -Xclang {} -include {}",
+                       currentPchPath(), PchLayerStack::kIndexHeader);
+}
+
 CompilerResult<void> CompilerService::buildCustomPCH(
     const std::string &compiler, const std::string &header,
     const std::string &outputPchFile,
@@ -381,18 +1304,59 @@ CompilerResult<void> CompilerService::buildCustomPCH(
         return result;
     }
 
-    std::string cmd =
-        std::format("{}{} {} -fPIC -x c++-header -std=gnu++20 -o {} {}",
-                    compiler, getPreprocessorDefinitionsStr(),
-                    getIncludeDirectoriesStr(), outputPchFile, header);
+    if (!pchStore_) {
+        return compilePch(compiler, header, outputPchFile, {}, false);
+    }
 
-    auto cmdResult = executeCommand(cmd);
-    if (!cmdResult) {
-        result.error = CompilerError::PrecompiledHeaderFailed;
-        return result;
+    // O PCH registra o caminho do header, então ele entra na chave junto com
+    // o conteúdo; outputPchFile vira um link para a entrada
+    std::error_code ec;
+    const auto absHeader = std::filesystem::absolute(header, ec).string();
+    std::string text;
+    if (std::ifstream in(header, std::ios::in | std::ios::binary); in) {
+        text.assign(std::istreambuf_iterator<char>(in),
+                    std::istreambuf_iterator<char>());
     }
+    auto key = pchKey(compiler, absHeader, text, {}, {});
 
-    result.error = CompilerError::Success;
+    auto dir = pchStore_->lookup(kPchFamily, key, "custom.pch", &key);
+    if (dir.empty()) {
+        dir = pchStore_->prepare(kPchFamily, key);
+        if (dir.empty()) {
+            return compilePch(compiler, header, outputPchFile, {}, false);
+        }
+
+        const auto built = pchStore_->tempPathFor(dir / "custom.pch");
+        const auto deps = pchStore_->tempPathFor(dir / "deps.d");
+        result = compilePch(compiler, absHeader, built.string(), {}, true,
+                            deps.string());
+        if (result) {
+            PchStore::recordDeps(dir, deps);
+        }
+        std::filesystem::remove(deps, ec);
+        if (!result) {
+            std::filesystem::remove(built, ec);
+            return result;
+        }
+        if (!pchStore_->publish(built, dir / "custom.pch")) {
+            result.error = CompilerError::FileWriteFailed;
+            return result;
+        }
+    }
+
+    // Troca atômica do link
+    auto link = std::filesystem::path(outputPchFile);
+    auto tmpLink = link;
+    tmpLink += std::format(".{}.lnk", getpid());
+    std::filesystem::remove(tmpLink, ec);
+    std::filesystem::create_symlink(dir / "custom.pch", tmpLink, ec);
+    if (!ec) {
+        std::filesystem::rename(tmpLink, link, ec);
+    }
+    if (ec) {
+        std::filesystem::remove(tmpLink, ec);
+        result.error = CompilerError::FileWriteFailed;
+    }
 
     return result;
 }
@@ -404,11 +1368,12 @@ CompilerService::linkObjects(const std::vector<std::string> &objects,
     std::string namesConcated = concatenateNames(objects);
     std::string extraLinkerFlags = buildSettings_->getExtraLinkerFlags();
 
-    std::string cmd =
-        std::format("clang++ -shared -g -Wl,--export-dynamic {} {} {} -o lib{}.so",
-                    namesConcated, linkLibraries, extraLinkerFlags, libname);
+    std::string cmd = std::format(
+        "clang++ -shared -g -Wl,--export-dynamic{} {} {} {} -o {}",
+        disklessLinkFlags(), namesConcated, linkLibraries, extraLinkerFlags,
+        outputPath(std::format("lib{}.so", libname), true));
 
-    return executeCommand(cmd);
+    return executeCommand(cmd, execution::JobKind::Link);
 }
 
 CompilerResult<CompilationResult> CompilerService::buildMultipleSourcesWithAST(
@@ -431,14 +1396,24 @@ CompilerResult<CompilationResult> CompilerService::buildMultipleSourcesWithAST(
     bool hasChanged = false;
     int errorCode = 0;
 
+    // Ctrl-C cancela o eval; a primeira fonte que falhar cancela o build
+    // (as demais fontes); cada fonte cancela o próprio par AST/compile
+    const auto evalCancel = execution::currentEvalToken();
+    const auto buildCancel = evalCancel.child();
+
     struct SourceProcessResult {
         std::string sourceFile;
         std::string purefilename;
         std::string objectName;
         std::vector<VarDecl> localVars;
+        std::vector<std::string> provides; // registrados no grafo
+        analysis::AstContext::StaleSnippets stale; // avisado pelo chamador
         bool hasHeaderChanged = false;
+        bool cancelled = false; // morto porque outra parte falhou
         int errorCode = 0;
         std::string errorMessage;
+        std::string diagnostics;
+        bool compilerRejected = false;
     };
 
     // Helpers ---------------------------------------------------------------
@@ -467,36 +1442,45 @@ CompilerResult<CompilationResult> CompilerService::buildMultipleSourcesWithAST(
         result.push_back("-fPIC");
         result.push_back("-Xclang");
         result.push_back("-ast-dump=json");
-        result.push_back("-Xclang");
-        result.push_back("-include-pch");
-        result.push_back("-Xclang");
-        result.push_back("precompiledheader.hpp.pch");
-        result.push_back("-include");
-        result.push_back("precompiledheader.hpp");
+        appendSplitFlags(result, getPrecompiledHeaderFlag(".cpp", std));
+        appendSplitFlags(result, artifactCompileFlags());
         result.push_back("-fsyntax-only");
         result.push_back(name);
         return result;
     };
 
+    // Flags do objeto: as mesmas no comando externo e no frontend in-process
+    const std::string objectFlags =
+        std::format("-fPIC{}{} -g", getPrecompiledHeaderFlag(".cpp", std),
+                    artifactCompileFlags());
+
+    // O frontend in-process lê o decl_amalgama.hpp do início da onda: as
+    // análises paralelas das outras fontes alteram o AstContext enquanto
+    // isso
+    std::string declHeader =
+        usingInProcessBackend() ? analysis::AstContext::snapshotOutputHeader()
+                                : std::string{};
+
     auto compileCmdFor = [&](const std::string &name, const std::string &obj) {
-        return std::format("{}{} {} -std=gnu++20 -fPIC -c -Xclang "
-                           "-include-pch -Xclang precompiledheader.hpp.pch "
-                           "-include precompiledheader.hpp "
-                           "-g -fPIC {} -o {}",
-                           compiler, ppdefs, includes, name, obj);
+        return std::format("{}{} {} -std={} -c {} {} -o {}", compiler, ppdefs,
+                           includes, std, objectFlags, name, obj);
     };
 
     auto compileAndLinkCmdFor = [&](const std::string &name,
                                     const std::string &obj) {
         auto linkerFlags = buildSettings_->getExtraLinkerFlags();
         return std::format(
-            "{}{} {} -std=gnu++20 -shared -include "
-            "precompiledheader.hpp -g -Wl,--export-dynamic {} -fPIC {} -o {}",
-            compiler, ppdefs, includes, linkerFlags, name, obj);
+            "{}{} {} -std={} -shared {} -Wl,--export-dynamic{} {} {} -o {}",
+            compiler, ppdefs, includes, std, objectFlags, disklessLinkFlags(),
+            linkerFlags, name, obj);
     };
 
-    auto processOne = [&](const std::string &name,
-                          bool buildAndLink = false) -> SourceProcessResult {
+    // output: caminho já reservado para a saída (memfd do cache); vazio
+    // cria um. depFile: recebe a lista de headers do -MMD
+    auto processOne = [&](const std::string &name, bool buildAndLink = false,
+                          const std::string &output = {},
+                          const std::string &depFile = {})
+        -> SourceProcessResult {
         SourceProcessResult r;
         r.sourceFile = name;
         if (name.empty()) {
@@ -504,55 +1488,211 @@ CompilerResult<CompilationResult> CompilerService::buildMultipleSourcesWithAST(
         }
 
         r.purefilename = pureName(name);
-
-        if (buildAndLink) {
-            r.objectName = std::format("lib{}.so", r.purefilename);
+        // No modo diskless o compilador lê e escreve em /proc/<pid>/fd/N
+        const auto source = sourcePath(name);
+        const auto logName = std::format("{}.log", r.purefilename);
+        const auto jobCancel = buildCancel.child();
+        bool astKilled = false;
+
+        if (!output.empty()) {
+            r.objectName = output;
+        } else if (buildAndLink) {
+            r.objectName =
+                outputPath(std::format("lib{}.so", r.purefilename), true);
         } else {
-            r.objectName = std::format("{}.o", r.purefilename);
+            r.objectName =
+                outputPath(std::format("{}.o", r.purefilename), false);
         }
 
         int ares = -1;
         bool headerChanged = false;
 
-        const std::string ccCmd = buildAndLink
-                                      ? compileAndLinkCmdFor(name, r.objectName)
-                                      : compileCmdFor(name, r.objectName);
+        std::error_code logEc;
+        std::filesystem::remove(logName, logEc);
+
+        // Declarações via plugin (-fplugin) no próprio compile; o
+        // -ast-dump=json fica como fallback
+        const std::string plugin = usingInProcessBackend()
+                                 ? std::string{}
+                                 : declExportPlugin(compiler);
+        const bool usePlugin = !plugin.empty();
+        const auto declsPath =
+            usePlugin ? outputPath(std::format("{}.decls", r.purefilename),
+                                   false)
+                      : std::string{};
+        if (usePlugin && !execution::MemoryArtifacts::isMemoryPath(declsPath)) {
+            std::filesystem::remove(declsPath, logEc);
+        }
 
-        auto astFn = [&] {
-            execution::SpawnToMemfdMap executor{
-                {.redirect_stderr = false, .memfd_flags = 0}};
-            auto astCmd = astCmdArgs(name, r.purefilename);
-            auto result = executor.runDup2(astCmd);
-            if (result != 0) {
-                r.errorCode = result;
-                r.errorMessage = std::format("AST dump failed for {}: {}", name,
-                                             r.purefilename);
-                return result;
-            }
+        const std::string depFlags =
+            depFile.empty() ? std::string{}
+                            : std::format(" -MMD -MF {}", depFile);
+        std::string ccCmd = buildAndLink
+                                ? compileAndLinkCmdFor(source, r.objectName)
+                                : compileCmdFor(source, r.objectName);
+        ccCmd += depFlags;
+        if (usePlugin) {
+            ccCmd += std::format(" -fplugin={} -fplugin-arg-{}-out={}", plugin,
+                                 analysis::decl_export::kPluginName,
+                                 declsPath);
+        }
 
-            auto data = executor.view();
+        auto analyzeJson = [&](std::string_view data) {
+            analysis::ClangAstAnalyzerAdapter analyzer;
+            analyzer.setSnippetUnit(r.purefilename);
+            ares = analyzer.analyzeJson(data, source, r.localVars);
+            if (ares == 0) {
+                headerChanged = analyzer.getContext()->hasHeaderChanged();
+                r.provides = analyzer.getAnalyzer().providedNames();
+                r.stale = analyzer.getAnalyzer().staleSnippets();
+            }
+        };
 
+        auto analyzeRecords = [&](std::string_view data) {
             analysis::ClangAstAnalyzerAdapter analyzer;
-            ares = analyzer.analyzeJson(data, name, r.localVars);
+            analyzer.setSnippetUnit(r.purefilename);
+            ares = analyzer.analyzeDeclRecords(data, source, r.localVars);
             if (ares == 0) {
                 headerChanged = analyzer.getContext()->hasHeaderChanged();
+                r.provides = analyzer.getAnalyzer().providedNames();
+                r.stale = analyzer.getAnalyzer().staleSnippets();
             }
+        };
 
-            return result;
+        auto astFn = [&] {
+            auto astRes = runCompilerJob(
+                execution::JobKind::AstDump, jobCancel, [&](auto opts) {
+                    return execution::runProcess(
+                        astCmdArgs(source, r.purefilename), std::move(opts));
+                });
+            if (!astRes.success()) {
+                astKilled = astRes.cancelled;
+                if (!astKilled) {
+                    jobCancel.cancel(); // o compile já não serve
+                }
+                r.errorCode = astRes.spawnError ? astRes.spawnError
+                                                : astRes.status;
+                r.errorMessage = std::format("AST dump failed for {}: {}", name,
+                                             r.purefilename);
+                return r.errorCode;
+            }
+
+            analyzeJson(astRes.out());
+            return 0;
         };
 
         try {
-            // AST + compile em paralelo
-            auto futAst = std::async(std::launch::async, astFn);
+            // Externo: AST + compile em paralelo (ou só o compile, com o
+            // plugin). In-process: um único frontend gera o objeto e as
+            // declarações.
+            // Diagnósticos capturados (2>&1) para o .log e para o cache
+            auto runCaptured = [&](execution::JobKind kind,
+                                   const std::string &cmd) {
+                auto res =
+                    runCompilerJob(kind, jobCancel, [&](auto opts) {
+                        return execution::runCommandLine(cmd + " 2>&1",
+                                                         std::move(opts));
+                    });
+                if (!res.success() && !res.cancelled) {
+                    jobCancel.cancel(); // o dump da AST já não serve
+                }
+                return std::pair<std::string, int>{std::string(res.out()),
+                                                   res.status};
+            };
 
-            auto futCC = std::async(std::launch::async, [&, ccCmd] {
-                return utility::runProgramGetOutput(ccCmd);
-            });
+            auto ccFn = [&]() -> std::pair<std::string, int> {
+                if (!usingInProcessBackend()) {
+                    return runCaptured(execution::JobKind::Compile, ccCmd);
+                }
+
+                // Mesmo TU, mesmas flags, sem fork/exec do frontend
+                const auto object =
+                    buildAndLink
+                        ? outputPath(std::format("{}.o", r.purefilename), false)
+                        : r.objectName;
+                std::string astOutput;
+                const bool records = !forceAstJson();
+                CompilerResult<int> objRes;
+                {
+                    // Sem pid: a memória do frontend conta no próprio REPL
+                    auto token =
+                        execution::Jobserver::instance().acquire(jobCancel);
+                    auto ticket = execution::MemoryAdmission::instance().admit(
+                        execution::JobKind::Compile);
+                    objRes = compileObjectInProcess(
+                        compiler, std, objectFlags + depFlags, source, object,
+                        outputPath(logName, false),
+                        records ? nullptr : &astOutput,
+                        records ? &astOutput : nullptr, &declHeader);
+                }
+                if (objRes && records) {
+                    analyzeRecords(astOutput);
+                } else if (objRes) {
+                    analyzeJson(astOutput);
+                }
+                if (!objRes || !buildAndLink) {
+                    return std::pair<std::string, int>{readLogFile(logName),
+                                                       objRes.value};
+                }
+
+                return runCaptured(
+                    execution::JobKind::Link,
+                    std::format(
+                        "{} -shared -g -Wl,--export-dynamic{} {} {} {} -o {}",
+                        compiler, disklessLinkFlags(),
+                        buildSettings_->getExtraLinkerFlags(), object,
+                        getLinkLibrariesStr(), r.objectName));
+            };
+
+            std::pair<std::string, int> ccRes;
+            int astRes = 0;
+            if (!usingInProcessBackend() && !usePlugin) {
+                execution::TaskScheduler::instance().parallelInvoke(
+                    [&] { ccRes = ccFn(); }, [&] { astRes = astFn(); });
+            } else {
+                ccRes = ccFn();
+            }
 
-            const auto astRes = futAst.get();
-            const auto ccRes = futCC.get();
+            if (usePlugin && ccRes.second == 0) {
+                std::string records;
+                bool written = std::filesystem::exists(declsPath, logEc);
+                if (written) {
+                    records = readWholeFile(declsPath);
+                    // Em memfd o arquivo sempre existe: vazio = não gravou
+                    written = !records.empty() ||
+                              !execution::MemoryArtifacts::isMemoryPath(
+                                  declsPath);
+                }
+                if (written) {
+                    analyzeRecords(records);
+                } else {
+                    // Plugin não rodou (ex.: clang trocado): dump JSON
+                    astRes = astFn();
+                }
+            }
 
-            if (astRes != 0) {
+            if (buildCancel.cancelled()) {
+                r.cancelled = true;
+                r.errorCode = -ECANCELED;
+                r.errorMessage = std::format("Compilation of {} cancelled",
+                                             name);
+                return r;
+            }
+
+            r.diagnostics = ccRes.first;
+            if (!r.diagnostics.empty()) {
+                writeLogFile(logName, r.diagnostics);
+            }
+
+            // Erro do próprio compilador (exit 1), não sinal/falha de spawn
+            r.compilerRejected =
+                ccRes.second != 0 &&
+                (usingInProcessBackend() ? ccRes.second == 1
+                                         : WIFEXITED(ccRes.second) &&
+                                               WEXITSTATUS(ccRes.second) == 1);
+
+            // AST morta por causa do compile: vale o erro do compile
+            if (astRes != 0 && !(astKilled && ccRes.second != 0)) {
                 r.errorCode = astRes;
                 r.errorMessage =
                     std::format("AST dump failed for {}: {}", name, name);
@@ -573,6 +1713,18 @@ CompilerResult<CompilationResult> CompilerService::buildMultipleSourcesWithAST(
                 return r;
             }
 
+            if (!r.diagnostics.empty()) {
+                std::cerr << r.diagnostics; // warnings
+            }
+
+            if (source != name) {
+                for (auto &var : r.localVars) {
+                    if (var.file == source) {
+                        var.file = name;
+                    }
+                }
+            }
+
             r.hasHeaderChanged = headerChanged;
             r.errorCode = 0;
             return r;
@@ -585,6 +1737,93 @@ CompilerResult<CompilationResult> CompilerService::buildMultipleSourcesWithAST(
         }
     };
 
+    // Fonte único: consulta o cache de artefatos antes de compilar. A chave
+    // cobre tudo que o TU enxerga (fonte, decl_amalgama, PCH, flags e
+    // compilador), então um acerto dispensa compilação e dump da AST.
+    auto processOneCached = [&](const std::string &name) {
+        if (!artifactCache_) {
+            return processOne(name, true);
+        }
+
+        SourceProcessResult r;
+        r.sourceFile = name;
+        r.purefilename = pureName(name);
+        r.objectName =
+            outputPath(std::format("lib{}.so", r.purefilename), true);
+
+        // Em caso de falta, key passa a ser a variante onde publicar
+        auto key = artifactKey(compiler, std, name);
+
+        if (auto hit = artifactCache_->lookup(key, r.objectName, &key)) {
+            if (verbosityLevel >= 1) {
+                std::cout << std::format("Artifact cache hit for {} ({})\n",
+                                         name, key.substr(0, 12));
+            }
+
+            if (!hit->success) {
+                writeLogFile(std::format("{}.log", r.purefilename),
+                             hit->diagnostics);
+                r.errorCode = 1;
+                r.errorMessage = std::format(
+                    "Object compilation failed for {} (cached)", name);
+                return r;
+            }
+
+            if (!hit->diagnostics.empty()) {
+                std::cerr << hit->diagnostics;
+            }
+
+            replayCachedSnippets(hit->snippets, hit->sourceName, name);
+
+            // Sem análise: o grafo recebe o que ela registrou da outra vez
+            r.provides = std::move(hit->provides);
+            r.stale = analysis::AstContext::recordSnippetDependencies(
+                r.purefilename, readWholeFile(sourcePath(name)), r.provides);
+            for (auto &var : hit->variables) {
+                if (var.file == hit->sourceName) {
+                    var.file = name;
+                }
+            }
+            r.localVars = std::move(hit->variables);
+            r.hasHeaderChanged = !hit->snippets.empty();
+            return r;
+        }
+
+        const auto depFile =
+            outputPath(std::format("{}.d", r.purefilename), false);
+        std::error_code depEc;
+        if (!execution::MemoryArtifacts::isMemoryPath(depFile)) {
+            std::filesystem::remove(depFile, depEc);
+        }
+
+        const size_t snippetsBefore = analysis::AstContext::codeSnippetCount();
+        r = processOne(name, true, r.objectName, depFile);
+
+        // Sem a lista do -MMD não há como invalidar a entrada quando um
+        // header mudar: não publica
+        const auto depText = readWholeFile(depFile);
+        if (parseDepFile(depText).empty()) {
+            return r;
+        }
+
+        ArtifactCache::Entry entry;
+        entry.sourceName = name;
+        entry.diagnostics = r.diagnostics;
+        entry.dependencies = headerDependencies(depText, sourcePath(name));
+        if (r.errorCode == 0) {
+            entry.success = true;
+            entry.variables = r.localVars;
+            entry.provides = r.provides;
+            entry.snippets =
+                analysis::AstContext::codeSnippetsSince(snippetsBefore);
+            artifactCache_->store(key, entry, r.objectName);
+        } else if (r.compilerRejected && !r.diagnostics.empty()) {
+            artifactCache_->store(key, entry, {});
+        }
+
+        return r;
+    };
+
     auto handleErrorAndBail = [&](const SourceProcessResult &r) {
         if (r.errorCode != 0) {
             std::cerr << r.errorMessage << std::endl;
@@ -601,37 +1840,88 @@ CompilerResult<CompilationResult> CompilerService::buildMultipleSourcesWithAST(
 
     if (sources.size() == 1) {
         linked = true;
-        auto r = processOne(sources.front(), linked);
+        auto r = processOneCached(sources.front());
         if (r.errorCode != 0) {
             handleErrorAndBail(r);
         } else {
+            analysis::AstContext::reportStaleSnippets(r.stale);
             namesConcated += std::format("{} ", r.objectName);
             allVars.insert(allVars.end(), r.localVars.begin(),
                            r.localVars.end());
             hasChanged |= r.hasHeaderChanged;
         }
     } else {
-        const size_t maxConc =
-            std::min(getEffectiveThreadCount(), sources.size());
-        std::vector<std::future<SourceProcessResult>> futures;
-        futures.reserve(sources.size());
-
-        // Lança com capping simples (como seu original)
-        for (size_t i = 0; i < sources.size(); ++i) {
-            const auto &name = sources[i];
-            if (name.empty())
-                continue;
-            auto policy =
-                (i < maxConc) ? std::launch::async : std::launch::deferred;
-            futures.emplace_back(std::async(policy, processOne, name));
+        // Fonte que cita um nome declarado por outra espera a onda dela: a
+        // declaração só entra no decl_amalgama.hpp depois da análise. Fontes
+        // independentes compilam juntas
+        std::vector<std::string> codes;
+        codes.reserve(sources.size());
+        for (const auto &source : sources) {
+            codes.push_back(source.empty() ? std::string{}
+                                           : readWholeFile(sourcePath(source)));
+        }
+        const auto waves = analysis::SnippetGraph::parallelWaves(codes);
+        if (waves.size() > 1 && verbosityLevel >= 1) {
+            std::cout << std::format("{} sources in {} dependency waves\n",
+                                     sources.size(), waves.size());
+        }
+
+        // Um job por fonte na arena compartilhada; depois do primeiro erro
+        // nenhuma fonte nova começa
+        std::vector<SourceProcessResult> results(sources.size());
+        std::atomic<bool> failed{false};
+        for (size_t w = 0; w < waves.size(); ++w) {
+            const auto &wave = waves[w];
+            execution::TaskScheduler::instance().parallelFor(
+                wave.size(),
+                [&](size_t k) {
+                    const size_t i = wave[k];
+                    if (sources[i].empty() ||
+                        failed.load(std::memory_order_relaxed) ||
+                        buildCancel.cancelled()) {
+                        return;
+                    }
+                    results[i] = processOne(sources[i]);
+                    if (results[i].errorCode != 0) {
+                        failed.store(true, std::memory_order_relaxed);
+                        buildCancel.cancel(); // mata as fontes em andamento
+                    }
+                },
+                maxThreads_);
+
+            if (failed.load() || buildCancel.cancelled()) {
+                break;
+            }
+            // A próxima onda enxerga o que esta declarou
+            if (w + 1 < waves.size() &&
+                std::ranges::any_of(wave, [&](size_t i) {
+                    return results[i].hasHeaderChanged;
+                })) {
+                analysis::AstContext::staticSaveHeaderToFile(
+                    "decl_amalgama.hpp");
+                if (usingInProcessBackend()) {
+                    declHeader = analysis::AstContext::snapshotOutputHeader();
+                }
+            }
         }
 
-        for (auto &f : futures) {
-            auto r = f.get();
+        for (size_t i = 0; i < sources.size() && !evalCancel.cancelled();
+             ++i) {
+            if (sources[i].empty()) {
+                continue;
+            }
+            auto &r = results[i];
+            if (r.cancelled) {
+                continue; // vítima da falha de outra fonte
+            }
             if (r.errorCode != 0) {
                 handleErrorAndBail(r);
                 break; // comportamento compatível: para no primeiro erro
             }
+            if (r.objectName.empty()) {
+                continue; // não iniciada: o erro aparece em outro índice
+            }
+            analysis::AstContext::reportStaleSnippets(r.stale);
             namesConcated += std::format("{} ", r.objectName);
             allVars.insert(allVars.end(), r.localVars.begin(),
                            r.localVars.end());
@@ -639,6 +1929,13 @@ CompilerResult<CompilationResult> CompilerService::buildMultipleSourcesWithAST(
         }
     }
 
+    if (evalCancel.cancelled()) {
+        std::cerr << "Build interrupted\n";
+        result.error = CompilerError::Cancelled;
+        result.value.returnCode = -ECANCELED;
+        return result;
+    }
+
     if (errorCode != 0) {
         result.error = CompilerError::BuildFailed;
         result.value.returnCode = errorCode;
@@ -650,10 +1947,13 @@ CompilerResult<CompilationResult> CompilerService::buildMultipleSourcesWithAST(
 
         // Link (sequencial)
         const std::string linkCmd = std::format(
-            "{} {} -shared -g -Wl,--export-dynamic {} {} -o lib{}.so", compiler,
-            linkerFlags, namesConcated, getLinkLibrariesStr(), libname);
+            "{} {} -shared -g -Wl,--export-dynamic{} {} {} -o {}", compiler,
+            linkerFlags, disklessLinkFlags(), namesConcated,
+            getLinkLibrariesStr(),
+            outputPath(std::format("lib{}.so", libname), true));
 
-        if (auto linkRes = executeCommand(linkCmd); !linkRes) {
+        if (auto linkRes = executeCommand(linkCmd, execution::JobKind::Link);
+            !linkRes) {
             result.error = CompilerError::LinkingFailed;
             result.value.returnCode = linkRes.value;
             return result;
@@ -798,8 +2098,8 @@ CompilerResult<std::vector<std::string>> CompilerService::analyzeCustomCommands(
     };
 
     // Processa os comandos em paralelo
-    std::for_each(std::execution::par_unseq, commands.begin(), commands.end(),
-                  evalcmd);
+    execution::TaskScheduler::instance().parallelFor(
+        commands.size(), [&](size_t i) { evalcmd(commands[i]); });
 
     // Verifica se houve erros
     if (!errors.empty()) {
@@ -0,0 +1,412 @@
+#include "compiler/inprocess_backend.hpp"
+
+#include "utility/system_exec.hpp"
+#include <atomic>
+#include <format>
+#include <iostream>
+#include <mutex>
+#include <string_view>
+
+#ifdef CLANG_COMPLETION_ENABLED
+#include "analysis/decl_export_consumer.hpp"
+#include <clang/Basic/Diagnostic.h>
+#include <clang/Basic/DiagnosticOptions.h>
+#include <clang/Basic/Version.h>
+#include <clang/CodeGen/CodeGenAction.h>
+#include <clang/Frontend/ASTConsumers.h>
+#include <clang/Frontend/CompilerInstance.h>
+#include <clang/Frontend/CompilerInvocation.h>
+#include <clang/Frontend/FrontendActions.h>
+#include <clang/Frontend/MultiplexConsumer.h>
+#include <clang/Frontend/TextDiagnosticPrinter.h>
+#include <clang/Frontend/Utils.h>
+#include <clang/Lex/PreprocessorOptions.h>
+#include <clang/Serialization/InMemoryModuleCache.h>
+#include <llvm/ADT/IntrusiveRefCntPtr.h>
+#include <llvm/Support/CrashRecoveryContext.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/TargetSelect.h>
+#include <llvm/Support/VirtualFileSystem.h>
+#include <llvm/Support/raw_ostream.h>
+#endif
+
+extern int verbosityLevel;
+
+namespace compiler {
+
+#ifdef CLANG_COMPLETION_ENABLED
+
+namespace {
+
+/**
+ * @brief Descobre o resource-dir do clang++ do sistema (uma vez por processo)
+ *
+ * O driver embutido deduz o resource-dir a partir do executável atual, que
+ * aqui é o cpprepl; sem este ajuste os headers intrínsecos (stddef.h etc.) não
+ * seriam encontrados.
+ */
+const std::string &systemResourceDir() {
+    static const std::string dir = [] {
+        auto [output, rc] =
+            utility::runProgramGetOutput("clang++ -print-resource-dir");
+        if (rc != 0) {
+            return std::string{};
+        }
+        while (!output.empty() &&
+               (output.back() == '\n' || output.back() == '\r')) {
+            output.pop_back();
+        }
+        return output;
+    }();
+    return dir;
+}
+
+void initializeNativeTargetOnce() {
+    static std::once_flag once;
+    std::call_once(once, [] {
+        llvm::InitializeNativeTarget();
+        llvm::InitializeNativeTargetAsmPrinter();
+        llvm::InitializeNativeTargetAsmParser();
+        // Sem Enable() o RunSafely só chama a função: um crash do frontend
+        // derrubaria o REPL em vez de virar um erro de compilação
+        llvm::CrashRecoveryContext::Enable();
+    });
+}
+
+/**
+ * @brief EmitObjAction que também emite o dump JSON da AST
+ *
+ * O mesmo parse alimenta o codegen e o ASTDumper (equivalente a
+ * -Xclang -ast-dump=json), então um único frontend produz o objeto e as
+ * declarações que o ContextualAstAnalyzer precisa.
+ */
+class EmitObjWithAstDumpAction : public clang::EmitObjAction {
+  public:
+    explicit EmitObjWithAstDumpAction(std::string &json) : json_(json) {}
+
+  protected:
+    std::unique_ptr<clang::ASTConsumer>
+    CreateASTConsumer(clang::CompilerInstance &ci,
+                      llvm::StringRef inFile) override {
+        auto codegen = clang::EmitObjAction::CreateASTConsumer(ci, inFile);
+        if (!codegen) {
+            return nullptr;
+        }
+
+        std::vector<std::unique_ptr<clang::ASTConsumer>> consumers;
+        consumers.push_back(std::move(codegen));
+        consumers.push_back(clang::CreateASTDumper(
+            std::make_unique<llvm::raw_string_ostream>(json_),
+            /*FilterString=*/"", /*DumpDecls=*/true, /*Deserialize=*/false,
+            /*DumpLookups=*/false, /*DumpDeclTypes=*/false,
+            clang::ADOF_JSON));
+        return std::make_unique<clang::MultiplexConsumer>(std::move(consumers));
+    }
+
+  private:
+    std::string &json_;
+};
+
+/**
+ * @brief EmitObjAction que também exporta as declarações (cpprepl-decls)
+ *
+ * Mesmo consumer do plugin carregado pelo clang++ externo, então os dois
+ * backends entregam registros idênticos ao ContextualAstAnalyzer.
+ */
+class EmitObjWithDeclExportAction : public clang::EmitObjAction {
+  public:
+    explicit EmitObjWithDeclExportAction(std::string &records)
+        : records_(records) {}
+
+  protected:
+    std::unique_ptr<clang::ASTConsumer>
+    CreateASTConsumer(clang::CompilerInstance &ci,
+                      llvm::StringRef inFile) override {
+        auto codegen = clang::EmitObjAction::CreateASTConsumer(ci, inFile);
+        if (!codegen) {
+            return nullptr;
+        }
+
+        std::vector<std::unique_ptr<clang::ASTConsumer>> consumers;
+        consumers.push_back(std::move(codegen));
+        consumers.push_back(
+            std::make_unique<analysis::decl_export::DeclExportConsumer>(
+                [this](std::string &&records) {
+                    records_ = std::move(records);
+                }));
+        return std::make_unique<clang::MultiplexConsumer>(std::move(consumers));
+    }
+
+  private:
+    std::string &records_;
+};
+
+} // namespace
+
+struct InProcessClangBackend::Impl {
+    std::shared_ptr<clang::PCHContainerOperations> pchOps =
+        std::make_shared<clang::PCHContainerOperations>();
+
+    // Caches de módulo/PCH reaproveitados entre avaliações. O
+    // InMemoryModuleCache não é thread-safe, então cada compilação pega um
+    // cache exclusivo do pool e o devolve ao final.
+    // Caches emprestados antes de uma invalidação não voltam ao pool.
+    std::mutex poolMutex;
+    std::vector<llvm::IntrusiveRefCntPtr<clang::InMemoryModuleCache>> pool;
+    uint64_t poolGeneration = 0;
+    std::atomic<uint64_t> compilations{0};
+
+    std::pair<llvm::IntrusiveRefCntPtr<clang::InMemoryModuleCache>, uint64_t>
+    acquireCache() {
+        std::scoped_lock lock(poolMutex);
+        if (pool.empty()) {
+            return {llvm::makeIntrusiveRefCnt<clang::InMemoryModuleCache>(),
+                    poolGeneration};
+        }
+        auto cache = std::move(pool.back());
+        pool.pop_back();
+        return {std::move(cache), poolGeneration};
+    }
+
+    void releaseCache(llvm::IntrusiveRefCntPtr<clang::InMemoryModuleCache> c,
+                      uint64_t generation) {
+        std::scoped_lock lock(poolMutex);
+        if (generation == poolGeneration) {
+            pool.push_back(std::move(c));
+        }
+    }
+
+    enum class Action { EmitObject, GeneratePch, SyntaxOnly };
+
+    Result run(const std::vector<std::string> &args,
+               const std::vector<RemappedFile> &remapped, Action kind,
+               std::string *astJson = nullptr,
+               std::string *declRecords = nullptr);
+};
+
+InProcessClangBackend::Result
+InProcessClangBackend::Impl::run(const std::vector<std::string> &args,
+                                 const std::vector<RemappedFile> &remapped,
+                                 Action kind, std::string *astJson,
+                                 std::string *declRecords) {
+    Result result;
+    if (args.empty()) {
+        result.diagnostics = "empty command line";
+        return result;
+    }
+
+    initializeNativeTargetOnce();
+
+    std::vector<std::string> fullArgs(args);
+    if (const auto &rd = systemResourceDir(); !rd.empty()) {
+        fullArgs.insert(fullArgs.begin() + 1, {"-resource-dir", rd});
+    }
+
+    std::vector<const char *> cargs;
+    cargs.reserve(fullArgs.size());
+    for (const auto &a : fullArgs) {
+        cargs.push_back(a.c_str());
+    }
+
+    llvm::raw_string_ostream diagStream(result.diagnostics);
+#if CLANG_VERSION_MAJOR >= 21
+    clang::DiagnosticOptions diagOpts;
+    diagOpts.ShowColors = true;
+    auto diagPrinter =
+        std::make_unique<clang::TextDiagnosticPrinter>(diagStream, diagOpts);
+#else
+    llvm::IntrusiveRefCntPtr<clang::DiagnosticOptions> diagOpts(
+        new clang::DiagnosticOptions());
+    diagOpts->ShowColors = true;
+    auto diagPrinter = std::make_unique<clang::TextDiagnosticPrinter>(
+        diagStream, diagOpts.get());
+#endif
+
+    auto leased = acquireCache();
+    auto &cache = leased.first;
+
+    bool ok = false;
+    llvm::CrashRecoveryContext crc;
+    bool completed = crc.RunSafely([&] {
+#if CLANG_VERSION_MAJOR >= 21
+        auto diags = clang::CompilerInstance::createDiagnostics(
+            *llvm::vfs::getRealFileSystem(), diagOpts, diagPrinter.get(),
+            /*ShouldOwnClient=*/false);
+#elif CLANG_VERSION_MAJOR >= 20
+        auto diags = clang::CompilerInstance::createDiagnostics(
+            *llvm::vfs::getRealFileSystem(), diagOpts.get(), diagPrinter.get(),
+            /*ShouldOwnClient=*/false);
+#else
+        auto diags = clang::CompilerInstance::createDiagnostics(
+            diagOpts.get(), diagPrinter.get(), /*ShouldOwnClient=*/false);
+#endif
+
+        clang::CreateInvocationOptions opts;
+        opts.Diags = diags;
+        std::shared_ptr<clang::CompilerInvocation> invocation =
+            clang::createInvocation(cargs, std::move(opts));
+        if (!invocation) {
+            return;
+        }
+
+        auto &ppOpts = invocation->getPreprocessorOpts();
+        for (const auto &file : remapped) {
+            ppOpts.addRemappedFile(file.path,
+                                   llvm::MemoryBuffer::getMemBufferCopy(
+                                       file.contents, file.path)
+                                       .release());
+        }
+        ppOpts.RetainRemappedFileBuffers = false;
+
+#if CLANG_VERSION_MAJOR >= 21
+        // A partir do Clang 21 o cache compartilhado passou a ser um
+        // clang::ModuleCache; mantemos apenas o PCHContainerOperations.
+        clang::CompilerInstance ci(std::move(invocation), pchOps);
+#else
+        clang::CompilerInstance ci(pchOps, cache.get());
+        ci.setInvocation(std::move(invocation));
+#endif
+        ci.setDiagnostics(diags.get());
+
+        if (kind == Action::GeneratePch) {
+            clang::GeneratePCHAction action;
+            ok = ci.ExecuteAction(action);
+        } else if (kind == Action::SyntaxOnly) {
+            clang::SyntaxOnlyAction action;
+            ok = ci.ExecuteAction(action);
+        } else if (astJson) {
+            EmitObjWithAstDumpAction action(*astJson);
+            ok = ci.ExecuteAction(action);
+        } else if (declRecords) {
+            EmitObjWithDeclExportAction action(*declRecords);
+            ok = ci.ExecuteAction(action);
+        } else {
+            clang::EmitObjAction action;
+            ok = ci.ExecuteAction(action);
+        }
+    });
+
+    diagStream.flush();
+    releaseCache(std::move(cache), leased.second);
+
+    if (!completed) {
+        result.diagnostics += "\nclang frontend crashed (in-process)\n";
+        result.returnCode = -1;
+        return result;
+    }
+
+    compilations.fetch_add(1, std::memory_order_relaxed);
+    result.returnCode = ok ? 0 : 1;
+    return result;
+}
+
+InProcessClangBackend::InProcessClangBackend()
+    : impl_(std::make_unique<Impl>()) {}
+
+InProcessClangBackend::~InProcessClangBackend() = default;
+
+bool InProcessClangBackend::isAvailable() { return true; }
+
+InProcessClangBackend::Result
+InProcessClangBackend::compileToObject(const std::vector<std::string> &args,
+                                       const std::vector<RemappedFile> &remapped) {
+    if (::verbosityLevel >= 2) {
+        std::string cmd;
+        for (const auto &a : args) {
+            cmd += a + " ";
+        }
+        std::cout << std::format("In-process: {}\n", cmd);
+    }
+    return impl_->run(args, remapped, Impl::Action::EmitObject);
+}
+
+InProcessClangBackend::Result InProcessClangBackend::compileToObjectWithAst(
+    const std::vector<std::string> &args, std::string &astJson,
+    const std::vector<RemappedFile> &remapped) {
+    astJson.clear();
+    return impl_->run(args, remapped, Impl::Action::EmitObject, &astJson);
+}
+
+InProcessClangBackend::Result InProcessClangBackend::compileToObjectWithDecls(
+    const std::vector<std::string> &args, std::string &declRecords,
+    const std::vector<RemappedFile> &remapped) {
+    declRecords.clear();
+    return impl_->run(args, remapped, Impl::Action::EmitObject, nullptr,
+                      &declRecords);
+}
+
+InProcessClangBackend::Result
+InProcessClangBackend::generatePch(const std::vector<std::string> &args) {
+    auto result = impl_->run(args, {}, Impl::Action::GeneratePch);
+    invalidatePchCache();
+    return result;
+}
+
+InProcessClangBackend::Result
+InProcessClangBackend::checkSyntax(const std::vector<std::string> &args,
+                                   const std::vector<RemappedFile> &remapped) {
+    return impl_->run(args, remapped, Impl::Action::SyntaxOnly);
+}
+
+void InProcessClangBackend::invalidatePchCache() {
+    std::scoped_lock lock(impl_->poolMutex);
+    impl_->pool.clear();
+    ++impl_->poolGeneration;
+}
+
+uint64_t InProcessClangBackend::compilationCount() const {
+    return impl_->compilations.load(std::memory_order_relaxed);
+}
+
+#else // !CLANG_COMPLETION_ENABLED
+
+struct InProcessClangBackend::Impl {};
+
+InProcessClangBackend::InProcessClangBackend()
+    : impl_(std::make_unique<Impl>()) {}
+
+InProcessClangBackend::~InProcessClangBackend() = default;
+
+bool InProcessClangBackend::isAvailable() { return false; }
+
+InProcessClangBackend::Result
+InProcessClangBackend::compileToObject(const std::vector<std::string> &,
+                                       const std::vector<RemappedFile> &) {
+    return {.returnCode = -1,
+            .diagnostics = "in-process clang backend not available"};
+}
+
+InProcessClangBackend::Result InProcessClangBackend::compileToObjectWithAst(
+    const std::vector<std::string> &, std::string &,
+    const std::vector<RemappedFile> &) {
+    return {.returnCode = -1,
+            .diagnostics = "in-process clang backend not available"};
+}
+
+InProcessClangBackend::Result InProcessClangBackend::compileToObjectWithDecls(
+    const std::vector<std::string> &, std::string &,
+    const std::vector<RemappedFile> &) {
+    return {.returnCode = -1,
+            .diagnostics = "in-process clang backend not available"};
+}
+
+InProcessClangBackend::Result
+InProcessClangBackend::generatePch(const std::vector<std::string> &) {
+    return {.returnCode = -1,
+            .diagnostics = "in-process clang backend not available"};
+}
+
+InProcessClangBackend::Result
+InProcessClangBackend::checkSyntax(const std::vector<std::string> &,
+                                   const std::vector<RemappedFile> &) {
+    return {.returnCode = -1,
+            .diagnostics = "in-process clang backend not available"};
+}
+
+void InProcessClangBackend::invalidatePchCache() {}
+
+uint64_t InProcessClangBackend::compilationCount() const { return 0; }
+
+#endif
+
+} // namespace compiler
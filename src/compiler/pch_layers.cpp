@@ -0,0 +1,204 @@
+#include "compiler/pch_layers.hpp"
+
+#include <format>
+
+namespace compiler {
+
+std::string PchLayerStack::Layer::header() const {
+    if (stored()) {
+        return std::format("{}/layer.hpp", dir);
+    }
+    return std::format("precompiledheader_layer{}.hpp", id);
+}
+
+std::string PchLayerStack::Layer::pch() const {
+    return std::format("{}.pch", header());
+}
+
+PchLayerStack::PchLayerStack(std::string preamble, size_t maxLayers)
+    : preamble_(std::move(preamble)), maxLayers_(maxLayers) {}
+
+PchLayerStack::Plan PchLayerStack::plan(const std::vector<Include> &includes) {
+    std::scoped_lock lock(mutex_);
+
+    Plan result;
+    result.baseTopId = layers_.empty() ? 0 : layers_.back().id;
+
+    // A pilha precisa ser um prefixo exato da lista atual; qualquer outra
+    // coisa (clear, ordem diferente) volta para uma camada base nova
+    size_t covered = 0;
+    bool prefix = !layers_.empty();
+    for (const auto &layer : layers_) {
+        for (const auto &inc : layer.includes) {
+            if (covered >= includes.size() || includes[covered] != inc) {
+                prefix = false;
+                break;
+            }
+            ++covered;
+        }
+        if (!prefix) {
+            break;
+        }
+    }
+
+    if (prefix && covered == includes.size()) {
+        return result;
+    }
+
+    result.layer.id = nextId_++;
+    if (prefix) {
+        result.kind = Plan::Kind::Append;
+        result.layer.includes.assign(includes.begin() + covered,
+                                     includes.end());
+        result.parentPch = layers_.back().pch();
+    } else {
+        result.kind = Plan::Kind::Rebuild;
+        result.layer.base = true;
+        result.layer.includes = includes;
+        // O decl_amalgama.hpp não tem mais as declarações dobradas
+        for (const auto &layer : layers_) {
+            result.layer.declarations += layer.declarations;
+        }
+    }
+    return result;
+}
+
+PchLayerStack::Plan PchLayerStack::planFlatten() {
+    std::scoped_lock lock(mutex_);
+
+    Plan result;
+    if (layers_.size() < 2) {
+        return result;
+    }
+
+    result.kind = Plan::Kind::Rebuild;
+    result.baseTopId = layers_.back().id;
+    result.layer.id = nextId_++;
+    result.layer.base = true;
+    for (const auto &layer : layers_) {
+        result.layer.includes.insert(result.layer.includes.end(),
+                                     layer.includes.begin(),
+                                     layer.includes.end());
+        result.layer.declarations += layer.declarations;
+    }
+    return result;
+}
+
+PchLayerStack::Plan PchLayerStack::planDeclarations(std::string declarations) {
+    std::scoped_lock lock(mutex_);
+
+    Plan result;
+    if (layers_.empty() || declarations.empty()) {
+        return result;
+    }
+
+    result.kind = Plan::Kind::Append;
+    result.baseTopId = layers_.back().id;
+    result.layer.id = nextId_++;
+    result.layer.declarations = std::move(declarations);
+    result.parentPch = layers_.back().pch();
+    return result;
+}
+
+bool PchLayerStack::commit(const Plan &plan) {
+    std::scoped_lock lock(mutex_);
+
+    if (plan.kind == Plan::Kind::UpToDate) {
+        return true;
+    }
+
+    const uint64_t top = layers_.empty() ? 0 : layers_.back().id;
+    if (top != plan.baseTopId) {
+        return false;
+    }
+
+    if (plan.kind == Plan::Kind::Append) {
+        layers_.push_back(plan.layer);
+        return true;
+    }
+
+    retired_.insert(retired_.end(), retiring_.begin(), retiring_.end());
+    retiring_ = std::move(layers_);
+    layers_ = {plan.layer};
+    return true;
+}
+
+std::string PchLayerStack::layerSource(const Layer &layer) const {
+    std::string out = "#pragma once\n\n";
+    if (layer.base) {
+        std::scoped_lock lock(mutex_);
+        out += preamble_;
+    }
+    for (const auto &[path, system] : layer.includes) {
+        out += system ? std::format("#include <{}>\n", path)
+                      : std::format("#include \"{}\"\n", path);
+    }
+    if (!layer.declarations.empty()) {
+        out += "\n";
+        out += layer.declarations;
+    }
+    return out;
+}
+
+std::string PchLayerStack::indexSource() const {
+    std::scoped_lock lock(mutex_);
+
+    std::string out = "#pragma once\n\n";
+    for (const auto &layer : layers_) {
+        out += std::format("#include \"{}\"\n", layer.header());
+    }
+    return out;
+}
+
+std::string PchLayerStack::combinedSource() const {
+    std::scoped_lock lock(mutex_);
+
+    std::string out = preamble_;
+    for (const auto &layer : layers_) {
+        for (const auto &[path, system] : layer.includes) {
+            out += system ? std::format("#include <{}>\n", path)
+                          : std::format("#include \"{}\"\n", path);
+        }
+    }
+    // Mesma ordem de uma camada achatada: declarações depois dos includes
+    for (const auto &layer : layers_) {
+        out += layer.declarations;
+    }
+    return out;
+}
+
+std::string PchLayerStack::topPch() const {
+    std::scoped_lock lock(mutex_);
+    return layers_.empty() ? std::string{} : layers_.back().pch();
+}
+
+uint64_t PchLayerStack::topId() const {
+    std::scoped_lock lock(mutex_);
+    return layers_.empty() ? 0 : layers_.back().id;
+}
+
+size_t PchLayerStack::depth() const {
+    std::scoped_lock lock(mutex_);
+    return layers_.size();
+}
+
+size_t PchLayerStack::declarationBytes() const {
+    std::scoped_lock lock(mutex_);
+    size_t bytes = 0;
+    for (const auto &layer : layers_) {
+        bytes += layer.declarations.size();
+    }
+    return bytes;
+}
+
+bool PchLayerStack::needsFlatten() const {
+    std::scoped_lock lock(mutex_);
+    return layers_.size() > maxLayers_;
+}
+
+std::vector<PchLayerStack::Layer> PchLayerStack::takeRetired() {
+    std::scoped_lock lock(mutex_);
+    return std::exchange(retired_, {});
+}
+
+} // namespace compiler
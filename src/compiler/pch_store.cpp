@@ -0,0 +1,284 @@
+#include "compiler/pch_store.hpp"
+
+#include "compiler/artifact_cache.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <format>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <optional>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace compiler {
+
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr const char *kDepsFile = "deps";
+
+// Variantes seguidas por lookup() antes de desistir
+constexpr int kMaxVariants = 8;
+
+// nullopt: deps ainda batem com o disco; senão, os caminhos listados
+std::optional<std::vector<std::string>> changedDeps(const fs::path &dir) {
+    std::ifstream in(dir / kDepsFile, std::ios::in | std::ios::binary);
+    if (!in.is_open()) {
+        return std::nullopt; // entrada sem lista: só a chave vale
+    }
+    const std::string list((std::istreambuf_iterator<char>(in)),
+                           std::istreambuf_iterator<char>());
+    return changedDependencies(list);
+}
+
+uint64_t directorySize(const fs::path &dir) {
+    uint64_t total = 0;
+    std::error_code ec;
+    for (fs::recursive_directory_iterator it(dir, ec), end; !ec && it != end;
+         it.increment(ec)) {
+        std::error_code fec;
+        if (it->is_regular_file(fec)) {
+            auto size = it->file_size(fec);
+            if (!fec) {
+                total += size;
+            }
+        }
+    }
+    return total;
+}
+
+// Percorre <root>/<família>/<chave>
+template <typename Fn> void forEachEntry(const fs::path &root, Fn &&fn) {
+    std::error_code ec;
+    for (fs::directory_iterator fam(root, ec), end; !ec && fam != end;
+         fam.increment(ec)) {
+        std::error_code dec;
+        if (!fam->is_directory(dec)) {
+            continue;
+        }
+        for (fs::directory_iterator it(fam->path(), dec); !dec && it != end;
+             it.increment(dec)) {
+            fn(it->path());
+        }
+    }
+}
+
+} // namespace
+
+PchStore::PchStore(fs::path root, uint64_t maxBytes)
+    : root_(std::move(root)), maxBytes_(maxBytes) {}
+
+fs::path PchStore::defaultRoot() { return ArtifactCache::defaultRoot() / "pch"; }
+
+uint64_t PchStore::defaultMaxBytes() {
+    uint64_t mb = 2048;
+    if (const char *env = std::getenv("CPPREPL_PCH_STORE_MAX_MB");
+        env && *env) {
+        char *end = nullptr;
+        auto value = std::strtoull(env, &end, 10);
+        if (end && *end == '\0' && value > 0) {
+            mb = value;
+        }
+    }
+    return mb * 1024 * 1024;
+}
+
+fs::path PchStore::entryDir(std::string_view family,
+                            const std::string &key) const {
+    return root_ / family / key;
+}
+
+fs::path PchStore::lookup(std::string_view family, const std::string &key,
+                          std::string_view pchName, std::string *missKey) {
+    std::string current = key;
+    for (int variant = 0; variant < kMaxVariants; ++variant) {
+        const auto dir = entryDir(family, current);
+        std::error_code ec;
+        if (!fs::exists(dir / pchName, ec)) {
+            break;
+        }
+
+        // Header indireto editado: a variante do conteúdo atual
+        if (auto changed = changedDeps(dir)) {
+            current = dependencyVariant(current, *changed);
+            continue;
+        }
+
+        // Marca como usado recentemente (LRU); o conteúdo não muda
+        fs::last_write_time(dir, fs::file_time_type::clock::now(), ec);
+        hits_.fetch_add(1, std::memory_order_relaxed);
+        return dir;
+    }
+
+    misses_.fetch_add(1, std::memory_order_relaxed);
+    if (missKey != nullptr) {
+        *missKey = std::move(current);
+    }
+    return {};
+}
+
+fs::path PchStore::prepare(std::string_view family, const std::string &key) {
+    const auto dir = entryDir(family, key);
+    std::error_code ec;
+    fs::create_directories(dir, ec);
+    if (ec) {
+        return {};
+    }
+    fs::last_write_time(dir, fs::file_time_type::clock::now(), ec);
+    return dir;
+}
+
+bool PchStore::writeFile(const fs::path &path, std::string_view contents) {
+    auto tmp = path;
+    tmp += std::format(".{}.{}.tmp", getpid(),
+                       std::hash<std::thread::id>{}(std::this_thread::get_id()));
+    {
+        std::ofstream out(tmp, std::ios::out | std::ios::binary |
+                                   std::ios::trunc);
+        out.write(contents.data(), static_cast<std::streamsize>(contents.size()));
+        if (!out) {
+            std::error_code ec;
+            fs::remove(tmp, ec);
+            return false;
+        }
+    }
+
+    std::error_code ec;
+    fs::rename(tmp, path, ec);
+    if (ec) {
+        fs::remove(tmp, ec);
+        return false;
+    }
+    return true;
+}
+
+fs::path PchStore::tempPathFor(const fs::path &finalPath) {
+    auto tmp = finalPath;
+    tmp += std::format(".{}.{}.tmp", getpid(),
+                       tempCounter_.fetch_add(1, std::memory_order_relaxed));
+    return tmp;
+}
+
+bool PchStore::recordDeps(const fs::path &entryDir, const fs::path &depFile) {
+    std::ifstream in(depFile, std::ios::in | std::ios::binary);
+    if (!in.is_open()) {
+        return false;
+    }
+    const std::string text((std::istreambuf_iterator<char>(in)),
+                           std::istreambuf_iterator<char>());
+
+    // O header da própria entrada já está na chave, e PCHs pais entram
+    // pelo caminho
+    std::error_code ec;
+    const auto canonicalDir = fs::weakly_canonical(entryDir, ec);
+    std::vector<std::string> paths;
+    for (const auto &dep : parseDepFile(text)) {
+        const auto path = fs::weakly_canonical(dep, ec);
+        if (ec || path.parent_path() == canonicalDir ||
+            path.extension() == ".pch") {
+            continue;
+        }
+        paths.push_back(path.string());
+    }
+    return writeFile(entryDir / kDepsFile, formatDependencies(paths));
+}
+
+bool PchStore::publish(const fs::path &built, const fs::path &finalPath) {
+    std::error_code ec;
+    const auto size = fs::file_size(built, ec);
+    fs::rename(built, finalPath, ec);
+    if (ec) {
+        fs::remove(built, ec);
+        return false;
+    }
+
+    bool evict = false;
+    {
+        std::scoped_lock lock(usageMutex_);
+        if (!approxUsage_) {
+            approxUsage_ = directorySize(root_);
+        } else {
+            *approxUsage_ += size;
+        }
+        evict = *approxUsage_ > maxBytes_ &&
+                std::chrono::steady_clock::now() >= nextEviction_;
+    }
+
+    if (evict) {
+        evictToLimit();
+    }
+    return true;
+}
+
+size_t PchStore::evictToLimit() {
+    struct Candidate {
+        fs::path dir;
+        fs::file_time_type lastUse;
+        uint64_t size;
+    };
+
+    std::vector<Candidate> candidates;
+    uint64_t total = 0;
+    forEachEntry(root_, [&](const fs::path &dir) {
+        std::error_code ec;
+        auto lastUse = fs::last_write_time(dir, ec);
+        if (ec) {
+            lastUse = fs::file_time_type::min();
+        }
+        auto size = directorySize(dir);
+        total += size;
+        candidates.push_back({dir, lastUse, size});
+    });
+
+    const uint64_t target = maxBytes_ / 10 * 9;
+    const auto inUse =
+        fs::file_time_type::clock::now() - std::chrono::hours(1);
+    size_t removed = 0;
+
+    if (total > maxBytes_) {
+        std::sort(candidates.begin(), candidates.end(),
+                  [](const Candidate &a, const Candidate &b) {
+                      return a.lastUse < b.lastUse;
+                  });
+
+        for (const auto &candidate : candidates) {
+            if (total <= target || candidate.lastUse > inUse) {
+                break;
+            }
+            std::error_code ec;
+            fs::remove_all(candidate.dir, ec);
+            total -= std::min(total, candidate.size);
+            ++removed;
+        }
+    }
+
+    evictions_.fetch_add(removed, std::memory_order_relaxed);
+
+    std::scoped_lock lock(usageMutex_);
+    approxUsage_ = total;
+    if (total > maxBytes_) {
+        nextEviction_ =
+            std::chrono::steady_clock::now() + std::chrono::minutes(1);
+    }
+    return removed;
+}
+
+uint64_t PchStore::diskUsage() const { return directorySize(root_); }
+
+size_t PchStore::entryCount() const {
+    size_t count = 0;
+    forEachEntry(root_, [&](const fs::path &) { ++count; });
+    return count;
+}
+
+PchStore::Stats PchStore::stats() const {
+    return {.hits = hits_.load(std::memory_order_relaxed),
+            .misses = misses_.load(std::memory_order_relaxed),
+            .evictions = evictions_.load(std::memory_order_relaxed)};
+}
+
+} // namespace compiler
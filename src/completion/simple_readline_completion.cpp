@@ -1,5 +1,6 @@
 #include "completion/simple_readline_completion.hpp"
 #include "commands/command_registry.hpp"
+#include "execution/symbol_index.hpp"
 #include "repl.hpp" // Para ReplState e VarDecl
 #include <algorithm>
 #include <cstring>
@@ -24,8 +25,6 @@ void SimpleReadlineCompletion::initialize() noexcept {
 
     keywords_.clear();
     replCommands_.clear();
-    variables_.clear();
-    functions_.clear();
 
     addBuiltinKeywords();
     addReplCommands();
@@ -41,33 +40,13 @@ void SimpleReadlineCompletion::shutdown() noexcept {
 
 void SimpleReadlineCompletion::updateFromReplState(
     const ReplState &state) noexcept {
-    // Limpar dados anteriores (manter keywords built-in)
-    variables_.clear();
-    functions_.clear();
-
-    // Adicionar variáveis do REPL
-    for (const auto &varName : state.varsNames) {
-        variables_.emplace(varName);
-    }
-
-    // Adicionar variáveis detalhadas
-    for (const auto &var : state.allTheVariables) {
-        if (var.kind == "VarDecl") {
-            variables_.emplace(var.name);
-        } else if (var.kind == "FunctionDecl") {
-            functions_.emplace(var.name);
-        }
-    }
-
-    // Adicionar funções dos printer addresses
-    for (const auto &[funcName, _] : state.varPrinterAddresses) {
-        functions_.emplace(funcName);
-    }
+    // Nada a copiar: o índice é consultado a cada completion, então o custo
+    // por eval não cresce com a sessão
+    (void)state;
 
     if (verbosityLevel >= 3) {
         std::cout << "[DEBUG] SimpleCompletion: Updated context - "
-                  << variables_.size() << " vars, " << functions_.size()
-                  << " funcs\n";
+                  << (symbols_ ? symbols_->size() : 0) << " symbols\n";
     }
 }
 
@@ -123,72 +102,62 @@ void SimpleReadlineCompletion::addReplCommands() noexcept {
 
 std::vector<std::string> SimpleReadlineCompletion::getCompletions(
     std::string_view prefix) const noexcept {
-    std::vector<std::string> matches;
-    matches.reserve(64);
+    // Prioridade: exact match > variables > functions > commands > keywords
+    enum Rank { Variable, Function, Command, Keyword };
+    std::vector<std::pair<Rank, std::string>> ranked;
+    ranked.reserve(64);
+
+    // Limitar resultados para performance
+    constexpr size_t maxResults = 50;
 
-    // Helper lambda para adicionar matches
-    auto addMatches = [&](const std::unordered_set<std::string> &container) {
+    if (symbols_ != nullptr) {
+        try {
+            for (auto &record : symbols_->withPrefix(prefix, maxResults * 2)) {
+                const auto &kind = record.decl.kind;
+                if (kind == "VarDecl") {
+                    ranked.emplace_back(Variable, std::move(record.decl.name));
+                } else if (kind == "FunctionDecl") {
+                    ranked.emplace_back(Function, std::move(record.decl.name));
+                }
+            }
+        } catch (...) {
+        }
+    }
+
+    auto addMatches = [&](const std::unordered_set<std::string> &container,
+                          Rank rank) {
         for (const auto &item : container) {
             if (item.starts_with(prefix)) {
-                matches.push_back(item);
+                ranked.emplace_back(rank, item);
             }
         }
     };
 
-    // Buscar em todas as categorias
-    addMatches(variables_);
-    addMatches(functions_);
-    addMatches(keywords_);
-    addMatches(replCommands_);
-
-    // Ordenar por relevância: variáveis primeiro, depois funções, etc.
-    std::sort(matches.begin(), matches.end(),
-              [&](const auto &a, const auto &b) {
-                  // Prioridade: exact match > variables > functions > commands
-                  // > keywords
-                  bool aIsVar = variables_.contains(a);
-                  bool bIsVar = variables_.contains(b);
-                  bool aIsFunc = functions_.contains(a);
-                  bool bIsFunc = functions_.contains(b);
-                  bool aIsCmd = replCommands_.contains(a);
-                  bool bIsCmd = replCommands_.contains(b);
-
-                  // Exact matches primeiro
-                  if (a == prefix && b != prefix)
-                      return true;
-                  if (b == prefix && a != prefix)
-                      return false;
-
-                  // Variáveis do REPL têm prioridade
-                  if (aIsVar && !bIsVar)
-                      return true;
-                  if (bIsVar && !aIsVar)
-                      return false;
-
-                  // Funções do REPL em segundo
-                  if (aIsFunc && !bIsFunc)
-                      return true;
-                  if (bIsFunc && !aIsFunc)
-                      return false;
-
-                  // Comandos REPL em terceiro
-                  if (aIsCmd && !bIsCmd)
-                      return true;
-                  if (bIsCmd && !aIsCmd)
-                      return false;
-
-                  // Mesmo tipo: ordenação alfabética
-                  return a < b;
-              });
+    addMatches(replCommands_, Command);
+    addMatches(keywords_, Keyword);
 
-    // Remover duplicatas mantendo ordem
-    auto last = std::unique(matches.begin(), matches.end());
-    matches.erase(last, matches.end());
+    std::sort(ranked.begin(), ranked.end(), [&](const auto &a, const auto &b) {
+        // Exact matches primeiro
+        const bool aExact = a.second == prefix;
+        const bool bExact = b.second == prefix;
+        if (aExact != bExact) {
+            return aExact;
+        }
+        // Mesmo tipo: ordenação alfabética
+        return a < b;
+    });
 
-    // Limitar resultados para performance
-    constexpr size_t maxResults = 50;
-    if (matches.size() > maxResults) {
-        matches.resize(maxResults);
+    // Remover duplicatas mantendo ordem
+    std::vector<std::string> matches;
+    matches.reserve(std::min(ranked.size(), maxResults));
+    std::unordered_set<std::string_view> seen;
+    for (const auto &[rank, name] : ranked) {
+        if (matches.size() >= maxResults) {
+            break;
+        }
+        if (seen.insert(name).second) {
+            matches.push_back(name);
+        }
     }
 
     return matches;
@@ -242,8 +211,10 @@ char **SimpleReadlineCompletion::completionFunction(const char *text, int start,
 
 // RAII Wrapper Implementation
 SimpleCompletionScope::SimpleCompletionScope(
-    const ReplState &replState) noexcept {
+    const ReplState &replState,
+    const execution::SymbolIndex *symbols) noexcept {
     completion_.initialize();
+    completion_.setSymbolIndex(symbols);
     completion_.updateFromReplState(replState);
 }
 
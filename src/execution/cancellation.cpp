@@ -0,0 +1,206 @@
+#include "execution/cancellation.hpp"
+
+#include <csignal>
+#include <cstdint>
+#include <thread>
+#include <unistd.h>
+
+namespace execution {
+
+namespace {
+
+// Escopo de build ativo; lido pelo handler de Ctrl-C
+std::atomic<void *> currentScopeState{nullptr};
+
+// Thread dona do escopo ativo (a que abriu o mais externo)
+std::atomic<std::thread::id> scopeOwner{};
+
+// write() num eventfd é async-signal-safe; cheio (EAGAIN) já acorda o poll()
+void signalWakeup(int fd) noexcept {
+    const uint64_t one = 1;
+    [[maybe_unused]] const auto n = ::write(fd, &one, sizeof one);
+}
+
+} // namespace
+
+CancellationToken::ProcessGroup &
+CancellationToken::ProcessGroup::operator=(ProcessGroup &&other) noexcept {
+    if (this != &other) {
+        reset();
+        slots_ = std::move(other.slots_);
+        full_ = other.full_;
+        other.slots_.clear();
+    }
+    return *this;
+}
+
+void CancellationToken::ProcessGroup::reset() noexcept {
+    for (auto &[state, slot] : slots_) {
+        state->groups[slot].store(0);
+    }
+    slots_.clear();
+}
+
+CancellationToken::Wakeup &
+CancellationToken::Wakeup::operator=(Wakeup &&other) noexcept {
+    if (this != &other) {
+        reset();
+        slots_ = std::move(other.slots_);
+        full_ = other.full_;
+        other.slots_.clear();
+    }
+    return *this;
+}
+
+void CancellationToken::Wakeup::reset() noexcept {
+    for (auto &[state, slot] : slots_) {
+        state->wakeups[slot].store(0);
+    }
+    slots_.clear();
+}
+
+CancellationToken CancellationToken::create() {
+    return CancellationToken(std::make_shared<State>());
+}
+
+CancellationToken CancellationToken::child() const {
+    auto state = std::make_shared<State>();
+    state->parent = state_;
+    return CancellationToken(std::move(state));
+}
+
+bool CancellationToken::cancelled() const noexcept {
+    for (const State *s = state_.get(); s != nullptr; s = s->parent.get()) {
+        if (s->cancelled.load()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void CancellationToken::cancelState(State &state) noexcept {
+    state.cancelled.store(true);
+    for (auto &group : state.groups) {
+        if (const pid_t pgid = group.load(); pgid > 0) {
+            ::kill(-pgid, SIGTERM);
+        }
+    }
+    for (auto &wakeup : state.wakeups) {
+        if (const int fd = wakeup.load(); fd > 0) {
+            signalWakeup(fd - 1);
+        }
+    }
+}
+
+void CancellationToken::cancel() const noexcept {
+    if (state_) {
+        cancelState(*state_);
+    }
+}
+
+CancellationToken::ProcessGroup CancellationToken::track(pid_t pgid) const {
+    ProcessGroup registration;
+    for (State *s = state_.get(); s != nullptr; s = s->parent.get()) {
+        size_t i = 0;
+        for (; i < kMaxGroups; ++i) {
+            pid_t expected = 0;
+            if (s->groups[i].compare_exchange_strong(expected, pgid)) {
+                registration.slots_.emplace_back(s->shared_from_this(), i);
+                break;
+            }
+        }
+        if (i == kMaxGroups) {
+            // Um ancestral que não conhece o grupo não o mata: desfaz tudo
+            registration.reset();
+            registration.full_ = true;
+            return registration;
+        }
+    }
+
+    // cancel() pode ter varrido a tabela antes do registro
+    if (cancelled()) {
+        ::kill(-pgid, SIGTERM);
+    }
+    return registration;
+}
+
+CancellationToken::Wakeup CancellationToken::watch(int fd) const {
+    Wakeup registration;
+    for (State *s = state_.get(); s != nullptr; s = s->parent.get()) {
+        size_t i = 0;
+        for (; i < kMaxWakeups; ++i) {
+            int expected = 0;
+            if (s->wakeups[i].compare_exchange_strong(expected, fd + 1)) {
+                registration.slots_.emplace_back(s->shared_from_this(), i);
+                break;
+            }
+        }
+        if (i == kMaxWakeups) {
+            registration.reset();
+            registration.full_ = true;
+            return registration;
+        }
+    }
+
+    if (cancelled()) {
+        signalWakeup(fd);
+    }
+    return registration;
+}
+
+EvalCancellationScope::EvalCancellationScope()
+    : previous_(static_cast<CancellationToken::State *>(
+          currentScopeState.load())) {
+    token_ = previous_ != nullptr
+                 ? CancellationToken(previous_->shared_from_this()).child()
+                 : CancellationToken::create();
+
+    // Só a dona publica: um escopo de outra thread restauraria o anterior
+    // fora de ordem
+    const auto self = std::this_thread::get_id();
+    auto owner = std::thread::id{};
+    published_ = scopeOwner.compare_exchange_strong(owner, self) ||
+                 owner == self;
+    if (published_) {
+        currentScopeState.store(token_.state_.get());
+    }
+}
+
+EvalCancellationScope::~EvalCancellationScope() {
+    if (!published_) {
+        return;
+    }
+    currentScopeState.store(previous_);
+    if (previous_ == nullptr) {
+        scopeOwner.store(std::thread::id{});
+    }
+}
+
+CancellationToken EvalCancellationScope::current() {
+    auto *state =
+        static_cast<CancellationToken::State *>(currentScopeState.load());
+    if (state == nullptr) {
+        return {};
+    }
+    return CancellationToken(state->shared_from_this());
+}
+
+bool EvalCancellationScope::cancelCurrent() noexcept {
+    auto *state =
+        static_cast<CancellationToken::State *>(currentScopeState.load());
+    if (state == nullptr) {
+        return false;
+    }
+    CancellationToken::cancelState(*state);
+    return true;
+}
+
+CancellationToken currentEvalToken() {
+    return EvalCancellationScope::current();
+}
+
+bool cancelCurrentEval() noexcept {
+    return EvalCancellationScope::cancelCurrent();
+}
+
+} // namespace execution
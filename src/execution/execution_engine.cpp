@@ -6,6 +6,17 @@
 
 namespace execution {
 
+GlobalExecutionState::GlobalExecutionState() {
+    /*
+     * A arena nunca é liberada: bibliotecas carregadas ainda podem chamar os
+     * trampolines em destrutores estáticos durante o exit.
+     */
+    static auto *arena = new TrampolineArena();
+    if (arena->available()) {
+        wrapperConfig.arena = arena;
+    }
+}
+
 // Implementação dos métodos helper da GlobalExecutionState
 void GlobalExecutionState::setLastLibrary(const std::string &library) {
     std::unique_lock lock(stateMutex);
@@ -28,22 +39,6 @@ void GlobalExecutionState::addSymbolToResolve(const std::string &symbol,
     symbolsToResolve[symbol] = address;
 }
 
-bool GlobalExecutionState::hasFnName(const std::string &mangledName) const {
-    std::shared_lock lock(stateMutex);
-    return fnNames.contains(mangledName);
-}
-
-wrapperFn &GlobalExecutionState::getFnName(const std::string &mangledName) {
-    std::unique_lock lock(stateMutex);
-    return fnNames[mangledName];
-}
-
-void GlobalExecutionState::setFnName(const std::string &mangledName,
-                                     const wrapperFn &fn) {
-    std::unique_lock lock(stateMutex);
-    fnNames[mangledName] = fn;
-}
-
 SymbolResolver::WrapperConfig &GlobalExecutionState::getWrapperConfig() {
     std::shared_lock lock(stateMutex);
     return wrapperConfig;
@@ -0,0 +1,485 @@
+#include "execution/jobserver.hpp"
+#include "execution/task_scheduler.hpp"
+#include "execution/workspace.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <charconv>
+#include <cstdint>
+#include <cstdlib>
+#include <fcntl.h>
+#include <format>
+#include <iostream>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utility>
+
+namespace execution {
+
+namespace {
+
+bool disabledByEnv() {
+    const char *env = std::getenv("CPPREPL_JOBSERVER");
+    if (env == nullptr) {
+        return false;
+    }
+    const std::string_view value(env);
+    return value == "0" || value == "off";
+}
+
+std::optional<int> parseInt(std::string_view text) {
+    int value = 0;
+    auto [ptr, ec] = std::from_chars(text.data(), text.data() + text.size(),
+                                     value);
+    if (ec != std::errc{} || ptr != text.data() + text.size()) {
+        return std::nullopt;
+    }
+    return value;
+}
+
+// Descritor herdado do make e aberto para @p access (O_RDONLY/O_WRONLY)
+bool inheritedFd(int fd, int access) {
+    const int flags = ::fcntl(fd, F_GETFL);
+    if (flags < 0) {
+        return false; // make não repassou (alvo sem '+')
+    }
+    const int mode = flags & O_ACCMODE;
+    return mode == O_RDWR || mode == access;
+}
+
+// Descrição de arquivo própria para o poll(): O_NONBLOCK nela não afeta o
+// pipe herdado do make nem os outros leitores. /proc/self/fd reabre pipes.
+int openNonBlockingReader(const std::string &path) {
+    return ::open(path.c_str(), O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+}
+
+void warnUnthrottled() {
+    static std::atomic<bool> warned{false};
+    if (!warned.exchange(true)) {
+        std::cerr << "Jobserver: token read failed, running unthrottled\n";
+    }
+}
+
+} // namespace
+
+Jobserver::Token &Jobserver::Token::operator=(Token &&other) noexcept {
+    if (this != &other) {
+        release();
+        owner_ = std::exchange(other.owner_, nullptr);
+        implicit_ = other.implicit_;
+        byte_ = other.byte_;
+    }
+    return *this;
+}
+
+void Jobserver::Token::release() {
+    if (owner_ == nullptr) {
+        return;
+    }
+    if (implicit_) {
+        owner_->implicitFree_.store(true);
+        owner_->wakeWaiters();
+    } else {
+        owner_->putBack(byte_);
+    }
+    owner_ = nullptr;
+}
+
+std::optional<Jobserver::Auth>
+Jobserver::parseMakeflags(std::string_view makeflags) {
+    std::optional<Auth> auth;
+    size_t jobs = 0;
+
+    size_t pos = 0;
+    while (pos < makeflags.size()) {
+        const size_t begin = makeflags.find_first_not_of(' ', pos);
+        if (begin == std::string_view::npos) {
+            break;
+        }
+        size_t end = makeflags.find(' ', begin);
+        if (end == std::string_view::npos) {
+            end = makeflags.size();
+        }
+        const auto word = makeflags.substr(begin, end - begin);
+        pos = end;
+
+        if (word == "--") {
+            break; // daqui em diante, atribuições de variáveis
+        }
+
+        if (word.starts_with("-j")) {
+            if (auto n = parseInt(word.substr(2)); n && *n > 0) {
+                jobs = static_cast<size_t>(*n);
+            }
+            continue;
+        }
+
+        std::string_view value;
+        if (word.starts_with("--jobserver-auth=")) {
+            value = word.substr(17);
+        } else if (word.starts_with("--jobserver-fds=")) {
+            value = word.substr(16);
+        } else {
+            continue;
+        }
+
+        // O último vale: make recursivo acrescenta o próprio
+        Auth parsed;
+        if (value.starts_with("fifo:")) {
+            parsed.fifo = std::string(value.substr(5));
+            if (parsed.fifo.empty()) {
+                continue;
+            }
+        } else {
+            const size_t comma = value.find(',');
+            if (comma == std::string_view::npos) {
+                continue; // ex.: semáforo do Windows
+            }
+            auto r = parseInt(value.substr(0, comma));
+            auto w = parseInt(value.substr(comma + 1));
+            if (!r || !w || *r < 0 || *w < 0) {
+                continue;
+            }
+            parsed.readFd = *r;
+            parsed.writeFd = *w;
+        }
+        auth = std::move(parsed);
+    }
+
+    if (auth) {
+        auth->jobs = jobs;
+    }
+    return auth;
+}
+
+Jobserver &Jobserver::instance() {
+    static Jobserver &jobserver = []() -> Jobserver & {
+        const bool disabled = disabledByEnv();
+        const char *env = disabled ? nullptr : std::getenv("MAKEFLAGS");
+        static Jobserver shared(env != nullptr ? env : "");
+        shared.autoServe_ = !disabled;
+        return shared;
+    }();
+    return jobserver;
+}
+
+Jobserver::Jobserver(std::string_view makeflags) : baseMakeflags_(makeflags) {
+    auto auth = parseMakeflags(makeflags);
+    if (!auth) {
+        return;
+    }
+
+    if (!auth->fifo.empty()) {
+        // O_RDWR: o open não espera o outro lado e o write nunca dá EPIPE
+        const int fd = ::open(auth->fifo.c_str(), O_RDWR | O_CLOEXEC);
+        if (fd < 0) {
+            return;
+        }
+        readFd_ = writeFd_ = fd;
+        ownsFds_ = true;
+        fifo_ = auth->fifo;
+        pollFd_ = openNonBlockingReader(fifo_);
+    } else if (inheritedFd(auth->readFd, O_RDONLY) &&
+               inheritedFd(auth->writeFd, O_WRONLY)) {
+        readFd_ = auth->readFd;
+        writeFd_ = auth->writeFd;
+        pollFd_ =
+            openNonBlockingReader(std::format("/proc/self/fd/{}", readFd_));
+    } else {
+        return;
+    }
+
+    mode_ = Mode::Client;
+    jobs_ = auth->jobs;
+}
+
+Jobserver::~Jobserver() {
+    if (pollFd_ >= 0) {
+        ::close(pollFd_);
+    }
+    if (ownsFds_ && readFd_ >= 0) {
+        ::close(readFd_);
+    }
+    if (mode_ == Mode::Server && !fifo_.empty()) {
+        ::unlink(fifo_.c_str());
+    }
+}
+
+Jobserver::Mode Jobserver::mode() const {
+    std::lock_guard lock(mutex_);
+    return mode_;
+}
+
+size_t Jobserver::limit() const {
+    std::lock_guard lock(mutex_);
+    return jobs_;
+}
+
+Jobserver::Token Jobserver::acquire(const CancellationToken &cancel) {
+    if (autoServe_) {
+        std::call_once(autoServeOnce_, [this] {
+            serve(TaskScheduler::instance().concurrency());
+        });
+    }
+
+    int fd = -1;
+    int pollFd = -1;
+    {
+        std::lock_guard lock(mutex_);
+        if (mode_ == Mode::Disabled) {
+            return {};
+        }
+        fd = readFd_;
+        pollFd = pollFd_;
+    }
+
+    if (implicitFree_.exchange(false)) {
+        return Token(this, true, '+');
+    }
+    if (pollFd >= 0) {
+        return waitForToken(pollFd, cancel);
+    }
+
+    // Sem leitor próprio: read() bloqueante, sem acordar por cancelamento
+    char byte = '+';
+    while (true) {
+        const ssize_t n = ::read(fd, &byte, 1);
+        if (n == 1) {
+            return Token(this, false, byte);
+        }
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+
+        // Jobserver sumiu (make encerrado): segue sem limite externo
+        warnUnthrottled();
+        return {};
+    }
+}
+
+Jobserver::Token Jobserver::waitForToken(int fd,
+                                         const CancellationToken &cancel) {
+    // eventfd desta espera: a devolução do token implícito e o cancelamento
+    // escrevem nele e o poll() acorda junto com o fd do jobserver
+    const int wake = ::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (wake < 0) {
+        warnUnthrottled();
+        return {};
+    }
+    {
+        std::lock_guard lock(mutex_);
+        waiters_.push_back(wake);
+    }
+    auto watch = cancel.watch(wake);
+    // Sem vaga no token o cancelamento não acorda o poll(): confere
+    // periodicamente
+    const int timeoutMs = watch.registered() ? -1 : 100;
+
+    Token token;
+    char byte = '+';
+    while (true) {
+        // Já registrado: uma devolução depois deste teste acorda o poll()
+        if (implicitFree_.exchange(false)) {
+            token = Token(this, true, '+');
+            break;
+        }
+        if (cancel.cancelled()) {
+            break;
+        }
+
+        std::array<pollfd, 2> fds{{{fd, POLLIN, 0}, {wake, POLLIN, 0}}};
+        if (::poll(fds.data(), fds.size(), timeoutMs) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            warnUnthrottled();
+            break;
+        }
+        if ((fds[1].revents & POLLIN) != 0) {
+            uint64_t count = 0;
+            [[maybe_unused]] const auto n = ::read(wake, &count, sizeof count);
+        }
+        if (fds[0].revents == 0) {
+            continue;
+        }
+
+        const ssize_t n = ::read(fd, &byte, 1);
+        if (n == 1) {
+            token = Token(this, false, byte);
+            break;
+        }
+        if (n < 0 && (errno == EAGAIN || errno == EINTR)) {
+            continue; // outro leitor levou o byte primeiro
+        }
+
+        // Jobserver sumiu (make encerrado): segue sem limite externo
+        warnUnthrottled();
+        break;
+    }
+
+    watch.reset();
+    {
+        std::lock_guard lock(mutex_);
+        std::erase(waiters_, wake);
+    }
+    ::close(wake);
+    return token;
+}
+
+void Jobserver::wakeWaiters() {
+    std::lock_guard lock(mutex_);
+    const uint64_t one = 1;
+    for (const int fd : waiters_) {
+        [[maybe_unused]] const auto n = ::write(fd, &one, sizeof one);
+    }
+}
+
+void Jobserver::putBack(char byte) {
+    std::lock_guard lock(mutex_);
+    if (debt_ > 0) {
+        --debt_; // limite reduzido: o token sai de circulação
+        return;
+    }
+
+    ssize_t n = 0;
+    do {
+        n = ::write(writeFd_, &byte, 1);
+    } while (n < 0 && errno == EINTR);
+}
+
+bool Jobserver::writeTokens(size_t count) {
+    const std::string tokens(count, '+');
+    size_t done = 0;
+    while (done < tokens.size()) {
+        const ssize_t n =
+            ::write(writeFd_, tokens.data() + done, tokens.size() - done);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        done += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+void Jobserver::drainFreeTokens() {
+    // Descrição de arquivo própria: O_NONBLOCK não afeta os outros leitores
+    const int fd = ::open(fifo_.c_str(), O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+    if (fd < 0) {
+        return;
+    }
+
+    char byte = 0;
+    while (debt_ > 0 && ::read(fd, &byte, 1) == 1) {
+        --debt_;
+    }
+    ::close(fd);
+}
+
+bool Jobserver::serve(size_t slots, const std::filesystem::path &dir) {
+    if (disabledByEnv()) {
+        return false;
+    }
+    slots = std::max<size_t>(slots, 1);
+
+    std::lock_guard lock(mutex_);
+    if (mode_ == Mode::Client) {
+        return false;
+    }
+
+    if (mode_ == Mode::Server) {
+        // Só ajusta: tokens extras entram agora; na redução, os livres saem
+        // do fifo já e os em uso quando voltarem
+        if (slots > jobs_) {
+            size_t grow = slots - jobs_;
+            const size_t paid = std::min(grow, debt_);
+            debt_ -= paid;
+            grow -= paid;
+            if (!writeTokens(grow)) {
+                return false;
+            }
+        } else {
+            debt_ += jobs_ - slots;
+            drainFreeTokens();
+        }
+        jobs_ = slots;
+        ::setenv("MAKEFLAGS", makeflagsLocked().c_str(), 1);
+        return true;
+    }
+
+    std::filesystem::path base = dir;
+    if (base.empty()) {
+        auto &workspace = Workspace::instance();
+        std::error_code ec;
+        base = workspace.enabled() ? workspace.root()
+                                   : std::filesystem::temp_directory_path(ec);
+    }
+
+    static std::atomic<unsigned> instances{0};
+    const auto path =
+        (base / std::format("jobserver-{}-{}", ::getpid(), instances++))
+            .string();
+    ::unlink(path.c_str());
+    if (::mkfifo(path.c_str(), 0600) != 0) {
+        return false;
+    }
+
+    const int fd = ::open(path.c_str(), O_RDWR | O_CLOEXEC);
+    if (fd < 0) {
+        ::unlink(path.c_str());
+        return false;
+    }
+
+    readFd_ = writeFd_ = fd;
+    ownsFds_ = true;
+    fifo_ = path;
+    pollFd_ = openNonBlockingReader(path);
+    jobs_ = slots;
+    // O token implícito é o do próprio REPL
+    if (!writeTokens(slots - 1)) {
+        ::close(fd);
+        ::unlink(path.c_str());
+        if (pollFd_ >= 0) {
+            ::close(pollFd_);
+        }
+        readFd_ = writeFd_ = pollFd_ = -1;
+        ownsFds_ = false;
+        fifo_.clear();
+        return false;
+    }
+
+    mode_ = Mode::Server;
+    ::setenv("MAKEFLAGS", makeflagsLocked().c_str(), 1);
+    return true;
+}
+
+std::string Jobserver::makeflags() const {
+    std::lock_guard lock(mutex_);
+    return makeflagsLocked();
+}
+
+std::string Jobserver::makeflagsLocked() const {
+    switch (mode_) {
+    case Mode::Client:
+        return baseMakeflags_;
+    case Mode::Server: {
+        auto flags = std::format("-j{} --jobserver-auth=fifo:{}", jobs_,
+                                 fifo_);
+        if (!baseMakeflags_.empty()) {
+            flags = std::format("{} {}", baseMakeflags_, flags);
+        }
+        return flags;
+    }
+    case Mode::Disabled:
+        break;
+    }
+    return {};
+}
+
+} // namespace execution
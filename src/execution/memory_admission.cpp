@@ -0,0 +1,306 @@
+#include "execution/memory_admission.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstdlib>
+#include <format>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <unistd.h>
+#include <utility>
+
+namespace execution {
+
+namespace {
+
+// Antes da primeira amostra: um clang com PCH grande fica nessa faixa
+constexpr std::array<uint64_t, kJobKindCount> kInitialEstimate{
+    512ull << 20, // AstDump
+    768ull << 20, // Compile
+    384ull << 20, // Link
+};
+
+// Sem folga, reavalia de tempos em tempos: a memória pode ser liberada por
+// processos de fora
+constexpr auto kRecheckInterval = std::chrono::milliseconds(100);
+
+// Limites do cgroup v1 sem restrição ficam perto de 2^63
+constexpr uint64_t kUnlimited = 1ull << 60;
+
+size_t index(JobKind kind) { return static_cast<size_t>(kind); }
+
+std::string readFile(const std::string &path) {
+    std::ifstream in(path);
+    return {std::istreambuf_iterator<char>(in),
+            std::istreambuf_iterator<char>()};
+}
+
+std::optional<uint64_t> parseNumber(std::string_view text) {
+    while (!text.empty() && (text.back() == '\n' || text.back() == ' ')) {
+        text.remove_suffix(1);
+    }
+    uint64_t value = 0;
+    auto [ptr, ec] =
+        std::from_chars(text.data(), text.data() + text.size(), value);
+    if (ec != std::errc{} || ptr != text.data() + text.size()) {
+        return std::nullopt; // inclui "max" do cgroup v2
+    }
+    return value;
+}
+
+// Folga do cgroup de memória do processo (limite - uso), se houver limite
+std::optional<uint64_t> cgroupAvailable() {
+    std::ifstream in("/proc/self/cgroup");
+    std::string line;
+    while (std::getline(in, line)) {
+        // v2: "0::/caminho"; v1: "N:memory:/caminho"
+        std::string base;
+        std::string limitFile;
+        std::string usageFile;
+        if (line.starts_with("0::")) {
+            base = "/sys/fs/cgroup" + line.substr(3);
+            limitFile = "/memory.max";
+            usageFile = "/memory.current";
+        } else if (auto pos = line.find(":memory:");
+                   pos != std::string::npos) {
+            base = "/sys/fs/cgroup/memory" + line.substr(pos + 8);
+            limitFile = "/memory.limit_in_bytes";
+            usageFile = "/memory.usage_in_bytes";
+        } else {
+            continue;
+        }
+
+        auto limit = parseNumber(readFile(base + limitFile));
+        auto usage = parseNumber(readFile(base + usageFile));
+        if (limit && usage && *limit < kUnlimited) {
+            return *limit > *usage ? *limit - *usage : 0;
+        }
+    }
+    return std::nullopt;
+}
+
+bool disabledByEnv() {
+    const char *env = std::getenv("CPPREPL_ADMISSION");
+    if (env == nullptr) {
+        return false;
+    }
+    const std::string_view value(env);
+    return value == "0" || value == "off";
+}
+
+} // namespace
+
+std::string_view jobKindName(JobKind kind) {
+    switch (kind) {
+    case JobKind::AstDump:
+        return "ast-dump";
+    case JobKind::Compile:
+        return "compile";
+    case JobKind::Link:
+        return "link";
+    }
+    return "unknown";
+}
+
+MemoryAdmission::Ticket &
+MemoryAdmission::Ticket::operator=(Ticket &&other) noexcept {
+    if (this != &other) {
+        release();
+        owner_ = std::exchange(other.owner_, nullptr);
+        job_ = other.job_;
+    }
+    return *this;
+}
+
+void MemoryAdmission::Ticket::attach(pid_t pid) {
+    if (owner_ != nullptr) {
+        std::lock_guard lock(owner_->mutex_);
+        job_->pid = pid;
+    }
+}
+
+void MemoryAdmission::Ticket::finish(long peakRssKb) {
+    if (owner_ != nullptr) {
+        owner_->finishJob(job_, peakRssKb);
+        owner_ = nullptr;
+    }
+}
+
+void MemoryAdmission::Ticket::release() { finish(0); }
+
+MemoryAdmission &MemoryAdmission::instance() {
+    static MemoryAdmission admission;
+    return admission;
+}
+
+MemoryAdmission::MemoryAdmission(Probe probe)
+    : probe_(std::move(probe)), enabled_(!disabledByEnv()),
+      estimate_(kInitialEstimate) {}
+
+bool MemoryAdmission::enabled() const {
+    std::lock_guard lock(mutex_);
+    return enabled_;
+}
+
+void MemoryAdmission::setEnabled(bool enabled) {
+    {
+        std::lock_guard lock(mutex_);
+        enabled_ = enabled;
+    }
+    cv_.notify_all();
+}
+
+std::optional<uint64_t> MemoryAdmission::parseMeminfo(std::string_view meminfo,
+                                                      std::string_view key) {
+    size_t pos = 0;
+    while (pos < meminfo.size()) {
+        size_t end = meminfo.find('\n', pos);
+        if (end == std::string_view::npos) {
+            end = meminfo.size();
+        }
+        auto line = meminfo.substr(pos, end - pos);
+        pos = end + 1;
+
+        // "MemAvailable:   12345678 kB"
+        if (!line.starts_with(key) || line.size() <= key.size() ||
+            line[key.size()] != ':') {
+            continue;
+        }
+        line.remove_prefix(key.size() + 1);
+        const size_t begin = line.find_first_not_of(' ');
+        if (begin == std::string_view::npos) {
+            return std::nullopt;
+        }
+        line.remove_prefix(begin);
+
+        uint64_t value = 0;
+        auto [ptr, ec] =
+            std::from_chars(line.data(), line.data() + line.size(), value);
+        if (ec != std::errc{}) {
+            return std::nullopt;
+        }
+        const bool kb = std::string_view(ptr, line.data() + line.size())
+                            .find("kB") != std::string_view::npos;
+        return kb ? value * 1024 : value;
+    }
+    return std::nullopt;
+}
+
+std::optional<uint64_t> MemoryAdmission::availableMemory() {
+    auto available = parseMeminfo(readFile("/proc/meminfo"), "MemAvailable");
+    if (auto cgroup = cgroupAvailable()) {
+        available = available ? std::min(*available, *cgroup) : *cgroup;
+    }
+    return available;
+}
+
+uint64_t MemoryAdmission::residentBytes(pid_t pid) {
+    // statm: tamanho total e residente, em páginas
+    std::ifstream in(std::format("/proc/{}/statm", pid));
+    uint64_t size = 0;
+    uint64_t resident = 0;
+    if (!(in >> size >> resident)) {
+        return 0;
+    }
+    return resident * static_cast<uint64_t>(::sysconf(_SC_PAGESIZE));
+}
+
+int64_t MemoryAdmission::headroomLocked(uint64_t available,
+                                        uint64_t *reserved) const {
+    // MemAvailable já desconta o que os jobs usam agora; falta reservar o
+    // quanto cada um ainda deve crescer até o pico
+    uint64_t pending = 0;
+    for (const auto &job : running_) {
+        const uint64_t expected = estimate_[index(job.kind)];
+        const uint64_t resident = job.pid > 0 ? residentBytes(job.pid) : 0;
+        pending += expected > resident ? expected - resident : 0;
+    }
+    if (reserved != nullptr) {
+        *reserved = pending;
+    }
+    return static_cast<int64_t>(available) -
+           static_cast<int64_t>(kSafetyMargin) - static_cast<int64_t>(pending);
+}
+
+MemoryAdmission::Ticket MemoryAdmission::admit(JobKind kind) {
+    std::unique_lock lock(mutex_);
+    ++queued_;
+    bool waited = false;
+
+    while (enabled_ && !running_.empty()) {
+        const auto available = probe_ ? probe_() : std::nullopt;
+        if (!available) {
+            break; // sem medida (ex.: sem /proc): não limita
+        }
+        const auto need = static_cast<int64_t>(estimate_[index(kind)]);
+        if (need <= headroomLocked(*available, nullptr)) {
+            break;
+        }
+        waited = true;
+        cv_.wait_for(lock, kRecheckInterval);
+    }
+
+    --queued_;
+    ++admitted_;
+    delayed_ += waited ? 1 : 0;
+    running_.push_back(Job{.kind = kind});
+    return Ticket(this, std::prev(running_.end()));
+}
+
+void MemoryAdmission::finishJob(std::list<Job>::iterator job, long peakRssKb) {
+    {
+        std::lock_guard lock(mutex_);
+        const auto kind = job->kind;
+        running_.erase(job);
+        if (peakRssKb > 0) {
+            recordLocked(kind, static_cast<uint64_t>(peakRssKb) * 1024);
+        }
+    }
+    cv_.notify_all();
+}
+
+uint64_t MemoryAdmission::estimate(JobKind kind) const {
+    std::lock_guard lock(mutex_);
+    return estimate_[index(kind)];
+}
+
+void MemoryAdmission::record(JobKind kind, uint64_t peakBytes) {
+    {
+        std::lock_guard lock(mutex_);
+        recordLocked(kind, peakBytes);
+    }
+    cv_.notify_all();
+}
+
+void MemoryAdmission::recordLocked(JobKind kind, uint64_t peakBytes) {
+    auto &estimate = estimate_[index(kind)];
+    // Sobe de imediato, desce devagar: um pico isolado pesa mais que vários
+    // jobs pequenos
+    estimate = samples_[index(kind)] == 0 || peakBytes > estimate
+                   ? peakBytes
+                   : (estimate * 3 + peakBytes) / 4;
+    peak_[index(kind)] = std::max(peak_[index(kind)], peakBytes);
+    ++samples_[index(kind)];
+}
+
+MemoryAdmission::Stats MemoryAdmission::stats() const {
+    const auto available = probe_ ? probe_() : std::nullopt;
+
+    std::lock_guard lock(mutex_);
+    Stats stats;
+    stats.enabled = enabled_;
+    stats.available = available.value_or(0);
+    stats.headroom = headroomLocked(stats.available, &stats.reserved);
+    stats.running = running_.size();
+    stats.queued = queued_;
+    stats.admitted = admitted_;
+    stats.delayed = delayed_;
+    stats.estimate = estimate_;
+    stats.peak = peak_;
+    stats.samples = samples_;
+    return stats;
+}
+
+} // namespace execution
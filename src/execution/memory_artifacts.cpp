@@ -0,0 +1,201 @@
+#include "execution/memory_artifacts.hpp"
+#include "execution/process_launcher.hpp"
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <format>
+#include <iostream>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifndef MFD_CLOEXEC
+#define MFD_CLOEXEC 0x0001U
+#endif
+
+namespace execution {
+
+namespace {
+
+bool writeAll(int fd, std::string_view content) {
+    while (!content.empty()) {
+        ssize_t n = ::write(fd, content.data(), content.size());
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        content.remove_prefix(static_cast<size_t>(n));
+    }
+    return true;
+}
+
+// Uma biblioteca mantida aberta por eval: o limite padrão (1024) acaba em
+// sessões longas
+void raiseDescriptorLimit() {
+    struct rlimit lim {};
+    if (::getrlimit(RLIMIT_NOFILE, &lim) == 0 && lim.rlim_cur < lim.rlim_max) {
+        lim.rlim_cur = lim.rlim_max;
+        ::setrlimit(RLIMIT_NOFILE, &lim);
+    }
+}
+
+} // namespace
+
+MemoryArtifacts::MemoryArtifacts() {
+    const char *env = std::getenv("CPPREPL_DISKLESS");
+    if (env != nullptr && *env != '\0' && std::string_view(env) != "0") {
+        setEnabled(true);
+    }
+}
+
+MemoryArtifacts &MemoryArtifacts::instance() {
+    static MemoryArtifacts artifacts;
+    return artifacts;
+}
+
+bool MemoryArtifacts::enabled() const {
+    std::lock_guard lock(mutex_);
+    return enabled_;
+}
+
+bool MemoryArtifacts::setEnabled(bool enable) {
+    if (enable) {
+        int probe = memfd_create_compat("cpprepl-probe", MFD_CLOEXEC);
+        if (probe < 0) {
+            std::cerr << std::format("memfd_create: {}\n",
+                                     std::strerror(errno));
+            return false;
+        }
+        ::close(probe);
+        raiseDescriptorLimit();
+    }
+
+    std::lock_guard lock(mutex_);
+    enabled_ = enable;
+    if (!enable) {
+        // Sem isso resolve() continuaria devolvendo os memfds antigos para
+        // nomes reescritos em disco (ex.: printerOutput.cpp)
+        for (auto &[name, artifact] : artifacts_) {
+            retireLocked(artifact);
+        }
+        artifacts_.clear();
+    }
+    return true;
+}
+
+std::string MemoryArtifacts::normalize(std::string_view name) {
+    while (name.starts_with("./")) {
+        name.remove_prefix(2);
+    }
+    return std::string(name);
+}
+
+void MemoryArtifacts::retireLocked(Artifact &artifact) {
+    if (artifact.fd < 0) {
+        return;
+    }
+    if (artifact.kind == Kind::Library) {
+        retiredLibraries_.push_back(artifact.fd);
+    } else {
+        ::close(artifact.fd);
+    }
+    artifact.fd = -1;
+}
+
+std::optional<std::string>
+MemoryArtifacts::create(const std::string &name, std::string_view content,
+                        Kind kind) {
+    // Os filhos abrem pelo caminho em /proc/<pid>/fd, não pelo descritor
+    // herdado
+    const auto key = normalize(name);
+    int fd = memfd_create_compat(key.c_str(), MFD_CLOEXEC);
+    if (fd < 0) {
+        return std::nullopt;
+    }
+
+    if (!writeAll(fd, content)) {
+        ::close(fd);
+        return std::nullopt;
+    }
+
+    auto path = std::format("/proc/{}/fd/{}", ::getpid(), fd);
+
+    std::lock_guard lock(mutex_);
+    auto &artifact = artifacts_[key];
+    retireLocked(artifact);
+    artifact = Artifact{.fd = fd, .path = path, .kind = kind};
+    return path;
+}
+
+std::string MemoryArtifacts::resolve(const std::string &name) const {
+    std::lock_guard lock(mutex_);
+    auto it = artifacts_.find(normalize(name));
+    if (it == artifacts_.end() || it->second.fd < 0) {
+        return name;
+    }
+    return it->second.path;
+}
+
+bool MemoryArtifacts::contains(const std::string &name) const {
+    std::lock_guard lock(mutex_);
+    auto it = artifacts_.find(normalize(name));
+    return it != artifacts_.end() && it->second.fd >= 0;
+}
+
+void MemoryArtifacts::release(const std::string &name) {
+    std::lock_guard lock(mutex_);
+    auto it = artifacts_.find(normalize(name));
+    if (it == artifacts_.end() || it->second.kind == Kind::Library) {
+        return;
+    }
+    retireLocked(it->second);
+    artifacts_.erase(it);
+}
+
+void MemoryArtifacts::releaseStem(std::string_view stem) {
+    std::lock_guard lock(mutex_);
+    for (auto it = artifacts_.begin(); it != artifacts_.end();) {
+        const std::string_view name = it->first;
+        if (it->second.kind == Kind::Library ||
+            name.substr(0, name.find_last_of('.')) != stem) {
+            ++it;
+            continue;
+        }
+        retireLocked(it->second);
+        it = artifacts_.erase(it);
+    }
+}
+
+bool MemoryArtifacts::isMemoryPath(std::string_view path) {
+    return path.starts_with("/proc/") && path.find("/fd/") != path.npos;
+}
+
+size_t MemoryArtifacts::count() const {
+    std::lock_guard lock(mutex_);
+    return artifacts_.size() + retiredLibraries_.size();
+}
+
+size_t MemoryArtifacts::bytes() const {
+    std::lock_guard lock(mutex_);
+    size_t total = 0;
+    auto add = [&](int fd) {
+        struct stat st {};
+        if (::fstat(fd, &st) == 0) {
+            total += static_cast<size_t>(st.st_size);
+        }
+    };
+    for (const auto &[name, artifact] : artifacts_) {
+        if (artifact.fd >= 0) {
+            add(artifact.fd);
+        }
+    }
+    for (int fd : retiredLibraries_) {
+        add(fd);
+    }
+    return total;
+}
+
+} // namespace execution
@@ -0,0 +1,412 @@
+#include "execution/process_launcher.hpp"
+
+#include "utility/eval_scope_exit.hpp"
+#include <cerrno>
+#include <csignal>
+#include <fcntl.h>
+#include <spawn.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <utility>
+
+#ifndef MFD_CLOEXEC
+#define MFD_CLOEXEC 0x0001U
+#endif
+
+extern char **environ;
+
+namespace execution {
+
+int memfd_create_compat(const char *name, unsigned flags) {
+#ifdef SYS_memfd_create
+    return static_cast<int>(::syscall(SYS_memfd_create, name, flags));
+#else
+    errno = ENOSYS;
+    return -1;
+#endif
+}
+
+MemfdCapture::~MemfdCapture() { reset(); }
+
+MemfdCapture::MemfdCapture(MemfdCapture &&other) noexcept
+    : fd_(std::exchange(other.fd_, -1)),
+      addr_(std::exchange(other.addr_, nullptr)),
+      len_(std::exchange(other.len_, 0)) {}
+
+MemfdCapture &MemfdCapture::operator=(MemfdCapture &&other) noexcept {
+    if (this != &other) {
+        reset();
+        fd_ = std::exchange(other.fd_, -1);
+        addr_ = std::exchange(other.addr_, nullptr);
+        len_ = std::exchange(other.len_, 0);
+    }
+    return *this;
+}
+
+void MemfdCapture::reset() noexcept {
+    if (addr_ != nullptr) {
+        ::munmap(addr_, len_);
+        addr_ = nullptr;
+    }
+    if (fd_ >= 0) {
+        ::close(fd_);
+        fd_ = -1;
+    }
+    len_ = 0;
+}
+
+int MemfdCapture::open(const char *name) {
+    reset();
+    fd_ = memfd_create_compat(name, MFD_CLOEXEC);
+    return fd_ < 0 ? errno : 0;
+}
+
+int MemfdCapture::map() {
+    if (fd_ < 0) {
+        return EBADF;
+    }
+
+    struct stat st {};
+    if (::fstat(fd_, &st) != 0) {
+        return errno;
+    }
+    if (st.st_size == 0) {
+        return 0;
+    }
+
+    auto len = static_cast<size_t>(st.st_size);
+    void *addr = ::mmap(nullptr, len, PROT_READ, MAP_PRIVATE, fd_, 0);
+    if (addr == MAP_FAILED) {
+        return errno;
+    }
+    addr_ = addr;
+    len_ = len;
+    return 0;
+}
+
+std::string_view MemfdCapture::view() const {
+    return addr_ == nullptr
+               ? std::string_view{}
+               : std::string_view(static_cast<const char *>(addr_), len_);
+}
+
+bool ProcessResult::exited() const {
+    return spawnError == 0 && WIFEXITED(status);
+}
+
+int ProcessResult::exitCode() const {
+    return exited() ? WEXITSTATUS(status) : -1;
+}
+
+namespace {
+
+constexpr int kSpawnFailedStatus = 127 << 8;
+
+int addStream(posix_spawn_file_actions_t &acts, int target, Stream stream,
+              const std::string &path, bool append, MemfdCapture &capture,
+              const char *captureName) {
+    switch (stream) {
+    case Stream::Inherit:
+        return 0;
+    case Stream::Capture:
+        if (int rc = capture.open(captureName)) {
+            return rc;
+        }
+        return ::posix_spawn_file_actions_adddup2(&acts, capture.fd(), target);
+    case Stream::File:
+        return ::posix_spawn_file_actions_addopen(
+            &acts, target, path.empty() ? "/dev/null" : path.c_str(),
+            O_WRONLY | O_CREAT | (append ? O_APPEND : O_TRUNC), 0644);
+    case Stream::ToStdout:
+        return ::posix_spawn_file_actions_adddup2(&acts, STDOUT_FILENO,
+                                                  target);
+    }
+    return EINVAL;
+}
+
+} // namespace
+
+ProcessResult runProcess(const std::vector<std::string> &argv,
+                         const ProcessOptions &opts) {
+    ProcessResult result;
+    auto fail = [&](int error) -> ProcessResult {
+        result.spawnError = error;
+        result.status = kSpawnFailedStatus;
+        return std::move(result);
+    };
+
+    if (argv.empty() || opts.out == Stream::ToStdout) {
+        return fail(EINVAL);
+    }
+    if (opts.cancel.cancelled()) {
+        result.cancelled = true;
+        return fail(ECANCELED);
+    }
+
+    posix_spawn_file_actions_t acts;
+    if (int rc = ::posix_spawn_file_actions_init(&acts)) {
+        return fail(rc);
+    }
+    auto actsGuard =
+        EvalOnScopeExit([&] { ::posix_spawn_file_actions_destroy(&acts); });
+
+    if (!opts.inPath.empty()) {
+        if (int rc = ::posix_spawn_file_actions_addopen(
+                &acts, STDIN_FILENO, opts.inPath.c_str(), O_RDONLY, 0)) {
+            return fail(rc);
+        }
+    }
+
+    // stdout antes do stderr: 2>&1 copia o stdout já redirecionado
+    if (int rc = addStream(acts, STDOUT_FILENO, opts.out, opts.outPath,
+                           opts.appendOut, result.outCapture, "cpprepl-out")) {
+        return fail(rc);
+    }
+    if (int rc = addStream(acts, STDERR_FILENO, opts.err, opts.errPath,
+                           opts.appendErr, result.errCapture, "cpprepl-err")) {
+        return fail(rc);
+    }
+
+    posix_spawnattr_t attr;
+    if (int rc = ::posix_spawnattr_init(&attr)) {
+        return fail(rc);
+    }
+    auto attrGuard = EvalOnScopeExit([&] { ::posix_spawnattr_destroy(&attr); });
+
+    sigset_t emptyMask;
+    sigset_t defaults;
+    sigemptyset(&emptyMask);
+    sigemptyset(&defaults);
+    sigaddset(&defaults, SIGPIPE);
+    sigaddset(&defaults, SIGINT);
+    posix_spawnattr_setsigmask(&attr, &emptyMask);
+    posix_spawnattr_setsigdefault(&attr, &defaults);
+    short spawnFlags = POSIX_SPAWN_SETSIGMASK | POSIX_SPAWN_SETSIGDEF;
+    if (opts.cancel.cancellable()) {
+        // Grupo próprio: o cancelamento mata o compilador e os filhos dele
+        // (cc1, ld) de uma vez
+        posix_spawnattr_setpgroup(&attr, 0);
+        spawnFlags |= POSIX_SPAWN_SETPGROUP;
+    }
+    posix_spawnattr_setflags(&attr, spawnFlags);
+
+    std::vector<char *> cargv;
+    cargv.reserve(argv.size() + 1);
+    for (const auto &arg : argv) {
+        cargv.push_back(const_cast<char *>(arg.c_str()));
+    }
+    cargv.push_back(nullptr);
+
+    pid_t pid = -1;
+    if (int rc = ::posix_spawnp(&pid, cargv[0], &acts, &attr, cargv.data(),
+                                environ)) {
+        return fail(rc);
+    }
+
+    if (opts.onSpawn) {
+        opts.onSpawn(pid);
+    }
+
+    if (opts.cancel.cancellable()) {
+        auto group = opts.cancel.track(pid);
+        if (!group.registered()) {
+            // Sem vaga no token: nem Ctrl-C nem a falha de outro job
+            // alcançariam o grupo, então ele não roda
+            ::kill(-pid, SIGKILL);
+            while (::waitpid(pid, nullptr, 0) < 0 && errno == EINTR) {
+            }
+            return fail(EAGAIN);
+        }
+        // Espera sem colher: enquanto o zumbi existe o pgid não é reusado,
+        // então o registro só sai depois
+        siginfo_t info{};
+        while (::waitid(P_PID, static_cast<id_t>(pid), &info,
+                        WEXITED | WNOWAIT) < 0 &&
+               errno == EINTR) {
+        }
+        group.reset();
+        result.cancelled = opts.cancel.cancelled();
+    }
+
+    int status = 0;
+    struct rusage usage {};
+    while (::wait4(pid, &status, 0, &usage) < 0) {
+        if (errno != EINTR) {
+            return fail(errno);
+        }
+    }
+    result.status = status;
+    result.peakRssKb = usage.ru_maxrss;
+
+    if (result.outCapture.valid()) {
+        result.outCapture.map();
+    }
+    if (result.errCapture.valid()) {
+        result.errCapture.map();
+    }
+    return result;
+}
+
+bool parseCommandLine(std::string_view command, std::vector<std::string> &argv,
+                      ProcessOptions &opts) {
+    enum class Target { None, In, Out, OutAppend, Err, ErrAppend, Both };
+
+    size_t i = 0;
+    const size_t n = command.size();
+    Target pending = Target::None;
+
+    auto isSpace = [](char c) {
+        return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+    };
+    auto startsWith = [&](std::string_view prefix) {
+        return command.substr(i).starts_with(prefix);
+    };
+
+    while (true) {
+        while (i < n && isSpace(command[i])) {
+            ++i;
+        }
+        if (i >= n) {
+            break;
+        }
+
+        // Redirecionamentos no começo de uma palavra
+        if (pending == Target::None) {
+            struct Redirect {
+                std::string_view token;
+                Target target;
+            };
+            static constexpr Redirect redirects[] = {
+                {"2>&1", Target::None},     {"&>>", Target::None},
+                {"&>", Target::Both},       {"2>>", Target::ErrAppend},
+                {"2>", Target::Err},        {"1>>", Target::OutAppend},
+                {">>", Target::OutAppend},  {"1>", Target::Out},
+                {">", Target::Out},         {"<", Target::In},
+            };
+
+            bool matched = false;
+            for (const auto &redirect : redirects) {
+                if (!startsWith(redirect.token)) {
+                    continue;
+                }
+                if (redirect.token == "&>>") {
+                    return false;
+                }
+                i += redirect.token.size();
+                if (redirect.token == "2>&1") {
+                    if (i < n && !isSpace(command[i])) {
+                        return false;
+                    }
+                    opts.err = Stream::ToStdout;
+                } else {
+                    pending = redirect.target;
+                }
+                matched = true;
+                break;
+            }
+            if (matched) {
+                continue;
+            }
+        }
+
+        std::string word;
+        bool quoted = false;
+        while (i < n && !isSpace(command[i])) {
+            const char c = command[i];
+            if (c == '\'') {
+                auto end = command.find('\'', i + 1);
+                if (end == std::string_view::npos) {
+                    return false;
+                }
+                word.append(command.substr(i + 1, end - i - 1));
+                quoted = true;
+                i = end + 1;
+            } else if (c == '"') {
+                ++i;
+                while (i < n && command[i] != '"') {
+                    if (command[i] == '$' || command[i] == '`') {
+                        return false;
+                    }
+                    if (command[i] == '\\' && i + 1 < n &&
+                        std::string_view("$`\"\\").find(command[i + 1]) !=
+                            std::string_view::npos) {
+                        ++i;
+                    }
+                    word += command[i++];
+                }
+                if (i >= n) {
+                    return false;
+                }
+                quoted = true;
+                ++i;
+            } else if (c == '\\') {
+                if (i + 1 >= n) {
+                    return false;
+                }
+                word += command[i + 1];
+                i += 2;
+            } else if (std::string_view("|&;<>()$`*?[]").find(c) !=
+                           std::string_view::npos ||
+                       (word.empty() && !quoted && (c == '~' || c == '#'))) {
+                return false;
+            } else {
+                word += c;
+                ++i;
+            }
+        }
+
+        switch (pending) {
+        case Target::None:
+            // FOO=bar cmd: atribuição de ambiente, só o shell entende
+            if (argv.empty() && !quoted && word.find('=') != std::string::npos) {
+                return false;
+            }
+            argv.push_back(std::move(word));
+            break;
+        case Target::In:
+            opts.inPath = std::move(word);
+            break;
+        case Target::Out:
+        case Target::OutAppend:
+            // "2>&1 >arquivo" manda o stderr para o stdout antigo
+            if (opts.err == Stream::ToStdout) {
+                return false;
+            }
+            opts.out = Stream::File;
+            opts.outPath = std::move(word);
+            opts.appendOut = pending == Target::OutAppend;
+            break;
+        case Target::Err:
+        case Target::ErrAppend:
+            opts.err = Stream::File;
+            opts.errPath = std::move(word);
+            opts.appendErr = pending == Target::ErrAppend;
+            break;
+        case Target::Both:
+            opts.out = Stream::File;
+            opts.outPath = std::move(word);
+            opts.appendOut = false;
+            opts.err = Stream::ToStdout;
+            break;
+        }
+        pending = Target::None;
+    }
+
+    return pending == Target::None && !argv.empty();
+}
+
+ProcessResult runCommandLine(std::string_view command, ProcessOptions opts) {
+    std::vector<std::string> argv;
+    ProcessOptions parsed = opts;
+    if (parseCommandLine(command, argv, parsed)) {
+        return runProcess(argv, parsed);
+    }
+
+    return runProcess({"/bin/sh", "-c", std::string(command)}, opts);
+}
+
+} // namespace execution
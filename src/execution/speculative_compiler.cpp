@@ -0,0 +1,166 @@
+#include "execution/speculative_compiler.hpp"
+
+#include "execution/memory_artifacts.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <format>
+#include <string_view>
+#include <utility>
+
+namespace execution {
+
+namespace {
+
+bool enabledByEnv() {
+    const char *env = std::getenv("CPPREPL_SPECULATE");
+    if (env == nullptr) {
+        return false;
+    }
+    const std::string_view value(env);
+    return value == "1" || value == "on";
+}
+
+} // namespace
+
+SpeculativeCompiler &SpeculativeCompiler::instance() {
+    static SpeculativeCompiler speculative;
+    return speculative;
+}
+
+SpeculativeCompiler::SpeculativeCompiler() : enabled_(enabledByEnv()) {}
+
+SpeculativeCompiler::~SpeculativeCompiler() { cancel(); }
+
+void SpeculativeCompiler::setBuild(Build build) {
+    std::lock_guard lock(mutex_);
+    build_ = std::move(build);
+}
+
+void SpeculativeCompiler::setEnabled(bool enabled) {
+    {
+        std::lock_guard lock(mutex_);
+        enabled_ = enabled;
+    }
+    if (!enabled) {
+        cancel();
+    }
+}
+
+bool SpeculativeCompiler::enabled() const {
+    std::lock_guard lock(mutex_);
+    return enabled_;
+}
+
+void SpeculativeCompiler::retire(Job &job) {
+    job.cancel.cancel();
+    job.done.wait();
+    // Fonte e .log do job; a biblioteca não chegou a ser carregada
+    MemoryArtifacts::instance().releaseStem(job.name);
+}
+
+void SpeculativeCompiler::speculate(const std::string &key,
+                                    std::string source) {
+    std::optional<Job> previous;
+    {
+        std::lock_guard lock(mutex_);
+        if (!enabled_ || !build_ || (job_ && job_->key == key)) {
+            return;
+        }
+        previous = std::exchange(job_, std::nullopt);
+        if (previous) {
+            ++stats_.cancelled;
+        }
+    }
+
+    // Fora do lock: o job anterior pode levar alguns ms para morrer
+    if (previous) {
+        retire(*previous);
+    }
+
+    std::lock_guard lock(mutex_);
+    if (!enabled_ || job_) {
+        return; // desligado ou outro speculate() chegou antes
+    }
+
+    Job job;
+    job.key = key;
+    job.name = std::format("spec_{}", ++sequence_);
+    job.cancel = CancellationToken::create();
+    job.done = std::async(std::launch::async,
+                          [build = build_, name = job.name,
+                           source = std::move(source), cancel = job.cancel] {
+                              return build(name, source, cancel) &&
+                                     !cancel.cancelled();
+                          });
+    job_ = std::move(job);
+    ++stats_.started;
+}
+
+std::optional<std::string> SpeculativeCompiler::claim(const std::string &key) {
+    std::optional<Job> job;
+    {
+        std::lock_guard lock(mutex_);
+        job = std::exchange(job_, std::nullopt);
+    }
+    if (!job) {
+        return std::nullopt;
+    }
+
+    if (job->key != key) {
+        retire(*job);
+        std::lock_guard lock(mutex_);
+        ++stats_.misses;
+        return std::nullopt;
+    }
+
+    // Ainda compilando: o Enter só chegou antes do fim
+    {
+        EvalCancellationScope scope;
+        while (job->done.wait_for(std::chrono::milliseconds(20)) !=
+               std::future_status::ready) {
+            if (scope.cancelled()) {
+                job->cancel.cancel();
+            }
+        }
+    }
+
+    const bool built = job->done.get();
+    std::lock_guard lock(mutex_);
+    if (!built) {
+        ++stats_.misses;
+        if (!job->cancel.cancelled()) {
+            ++stats_.failed;
+        }
+        MemoryArtifacts::instance().releaseStem(job->name);
+        return std::nullopt;
+    }
+    ++stats_.hits;
+    return job->name;
+}
+
+void SpeculativeCompiler::cancel() {
+    std::optional<Job> job;
+    {
+        std::lock_guard lock(mutex_);
+        job = std::exchange(job_, std::nullopt);
+        if (job) {
+            ++stats_.cancelled;
+        }
+    }
+    if (job) {
+        retire(*job);
+    }
+}
+
+SpeculativeCompiler::Stats SpeculativeCompiler::stats() const {
+    std::lock_guard lock(mutex_);
+    Stats stats = stats_;
+    stats.enabled = enabled_;
+    stats.running =
+        job_ && job_->done.wait_for(std::chrono::seconds(0)) !=
+                    std::future_status::ready;
+    return stats;
+}
+
+} // namespace execution
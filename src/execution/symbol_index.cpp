@@ -0,0 +1,148 @@
+#include "execution/symbol_index.hpp"
+
+#include <cstdlib>
+#include <cxxabi.h>
+#include <mutex>
+
+namespace execution {
+
+namespace {
+
+std::string demangle(const std::string &name) {
+    if (!name.starts_with("_Z")) {
+        return name;
+    }
+
+    int status = 0;
+    char *demangled =
+        abi::__cxa_demangle(name.c_str(), nullptr, nullptr, &status);
+    if (demangled == nullptr || status != 0) {
+        std::free(demangled);
+        return name;
+    }
+
+    std::string result(demangled);
+    std::free(demangled);
+    return result;
+}
+
+} // namespace
+
+std::string SymbolIndex::keyOf(const VarDecl &decl) {
+    return decl.mangledName.empty() ? decl.name : decl.mangledName;
+}
+
+SymbolRecord *SymbolIndex::findLocked(std::string_view mangledName) {
+    auto it = byKey_.find(std::string(mangledName));
+    return it != byKey_.end() ? &records_[it->second] : nullptr;
+}
+
+const SymbolRecord *
+SymbolIndex::findLocked(std::string_view mangledName) const {
+    auto it = byKey_.find(std::string(mangledName));
+    return it != byKey_.end() ? &records_[it->second] : nullptr;
+}
+
+bool SymbolIndex::add(const VarDecl &decl, int64_t generation,
+                      std::string_view library) {
+    auto key = keyOf(decl);
+    if (key.empty()) {
+        return false;
+    }
+
+    std::unique_lock lock(mutex_);
+    if (auto *record = findLocked(key)) {
+        // Redefinição: o nome não muda, o resto acompanha o eval mais novo
+        record->decl.qualType = decl.qualType;
+        record->decl.type = decl.type;
+        record->decl.file = decl.file;
+        record->decl.line = decl.line;
+        record->generation = generation;
+        if (!library.empty()) {
+            record->library = library;
+        }
+        return false;
+    }
+
+    const size_t index = records_.size();
+    records_.push_back(SymbolRecord{.decl = decl,
+                                    .demangledName = demangle(decl.mangledName),
+                                    .library = std::string(library),
+                                    .address = 0,
+                                    .generation = generation,
+                                    .wrapped = false});
+    byKey_.emplace(std::move(key), index);
+    byName_.emplace(decl.name, index);
+    return true;
+}
+
+void SymbolIndex::setAddress(std::string_view mangledName, uintptr_t address) {
+    std::unique_lock lock(mutex_);
+    if (auto *record = findLocked(mangledName)) {
+        record->address = address;
+    }
+}
+
+void SymbolIndex::markWrapped(std::string_view mangledName) {
+    std::unique_lock lock(mutex_);
+    if (auto *record = findLocked(mangledName)) {
+        record->wrapped = true;
+    }
+}
+
+bool SymbolIndex::isWrapped(std::string_view mangledName) const {
+    std::shared_lock lock(mutex_);
+    const auto *record = findLocked(mangledName);
+    return record != nullptr && record->wrapped;
+}
+
+bool SymbolIndex::contains(std::string_view mangledName) const {
+    std::shared_lock lock(mutex_);
+    return findLocked(mangledName) != nullptr;
+}
+
+bool SymbolIndex::containsName(std::string_view name) const {
+    std::shared_lock lock(mutex_);
+    auto it = byName_.lower_bound({std::string(name), 0});
+    return it != byName_.end() && it->first == name;
+}
+
+std::optional<SymbolRecord>
+SymbolIndex::find(std::string_view mangledName) const {
+    std::shared_lock lock(mutex_);
+    if (const auto *record = findLocked(mangledName)) {
+        return *record;
+    }
+    return std::nullopt;
+}
+
+std::vector<SymbolRecord> SymbolIndex::withPrefix(std::string_view prefix,
+                                                  size_t limit) const {
+    std::vector<SymbolRecord> result;
+
+    std::shared_lock lock(mutex_);
+    for (auto it = byName_.lower_bound({std::string(prefix), 0});
+         it != byName_.end() && it->first.starts_with(prefix) &&
+         result.size() < limit;
+         ++it) {
+        result.push_back(records_[it->second]);
+    }
+    return result;
+}
+
+std::vector<VarDecl> SymbolIndex::declarations() const {
+    std::shared_lock lock(mutex_);
+    std::vector<VarDecl> decls;
+    decls.reserve(records_.size());
+    for (const auto &record : records_) {
+        decls.push_back(record.decl);
+    }
+    return decls;
+}
+
+size_t SymbolIndex::size() const {
+    std::shared_lock lock(mutex_);
+    return records_.size();
+}
+
+} // namespace execution
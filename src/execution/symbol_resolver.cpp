@@ -1,11 +1,13 @@
 #include "execution/symbol_resolver.hpp"
 #include "../repl.hpp"
-#include "../utility/file_raii.hpp"
+#include "execution/workspace.hpp"
+#include "utility/elf_symbols.hpp"
 #include "utility/library_introspection.hpp"
+#include <cassert>
 #include <cstdio>
+#include <cstdlib>
 #include <dlfcn.h>
 #include <format>
-#include <fstream>
 #include <iostream>
 
 // Forward declarations for functions defined in repl.cpp
@@ -19,6 +21,45 @@ namespace execution {
 // Configuração global para wrappers (necessária para callbacks do assembly)
 static SymbolResolver::WrapperConfig *g_globalConfig = nullptr;
 
+namespace {
+
+// CPPREPL_COMPILED_WRAPPERS=1 volta para o wrapper_*.c compilado com clang
+bool useCompiledWrappers() {
+    const char *env = std::getenv("CPPREPL_COMPILED_WRAPPERS");
+    return env != nullptr && *env != '\0' && std::string_view(env) != "0";
+}
+
+/*
+ * Gera os trampolines na arena e exporta os símbolos com o mesmo soname do
+ * libwrapper_<name>.so. Retorna false se algo falhar, para o chamador
+ * compilar o wrapper como antes.
+ */
+bool emitArenaWrappers(const std::string &name,
+                       const std::vector<const VarDecl *> &fns,
+                       SymbolResolver::WrapperConfig &config) {
+    std::vector<TrampolineArena::Trampoline> trampolines;
+    trampolines.reserve(fns.size());
+
+    for (const auto *fnvars : fns) {
+        auto trampoline = config.arena->emit(fnvars->mangledName, &loadfnToPtr);
+        if (!trampoline) {
+            return false;
+        }
+        trampolines.push_back(std::move(*trampoline));
+    }
+
+    void *handle = config.arena->exportSymbols(
+        trampolines, std::format("libwrapper_{}.so", name));
+    if (handle == nullptr) {
+        return false;
+    }
+
+    config.wrapperHandles[name] = handle;
+    return true;
+}
+
+} // namespace
+
 std::string SymbolResolver::generateFunctionWrapper(const VarDecl &fnvars) {
     std::string wrapper;
 
@@ -137,12 +178,12 @@ std::string SymbolResolver::generateFunctionWrapper(const VarDecl &fnvars) {
 std::pair<std::unordered_map<std::string, std::string>, bool>
 SymbolResolver::prepareFunctionWrapper(
     const std::string &name, const std::vector<VarDecl> &vars,
-    WrapperConfig &config,
-    const std::unordered_map<std::string, std::string> &existingFunctions) {
+    WrapperConfig &config, const SymbolIndex &symbols) {
 
     std::string wrapperCode;
     std::unordered_map<std::string, std::string> functions;
     std::unordered_set<std::string> addedFns;
+    std::vector<const VarDecl *> newFunctions;
 
     for (const auto &fnvars : vars) {
         std::cout << fnvars.name << std::endl;
@@ -160,28 +201,51 @@ SymbolResolver::prepareFunctionWrapper(
             continue;
         }
 
-        if (!existingFunctions.contains(fnvars.mangledName)) {
+        if (!symbols.isWrapped(fnvars.mangledName)) {
             addedFns.insert(fnvars.mangledName);
-            wrapperCode += generateFunctionWrapper(fnvars);
+            newFunctions.push_back(&fnvars);
         }
 
         functions[fnvars.mangledName] = fnvars.name;
     }
 
-    if (!wrapperCode.empty()) {
-        auto wrappername = std::format("wrapper_{}", name);
-        std::fstream wrapperOutput(std::format("{}.c", wrappername),
-                                   std::ios::out | std::ios::trunc);
-        wrapperOutput << wrapperCode << std::endl;
-        wrapperOutput.close();
-
-        // Compilar wrapper
-        int result =
-            onlyBuildLib("clang", wrappername, ".c", "c11", config.extraArgs);
-        (void)result; // Suprimir warning de variável não utilizada
+    if (newFunctions.empty()) {
+        return {functions, false};
+    }
+
+    if (config.arena != nullptr && !useCompiledWrappers() &&
+        emitArenaWrappers(name, newFunctions, config)) {
+        return {functions, true};
     }
 
-    return {functions, !wrapperCode.empty()};
+    for (const auto *fnvars : newFunctions) {
+        wrapperCode += generateFunctionWrapper(*fnvars);
+    }
+
+    auto wrappername = std::format("wrapper_{}", name);
+    wrapperCode += '\n';
+    if (!writeArtifact(std::format("{}.c", wrappername), wrapperCode)) {
+        std::cerr << std::format("Cannot write {}.c\n", wrappername);
+    }
+
+    // Compilar wrapper
+    int result =
+        onlyBuildLib("clang", wrappername, ".c", "c11", config.extraArgs);
+    (void)result; // Suprimir warning de variável não utilizada
+
+    return {functions, true};
+}
+
+void *SymbolResolver::openWrapperLibrary(const std::string &name,
+                                         WrapperConfig &config) {
+    auto it = config.wrapperHandles.find(name);
+    if (it != config.wrapperHandles.end()) {
+        return it->second;
+    }
+
+    return dlopen(
+        artifactPath(std::format("./libwrapper_{}.so", name)).c_str(),
+        RTLD_NOW | RTLD_GLOBAL);
 }
 
 void SymbolResolver::fillWrapperPtrs(
@@ -255,22 +319,20 @@ SymbolResolver::resolveSymbolOffsetsFromLibraryFile(
         return symbolOffsets;
     }
 
-    auto command = std::format("nm -D --defined-only {}", libraryPath);
-    auto symbol_address_command = utility::make_popen(command, "r");
-    if (!symbol_address_command) {
-        perror("popen");
+    // Uma busca por .gnu.hash por função, sem listar a biblioteca inteira
+    utility::ElfDynamicSymbols elf(libraryPath);
+    if (!elf.valid()) {
+        for (const auto &def : utility::getAllBuiltFileDecls(libraryPath)) {
+            if (functions.contains(def.nativeName)) {
+                symbolOffsets[def.nativeName] = def.address;
+            }
+        }
         return symbolOffsets;
     }
 
-    char line[1024]{};
-
-    while (fgets(line, 1024, symbol_address_command.get()) != NULL) {
-        uintptr_t symbol_offset = 0;
-        char symbol_name[256];
-        sscanf(line, "%zx %*s %255s", &symbol_offset, symbol_name);
-
-        if (functions.contains(symbol_name)) {
-            symbolOffsets[symbol_name] = symbol_offset;
+    for (const auto &[name, _] : functions) {
+        if (auto def = elf.find(name)) {
+            symbolOffsets[name] = def->address;
         }
     }
 
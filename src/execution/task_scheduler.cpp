@@ -0,0 +1,75 @@
+#include "execution/task_scheduler.hpp"
+#include "execution/jobserver.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <cstdlib>
+#include <string_view>
+#include <tbb/info.h>
+#include <thread>
+
+namespace execution {
+
+size_t TaskScheduler::defaultConcurrency() {
+    if (const char *env = std::getenv("CPPREPL_JOBS"); env != nullptr) {
+        const std::string_view value(env);
+        size_t jobs = 0;
+        auto [ptr, ec] =
+            std::from_chars(value.data(), value.data() + value.size(), jobs);
+        if (ec == std::errc{} && jobs > 0) {
+            return jobs;
+        }
+    }
+
+    // Sob make -jN: o limite do build externo
+    auto &jobserver = Jobserver::instance();
+    if (jobserver.mode() == Jobserver::Mode::Client && jobserver.limit() > 0) {
+        return jobserver.limit();
+    }
+
+    auto hwThreads = std::thread::hardware_concurrency();
+    return hwThreads > 0 ? hwThreads : 4;
+}
+
+TaskScheduler &TaskScheduler::instance() {
+    static TaskScheduler scheduler;
+    return scheduler;
+}
+
+TaskScheduler::TaskScheduler(size_t concurrency) {
+    setConcurrency(concurrency);
+}
+
+size_t TaskScheduler::concurrency() const {
+    std::lock_guard lock(mutex_);
+    return concurrency_;
+}
+
+void TaskScheduler::setConcurrency(size_t concurrency) {
+    if (concurrency == 0) {
+        concurrency = defaultConcurrency();
+    }
+
+    std::lock_guard lock(mutex_);
+    if (arena_ && concurrency == concurrency_) {
+        return;
+    }
+
+    // +1: a thread que espera (REPL) também ocupa uma vaga; nunca abaixo do
+    // padrão do TBB, que outros usos (pstl) compartilham
+    const size_t allowed = std::max<size_t>(
+        concurrency + 1, static_cast<size_t>(tbb::info::default_concurrency()));
+    parallelism_ = std::make_unique<tbb::global_control>(
+        tbb::global_control::max_allowed_parallelism, allowed);
+
+    concurrency_ = concurrency;
+    arena_ = std::make_shared<tbb::task_arena>(static_cast<int>(concurrency));
+    arena_->initialize();
+}
+
+std::shared_ptr<tbb::task_arena> TaskScheduler::arena() const {
+    std::lock_guard lock(mutex_);
+    return arena_;
+}
+
+} // namespace execution
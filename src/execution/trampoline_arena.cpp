@@ -0,0 +1,440 @@
+#include "execution/trampoline_arena.hpp"
+
+#include "execution/process_launcher.hpp"
+#include <algorithm>
+#include <cstring>
+#include <dlfcn.h>
+#include <elf.h>
+#include <format>
+#include <iostream>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#ifndef MFD_CLOEXEC
+#define MFD_CLOEXEC 0x0001U
+#endif
+
+namespace execution {
+
+namespace {
+
+constexpr size_t kEntrySize = 16;
+constexpr size_t kCodeAlign = 16;
+constexpr size_t kXmmSave = 8 * 16;
+
+uint32_t sysvHash(std::string_view name) {
+    uint32_t h = 0;
+    for (unsigned char c : name) {
+        h = (h << 4) + c;
+        uint32_t g = h & 0xf0000000U;
+        if (g != 0) {
+            h ^= g >> 24;
+        }
+        h &= ~g;
+    }
+    return h;
+}
+
+size_t alignUp(size_t value, size_t align) {
+    return (value + align - 1) & ~(align - 1);
+}
+
+class CodeWriter {
+  public:
+    explicit CodeWriter(std::vector<unsigned char> &out) : out_(out) {}
+
+    void bytes(std::initializer_list<unsigned char> b) {
+        out_.insert(out_.end(), b);
+    }
+
+    void imm32(int32_t v) { raw(&v, sizeof(v)); }
+    void imm64(uint64_t v) { raw(&v, sizeof(v)); }
+
+    // jmp qword ptr [rip + rel32]; @p here é o endereço final da instrução
+    void jmpIndirect(uintptr_t here, uintptr_t slot) {
+        bytes({0xFF, 0x25});
+        imm32(static_cast<int32_t>(static_cast<intptr_t>(slot) -
+                                   static_cast<intptr_t>(here + 6)));
+    }
+
+    size_t size() const { return out_.size(); }
+
+  private:
+    void raw(const void *p, size_t n) {
+        const auto *b = static_cast<const unsigned char *>(p);
+        out_.insert(out_.end(), b, b + n);
+    }
+
+    std::vector<unsigned char> &out_;
+};
+
+// Stub lazy: mesmo protocolo do loadFn_<nome> do wrapper compilado, mas
+// preservando também os argumentos em ponto flutuante (xmm0-7)
+std::vector<unsigned char> lazyStub(uintptr_t at, uintptr_t slot,
+                                    uintptr_t name,
+                                    TrampolineArena::Resolver resolver) {
+    std::vector<unsigned char> code;
+    CodeWriter w(code);
+
+    // rax, rbx, rcx, rdx, rsi, rdi, rbp, r8-r15: 15 pushes + retorno deixam
+    // a pilha alinhada em 16 bytes
+    w.bytes({0x50, 0x53, 0x51, 0x52, 0x56, 0x57, 0x55});
+    for (unsigned char r = 0; r < 8; ++r) {
+        w.bytes({0x41, static_cast<unsigned char>(0x50 + r)});
+    }
+
+    w.bytes({0x48, 0x81, 0xEC}); // sub rsp, 128
+    w.imm32(static_cast<int32_t>(kXmmSave));
+    for (unsigned char i = 0; i < 8; ++i) { // movdqu [rsp+16*i], xmmi
+        w.bytes({0xF3, 0x0F, 0x7F, static_cast<unsigned char>(0x44 + 8 * i),
+                 0x24, static_cast<unsigned char>(16 * i)});
+    }
+
+    w.bytes({0x48, 0xBF}); // movabs rdi, slot
+    w.imm64(slot);
+    w.bytes({0x48, 0xBE}); // movabs rsi, name
+    w.imm64(name);
+    w.bytes({0x48, 0xB8}); // movabs rax, resolver
+    w.imm64(reinterpret_cast<uintptr_t>(resolver));
+    w.bytes({0xFF, 0xD0}); // call rax
+
+    for (unsigned char i = 0; i < 8; ++i) { // movdqu xmmi, [rsp+16*i]
+        w.bytes({0xF3, 0x0F, 0x6F, static_cast<unsigned char>(0x44 + 8 * i),
+                 0x24, static_cast<unsigned char>(16 * i)});
+    }
+    w.bytes({0x48, 0x81, 0xC4}); // add rsp, 128
+    w.imm32(static_cast<int32_t>(kXmmSave));
+
+    for (int r = 7; r >= 0; --r) {
+        w.bytes({0x41, static_cast<unsigned char>(0x58 + r)});
+    }
+    w.bytes({0x5D, 0x5F, 0x5E, 0x5A, 0x59, 0x5B, 0x58});
+
+    w.jmpIndirect(at + w.size(), slot);
+    return code;
+}
+
+} // namespace
+
+TrampolineArena::TrampolineArena(size_t capacity) {
+#if defined(__x86_64__)
+    capacity_ = alignUp(capacity, static_cast<size_t>(::getpagesize()));
+
+    int fd = memfd_create_compat("cpprepl-trampolines", MFD_CLOEXEC);
+    if (fd < 0) {
+        return;
+    }
+    if (::ftruncate(fd, static_cast<off_t>(capacity_)) != 0) {
+        ::close(fd);
+        return;
+    }
+
+    // Reserva contígua: RX e RW ficam a menos de 2 GiB um do outro, então o
+    // jmp [rip+rel32] da entrada alcança o slot
+    void *reserve = ::mmap(nullptr, 2 * capacity_, PROT_NONE,
+                           MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (reserve == MAP_FAILED) {
+        ::close(fd);
+        return;
+    }
+    auto *base = static_cast<unsigned char *>(reserve);
+
+    void *exec = ::mmap(base, capacity_, PROT_READ | PROT_EXEC,
+                        MAP_SHARED | MAP_FIXED, fd, 0);
+    void *write = ::mmap(base + capacity_, capacity_, PROT_READ | PROT_WRITE,
+                         MAP_SHARED | MAP_FIXED, fd, 0);
+    ::close(fd);
+
+    if (exec == MAP_FAILED || write == MAP_FAILED) {
+        ::munmap(reserve, 2 * capacity_);
+        return;
+    }
+
+    reserve_ = base;
+    exec_ = static_cast<unsigned char *>(exec);
+    write_ = static_cast<unsigned char *>(write);
+#else
+    (void)capacity;
+#endif
+}
+
+TrampolineArena::~TrampolineArena() {
+    // Bibliotecas do REPL podem continuar chamando os trampolines até o fim
+    // do processo; a arena só é liberada se nunca foi usada
+    if (reserve_ != nullptr && count_ == 0) {
+        ::munmap(reserve_, 2 * capacity_);
+    }
+}
+
+std::optional<TrampolineArena::Trampoline>
+TrampolineArena::emit(std::string_view name, Resolver resolver) {
+    std::scoped_lock lock(mutex_);
+    if (!available() || name.empty()) {
+        return std::nullopt;
+    }
+
+    // Código em [0, cap/2), slots e nomes em [cap/2, cap)
+    const size_t codeLimit = capacity_ / 2;
+    const size_t dataBase = capacity_ / 2;
+
+    const size_t slotOff = dataBase + alignUp(dataUsed_, alignof(void *));
+    const size_t nameOff = slotOff + sizeof(void *);
+    const size_t dataEnd = nameOff + name.size() + 1;
+    if (dataEnd > capacity_) {
+        return std::nullopt;
+    }
+
+    const size_t entryOff = codeUsed_;
+    const size_t lazyOff = entryOff + kEntrySize;
+
+    // O slot é lido/escrito pela visão RW; o nome também
+    auto slotAddr = reinterpret_cast<uintptr_t>(write_ + slotOff);
+    auto nameAddr = reinterpret_cast<uintptr_t>(write_ + nameOff);
+    auto entryAddr = reinterpret_cast<uintptr_t>(exec_ + entryOff);
+    auto lazyAddr = reinterpret_cast<uintptr_t>(exec_ + lazyOff);
+
+    std::vector<unsigned char> entry;
+    CodeWriter(entry).jmpIndirect(entryAddr, slotAddr);
+    entry.resize(kEntrySize, 0xCC); // int3
+
+    auto lazy = lazyStub(lazyAddr, slotAddr, nameAddr, resolver);
+    const size_t codeEnd = alignUp(lazyOff + lazy.size(), kCodeAlign);
+    if (codeEnd > codeLimit) {
+        return std::nullopt;
+    }
+
+    std::memcpy(write_ + nameOff, name.data(), name.size());
+    write_[nameOff + name.size()] = '\0';
+    std::memcpy(write_ + slotOff, &lazyAddr, sizeof(lazyAddr));
+    std::memcpy(write_ + lazyOff, lazy.data(), lazy.size());
+    std::memset(write_ + lazyOff + lazy.size(), 0xCC,
+                codeEnd - lazyOff - lazy.size());
+    // Entrada por último: só fica alcançável depois de completa
+    std::memcpy(write_ + entryOff, entry.data(), entry.size());
+
+    codeUsed_ = codeEnd;
+    dataUsed_ = dataEnd - dataBase;
+    ++count_;
+
+    return Trampoline{.name = std::string(name),
+                      .entry = exec_ + entryOff,
+                      .slot = reinterpret_cast<void **>(write_ + slotOff)};
+}
+
+std::string
+TrampolineArena::buildAbsoluteSymbolObject(const std::vector<Symbol> &symbols,
+                                           const std::string &soname) {
+    // Layout (vaddr == offset): ehdr, phdrs, .dynsym, .dynstr, .hash,
+    // .dynamic, .shstrtab, section headers
+    constexpr size_t kPhnum = 3;
+    constexpr size_t kShnum = 6;
+    static constexpr char kShstrtabData[] =
+        "\0.dynsym\0.dynstr\0.hash\0.dynamic\0.shstrtab";
+    static constexpr std::string_view kShstrtab(kShstrtabData,
+                                                sizeof(kShstrtabData));
+
+    std::string dynstr(1, '\0');
+    const size_t sonameOff = dynstr.size();
+    dynstr += soname;
+    dynstr += '\0';
+
+    std::vector<Elf64_Sym> syms(1 + symbols.size());
+    std::memset(syms.data(), 0, syms.size() * sizeof(Elf64_Sym));
+    for (size_t i = 0; i < symbols.size(); ++i) {
+        auto &sym = syms[i + 1];
+        sym.st_name = static_cast<Elf64_Word>(dynstr.size());
+        dynstr += symbols[i].name;
+        dynstr += '\0';
+        sym.st_info = ELF64_ST_INFO(
+            STB_GLOBAL, symbols[i].function ? STT_FUNC : STT_OBJECT);
+        sym.st_other = STV_DEFAULT;
+        sym.st_shndx = SHN_ABS;
+        sym.st_value = symbols[i].address;
+        sym.st_size = symbols[i].size;
+    }
+
+    const auto nchain = static_cast<uint32_t>(syms.size());
+    const uint32_t nbucket = std::max<uint32_t>(1, nchain / 2) | 1;
+    std::vector<uint32_t> hash(2 + nbucket + nchain, 0);
+    hash[0] = nbucket;
+    hash[1] = nchain;
+    for (uint32_t i = 1; i < nchain; ++i) {
+        uint32_t bucket = sysvHash(symbols[i - 1].name) % nbucket;
+        hash[2 + nbucket + i] = hash[2 + bucket];
+        hash[2 + bucket] = i;
+    }
+
+    const size_t phoff = sizeof(Elf64_Ehdr);
+    const size_t dynsymOff = alignUp(phoff + kPhnum * sizeof(Elf64_Phdr), 8);
+    const size_t dynsymSize = syms.size() * sizeof(Elf64_Sym);
+    const size_t dynstrOff = dynsymOff + dynsymSize;
+    const size_t hashOff = alignUp(dynstrOff + dynstr.size(), 8);
+    const size_t hashSize = hash.size() * sizeof(uint32_t);
+    const size_t dynamicOff = alignUp(hashOff + hashSize, 8);
+
+    const std::vector<Elf64_Dyn> dynamic{
+        {DT_HASH, {hashOff}},          {DT_STRTAB, {dynstrOff}},
+        {DT_SYMTAB, {dynsymOff}},      {DT_STRSZ, {dynstr.size()}},
+        {DT_SYMENT, {sizeof(Elf64_Sym)}}, {DT_SONAME, {sonameOff}},
+        {DT_NULL, {0}},
+    };
+    const size_t dynamicSize = dynamic.size() * sizeof(Elf64_Dyn);
+    const size_t shstrOff = dynamicOff + dynamicSize;
+    const size_t shoff = alignUp(shstrOff + kShstrtab.size(), 8);
+    const size_t total = shoff + kShnum * sizeof(Elf64_Shdr);
+
+    std::string image(total, '\0');
+    auto put = [&](size_t off, const void *data, size_t size) {
+        std::memcpy(image.data() + off, data, size);
+    };
+
+    Elf64_Ehdr ehdr{};
+    std::memcpy(ehdr.e_ident, ELFMAG, SELFMAG);
+    ehdr.e_ident[EI_CLASS] = ELFCLASS64;
+    ehdr.e_ident[EI_DATA] = ELFDATA2LSB;
+    ehdr.e_ident[EI_VERSION] = EV_CURRENT;
+    ehdr.e_ident[EI_OSABI] = ELFOSABI_NONE;
+    ehdr.e_type = ET_DYN;
+    ehdr.e_machine = EM_X86_64;
+    ehdr.e_version = EV_CURRENT;
+    ehdr.e_phoff = phoff;
+    ehdr.e_shoff = shoff;
+    ehdr.e_ehsize = sizeof(Elf64_Ehdr);
+    ehdr.e_phentsize = sizeof(Elf64_Phdr);
+    ehdr.e_phnum = kPhnum;
+    ehdr.e_shentsize = sizeof(Elf64_Shdr);
+    ehdr.e_shnum = kShnum;
+    ehdr.e_shstrndx = kShnum - 1;
+    put(0, &ehdr, sizeof(ehdr));
+
+    // glibc antiga reescreve a .dynamic ao carregar: segmento RW
+    const Elf64_Phdr phdrs[kPhnum] = {
+        {.p_type = PT_LOAD,
+         .p_flags = PF_R | PF_W,
+         .p_offset = 0,
+         .p_vaddr = 0,
+         .p_paddr = 0,
+         .p_filesz = total,
+         .p_memsz = total,
+         .p_align = 0x1000},
+        {.p_type = PT_DYNAMIC,
+         .p_flags = PF_R | PF_W,
+         .p_offset = dynamicOff,
+         .p_vaddr = dynamicOff,
+         .p_paddr = dynamicOff,
+         .p_filesz = dynamicSize,
+         .p_memsz = dynamicSize,
+         .p_align = 8},
+        // Sem PT_GNU_STACK o loader assume pilha executável
+        {.p_type = PT_GNU_STACK,
+         .p_flags = PF_R | PF_W,
+         .p_offset = 0,
+         .p_vaddr = 0,
+         .p_paddr = 0,
+         .p_filesz = 0,
+         .p_memsz = 0,
+         .p_align = 16},
+    };
+    put(phoff, phdrs, sizeof(phdrs));
+
+    put(dynsymOff, syms.data(), dynsymSize);
+    put(dynstrOff, dynstr.data(), dynstr.size());
+    put(hashOff, hash.data(), hashSize);
+    put(dynamicOff, dynamic.data(), dynamicSize);
+    put(shstrOff, kShstrtab.data(), kShstrtab.size());
+
+    // Seções só para ferramentas (nm, gdb, ElfDynamicSymbols)
+    auto section = [&](uint32_t name, uint32_t type, uint64_t flags,
+                       size_t off, size_t size, uint32_t link, uint32_t info,
+                       uint64_t align, uint64_t entsize) {
+        Elf64_Shdr sh{};
+        sh.sh_name = name;
+        sh.sh_type = type;
+        sh.sh_flags = flags;
+        sh.sh_addr = (flags & SHF_ALLOC) ? off : 0;
+        sh.sh_offset = off;
+        sh.sh_size = size;
+        sh.sh_link = link;
+        sh.sh_info = info;
+        sh.sh_addralign = align;
+        sh.sh_entsize = entsize;
+        return sh;
+    };
+    const Elf64_Shdr shdrs[kShnum] = {
+        Elf64_Shdr{},
+        section(1, SHT_DYNSYM, SHF_ALLOC, dynsymOff, dynsymSize, 2, 1, 8,
+                sizeof(Elf64_Sym)),
+        section(9, SHT_STRTAB, SHF_ALLOC, dynstrOff, dynstr.size(), 0, 0, 1,
+                0),
+        section(17, SHT_HASH, SHF_ALLOC, hashOff, hashSize, 1, 0, 8, 4),
+        section(23, SHT_DYNAMIC, SHF_ALLOC | SHF_WRITE, dynamicOff,
+                dynamicSize, 2, 0, 8, sizeof(Elf64_Dyn)),
+        section(32, SHT_STRTAB, 0, shstrOff, kShstrtab.size(), 0, 0, 1, 0),
+    };
+    put(shoff, shdrs, sizeof(shdrs));
+
+    return image;
+}
+
+void *TrampolineArena::exportSymbols(const std::vector<Trampoline> &trampolines,
+                                     const std::string &soname) {
+    if (trampolines.empty()) {
+        return nullptr;
+    }
+
+    std::vector<Symbol> symbols;
+    symbols.reserve(trampolines.size() * 2);
+    for (const auto &t : trampolines) {
+        symbols.push_back({.name = t.name,
+                           .address = reinterpret_cast<uintptr_t>(t.entry),
+                           .function = true,
+                           .size = kEntrySize});
+        symbols.push_back({.name = t.name + "_ptr",
+                           .address = reinterpret_cast<uintptr_t>(t.slot),
+                           .function = false,
+                           .size = sizeof(void *)});
+    }
+
+    const auto image = buildAbsoluteSymbolObject(symbols, soname);
+
+    // O .so nunca toca o disco
+    int fd = memfd_create_compat(soname.c_str(), MFD_CLOEXEC);
+    if (fd < 0) {
+        return nullptr;
+    }
+    bool written = ::write(fd, image.data(), image.size()) ==
+                   static_cast<ssize_t>(image.size());
+    void *handle = written ? dlopen(std::format("/proc/self/fd/{}", fd).c_str(),
+                                    RTLD_NOW | RTLD_GLOBAL)
+                           : nullptr;
+    ::close(fd);
+
+    if (handle == nullptr) {
+        if (written) {
+            std::cerr << std::format("Cannot load trampoline table: {}\n",
+                                     dlerror());
+        }
+        return nullptr;
+    }
+
+    // glibc < 2.28 soma a base do .so a símbolos SHN_ABS
+    if (dlsym(handle, symbols.front().name.c_str()) !=
+        reinterpret_cast<void *>(symbols.front().address)) {
+        dlclose(handle);
+        return nullptr;
+    }
+
+    return handle;
+}
+
+size_t TrampolineArena::codeBytesUsed() const {
+    std::scoped_lock lock(mutex_);
+    return codeUsed_;
+}
+
+size_t TrampolineArena::trampolineCount() const {
+    std::scoped_lock lock(mutex_);
+    return count_;
+}
+
+} // namespace execution
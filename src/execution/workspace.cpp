@@ -0,0 +1,376 @@
+#include "execution/workspace.hpp"
+#include "execution/memory_artifacts.hpp"
+
+#include <atomic>
+#include <cerrno>
+#include <charconv>
+#include <csignal>
+#include <cstdlib>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <link.h>
+#include <set>
+#include <sys/stat.h>
+#include <sys/statfs.h>
+#include <sys/statvfs.h>
+#include <unistd.h>
+
+#ifndef TMPFS_MAGIC
+#define TMPFS_MAGIC 0x01021994
+#endif
+
+namespace fs = std::filesystem;
+
+namespace execution {
+
+namespace {
+
+constexpr size_t kShardCount = 256;
+
+std::string normalize(std::string_view name) {
+    while (name.starts_with("./")) {
+        name.remove_prefix(2);
+    }
+    return std::string(name);
+}
+
+// A base precisa aceitar escrita e mapeamento executável (dlopen)
+bool usableBase(const fs::path &dir) {
+    struct statvfs vfs {};
+    return !dir.empty() && ::statvfs(dir.c_str(), &vfs) == 0 &&
+           (vfs.f_flag & ST_NOEXEC) == 0 &&
+           ::access(dir.c_str(), W_OK | X_OK) == 0;
+}
+
+bool isTmpfs(const fs::path &dir) {
+    struct statfs sfs {};
+    return ::statfs(dir.c_str(), &sfs) == 0 &&
+           static_cast<unsigned long>(sfs.f_type) == TMPFS_MAGIC;
+}
+
+using FileKey = std::pair<uint64_t, uint64_t>; // dispositivo, inode
+
+// Arquivos de todos os objetos carregados agora no processo
+std::set<FileKey> loadedFiles() {
+    std::set<FileKey> files;
+    ::dl_iterate_phdr(
+        [](struct dl_phdr_info *info, size_t, void *data) {
+            struct stat st {};
+            if (info->dlpi_name != nullptr && info->dlpi_name[0] != '\0' &&
+                ::stat(info->dlpi_name, &st) == 0) {
+                static_cast<std::set<FileKey> *>(data)->emplace(st.st_dev,
+                                                                st.st_ino);
+            }
+            return 0;
+        },
+        &files);
+    return files;
+}
+
+} // namespace
+
+fs::path Workspace::defaultBase() {
+    const char *env = std::getenv("CPPREPL_WORKSPACE");
+    if (env != nullptr && *env != '\0') {
+        const std::string_view value(env);
+        if (value == "0" || value == "off") {
+            return {};
+        }
+        return fs::path(value);
+    }
+
+    const char *runtimeDir = std::getenv("XDG_RUNTIME_DIR");
+    for (const char *candidate : {runtimeDir, "/dev/shm"}) {
+        if (candidate != nullptr && usableBase(candidate)) {
+            return fs::path(candidate);
+        }
+    }
+
+    std::error_code ec;
+    return fs::current_path(ec) / ".cpprepl";
+}
+
+Workspace &Workspace::instance() {
+    static Workspace workspace(defaultBase());
+    return workspace;
+}
+
+Workspace::Workspace(const fs::path &base, size_t keepGenerations)
+    : keepGenerations_(keepGenerations), shards_(kShardCount, false) {
+    if (base.empty()) {
+        return;
+    }
+
+    // Uma sessão por instância; o pid identifica sessões órfãs
+    static std::atomic<unsigned> instances{0};
+    const auto userDir = base / std::format("cpprepl-{}", ::getuid());
+    const auto root =
+        userDir / std::format("session-{}-{}", ::getpid(), instances++);
+
+    std::error_code ec;
+    fs::create_directories(root, ec);
+    if (ec) {
+        std::cerr << std::format("Workspace disabled: {}: {}\n", root.string(),
+                                 ec.message());
+        return;
+    }
+    // /dev/shm é compartilhado entre usuários
+    fs::permissions(userDir, fs::perms::owner_all, ec);
+
+    root_ = root;
+    tmpfs_ = isTmpfs(root_);
+    worker_ = std::thread([this] { worker(); });
+}
+
+Workspace::~Workspace() {
+    {
+        std::lock_guard lock(mutex_);
+        stopping_ = true;
+    }
+    cv_.notify_all();
+    if (worker_.joinable()) {
+        worker_.join();
+    }
+
+    if (!root_.empty()) {
+        std::error_code ec;
+        fs::remove_all(root_, ec);
+    }
+}
+
+void Workspace::removeStaleSessions(const fs::path &userDir) {
+    std::error_code ec;
+    for (const auto &entry : fs::directory_iterator(userDir, ec)) {
+        const auto name = entry.path().filename().string();
+        if (!name.starts_with("session-")) {
+            continue;
+        }
+
+        pid_t pid = 0;
+        const char *begin = name.data() + 8;
+        const char *end = name.data() + name.size();
+        if (std::from_chars(begin, end, pid).ec != std::errc{} ||
+            pid == ::getpid()) {
+            continue;
+        }
+
+        if (::kill(pid, 0) != 0 && errno == ESRCH) {
+            std::error_code rmEc;
+            fs::remove_all(entry.path(), rmEc);
+        }
+    }
+}
+
+fs::path Workspace::shardFor(std::string_view name) {
+    const size_t shard = std::hash<std::string_view>{}(name) % kShardCount;
+    auto dir = root_ / std::format("{:02x}", shard);
+    if (!shards_[shard]) {
+        std::error_code ec;
+        fs::create_directory(dir, ec);
+        shards_[shard] = true;
+    }
+    return dir;
+}
+
+std::string Workspace::place(const std::string &name) {
+    if (!enabled()) {
+        return name;
+    }
+
+    auto logical = normalize(name);
+    const fs::path logicalPath(logical);
+    const auto stem = logicalPath.stem().string();
+    const auto ext = logicalPath.extension().string();
+
+    std::lock_guard lock(mutex_);
+    // Extensão no fim: o compilador escolhe a linguagem por ela
+    auto path =
+        (shardFor(stem) / std::format("{}.{}{}", stem, ++sequence_, ext))
+            .string();
+
+    auto [it, inserted] = current_.try_emplace(std::move(logical));
+    if (!inserted) {
+        superseded_.push_back(std::move(it->second.path));
+    }
+    it->second = Entry{.path = path, .generation = generation_};
+    return path;
+}
+
+std::string Workspace::resolve(const std::string &name) const {
+    if (!enabled()) {
+        return name;
+    }
+
+    std::lock_guard lock(mutex_);
+    auto it = current_.find(normalize(name));
+    return it != current_.end() ? it->second.path : name;
+}
+
+void Workspace::advance() {
+    if (!enabled()) {
+        return;
+    }
+
+    std::lock_guard lock(mutex_);
+    ++generation_;
+
+    // O nome continua resolvendo até o worker apagar o arquivo: uma
+    // biblioteca ainda carregada pode ficar por muitas gerações
+    const int64_t oldest = generation_ - static_cast<int64_t>(keepGenerations_);
+    for (auto &[name, entry] : current_) {
+        if (!entry.collecting && entry.generation < oldest) {
+            entry.collecting = true;
+            aged_.emplace(entry.path, name);
+            queue_.push_back(entry.path);
+        }
+    }
+
+    // Bibliotecas retidas são conferidas de novo: podem ter sido
+    // descarregadas desde a última coleta
+    std::move(superseded_.begin(), superseded_.end(),
+              std::back_inserter(queue_));
+    std::move(retained_.begin(), retained_.end(), std::back_inserter(queue_));
+    superseded_.clear();
+    retained_.clear();
+
+    if (!queue_.empty()) {
+        cv_.notify_one();
+    }
+}
+
+void Workspace::drain() {
+    std::unique_lock lock(mutex_);
+    idle_.wait(lock, [&] { return stopping_ || (queue_.empty() && !busy_); });
+}
+
+void Workspace::worker() {
+    removeStaleSessions(root_.parent_path());
+
+    std::unique_lock lock(mutex_);
+    while (true) {
+        cv_.wait(lock, [&] { return stopping_ || !queue_.empty(); });
+        if (stopping_) {
+            break;
+        }
+
+        auto batch = std::move(queue_);
+        queue_.clear();
+        busy_ = true;
+        lock.unlock();
+
+        const auto loaded = loadedFiles();
+        std::vector<std::string> keep;
+        std::vector<std::string> gone;
+        size_t removed = 0;
+        for (auto &path : batch) {
+            struct stat st {};
+            if (::stat(path.c_str(), &st) != 0) {
+                gone.push_back(std::move(path));
+                continue;
+            }
+            if (loaded.contains({st.st_dev, st.st_ino})) {
+                keep.push_back(std::move(path));
+            } else if (::unlink(path.c_str()) == 0) {
+                ++removed;
+                gone.push_back(std::move(path));
+            }
+        }
+
+        lock.lock();
+        for (const auto &path : gone) {
+            auto aged = aged_.find(path);
+            if (aged == aged_.end()) {
+                continue;
+            }
+            // place() pode ter dado um caminho novo ao nome enquanto isso
+            if (auto it = current_.find(aged->second);
+                it != current_.end() && it->second.path == path) {
+                current_.erase(it);
+            }
+            aged_.erase(aged);
+        }
+        busy_ = false;
+        deleted_ += removed;
+        std::move(keep.begin(), keep.end(), std::back_inserter(retained_));
+        idle_.notify_all();
+    }
+    idle_.notify_all();
+}
+
+Workspace::Stats Workspace::stats() const {
+    Stats stats;
+    {
+        std::lock_guard lock(mutex_);
+        stats.root = root_;
+        stats.tmpfs = tmpfs_;
+        stats.tracked = current_.size();
+        stats.retained = retained_.size();
+        stats.pendingDeletes = queue_.size() + superseded_.size();
+        stats.deleted = deleted_;
+        stats.generation = generation_;
+    }
+
+    if (!stats.root.empty()) {
+        std::error_code ec;
+        for (const auto &entry : fs::recursive_directory_iterator(
+                 stats.root, fs::directory_options::skip_permission_denied,
+                 ec)) {
+            std::error_code sizeEc;
+            if (entry.is_regular_file(sizeEc)) {
+                ++stats.files;
+                stats.bytes += entry.file_size(sizeEc);
+            }
+        }
+    }
+    return stats;
+}
+
+std::string artifactPath(const std::string &name) {
+    auto &memory = MemoryArtifacts::instance();
+    if (memory.contains(name)) {
+        return memory.resolve(name);
+    }
+    return Workspace::instance().resolve(name);
+}
+
+std::string newArtifactPath(const std::string &name, bool library) {
+    auto &memory = MemoryArtifacts::instance();
+    if (memory.enabled()) {
+        using Kind = MemoryArtifacts::Kind;
+        const auto kind = library ? Kind::Library : Kind::Transient;
+        if (auto path = memory.create(name, {}, kind)) {
+            return *path;
+        }
+        // Sem memfd: um memfd antigo com o mesmo nome não pode ganhar
+        memory.release(name);
+    }
+    return Workspace::instance().place(name);
+}
+
+std::optional<std::string> writeArtifact(const std::string &name,
+                                         std::string_view content) {
+    auto &memory = MemoryArtifacts::instance();
+    if (memory.enabled()) {
+        if (auto path = memory.create(name, content)) {
+            return path;
+        }
+        memory.release(name);
+    }
+
+    auto path = Workspace::instance().place(name);
+    std::ofstream out(path, std::ios::out | std::ios::trunc | std::ios::binary);
+    out << content;
+    out.close();
+    if (!out) {
+        return std::nullopt;
+    }
+    return path;
+}
+
+void finishEvalArtifacts(std::string_view stem) {
+    MemoryArtifacts::instance().releaseStem(stem);
+    Workspace::instance().advance();
+}
+
+} // namespace execution
@@ -1,5 +1,7 @@
 #include "../test_helpers/temp_directory_fixture.hpp"
 #include "analysis/ast_context.hpp"
+#include "analysis/decl_export.hpp"
+#include "repl.hpp"
 
 #include <filesystem>
 #include <fstream>
@@ -371,3 +373,138 @@ TEST_F(AstContextTest, SnippetsAndOutputHeaderAreSynced) {
     EXPECT_FALSE(
         context->hasHeaderChanged()); // segunda checagem não vê mudança
 }
+
+// ============================================================================
+// Declaration Export Records Tests
+// ============================================================================
+
+TEST_F(AstContextTest, AnalyzeDeclRecords_VarsFunctionsAndRecords) {
+    namespace dx = decl_export;
+    auto shared = std::make_shared<AstContext>();
+    ContextualAstAnalyzer analyzer(shared);
+
+    const std::string source =
+        (std::filesystem::current_path() / "repl_1.cpp").string();
+    const std::string structText = "struct Point { int x; int y; }";
+    createFile("repl_1.cpp", structText + ";\nint counter = 0;\n");
+
+    std::string records(dx::kMagic);
+    records += '\n';
+    dx::appendDecl(records, {.kind = "CXXRecordDecl",
+                             .name = "Point",
+                             .file = source,
+                             .line = 1,
+                             .beginOffset = 0,
+                             .endOffset = (int64_t)structText.size()});
+    dx::appendDecl(records, {.kind = "VarDecl",
+                             .name = "counter",
+                             .qualType = "int",
+                             .mangledName = "counter",
+                             .file = source,
+                             .line = 2});
+    dx::appendDecl(records, {.kind = "FunctionDecl",
+                             .name = "helper",
+                             .qualType = "void (int)",
+                             .mangledName = "_Z6helperi",
+                             .file = source,
+                             .line = 3});
+    dx::appendDecl(records, {.kind = "VarDecl",
+                             .name = "hidden",
+                             .qualType = "int",
+                             .storageClass = "static",
+                             .file = source,
+                             .line = 4});
+
+    std::vector<VarDecl> vars;
+    ASSERT_EQ(analyzer.analyzeDeclRecords(records, source, vars), 0);
+
+    ASSERT_EQ(vars.size(), 2u);
+    EXPECT_EQ(vars[0].name, "counter");
+    EXPECT_EQ(vars[0].kind, "VarDecl");
+    EXPECT_EQ(vars[1].name, "helper");
+    EXPECT_EQ(vars[1].mangledName, "_Z6helperi");
+
+    const auto header = shared->getOutputHeader();
+    EXPECT_NE(header.find(structText + ";"), std::string::npos);
+    EXPECT_NE(header.find("extern int counter;"), std::string::npos);
+    EXPECT_NE(header.find("extern void helper(int);"), std::string::npos);
+    EXPECT_EQ(header.find("hidden"), std::string::npos);
+}
+
+TEST_F(AstContextTest, AnalyzeDeclRecords_RecordsSnippetGraph) {
+    namespace dx = decl_export;
+    ContextualAstAnalyzer analyzer(std::make_shared<AstContext>());
+    analyzer.setSnippetUnit("graph_unit");
+
+    const std::string source =
+        (std::filesystem::current_path() / "graph_src.cpp").string();
+    const std::string text = "int graphScale(Point p) { return p.x; }\n";
+    createFile("graph_src.cpp", text);
+
+    std::string records(dx::kMagic);
+    records += '\n';
+    dx::appendDecl(records, {.kind = "FunctionDecl",
+                             .name = "graphScale",
+                             .qualType = "int (Point)",
+                             .mangledName = "_Z10graphScale5Point",
+                             .file = source,
+                             .line = 1});
+
+    std::vector<VarDecl> vars;
+    ASSERT_EQ(analyzer.analyzeDeclRecords(records, source, vars), 0);
+
+    const auto graph = AstContext::snippetGraph();
+    const auto *node = graph.find("graph_unit");
+    ASSERT_NE(node, nullptr);
+    EXPECT_EQ(node->provides, std::vector<std::string>{"graphScale"});
+    EXPECT_TRUE(node->uses.contains("Point"));
+    EXPECT_EQ(analyzer.providedNames(), std::vector<std::string>{"graphScale"});
+}
+
+TEST_F(AstContextTest, AnalyzeDeclRecords_CollectsRedefinitionsForTheCaller) {
+    namespace dx = decl_export;
+    const std::string source =
+        (std::filesystem::current_path() / "stale_src.cpp").string();
+    createFile("stale_src.cpp", "int staleScale();\n");
+    createFile("stale_user.cpp", "int u = staleScale();\n");
+
+    std::string records(dx::kMagic);
+    records += '\n';
+    dx::appendDecl(records, {.kind = "FunctionDecl",
+                             .name = "staleScale",
+                             .qualType = "int ()",
+                             .mangledName = "_Z10staleScalev",
+                             .file = source,
+                             .line = 1});
+
+    std::vector<VarDecl> vars;
+    ContextualAstAnalyzer first(std::make_shared<AstContext>());
+    first.setSnippetUnit("stale_a");
+    ASSERT_EQ(first.analyzeDeclRecords(records, source, vars), 0);
+    EXPECT_TRUE(first.staleSnippets().empty());
+    AstContext::recordSnippetDependencies("stale_user",
+                                          "int u = staleScale();\n", {});
+
+    // Outra unidade redefine: o aviso fica com quem chamou a análise
+    ContextualAstAnalyzer second(std::make_shared<AstContext>());
+    second.setSnippetUnit("stale_b");
+    testing::internal::CaptureStdout();
+    ASSERT_EQ(second.analyzeDeclRecords(records, source, vars), 0);
+    EXPECT_EQ(testing::internal::GetCapturedStdout().find("redefined"),
+              std::string::npos);
+
+    ASSERT_EQ(second.staleSnippets().size(), 1u);
+    EXPECT_EQ(second.staleSnippets()[0].first, "staleScale");
+    EXPECT_EQ(second.staleSnippets()[0].second,
+              std::vector<std::string>{"stale_user"});
+}
+
+TEST_F(AstContextTest, AnalyzeDeclRecords_InvalidHeader_Fails) {
+    ContextualAstAnalyzer analyzer(std::make_shared<AstContext>());
+    std::vector<VarDecl> vars;
+
+    EXPECT_NE(analyzer.analyzeDeclRecords("{\"kind\":\"TranslationUnitDecl\"}",
+                                          "repl_1.cpp", vars),
+              0);
+    EXPECT_TRUE(vars.empty());
+}
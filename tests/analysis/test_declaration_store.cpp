@@ -0,0 +1,179 @@
+#include "../test_helpers/temp_directory_fixture.hpp"
+#include "analysis/declaration_store.hpp"
+
+#include <fstream>
+#include <gtest/gtest.h>
+#include <iterator>
+#include <string>
+
+using analysis::CodeTracking;
+using analysis::DeclarationStore;
+using namespace test_helpers;
+
+namespace {
+
+CodeTracking entity(std::string key, std::string decl, int64_t line = -1,
+                    std::string file = {}) {
+    CodeTracking entry;
+    entry.key = std::move(key);
+    entry.codeSnippet = std::move(decl) + "\n";
+    entry.filename = std::move(file);
+    entry.line = line;
+    return entry;
+}
+
+CodeTracking plain(std::string text) {
+    CodeTracking entry;
+    entry.codeSnippet = std::move(text) + "\n";
+    entry.line = -1;
+    return entry;
+}
+
+std::string readAll(const std::string &path) {
+    std::ifstream in(path, std::ios::binary);
+    return {std::istreambuf_iterator<char>(in),
+            std::istreambuf_iterator<char>()};
+}
+
+} // namespace
+
+class DeclarationStoreTest : public TempDirectoryFixture {};
+
+TEST_F(DeclarationStoreTest, RedeclarationIsANoOp) {
+    DeclarationStore store;
+    EXPECT_TRUE(store.add(entity("var:x", "extern int x;", 3, "repl_1.cpp")));
+    const auto generation = store.generation();
+
+    // Mesmo texto, outra linha: continua a primeira declaração
+    EXPECT_FALSE(store.add(entity("var:x", "extern int x;", 9, "repl_4.cpp")));
+    EXPECT_EQ(store.generation(), generation);
+    EXPECT_EQ(store.text(), "#line 3 \"repl_1.cpp\"\nextern int x;\n");
+    EXPECT_EQ(store.entries().size(), 1u);
+}
+
+TEST_F(DeclarationStoreTest, RedefinitionSupersedesTheOldEntry) {
+    DeclarationStore store;
+    store.add(entity("record:P", "struct P { int x; };"));
+    store.add(entity("fn:_Z4normv", "extern int norm();"));
+    EXPECT_TRUE(store.add(entity("record:P", "struct P { long x; };")));
+
+    // A versão nova fica onde estava a antiga, antes de quem usa P
+    EXPECT_EQ(store.text(), "struct P { long x; };\nextern int norm();\n");
+    ASSERT_EQ(store.entries().size(), 3u);
+    EXPECT_FALSE(store.live(0));
+    EXPECT_TRUE(store.live(2));
+    EXPECT_EQ(store.entries()[2].codeSnippet, "struct P { long x; };\n");
+
+    // Entradas novas continuam no fim
+    store.add(entity("var:p", "extern P p;"));
+    EXPECT_TRUE(store.text().ends_with("extern P p;\n"));
+}
+
+TEST_F(DeclarationStoreTest, UnkeyedEntriesAlwaysAppend) {
+    DeclarationStore store;
+    store.add(plain("#pragma once"));
+    store.add(plain("#pragma once"));
+    EXPECT_EQ(store.text(), "#pragma once\n#pragma once\n");
+}
+
+TEST_F(DeclarationStoreTest, WritesIncrementallyUntilASupersede) {
+    DeclarationStore store;
+    store.add(plain("#pragma once"));
+    ASSERT_TRUE(store.writeTo("decl_amalgama.hpp"));
+
+    // Marca no arquivo: append preserva, reescrita descarta
+    {
+        std::ofstream out("decl_amalgama.hpp", std::ios::binary);
+        out << "#pragma ONCE\n";
+    }
+    store.add(entity("var:a", "extern int a;"));
+    ASSERT_TRUE(store.writeTo("decl_amalgama.hpp"));
+    EXPECT_EQ(readAll("decl_amalgama.hpp"), "#pragma ONCE\nextern int a;\n");
+
+    store.add(entity("var:a", "extern long a;"));
+    ASSERT_TRUE(store.writeTo("decl_amalgama.hpp"));
+    EXPECT_EQ(readAll("decl_amalgama.hpp"), store.text());
+    EXPECT_EQ(store.text(), "#pragma once\nextern long a;\n");
+}
+
+TEST_F(DeclarationStoreTest, ForeignEditsForceARewrite) {
+    DeclarationStore store;
+    store.add(plain("#pragma once"));
+    ASSERT_TRUE(store.writeTo("decl_amalgama.hpp"));
+    {
+        std::ofstream out("decl_amalgama.hpp", std::ios::app);
+        out << "// editado fora\n";
+    }
+
+    store.add(entity("var:b", "extern int b;"));
+    ASSERT_TRUE(store.writeTo("decl_amalgama.hpp"));
+    EXPECT_EQ(readAll("decl_amalgama.hpp"), store.text());
+}
+
+TEST_F(DeclarationStoreTest, FoldKeepsDirectivesAndRecentEntries) {
+    DeclarationStore store;
+    store.add(plain("#pragma once"));
+    store.add(plain("#include \"precompiledheader.hpp\""));
+    store.add(entity("var:a", "extern int a;", 3, "repl_1.cpp"));
+    store.add(plain("#line 5 \"repl_2.cpp\""));
+    store.add(plain("struct Q { int v; };"));
+    store.add(plain("#line 5 \"repl_3.cpp\""));
+    store.add(plain("struct R { int v; };"));
+
+    // Abaixo do limite nada é proposto
+    EXPECT_TRUE(store.planFold(store.text().size() + 1, 1).empty());
+
+    // O #line de R fica junto com R, do lado recente
+    const auto fold = store.planFold(1, 1);
+    ASSERT_FALSE(fold.empty());
+    EXPECT_EQ(fold.end, 5u);
+    EXPECT_EQ(fold.text, "#line 3 \"repl_1.cpp\"\nextern int a;\n"
+                         "#line 5 \"repl_2.cpp\"\nstruct Q { int v; };\n");
+
+    const auto generation = store.generation();
+    ASSERT_TRUE(store.commitFold(fold));
+    EXPECT_NE(store.generation(), generation);
+    EXPECT_EQ(store.folded(), 5u);
+    EXPECT_EQ(store.text(), "#pragma once\n"
+                            "#include \"precompiledheader.hpp\"\n"
+                            "#line 5 \"repl_3.cpp\"\nstruct R { int v; };\n");
+
+    // Redefinir uma entrada dobrada só acrescenta o texto novo
+    store.add(entity("var:a", "extern long a;"));
+    EXPECT_TRUE(store.text().ends_with("extern long a;\n"));
+    EXPECT_EQ(store.text().find("extern int a;"), std::string::npos);
+}
+
+TEST_F(DeclarationStoreTest, StaleFoldIsRejected) {
+    DeclarationStore store;
+    store.add(entity("var:a", "extern int a;"));
+    store.add(entity("var:b", "extern int b;"));
+    store.add(entity("var:c", "extern int c;"));
+
+    const auto fold = store.planFold(1, 1);
+    ASSERT_EQ(fold.folded.size(), 2u);
+
+    // a foi redefinida enquanto a camada era gerada
+    store.add(entity("var:a", "extern long a;"));
+    EXPECT_FALSE(store.commitFold(fold));
+    EXPECT_EQ(store.folded(), 0u);
+
+    const auto again = store.planFold(1, 1);
+    ASSERT_TRUE(store.commitFold(again));
+    EXPECT_FALSE(store.commitFold(again));
+}
+
+TEST_F(DeclarationStoreTest, FoldFollowsHeaderPositions) {
+    DeclarationStore store;
+    store.add(entity("record:P", "struct P { int x; };"));
+    store.add(entity("fn:_Z4normv", "extern int norm(P);"));
+    store.add(entity("var:c", "extern int c;"));
+    store.add(entity("record:P", "struct P { long x; };"));
+
+    // P nova é a entrada mais recente do log, mas vem antes de norm no
+    // header: dobrar norm leva P junto
+    const auto fold = store.planFold(1, 1);
+    EXPECT_EQ(fold.text, "struct P { long x; };\nextern int norm(P);\n");
+    ASSERT_TRUE(store.commitFold(fold));
+    EXPECT_EQ(store.text(), "extern int c;\n");
+}
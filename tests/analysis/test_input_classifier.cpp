@@ -0,0 +1,238 @@
+#include "analysis/input_classifier.hpp"
+
+#include <chrono>
+#include <format>
+#include <gtest/gtest.h>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using analysis::classifyInput;
+using analysis::InputAccumulator;
+using analysis::InputKind;
+using analysis::TokenKind;
+
+namespace {
+
+InputKind kindOf(std::string_view input) {
+    return classifyInput(input).kind;
+}
+
+std::vector<std::string_view> tokens(std::string_view input) {
+    std::vector<std::string_view> out;
+    analysis::Tokenizer tokenizer(input);
+    for (auto tok = tokenizer.next(); tok.kind != TokenKind::End;
+         tok = tokenizer.next()) {
+        out.push_back(tok.text);
+    }
+    return out;
+}
+
+} // namespace
+
+TEST(InputClassifierTest, TokenizesLiteralsAndComments) {
+    EXPECT_EQ(tokens(R"(auto s = "a { b"; // }
+int n = 1'000'000; /* ( */ char c = '}';)"),
+              (std::vector<std::string_view>{
+                  "auto", "s", "=", R"("a { b")", ";", "int", "n", "=",
+                  "1'000'000", ";", "char", "c", "=", "'}'", ";"}));
+
+    EXPECT_EQ(tokens(R"-(x = R"x(a ) " ( b)x"; y)-"),
+              (std::vector<std::string_view>{"x", "=", R"-(R"x(a ) " ( b)x")-",
+                                             ";", "y"}));
+
+    EXPECT_EQ(tokens("std::vector<std::vector<int>> v;"),
+              (std::vector<std::string_view>{"std", "::", "vector", "<", "std",
+                                             "::", "vector", "<", "int", ">>",
+                                             "v", ";"}));
+}
+
+TEST(InputClassifierTest, ClassifiesDeclarations) {
+    EXPECT_EQ(kindOf("int x = 42;"), InputKind::Declaration);
+    EXPECT_EQ(kindOf("const std::string name = \"a\";"),
+              InputKind::Declaration);
+    EXPECT_EQ(kindOf("std::vector<std::pair<int, int>> v{{1, 2}};"),
+              InputKind::Declaration);
+    EXPECT_EQ(kindOf("struct Point { int x, y; };"), InputKind::Declaration);
+    EXPECT_EQ(kindOf("template <typename T> T twice(T v) { return v * 2; }"),
+              InputKind::Declaration);
+    EXPECT_EQ(kindOf("Foo *make(int n) { return new Foo(n); }"),
+              InputKind::Declaration);
+    EXPECT_EQ(kindOf("std::ostream &operator<<(std::ostream &, const Foo &);"),
+              InputKind::Declaration);
+    EXPECT_EQ(kindOf("using namespace std;"), InputKind::Declaration);
+    EXPECT_EQ(kindOf("// comentário\nauto f = [](int x) { return x; };"),
+              InputKind::Declaration);
+}
+
+TEST(InputClassifierTest, ClassifiesExecutableCode) {
+    EXPECT_EQ(kindOf("x = 3;"), InputKind::Statement);
+    EXPECT_EQ(kindOf("std::cout << \"int x;\" << std::endl;"),
+              InputKind::Statement);
+    EXPECT_EQ(kindOf("for (int i = 0; i < 3; ++i) { f(i); }"),
+              InputKind::Statement);
+    EXPECT_EQ(kindOf("return"), InputKind::Statement);
+    EXPECT_EQ(kindOf("v.push_back(1)"), InputKind::Expression);
+    EXPECT_EQ(kindOf("a < b"), InputKind::Expression);
+    EXPECT_EQ(kindOf("++counter"), InputKind::Expression);
+    EXPECT_EQ(kindOf("sizeof(int)"), InputKind::Expression);
+}
+
+TEST(InputClassifierTest, ClassifiesDirectives) {
+    auto include = classifyInput("#include <vector> // comentário");
+    EXPECT_EQ(include.kind, InputKind::Include);
+    EXPECT_EQ(include.includeTarget, "vector");
+    EXPECT_TRUE(include.systemInclude);
+
+    include = classifyInput("  #  include \"my header.hpp\"");
+    EXPECT_EQ(include.kind, InputKind::Include);
+    EXPECT_EQ(include.includeTarget, "my header.hpp");
+    EXPECT_FALSE(include.systemInclude);
+
+    include = classifyInput("#include vector");
+    EXPECT_EQ(include.kind, InputKind::Include);
+    EXPECT_TRUE(include.includeTarget.empty());
+
+    EXPECT_EQ(kindOf("#define N 3"), InputKind::Preprocessor);
+    EXPECT_EQ(kindOf("#include <a>\n#include <b>"), InputKind::Preprocessor);
+    EXPECT_EQ(kindOf("#include <vector>\nstd::vector<int> v;"),
+              InputKind::Declaration);
+    EXPECT_EQ(kindOf("  /* nada */ \n"), InputKind::Empty);
+}
+
+TEST(InputClassifierTest, DetectsTypeOnlyDeclarations) {
+    auto typeOnly = [](std::string_view input) {
+        return classifyInput(input).typeOnly;
+    };
+
+    EXPECT_TRUE(typeOnly("struct Point { int x, y; };"));
+    EXPECT_TRUE(typeOnly("class A;"));
+    EXPECT_TRUE(typeOnly("enum class Color : int { Red, Green };"));
+    EXPECT_TRUE(typeOnly("using Map = std::map<int, std::string>;"));
+    EXPECT_TRUE(typeOnly("typedef struct { int v; } Box;"));
+    EXPECT_TRUE(typeOnly("template <typename T> T twice(T v) { return v; }"));
+    EXPECT_TRUE(typeOnly("template <class T> struct S { T v; };\n"
+                         "static_assert(sizeof(S<int>) == 4);"));
+    EXPECT_TRUE(typeOnly(
+        "struct A { int get() const { return 1; } };\nusing B = A;"));
+
+    EXPECT_FALSE(typeOnly("int x = 1;"));
+    EXPECT_FALSE(typeOnly("struct A { int v; } a;"));
+    EXPECT_FALSE(typeOnly("struct A a;"));
+    EXPECT_FALSE(typeOnly("struct A make() { return {}; }"));
+    EXPECT_FALSE(typeOnly("struct A {};\nint f() { return 1; }"));
+    EXPECT_FALSE(typeOnly("template <> struct S<int> {};"));
+    EXPECT_FALSE(typeOnly("template class std::vector<Point>;"));
+    EXPECT_FALSE(typeOnly("namespace n { struct A {}; }"));
+    EXPECT_FALSE(typeOnly("#include <map>\nusing M = std::map<int, int>;"));
+    EXPECT_FALSE(typeOnly("struct Open {"));
+    EXPECT_FALSE(typeOnly("x = 1;"));
+}
+
+TEST(InputClassifierTest, CollectsTypeOnlyNames) {
+    using Names = std::vector<std::string_view>;
+    auto names = [](std::string_view input) {
+        return classifyInput(input).typeNames;
+    };
+
+    EXPECT_EQ(names("struct Point { int x, y; };"), Names{"Point"});
+    EXPECT_EQ(names("struct [[nodiscard]] Tag {};"), Names{"Tag"});
+    EXPECT_EQ(names("enum class Color : int { Red, Green };"),
+              Names{"Color"});
+    EXPECT_EQ(names("using Map = std::map<int, std::string>;"), Names{"Map"});
+    EXPECT_EQ(names("typedef struct { int v; } Box;"), Names{"Box"});
+    EXPECT_EQ(names("template <class T, class U = std::vector<T>>\n"
+                    "struct Pair { T a; U b; };"),
+              Names{"Pair"});
+    EXPECT_EQ(names("template <class T> using Vec = std::vector<T>;"),
+              Names{"Vec"});
+    EXPECT_EQ(names("struct A {};\nusing B = A;"), (Names{"A", "B"}));
+
+    // Só declaração, função, sem nome simples ou não é tipo
+    EXPECT_TRUE(names("class A;").empty());
+    EXPECT_TRUE(names("template <class T> struct S;").empty());
+    EXPECT_TRUE(names("template <typename T> T twice(T v) { return v; }")
+                    .empty());
+    EXPECT_TRUE(names("struct { int v; };").empty());
+    EXPECT_TRUE(names("typedef int (*Fn)(int);").empty());
+    EXPECT_TRUE(names("using namespace std;").empty());
+    EXPECT_TRUE(names("using std::string;").empty());
+    EXPECT_TRUE(names("static_assert(sizeof(int) == 4);").empty());
+    EXPECT_TRUE(names("int x = 1;").empty());
+}
+
+TEST(InputClassifierTest, DetectsIncompleteInput) {
+    EXPECT_TRUE(classifyInput("int f() { return 1; }").complete);
+    EXPECT_FALSE(classifyInput("int f() {").complete);
+    EXPECT_FALSE(classifyInput("call(1,").complete);
+    EXPECT_FALSE(classifyInput("class A").complete);
+    EXPECT_FALSE(classifyInput("template <typename T>").complete);
+    EXPECT_FALSE(classifyInput("/* aberto").complete);
+    EXPECT_FALSE(classifyInput("auto s = R\"(aberto").complete);
+    EXPECT_FALSE(classifyInput("#define F(x) \\").complete);
+    EXPECT_TRUE(classifyInput("auto s = \"{\";").complete);
+    EXPECT_TRUE(classifyInput("class A;").complete);
+}
+
+TEST(InputClassifierTest, AccumulatorJoinsLines) {
+    InputAccumulator input;
+    input.append("struct Point");
+    EXPECT_FALSE(input.complete());
+    input.append("{");
+    input.append("    int x; // }");
+    EXPECT_FALSE(input.complete());
+    input.append("    const char *s = R\"(");
+    input.append("}  }");
+    EXPECT_FALSE(input.complete());
+    input.append(")\";");
+    EXPECT_FALSE(input.complete());
+    input.append("};");
+    EXPECT_TRUE(input.complete());
+    EXPECT_EQ(input.lines(), 7u);
+
+    const std::string text = input.take();
+    EXPECT_EQ(classifyInput(text).kind, InputKind::Declaration);
+    EXPECT_TRUE(input.empty());
+    EXPECT_TRUE(input.complete());
+}
+
+TEST(InputClassifierTest, Benchmark_LongPasteIsLinear) {
+    // Bloco colado grande: uma classe com muitos membros e statements
+    std::string paste = "struct Big {\n";
+    for (int i = 0; i < 5000; ++i) {
+        paste += std::format(
+            "    std::vector<std::pair<int, std::string>> m{0}{{{{{0}, "
+            "\"{{\"}}}}; // }} {0}\n",
+            i);
+    }
+    paste += "};\n";
+
+    auto t0 = std::chrono::steady_clock::now();
+    const auto result = classifyInput(paste);
+    auto classify = std::chrono::steady_clock::now() - t0;
+
+    InputAccumulator input;
+    size_t begin = 0;
+    t0 = std::chrono::steady_clock::now();
+    while (begin < paste.size()) {
+        const size_t end = paste.find('\n', begin);
+        input.append(std::string_view(paste).substr(begin, end - begin));
+        begin = end + 1;
+    }
+    auto accumulate = std::chrono::steady_clock::now() - t0;
+
+    std::cout << std::format(
+        "{} bytes: classify {}us, line by line {}us\n", paste.size(),
+        std::chrono::duration_cast<std::chrono::microseconds>(classify)
+            .count(),
+        std::chrono::duration_cast<std::chrono::microseconds>(accumulate)
+            .count());
+
+    EXPECT_EQ(result.kind, InputKind::Declaration);
+    EXPECT_TRUE(result.complete);
+    EXPECT_TRUE(input.complete());
+
+    // Folga grande para não ficar instável em máquinas carregadas
+    EXPECT_LT(classify, std::chrono::milliseconds(500));
+    EXPECT_LT(accumulate, std::chrono::milliseconds(500));
+}
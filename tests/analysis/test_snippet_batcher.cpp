@@ -0,0 +1,91 @@
+#include "analysis/snippet_batcher.hpp"
+
+#include <gtest/gtest.h>
+#include <string>
+
+using analysis::classifyInput;
+using analysis::SnippetBatch;
+using analysis::SnippetBatcher;
+
+namespace {
+
+// Mesmo fluxo do modo script: fecha o lote quando o tipo muda
+std::vector<SnippetBatch> batchAll(
+    SnippetBatcher &batcher,
+    std::initializer_list<std::pair<std::string_view, int64_t>> blocks) {
+    std::vector<SnippetBatch> out;
+    for (const auto &[block, line] : blocks) {
+        const auto input = classifyInput(block);
+        if (!SnippetBatcher::batchable(input)) {
+            if (!batcher.empty()) {
+                out.push_back(batcher.take());
+            }
+            continue;
+        }
+        if (!batcher.accepts(input)) {
+            out.push_back(batcher.take());
+        }
+        batcher.add(block, line, input);
+    }
+    if (!batcher.empty()) {
+        out.push_back(batcher.take());
+    }
+    return out;
+}
+
+} // namespace
+
+TEST(SnippetBatcherTest, GroupsRunsOfTheSameKind) {
+    SnippetBatcher batcher("script.cpp");
+    const auto batches = batchAll(batcher, {{"int x = 1;", 1},
+                                            {"int y = 2;", 2},
+                                            {"x += y;", 4},
+                                            {"std::cout << x", 5},
+                                            {"int z = x;", 6}});
+
+    ASSERT_EQ(batches.size(), 3u);
+    EXPECT_EQ(batches[0].kind, SnippetBatch::Kind::Declarations);
+    EXPECT_EQ(batches[0].snippets, 2u);
+    EXPECT_EQ(batches[0].code, "#line 1 \"script.cpp\"\nint x = 1;\n"
+                               "#line 2 \"script.cpp\"\nint y = 2;\n");
+
+    // Declaração depois de statements abre outro lote
+    EXPECT_EQ(batches[1].kind, SnippetBatch::Kind::Statements);
+    EXPECT_EQ(batches[1].snippets, 2u);
+    EXPECT_EQ(batches[1].firstLine, 4);
+    EXPECT_EQ(batches[1].lastLine, 5);
+    EXPECT_EQ(batches[1].code, "void exec() {\n"
+                               "#line 4 \"script.cpp\"\nx += y;\n;\n"
+                               "#line 5 \"script.cpp\"\nstd::cout << x\n;\n"
+                               "}\n");
+
+    EXPECT_EQ(batches[2].kind, SnippetBatch::Kind::Declarations);
+    EXPECT_TRUE(batcher.empty());
+}
+
+TEST(SnippetBatcherTest, DirectivesAndCommandsRunAlone) {
+    SnippetBatcher batcher;
+    const auto batches = batchAll(batcher, {{"int a = 1;", 1},
+                                            {"#include <map>", 2},
+                                            {"int b = 2;", 3},
+                                            {"#help", 4},
+                                            {"a = b;", 5}});
+
+    ASSERT_EQ(batches.size(), 3u);
+    EXPECT_EQ(batches[0].snippets, 1u);
+    EXPECT_EQ(batches[1].snippets, 1u);
+    EXPECT_EQ(batches[1].code, "#line 3\nint b = 2;\n");
+    EXPECT_EQ(batches[2].kind, SnippetBatch::Kind::Statements);
+}
+
+TEST(SnippetBatcherTest, TracksMultilineBlocks) {
+    SnippetBatcher batcher;
+    const std::string block = "struct P {\n    int x; // comentário\n};";
+    batcher.add(block, 10, classifyInput(block));
+    batcher.add("P p{};", 13, classifyInput("P p{};"));
+
+    const auto batch = batcher.take();
+    EXPECT_EQ(batch.firstLine, 10);
+    EXPECT_EQ(batch.lastLine, 13);
+    EXPECT_EQ(batch.snippets, 2u);
+}
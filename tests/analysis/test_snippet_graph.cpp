@@ -0,0 +1,93 @@
+#include "analysis/snippet_graph.hpp"
+
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+
+using analysis::declaredNames;
+using analysis::SnippetGraph;
+
+using Names = std::vector<std::string>;
+
+TEST(SnippetGraphTest, DeclaredNamesAtGlobalScope) {
+    EXPECT_EQ(declaredNames("int x = 1; int y{2}, z;"), (Names{"x", "y", "z"}));
+    EXPECT_EQ(declaredNames("struct P : Base { int a; void f(); };\n"
+                            "double area(const P &p) { return p.a; }"),
+              (Names{"P", "area"}));
+    EXPECT_EQ(declaredNames("template <typename T, int N = 3>\n"
+                            "T twice(T v) { return v + v; }"),
+              (Names{"twice"}));
+    EXPECT_EQ(declaredNames("namespace geo { enum class Axis : int { X }; }\n"
+                            "using Len = double;\n"
+                            "using namespace std;\n"
+                            "std::map<int, double> table;"),
+              (Names{"Axis", "Len", "table"}));
+    EXPECT_EQ(declaredNames("extern \"C\" int c_api(int);\n"
+                            "bool operator==(const P &, const P &);\n"
+                            "typedef struct { int v; } Handle;"),
+              (Names{"c_api", "Handle"}));
+}
+
+TEST(SnippetGraphTest, ResolvesLatestProvider) {
+    SnippetGraph graph;
+    graph.record("repl_1", "struct P { int x; };", {"P"});
+    graph.record("repl_2", "int norm(P p) { return p.x; }", {"norm"});
+    graph.record("repl_3", "int twice(P p) { return 2 * norm(p); }",
+                 {"twice"});
+
+    const auto *node = graph.find("repl_3");
+    ASSERT_NE(node, nullptr);
+    EXPECT_EQ(node->dependsOn, (Names{"repl_1", "repl_2"}));
+
+    // Redefinir P deixa repl_2 e repl_3 compilados contra o P antigo
+    graph.record("repl_4", "struct P { long x; };", {"P"});
+    EXPECT_EQ(graph.providersOf("P"), (Names{"repl_1", "repl_4"}));
+    EXPECT_EQ(graph.affectedBy("P"), (Names{"repl_2", "repl_3"}));
+    EXPECT_TRUE(graph.affectedBy("twice").empty());
+
+    // Depois da redefinição, quem cita P já usa a definição nova
+    graph.record("repl_5", "P q{};", {"q"});
+    EXPECT_EQ(graph.find("repl_5")->dependsOn, (Names{"repl_4"}));
+    EXPECT_EQ(graph.affectedBy("P"), (Names{"repl_2", "repl_3"}));
+}
+
+TEST(SnippetGraphTest, ReRecordingReplacesTheNode) {
+    SnippetGraph graph;
+    graph.record("a", "int f();", {"f"});
+    graph.record("b", "int g() { return f(); }", {"g"});
+    graph.record("a", "int f() { return 1; }", {"f"});
+
+    EXPECT_EQ(graph.size(), 2u);
+    EXPECT_EQ(graph.nodes().back().unit, "a");
+    EXPECT_EQ(graph.providersOf("f"), (Names{"a"}));
+    EXPECT_EQ(graph.find("b")->dependsOn, (Names{"a"}));
+}
+
+TEST(SnippetGraphTest, ParallelWavesFollowDependencies) {
+    const std::vector<std::string> units{
+        "struct Vec { double x, y; };",
+        "int counter = 0;",
+        "double dot(Vec a, Vec b) { return a.x * b.x + a.y * b.y; }",
+        "double len(Vec v) { return dot(v, v); }",
+        "int bump() { return ++counter; }",
+    };
+
+    const auto waves = SnippetGraph::parallelWaves(units);
+    ASSERT_EQ(waves.size(), 3u);
+    EXPECT_EQ(waves[0], (std::vector<size_t>{0, 1}));
+    EXPECT_EQ(waves[1], (std::vector<size_t>{2, 4}));
+    EXPECT_EQ(waves[2], (std::vector<size_t>{3}));
+}
+
+TEST(SnippetGraphTest, CyclesCompileTogether) {
+    // Cada um declara o protótipo do outro: independentes
+    const auto prototyped = SnippetGraph::parallelWaves(
+        {"int g(); int f() { return g(); }", "int f(); int g() { return 1; }"});
+    EXPECT_EQ(prototyped.size(), 1u);
+
+    const auto cyclic = SnippetGraph::parallelWaves(
+        {"int a = b;", "int b = a;", "int c = 0;"});
+    ASSERT_EQ(cyclic.size(), 2u);
+    EXPECT_EQ(cyclic[0], (std::vector<size_t>{2}));
+    EXPECT_EQ(cyclic[1], (std::vector<size_t>{0, 1}));
+}
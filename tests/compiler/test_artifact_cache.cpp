@@ -0,0 +1,213 @@
+#include "../test_helpers/temp_directory_fixture.hpp"
+#include "analysis/ast_context.hpp"
+#include "compiler/artifact_cache.hpp"
+#include "repl.hpp"
+
+#include <fstream>
+#include <gtest/gtest.h>
+#include <thread>
+
+using namespace compiler;
+using namespace test_helpers;
+
+class ArtifactCacheTest : public TempDirectoryFixture {
+  protected:
+    void SetUp() override {
+        TempDirectoryFixture::SetUp();
+        cache = std::make_unique<ArtifactCache>(getTempDir() / "cache",
+                                                1024 * 1024);
+    }
+
+    void TearDown() override {
+        cache.reset();
+        TempDirectoryFixture::TearDown();
+    }
+
+    static ArtifactCache::Entry successEntry() {
+        ArtifactCache::Entry entry;
+        entry.success = true;
+        entry.sourceName = "repl_1.cpp";
+        entry.variables.push_back({.name = "x",
+                                   .mangledName = "x",
+                                   .type = "int",
+                                   .qualType = "std::vector<int>\nline2",
+                                   .kind = "VarDecl",
+                                   .file = "repl_1.cpp",
+                                   .line = 3});
+        analysis::CodeTracking decl;
+        decl.codeSnippet = "extern int x;\n";
+        decl.key = "var:x";
+        decl.line = -1;
+        decl.column = -1;
+        entry.snippets.push_back(decl);
+        entry.provides = {"x", "Point"};
+        return entry;
+    }
+
+    std::unique_ptr<ArtifactCache> cache;
+};
+
+// ============================================================================
+// Hashing Tests
+// ============================================================================
+
+TEST(ArtifactHasherTest, SameInput_SameKey) {
+    ArtifactHasher a;
+    ArtifactHasher b;
+    a.field("source", "int x = 1;");
+    b.field("source", "int x = 1;");
+
+    EXPECT_EQ(a.hex(), b.hex());
+    EXPECT_EQ(a.hex().size(), 32u);
+}
+
+TEST(ArtifactHasherTest, FieldBoundaries_DoNotCollide) {
+    ArtifactHasher a;
+    ArtifactHasher b;
+    a.field("f", "ab").field("f", "c");
+    b.field("f", "a").field("f", "bc");
+
+    EXPECT_NE(a.hex(), b.hex());
+}
+
+// ============================================================================
+// Lookup / Store Tests
+// ============================================================================
+
+TEST_F(ArtifactCacheTest, Lookup_EmptyCache_Miss) {
+    EXPECT_FALSE(cache->lookup("00112233445566778899aabbccddeeff", "out.so"));
+    EXPECT_EQ(cache->stats().misses, 1u);
+}
+
+TEST_F(ArtifactCacheTest, StoreThenLookup_RestoresLibraryAndMetadata) {
+    createFile("libsrc.so", "fake library contents");
+    const std::string key = "0123456789abcdef0123456789abcdef";
+
+    ASSERT_TRUE(cache->store(key, successEntry(), "libsrc.so"));
+
+    auto hit = cache->lookup(key, "librestored.so");
+    ASSERT_TRUE(hit.has_value());
+    EXPECT_TRUE(hit->success);
+    EXPECT_EQ(hit->sourceName, "repl_1.cpp");
+    ASSERT_EQ(hit->variables.size(), 1u);
+    EXPECT_EQ(hit->variables[0].qualType, "std::vector<int>\nline2");
+    EXPECT_EQ(hit->variables[0].line, 3);
+    ASSERT_EQ(hit->snippets.size(), 1u);
+    EXPECT_EQ(hit->snippets[0].codeSnippet, "extern int x;\n");
+    EXPECT_EQ(hit->snippets[0].key, "var:x");
+    EXPECT_EQ(hit->provides, (std::vector<std::string>{"x", "Point"}));
+
+    std::ifstream restored("librestored.so");
+    std::string contents((std::istreambuf_iterator<char>(restored)),
+                         std::istreambuf_iterator<char>());
+    EXPECT_EQ(contents, "fake library contents");
+    EXPECT_EQ(cache->stats().hits, 1u);
+}
+
+TEST_F(ArtifactCacheTest, StoreFailure_ReplaysDiagnostics) {
+    ArtifactCache::Entry entry;
+    entry.sourceName = "repl_2.cpp";
+    entry.diagnostics = "repl_2.cpp:3:1: error: expected ';'";
+    const std::string key = "fedcba9876543210fedcba9876543210";
+
+    ASSERT_TRUE(cache->store(key, entry, {}));
+
+    auto hit = cache->lookup(key, "libunused.so");
+    ASSERT_TRUE(hit.has_value());
+    EXPECT_FALSE(hit->success);
+    EXPECT_EQ(hit->diagnostics, entry.diagnostics);
+    EXPECT_FALSE(std::filesystem::exists("libunused.so"));
+    EXPECT_EQ(cache->stats().failureHits, 1u);
+}
+
+TEST_F(ArtifactCacheTest, ChangedIncludedHeader_MovesToAVariant) {
+    createFile("libsrc.so", "payload");
+    const auto header = (getTempDir() / "point.hpp").string();
+    std::ofstream(header) << "struct Point { int x; };\n";
+
+    auto entry = successEntry();
+    entry.dependencies = {header};
+    const std::string key = "cccccccccccccccccccccccccccccccc";
+    ASSERT_TRUE(cache->store(key, entry, "libsrc.so"));
+    EXPECT_TRUE(cache->lookup(key, "libout.so"));
+
+    // Header editado: a entrada antiga não serve mais
+    std::ofstream(header) << "struct Point { int x, y; };\n";
+    std::string variant;
+    EXPECT_FALSE(cache->lookup(key, "libout.so", &variant));
+    ASSERT_FALSE(variant.empty());
+    EXPECT_NE(variant, key);
+
+    ASSERT_TRUE(cache->store(variant, entry, "libsrc.so"));
+    EXPECT_TRUE(cache->lookup(key, "libout.so"));
+
+    // De volta ao conteúdo original: a primeira entrada vale de novo
+    std::ofstream(header) << "struct Point { int x; };\n";
+    std::string missKey;
+    EXPECT_TRUE(cache->lookup(key, "libout.so", &missKey));
+    EXPECT_TRUE(missKey.empty());
+}
+
+TEST(DependencyListTest, ParseDepFile_HandlesContinuationsAndEscapes) {
+    EXPECT_EQ(parseDepFile("out.o: repl_1.cpp \\\n /a/my\\ b.hpp $$c.hpp\n"
+                           "other: ignored.hpp\n"),
+              (std::vector<std::string>{"repl_1.cpp", "/a/my b.hpp",
+                                        "$c.hpp"}));
+}
+
+TEST_F(ArtifactCacheTest, ConcurrentStoreSameKey_OneEntryWins) {
+    createFile("libsrc.so", "payload");
+    const std::string key = "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa";
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 4; ++i) {
+        threads.emplace_back(
+            [&] { EXPECT_TRUE(cache->store(key, successEntry(), "libsrc.so")); });
+    }
+    for (auto &t : threads) {
+        t.join();
+    }
+
+    EXPECT_TRUE(cache->lookup(key, "libout.so").has_value());
+    EXPECT_TRUE(std::filesystem::is_empty(getTempDir() / "cache" / "tmp"));
+}
+
+// ============================================================================
+// Eviction Tests
+// ============================================================================
+
+TEST_F(ArtifactCacheTest, EvictToLimit_RemovesLeastRecentlyUsed) {
+    cache = std::make_unique<ArtifactCache>(getTempDir() / "cache", 64 * 1024);
+    createFile("libbig.so", std::string(25 * 1024, 'x'));
+
+    const std::string oldKey = "10000000000000000000000000000000";
+    const std::string newKey = "20000000000000000000000000000000";
+    ASSERT_TRUE(cache->store(oldKey, successEntry(), "libbig.so"));
+    ASSERT_TRUE(cache->store(newKey, successEntry(), "libbig.so"));
+
+    // Torna a primeira entrada a mais antiga e usa a segunda
+    std::filesystem::last_write_time(
+        getTempDir() / "cache" / "objects" / "10" / oldKey / "meta",
+        std::filesystem::file_time_type::clock::now() - std::chrono::hours(1));
+    ASSERT_TRUE(cache->lookup(newKey, "libout.so"));
+
+    // Terceira entrada ultrapassa o limite e dispara o despejo
+    ASSERT_TRUE(cache->store("30000000000000000000000000000000",
+                             successEntry(), "libbig.so"));
+
+    EXPECT_FALSE(cache->lookup(oldKey, "libout.so"));
+    EXPECT_TRUE(cache->lookup(newKey, "libout.so"));
+    EXPECT_LE(cache->diskUsage(), 64u * 1024u);
+    EXPECT_GE(cache->stats().evictions, 1u);
+}
+
+TEST_F(ArtifactCacheTest, Clear_RemovesAllEntries) {
+    createFile("libsrc.so", "payload");
+    const std::string key = "bbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbb";
+    ASSERT_TRUE(cache->store(key, successEntry(), "libsrc.so"));
+
+    cache->clear();
+
+    EXPECT_FALSE(cache->lookup(key, "libout.so"));
+    EXPECT_EQ(cache->diskUsage(), 0u);
+}
@@ -2,6 +2,8 @@
 #include "../test_helpers/temp_directory_fixture.hpp"
 #include "analysis/ast_context.hpp"
 #include "compiler/compiler_service.hpp"
+#include "compiler/inprocess_backend.hpp"
+#include "execution/workspace.hpp"
 #include "repl.hpp"
 
 #include <cstdlib>
@@ -230,6 +232,20 @@ TEST_F(CompilerServiceTest,
     }
 }
 
+TEST_F(CompilerServiceTest, BuildLibraryWithAST_SimpleFile_Success) {
+    createTestFileForAST("astlib.cpp", "int ast_lib_var = 7;");
+
+    auto result = compilerService->buildLibraryWithAST("clang++", "astlib",
+                                                       ".cpp", "gnu++20");
+
+    EXPECT_TRUE(result.success()) << "Build + AST analysis should succeed";
+    EXPECT_TRUE(
+        std::filesystem::exists(execution::artifactPath("libastlib.so")));
+    if (result.success()) {
+        EXPECT_EQ(capturedVars.size(), result.value.size());
+    }
+}
+
 // ============================================================================
 // Color Support Tests
 // ============================================================================
@@ -360,3 +376,72 @@ TEST_F(CompilerServiceTest, IncludeExists) {
     EXPECT_FALSE(compilerService->checkIncludeExists(
         *buildSettings, "non_existing_include.hpp"));
 }
+
+TEST_F(CompilerServiceTest, ArtifactKeyForText_DependsOnTheSourceText) {
+    const std::string f = "void exec() { f(); }\n";
+    const std::string g = "void exec() { g(); }\n";
+
+    EXPECT_EQ(compilerService->artifactKeyForText("clang++", "gnu++20", f),
+              compilerService->artifactKeyForText("clang++", "gnu++20", f));
+    EXPECT_NE(compilerService->artifactKeyForText("clang++", "gnu++20", f),
+              compilerService->artifactKeyForText("clang++", "gnu++20", g));
+
+    // O mesmo texto em disco dá a mesma chave que em memória
+    createFile("spec.cpp", f);
+    EXPECT_EQ(compilerService->artifactKey("clang++", "gnu++20", "spec.cpp"),
+              compilerService->artifactKeyForText("clang++", "gnu++20", f));
+}
+
+TEST_F(CompilerServiceTest, PchIncludeFlags_TextualUntilALayerExists) {
+    // Nenhuma camada gerada ainda: não aponta para um .pch inexistente
+    EXPECT_EQ(compilerService->pchIncludeFlags(),
+              "-include precompiledheader.hpp");
+}
+
+// ============================================================================
+// In-process Backend Tests
+// ============================================================================
+
+TEST_F(CompilerServiceTest, SetBackend_DefaultsToExternal) {
+    EXPECT_EQ(compilerService->backend(), CompilerBackend::External);
+    EXPECT_FALSE(compilerService->usingInProcessBackend());
+}
+
+TEST_F(CompilerServiceTest, SetBackend_InProcess_MatchesAvailability) {
+    bool ok = compilerService->setBackend(CompilerBackend::InProcess);
+
+    EXPECT_EQ(ok, InProcessClangBackend::isAvailable());
+    EXPECT_EQ(compilerService->usingInProcessBackend(), ok);
+
+    compilerService->setBackend(CompilerBackend::External);
+    EXPECT_FALSE(compilerService->usingInProcessBackend());
+}
+
+TEST_F(CompilerServiceTest, BuildLibraryOnly_InProcess_Success) {
+    if (!compilerService->setBackend(CompilerBackend::InProcess)) {
+        GTEST_SKIP() << "In-process backend not available in this build";
+    }
+
+    createSimpleTestFile("inprocsimple.cpp", "int inproc_var = 42;");
+
+    auto result = compilerService->buildLibraryOnly("clang++", "inproc",
+                                                    "simple.cpp", "gnu++20");
+
+    EXPECT_TRUE(result.success()) << "In-process compilation should succeed";
+    EXPECT_TRUE(
+        std::filesystem::exists(execution::artifactPath("libinproc.so")));
+}
+
+TEST_F(CompilerServiceTest, BuildLibraryOnly_InProcessSyntaxError_Failure) {
+    if (!compilerService->setBackend(CompilerBackend::InProcess)) {
+        GTEST_SKIP() << "In-process backend not available in this build";
+    }
+
+    createSimpleTestFile("inprocinvalid.cpp", "int invalid syntax here;");
+
+    auto result = compilerService->buildLibraryOnly("clang++", "inproc",
+                                                    "invalid.cpp", "gnu++20");
+
+    EXPECT_FALSE(result.success());
+    EXPECT_EQ(result.error, CompilerError::BuildFailed);
+}
@@ -0,0 +1,160 @@
+#include "compiler/pch_layers.hpp"
+
+#include <gtest/gtest.h>
+
+using namespace compiler;
+
+namespace {
+
+const std::string kPreamble = "extern int preamble;\n";
+
+PchLayerStack::Plan planAndCommit(PchLayerStack &stack,
+                                  const std::vector<PchLayerStack::Include> &inc) {
+    auto plan = stack.plan(inc);
+    EXPECT_TRUE(stack.commit(plan));
+    return plan;
+}
+
+} // namespace
+
+// ============================================================================
+// Planning Tests
+// ============================================================================
+
+TEST(PchLayerStackTest, FirstBuild_CreatesBaseLayerWithPreamble) {
+    PchLayerStack stack(kPreamble);
+
+    auto plan = planAndCommit(stack, {{"vector", true}});
+
+    EXPECT_EQ(plan.kind, PchLayerStack::Plan::Kind::Rebuild);
+    EXPECT_TRUE(plan.parentPch.empty());
+    auto source = stack.layerSource(plan.layer);
+    EXPECT_NE(source.find(kPreamble), std::string::npos);
+    EXPECT_NE(source.find("#include <vector>"), std::string::npos);
+    EXPECT_EQ(stack.topPch(), plan.layer.pch());
+}
+
+TEST(PchLayerStackTest, NewInclude_AppendsLayerChainedOnTop) {
+    PchLayerStack stack(kPreamble);
+    auto base = planAndCommit(stack, {{"vector", true}});
+
+    auto plan = stack.plan({{"vector", true}, {"my.hpp", false}});
+
+    ASSERT_EQ(plan.kind, PchLayerStack::Plan::Kind::Append);
+    EXPECT_EQ(plan.parentPch, base.layer.pch());
+    ASSERT_EQ(plan.layer.includes.size(), 1u);
+    EXPECT_EQ(plan.layer.includes[0].first, "my.hpp");
+
+    auto source = stack.layerSource(plan.layer);
+    EXPECT_EQ(source.find(kPreamble), std::string::npos);
+    EXPECT_EQ(source.find("<vector>"), std::string::npos);
+
+    ASSERT_TRUE(stack.commit(plan));
+    EXPECT_EQ(stack.depth(), 2u);
+    EXPECT_NE(stack.indexSource().find(base.layer.header()),
+              std::string::npos);
+    EXPECT_NE(stack.indexSource().find(plan.layer.header()),
+              std::string::npos);
+}
+
+TEST(PchLayerStackTest, SameIncludes_UpToDate) {
+    PchLayerStack stack(kPreamble);
+    planAndCommit(stack, {{"vector", true}});
+
+    EXPECT_EQ(stack.plan({{"vector", true}}).kind,
+              PchLayerStack::Plan::Kind::UpToDate);
+}
+
+TEST(PchLayerStackTest, IncludesNotAnExtension_RebuildsBase) {
+    PchLayerStack stack(kPreamble);
+    planAndCommit(stack, {{"vector", true}, {"map", true}});
+
+    auto plan = stack.plan({{"map", true}});
+
+    EXPECT_EQ(plan.kind, PchLayerStack::Plan::Kind::Rebuild);
+    EXPECT_TRUE(plan.layer.base);
+}
+
+// ============================================================================
+// Flattening Tests
+// ============================================================================
+
+TEST(PchLayerStackTest, Flatten_ReplacesLayersAndKeepsContent) {
+    PchLayerStack stack(kPreamble, 2);
+    std::vector<PchLayerStack::Include> inc;
+    for (const char *h : {"vector", "map", "set"}) {
+        inc.emplace_back(h, true);
+        planAndCommit(stack, inc);
+    }
+    ASSERT_TRUE(stack.needsFlatten());
+    const auto combined = stack.combinedSource();
+
+    auto flat = stack.planFlatten();
+    ASSERT_EQ(flat.kind, PchLayerStack::Plan::Kind::Rebuild);
+    ASSERT_TRUE(stack.commit(flat));
+
+    EXPECT_EQ(stack.depth(), 1u);
+    EXPECT_EQ(stack.topPch(), flat.layer.pch());
+    EXPECT_EQ(stack.combinedSource(), combined);
+
+    // Camadas antigas só são liberadas no commit seguinte
+    EXPECT_TRUE(stack.takeRetired().empty());
+    auto rebuilt = stack.plan({{"list", true}});
+    ASSERT_TRUE(stack.commit(rebuilt));
+    EXPECT_EQ(stack.takeRetired().size(), 3u);
+}
+
+TEST(PchLayerStackTest, Flatten_DiscardedWhenStackChanged) {
+    PchLayerStack stack(kPreamble, 1);
+    planAndCommit(stack, {{"vector", true}});
+    planAndCommit(stack, {{"vector", true}, {"map", true}});
+
+    auto flat = stack.planFlatten();
+    planAndCommit(stack, {{"vector", true}, {"map", true}, {"set", true}});
+
+    EXPECT_FALSE(stack.commit(flat));
+    EXPECT_EQ(stack.depth(), 3u);
+}
+
+// ============================================================================
+// Session Declarations
+// ============================================================================
+
+TEST(PchLayerStackTest, Declarations_AppendLayerAndSurviveFlatten) {
+    PchLayerStack stack(kPreamble);
+    auto base = planAndCommit(stack, {{"vector", true}});
+
+    EXPECT_EQ(stack.planDeclarations("").kind,
+              PchLayerStack::Plan::Kind::UpToDate);
+    auto decls = stack.planDeclarations("extern int x;\n");
+    ASSERT_EQ(decls.kind, PchLayerStack::Plan::Kind::Append);
+    EXPECT_EQ(decls.parentPch, base.layer.pch());
+    ASSERT_TRUE(stack.commit(decls));
+    EXPECT_NE(stack.layerSource(decls.layer).find("extern int x;"),
+              std::string::npos);
+    EXPECT_EQ(stack.declarationBytes(), 14u);
+
+    // Include depois das declarações: camada nova, declarações continuam
+    auto more = planAndCommit(stack, {{"vector", true}, {"map", true}});
+    EXPECT_EQ(more.kind, PchLayerStack::Plan::Kind::Append);
+    EXPECT_EQ(stack.combinedSource(), kPreamble + "#include <vector>\n"
+                                                  "#include <map>\n"
+                                                  "extern int x;\n");
+
+    auto flat = stack.planFlatten();
+    EXPECT_EQ(flat.layer.declarations, "extern int x;\n");
+    ASSERT_TRUE(stack.commit(flat));
+    EXPECT_EQ(stack.declarationBytes(), 14u);
+
+    // Reconstrução por includes que não estendem a pilha também as leva
+    auto rebuilt = planAndCommit(stack, {{"set", true}});
+    EXPECT_EQ(rebuilt.kind, PchLayerStack::Plan::Kind::Rebuild);
+    EXPECT_EQ(rebuilt.layer.declarations, "extern int x;\n");
+}
+
+TEST(PchLayerStackTest, Declarations_NeedABaseLayer) {
+    PchLayerStack stack(kPreamble);
+    EXPECT_EQ(stack.planDeclarations("extern int x;\n").kind,
+              PchLayerStack::Plan::Kind::UpToDate);
+    EXPECT_EQ(stack.topId(), 0u);
+}
@@ -0,0 +1,102 @@
+#include "../test_helpers/temp_directory_fixture.hpp"
+#include "compiler/pch_store.hpp"
+
+#include <fstream>
+#include <gtest/gtest.h>
+
+using namespace compiler;
+using namespace test_helpers;
+
+class PchStoreTest : public TempDirectoryFixture {
+  protected:
+    void SetUp() override {
+        TempDirectoryFixture::SetUp();
+        store = std::make_unique<PchStore>(getTempDir() / "pch", 1024 * 1024);
+    }
+
+    void TearDown() override {
+        store.reset();
+        TempDirectoryFixture::TearDown();
+    }
+
+    // Simula a geração de um PCH dentro de uma entrada
+    std::filesystem::path addEntry(std::string_view family,
+                                   const std::string &key, size_t size) {
+        auto dir = store->prepare(family, key);
+        EXPECT_FALSE(dir.empty());
+        EXPECT_TRUE(PchStore::writeFile(dir / "layer.hpp", "#pragma once\n"));
+        auto built = store->tempPathFor(dir / "layer.hpp.pch");
+        std::ofstream(built) << std::string(size, 'p');
+        EXPECT_TRUE(store->publish(built, dir / "layer.hpp.pch"));
+        return dir;
+    }
+
+    std::unique_ptr<PchStore> store;
+};
+
+TEST_F(PchStoreTest, Lookup_IncompleteEntry_Miss) {
+    auto dir = store->prepare("gnu++20", "aaaa");
+    ASSERT_FALSE(dir.empty());
+    ASSERT_TRUE(PchStore::writeFile(dir / "layer.hpp", "#pragma once\n"));
+
+    // Sem o .pch publicado a entrada ainda não vale
+    EXPECT_TRUE(store->lookup("gnu++20", "aaaa", "layer.hpp.pch").empty());
+    EXPECT_EQ(store->stats().misses, 1u);
+}
+
+TEST_F(PchStoreTest, PublishThenLookup_Hit) {
+    auto dir = addEntry("gnu++20", "bbbb", 16);
+
+    EXPECT_EQ(store->lookup("gnu++20", "bbbb", "layer.hpp.pch"), dir);
+    EXPECT_EQ(store->stats().hits, 1u);
+    EXPECT_EQ(store->entryCount(), 1u);
+}
+
+TEST_F(PchStoreTest, Families_AreSeparate) {
+    addEntry("gnu++20", "cccc", 16);
+
+    EXPECT_TRUE(store->lookup("c", "cccc", "layer.hpp.pch").empty());
+    EXPECT_FALSE(store->lookup("gnu++20", "cccc", "layer.hpp.pch").empty());
+}
+
+TEST_F(PchStoreTest, EvictToLimit_KeepsRecentlyUsedEntries) {
+    store = std::make_unique<PchStore>(getTempDir() / "pch", 64 * 1024);
+    auto old = addEntry("gnu++20", "1111", 40 * 1024);
+    auto recent = addEntry("gnu++20", "2222", 40 * 1024);
+
+    std::filesystem::last_write_time(
+        old, std::filesystem::file_time_type::clock::now() -
+                 std::chrono::hours(2));
+
+    EXPECT_EQ(store->evictToLimit(), 1u);
+    EXPECT_FALSE(std::filesystem::exists(old));
+    EXPECT_TRUE(std::filesystem::exists(recent));
+}
+
+TEST_F(PchStoreTest, ChangedIndirectHeader_MovesToAVariant) {
+    const auto inner = getTempDir() / "my inner.hpp";
+    std::ofstream(inner) << "struct A {};\n";
+    std::ofstream(getTempDir() / "layer.d")
+        << "layer.hpp.pch: layer.hpp \\\n " << getTempDir().string()
+        << "/my\\ inner.hpp\n";
+
+    auto dir = addEntry("gnu++20", "dddd", 16);
+    ASSERT_TRUE(PchStore::recordDeps(dir, getTempDir() / "layer.d"));
+    EXPECT_EQ(store->lookup("gnu++20", "dddd", "layer.hpp.pch"), dir);
+
+    // Header indireto editado: a entrada antiga não serve mais
+    std::ofstream(inner) << "struct A { int x; };\n";
+    std::string variant;
+    EXPECT_TRUE(
+        store->lookup("gnu++20", "dddd", "layer.hpp.pch", &variant).empty());
+    ASSERT_FALSE(variant.empty());
+    EXPECT_NE(variant, "dddd");
+
+    auto variantDir = addEntry("gnu++20", variant, 16);
+    ASSERT_TRUE(PchStore::recordDeps(variantDir, getTempDir() / "layer.d"));
+    EXPECT_EQ(store->lookup("gnu++20", "dddd", "layer.hpp.pch"), variantDir);
+
+    // De volta ao conteúdo original: a primeira entrada vale de novo
+    std::ofstream(inner) << "struct A {};\n";
+    EXPECT_EQ(store->lookup("gnu++20", "dddd", "layer.hpp.pch"), dir);
+}
@@ -0,0 +1,132 @@
+#include "execution/cancellation.hpp"
+#include "execution/process_launcher.hpp"
+
+#include <cerrno>
+#include <chrono>
+#include <gtest/gtest.h>
+#include <thread>
+#include <vector>
+
+using execution::CancellationToken;
+using execution::EvalCancellationScope;
+
+TEST(CancellationTest, DefaultTokenIsInert) {
+    CancellationToken token;
+    EXPECT_FALSE(token.cancellable());
+    token.cancel();
+    EXPECT_FALSE(token.cancelled());
+}
+
+TEST(CancellationTest, CancelReachesChildrenNotParent) {
+    auto root = CancellationToken::create();
+    auto build = root.child();
+    auto job = build.child();
+    auto sibling = build.child();
+
+    job.cancel();
+    EXPECT_TRUE(job.cancelled());
+    EXPECT_FALSE(sibling.cancelled());
+    EXPECT_FALSE(build.cancelled());
+
+    root.cancel();
+    EXPECT_TRUE(sibling.cancelled());
+    EXPECT_TRUE(build.cancelled());
+}
+
+TEST(CancellationTest, PreCancelledTokenDoesNotSpawn) {
+    auto token = CancellationToken::create();
+    token.cancel();
+
+    auto res = execution::runProcess({"true"}, {.cancel = token});
+    EXPECT_TRUE(res.cancelled);
+    EXPECT_EQ(res.spawnError, ECANCELED);
+}
+
+TEST(CancellationTest, CancelKillsRunningProcess) {
+    auto root = CancellationToken::create();
+    auto job = root.child();
+
+    std::thread canceller([&] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        root.cancel(); // o processo está registrado no filho
+    });
+
+    const auto start = std::chrono::steady_clock::now();
+    auto res = execution::runProcess({"sleep", "10"}, {.cancel = job});
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    canceller.join();
+
+    if (res.spawnError != 0) {
+        GTEST_SKIP() << "sleep not available";
+    }
+    EXPECT_TRUE(res.cancelled);
+    EXPECT_FALSE(res.success());
+    EXPECT_LT(elapsed, std::chrono::seconds(5));
+}
+
+TEST(CancellationTest, ScopeTracksCurrentEval) {
+    EXPECT_FALSE(execution::currentEvalToken().cancellable());
+    EXPECT_FALSE(execution::cancelCurrentEval());
+
+    {
+        EvalCancellationScope outer;
+        EXPECT_TRUE(execution::currentEvalToken().cancellable());
+
+        {
+            EvalCancellationScope inner;
+            EXPECT_TRUE(execution::cancelCurrentEval());
+            EXPECT_TRUE(inner.cancelled());
+            EXPECT_FALSE(outer.cancelled());
+        }
+
+        // Ctrl-C no escopo externo alcança quem pegou o token antes
+        auto token = execution::currentEvalToken();
+        EXPECT_TRUE(execution::cancelCurrentEval());
+        EXPECT_TRUE(outer.cancelled());
+        EXPECT_TRUE(token.cancelled());
+    }
+
+    EXPECT_FALSE(execution::currentEvalToken().cancellable());
+}
+
+TEST(CancellationTest, FullTablesAreReported) {
+    auto root = CancellationToken::create();
+    auto job = root.child();
+
+    // pgid/fd fictícios: nada é cancelado, então nunca são usados
+    std::vector<CancellationToken::ProcessGroup> groups;
+    for (pid_t pgid = 1; groups.empty() || groups.back().registered();
+         ++pgid) {
+        groups.push_back(root.track(0x7fff0000 + pgid));
+    }
+    EXPECT_FALSE(groups.back().registered());
+    EXPECT_FALSE(job.track(0x7ffffff0).registered());
+
+    groups.front().reset();
+    EXPECT_TRUE(job.track(0x7ffffff0).registered());
+
+    std::vector<CancellationToken::Wakeup> wakeups;
+    for (int fd = 1000; wakeups.empty() || wakeups.back().registered();
+         ++fd) {
+        wakeups.push_back(root.watch(fd));
+    }
+    EXPECT_FALSE(job.watch(999).registered());
+}
+
+TEST(CancellationTest, ScopeFromAnotherThreadDoesNotReplaceCurrent) {
+    EvalCancellationScope outer;
+
+    std::thread worker([&] {
+        EvalCancellationScope task;
+        // Ctrl-C ainda vai para o escopo da thread dona, e o da tarefa é
+        // filho dele
+        EXPECT_TRUE(execution::cancelCurrentEval());
+        EXPECT_TRUE(outer.cancelled());
+        EXPECT_TRUE(task.cancelled());
+    });
+    worker.join();
+
+    // A saída do escopo da outra thread não desfez o ativo
+    EXPECT_TRUE(execution::currentEvalToken().cancelled());
+    EXPECT_TRUE(execution::cancelCurrentEval());
+}
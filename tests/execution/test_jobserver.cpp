@@ -0,0 +1,250 @@
+#include "execution/jobserver.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <format>
+#include <gtest/gtest.h>
+#include <optional>
+#include <string>
+#include <thread>
+#include <unistd.h>
+
+using execution::Jobserver;
+
+namespace {
+
+class JobserverServeTest : public ::testing::Test {
+  protected:
+    void SetUp() override {
+        dir_ = std::filesystem::temp_directory_path() /
+               std::format("cpprepl-jobserver-test-{}", ::getpid());
+        std::filesystem::create_directories(dir_);
+        savedMakeflags_ = std::getenv("MAKEFLAGS") != nullptr
+                              ? std::optional<std::string>(
+                                    std::getenv("MAKEFLAGS"))
+                              : std::nullopt;
+    }
+
+    void TearDown() override {
+        // serve() exporta MAKEFLAGS para os filhos
+        if (savedMakeflags_) {
+            ::setenv("MAKEFLAGS", savedMakeflags_->c_str(), 1);
+        } else {
+            ::unsetenv("MAKEFLAGS");
+        }
+        std::error_code ec;
+        std::filesystem::remove_all(dir_, ec);
+    }
+
+    std::filesystem::path dir_;
+    std::optional<std::string> savedMakeflags_;
+};
+
+} // namespace
+
+TEST(JobserverTest, ParsesFifoAuth) {
+    auto auth = Jobserver::parseMakeflags(
+        " -j8 --jobserver-auth=fifo:/tmp/GMfifo123 -- CC=clang");
+    ASSERT_TRUE(auth.has_value());
+    EXPECT_EQ(auth->fifo, "/tmp/GMfifo123");
+    EXPECT_EQ(auth->jobs, 8u);
+}
+
+TEST(JobserverTest, ParsesPipeAuthAndLegacyFlag) {
+    auto auth = Jobserver::parseMakeflags("-j4 --jobserver-auth=3,4");
+    ASSERT_TRUE(auth.has_value());
+    EXPECT_TRUE(auth->fifo.empty());
+    EXPECT_EQ(auth->readFd, 3);
+    EXPECT_EQ(auth->writeFd, 4);
+
+    auto legacy = Jobserver::parseMakeflags("--jobserver-fds=5,6 -j");
+    ASSERT_TRUE(legacy.has_value());
+    EXPECT_EQ(legacy->readFd, 5);
+    EXPECT_EQ(legacy->jobs, 0u);
+}
+
+TEST(JobserverTest, IgnoresMissingOrInvalidAuth) {
+    EXPECT_FALSE(Jobserver::parseMakeflags("").has_value());
+    EXPECT_FALSE(Jobserver::parseMakeflags("-j8 -k").has_value());
+    EXPECT_FALSE(Jobserver::parseMakeflags("--jobserver-auth=x,y"));
+    // Depois de "--" só há variáveis
+    EXPECT_FALSE(Jobserver::parseMakeflags("-- --jobserver-auth=3,4"));
+}
+
+TEST(JobserverTest, ClientWithClosedDescriptorsStaysDisabled) {
+    Jobserver client("-j4 --jobserver-auth=900,901");
+    EXPECT_EQ(client.mode(), Jobserver::Mode::Disabled);
+    EXPECT_FALSE(client.acquire().valid());
+}
+
+TEST(JobserverTest, ClientUsesInheritedPipe) {
+    int fds[2];
+    ASSERT_EQ(::pipe(fds), 0);
+    ASSERT_EQ(::write(fds[1], "+", 1), 1);
+
+    {
+        Jobserver client(
+            std::format("-j2 --jobserver-auth={},{}", fds[0], fds[1]));
+        ASSERT_EQ(client.mode(), Jobserver::Mode::Client);
+        EXPECT_EQ(client.limit(), 2u);
+
+        auto implicit = client.acquire();
+        auto fromPipe = client.acquire();
+        EXPECT_TRUE(implicit.implicit());
+        EXPECT_TRUE(fromPipe.valid());
+        EXPECT_FALSE(fromPipe.implicit());
+    }
+
+    // O token lido voltou para o make
+    char byte = 0;
+    EXPECT_EQ(::read(fds[0], &byte, 1), 1);
+    EXPECT_EQ(byte, '+');
+    ::close(fds[0]);
+    ::close(fds[1]);
+}
+
+TEST_F(JobserverServeTest, ServerTokensBoundChildClients) {
+    Jobserver server("");
+    ASSERT_TRUE(server.serve(3, dir_));
+    EXPECT_EQ(server.mode(), Jobserver::Mode::Server);
+    EXPECT_EQ(std::getenv("MAKEFLAGS"), server.makeflags());
+
+    // Um filho (outro processo, aqui outra instância) vê só os tokens do
+    // fifo, mais o próprio implícito
+    Jobserver child(server.makeflags());
+    ASSERT_EQ(child.mode(), Jobserver::Mode::Client);
+    EXPECT_EQ(child.limit(), 3u);
+
+    auto implicit = child.acquire();
+    auto first = child.acquire();
+    auto second = child.acquire();
+
+    std::atomic<bool> acquired{false};
+    std::thread waiter([&] {
+        auto third = child.acquire();
+        acquired = true;
+    });
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    EXPECT_FALSE(acquired.load());
+
+    first.release();
+    waiter.join();
+    EXPECT_TRUE(acquired.load());
+}
+
+TEST(JobserverTest, ImplicitReleaseWakesABlockedWaiter) {
+    int fds[2];
+    ASSERT_EQ(::pipe(fds), 0);
+
+    {
+        // Pipe vazio: só o token implícito circula
+        Jobserver client(
+            std::format("-j1 --jobserver-auth={},{}", fds[0], fds[1]));
+        ASSERT_EQ(client.mode(), Jobserver::Mode::Client);
+        auto implicit = client.acquire();
+        ASSERT_TRUE(implicit.implicit());
+
+        std::atomic<bool> acquired{false};
+        std::thread waiter([&] {
+            auto next = client.acquire();
+            EXPECT_TRUE(next.implicit());
+            acquired = true;
+        });
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        EXPECT_FALSE(acquired.load());
+
+        implicit.release();
+        waiter.join();
+        EXPECT_TRUE(acquired.load());
+    }
+    ::close(fds[0]);
+    ::close(fds[1]);
+}
+
+TEST(JobserverTest, CancellationInterruptsTheWait) {
+    int fds[2];
+    ASSERT_EQ(::pipe(fds), 0);
+
+    {
+        Jobserver client(
+            std::format("-j1 --jobserver-auth={},{}", fds[0], fds[1]));
+        auto implicit = client.acquire();
+
+        const auto cancel = execution::CancellationToken::create();
+        std::atomic<bool> returned{false};
+        std::thread waiter([&] {
+            auto token = client.acquire(cancel.child());
+            EXPECT_FALSE(token.valid());
+            returned = true;
+        });
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        EXPECT_FALSE(returned.load());
+
+        cancel.cancel();
+        waiter.join();
+        EXPECT_TRUE(returned.load());
+
+        // Já cancelado: nem espera
+        EXPECT_FALSE(client.acquire(cancel).valid());
+    }
+    ::close(fds[0]);
+    ::close(fds[1]);
+}
+
+TEST_F(JobserverServeTest, ShrinkDrainsFreeTokens) {
+    Jobserver server("");
+    ASSERT_TRUE(server.serve(3, dir_));
+    ASSERT_TRUE(server.serve(1, dir_));
+    EXPECT_EQ(server.limit(), 1u);
+
+    Jobserver child(server.makeflags());
+    ASSERT_EQ(child.mode(), Jobserver::Mode::Client);
+    auto implicit = child.acquire();
+
+    std::atomic<bool> acquired{false};
+    std::thread waiter([&] {
+        auto extra = child.acquire();
+        acquired = true;
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    EXPECT_FALSE(acquired.load());
+
+    // Crescer de novo libera quem esperava
+    ASSERT_TRUE(server.serve(2, dir_));
+    waiter.join();
+    EXPECT_TRUE(acquired.load());
+}
+
+TEST_F(JobserverServeTest, ShrinkRetiresTokensInUse) {
+    Jobserver server("");
+    ASSERT_TRUE(server.serve(3, dir_));
+
+    auto implicit = server.acquire();
+    auto first = server.acquire();
+    auto second = server.acquire();
+
+    ASSERT_TRUE(server.serve(2, dir_));
+    first.release();
+    second.release(); // um dos dois sai de circulação
+
+    auto again = server.acquire();
+    EXPECT_TRUE(again.valid());
+    EXPECT_FALSE(again.implicit());
+
+    std::atomic<bool> acquired{false};
+    std::thread waiter([&] {
+        auto extra = server.acquire();
+        acquired = true;
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    EXPECT_FALSE(acquired.load());
+
+    again.release();
+    waiter.join();
+    EXPECT_TRUE(acquired.load());
+}
@@ -0,0 +1,122 @@
+#include "execution/memory_admission.hpp"
+#include "execution/process_launcher.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <gtest/gtest.h>
+#include <thread>
+
+using execution::JobKind;
+using execution::MemoryAdmission;
+
+namespace {
+
+constexpr uint64_t kMiB = 1024ull * 1024ull;
+
+// Memória disponível controlada pelo teste
+struct FakeMemory {
+    std::atomic<uint64_t> available{0};
+
+    MemoryAdmission::Probe probe() {
+        return [this]() -> std::optional<uint64_t> { return available.load(); };
+    }
+};
+
+} // namespace
+
+TEST(MemoryAdmissionTest, ParsesMeminfo) {
+    constexpr std::string_view meminfo = "MemTotal:       16314380 kB\n"
+                                         "MemFree:         1203344 kB\n"
+                                         "MemAvailable:    9876543 kB\n";
+    EXPECT_EQ(MemoryAdmission::parseMeminfo(meminfo, "MemAvailable"),
+              9876543ull * 1024);
+    EXPECT_EQ(MemoryAdmission::parseMeminfo(meminfo, "MemTotal"),
+              16314380ull * 1024);
+    EXPECT_FALSE(MemoryAdmission::parseMeminfo(meminfo, "Mem").has_value());
+    EXPECT_FALSE(MemoryAdmission::parseMeminfo("", "MemAvailable"));
+}
+
+TEST(MemoryAdmissionTest, FirstJobAlwaysAdmitted) {
+    FakeMemory memory; // nada disponível
+    MemoryAdmission admission(memory.probe());
+
+    auto ticket = admission.admit(JobKind::Compile);
+    EXPECT_TRUE(ticket.valid());
+    EXPECT_EQ(admission.stats().running, 1u);
+}
+
+TEST(MemoryAdmissionTest, QueuesUntilRunningJobFinishes) {
+    FakeMemory memory;
+    MemoryAdmission admission(memory.probe());
+    admission.record(JobKind::Compile, 512 * kMiB);
+
+    // Cabe um job com folga, mas não dois
+    memory.available = MemoryAdmission::kSafetyMargin + 768 * kMiB;
+
+    auto first = admission.admit(JobKind::Compile);
+
+    std::atomic<bool> admitted{false};
+    std::thread waiter([&] {
+        auto second = admission.admit(JobKind::Compile);
+        admitted = true;
+    });
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(150));
+    EXPECT_FALSE(admitted.load());
+    EXPECT_EQ(admission.stats().queued, 1u);
+
+    first.finish(0);
+    waiter.join();
+    EXPECT_TRUE(admitted.load());
+
+    const auto stats = admission.stats();
+    EXPECT_EQ(stats.admitted, 2u);
+    EXPECT_EQ(stats.delayed, 1u);
+    EXPECT_EQ(stats.queued, 0u);
+}
+
+TEST(MemoryAdmissionTest, DisabledNeverQueues) {
+    FakeMemory memory;
+    MemoryAdmission admission(memory.probe());
+    admission.setEnabled(false);
+
+    auto first = admission.admit(JobKind::Link);
+    auto second = admission.admit(JobKind::Link);
+    EXPECT_EQ(admission.stats().running, 2u);
+}
+
+TEST(MemoryAdmissionTest, EstimateFollowsObservedPeaks) {
+    FakeMemory memory;
+    MemoryAdmission admission(memory.probe());
+
+    admission.record(JobKind::AstDump, 400 * kMiB);
+    EXPECT_EQ(admission.estimate(JobKind::AstDump), 400 * kMiB);
+
+    // Sobe de imediato, desce devagar
+    admission.record(JobKind::AstDump, 800 * kMiB);
+    EXPECT_EQ(admission.estimate(JobKind::AstDump), 800 * kMiB);
+    admission.record(JobKind::AstDump, 400 * kMiB);
+    EXPECT_EQ(admission.estimate(JobKind::AstDump), 700 * kMiB);
+
+    const auto stats = admission.stats();
+    EXPECT_EQ(stats.peak[static_cast<size_t>(JobKind::AstDump)], 800 * kMiB);
+    EXPECT_EQ(stats.samples[static_cast<size_t>(JobKind::AstDump)], 3u);
+}
+
+TEST(MemoryAdmissionTest, TicketRecordsChildPeakRss) {
+    FakeMemory memory;
+    MemoryAdmission admission(memory.probe());
+
+    auto ticket = admission.admit(JobKind::Link);
+    auto res = execution::runProcess(
+        {"true"}, {.onSpawn = [&](pid_t pid) { ticket.attach(pid); }});
+    if (res.spawnError != 0) {
+        GTEST_SKIP() << "true not available";
+    }
+    EXPECT_GT(res.peakRssKb, 0);
+    ticket.finish(res.peakRssKb);
+
+    EXPECT_EQ(admission.estimate(JobKind::Link),
+              static_cast<uint64_t>(res.peakRssKb) * 1024);
+    EXPECT_EQ(admission.stats().running, 0u);
+}
@@ -0,0 +1,102 @@
+#include "execution/memory_artifacts.hpp"
+#include "execution/process_launcher.hpp"
+
+#include <dlfcn.h>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <iterator>
+
+using execution::MemoryArtifacts;
+
+namespace {
+
+std::string readAll(const std::string &path) {
+    std::ifstream in(path, std::ios::binary);
+    return {std::istreambuf_iterator<char>(in),
+            std::istreambuf_iterator<char>()};
+}
+
+class MemoryArtifactsTest : public ::testing::Test {
+  protected:
+    void SetUp() override {
+        ASSERT_TRUE(MemoryArtifacts::instance().setEnabled(true));
+    }
+
+    void TearDown() override { MemoryArtifacts::instance().setEnabled(false); }
+};
+
+} // namespace
+
+TEST_F(MemoryArtifactsTest, CreateResolveAndRead) {
+    auto &artifacts = MemoryArtifacts::instance();
+
+    auto path = artifacts.create("repl_test.cpp", "int x = 1;\n");
+    ASSERT_TRUE(path.has_value());
+    EXPECT_TRUE(MemoryArtifacts::isMemoryPath(*path));
+    EXPECT_EQ(artifacts.resolve("repl_test.cpp"), *path);
+    EXPECT_EQ(artifacts.resolve("./repl_test.cpp"), *path);
+    EXPECT_EQ(readAll(*path), "int x = 1;\n");
+
+    // Desconhecido: o próprio nome
+    EXPECT_EQ(artifacts.resolve("other.cpp"), "other.cpp");
+    EXPECT_FALSE(std::filesystem::exists("repl_test.cpp"));
+}
+
+TEST_F(MemoryArtifactsTest, ReleaseStemKeepsLibraries) {
+    auto &artifacts = MemoryArtifacts::instance();
+
+    ASSERT_TRUE(artifacts.create("repl_9.cpp", "//"));
+    ASSERT_TRUE(artifacts.create("repl_9.log", "warning"));
+    ASSERT_TRUE(artifacts.create("repl_90.cpp", "//"));
+    auto lib = artifacts.create("librepl_9.so", {},
+                                MemoryArtifacts::Kind::Library);
+    ASSERT_TRUE(lib.has_value());
+
+    artifacts.releaseStem("repl_9");
+
+    EXPECT_FALSE(artifacts.contains("repl_9.cpp"));
+    EXPECT_FALSE(artifacts.contains("repl_9.log"));
+    EXPECT_TRUE(artifacts.contains("repl_90.cpp"));
+    EXPECT_EQ(artifacts.resolve("librepl_9.so"), *lib);
+}
+
+TEST_F(MemoryArtifactsTest, RecreatedLibraryGetsNewPath) {
+    auto &artifacts = MemoryArtifacts::instance();
+    using Kind = MemoryArtifacts::Kind;
+
+    auto first = artifacts.create("libprinterOutput.so", "a", Kind::Library);
+    auto second = artifacts.create("libprinterOutput.so", "b", Kind::Library);
+    ASSERT_TRUE(first && second);
+
+    // O fd antigo continua aberto: o dlopen não pode reencontrar o caminho
+    EXPECT_NE(*first, *second);
+    EXPECT_EQ(readAll(*first), "a");
+    EXPECT_EQ(readAll(*second), "b");
+}
+
+TEST_F(MemoryArtifactsTest, CompileAndDlopenFromMemfd) {
+    auto &artifacts = MemoryArtifacts::instance();
+
+    auto source = artifacts.create(
+        "memfd_lib.c", "int memfd_answer(void) { return 42; }\n");
+    auto library = artifacts.create("libmemfd_lib.so", {},
+                                    MemoryArtifacts::Kind::Library);
+    ASSERT_TRUE(source && library);
+
+    auto res = execution::runProcess({"cc", "-x", "c", "-shared", "-fPIC",
+                                      *source, "-o", *library});
+    if (res.spawnError != 0) {
+        GTEST_SKIP() << "cc not available";
+    }
+    ASSERT_TRUE(res.success()) << res.err();
+
+    void *handle = dlopen(library->c_str(), RTLD_NOW | RTLD_LOCAL);
+    ASSERT_NE(handle, nullptr) << dlerror();
+
+    auto fn = reinterpret_cast<int (*)()>(dlsym(handle, "memfd_answer"));
+    ASSERT_NE(fn, nullptr);
+    EXPECT_EQ(fn(), 42);
+    dlclose(handle);
+}
@@ -0,0 +1,105 @@
+#include "../test_helpers/temp_directory_fixture.hpp"
+#include "execution/process_launcher.hpp"
+
+#include <fstream>
+#include <gtest/gtest.h>
+
+using namespace execution;
+using namespace test_helpers;
+
+class ProcessLauncherTest : public TempDirectoryFixture {};
+
+TEST_F(ProcessLauncherTest, RunProcess_CapturesStdoutAndStderrSeparately) {
+    auto res = runProcess({"sh", "-c", "echo out; echo err >&2"},
+                          {.out = Stream::Capture, .err = Stream::Capture});
+
+    ASSERT_TRUE(res.success());
+    EXPECT_EQ(res.out(), "out\n");
+    EXPECT_EQ(res.err(), "err\n");
+}
+
+TEST_F(ProcessLauncherTest, RunProcess_MergesStderrIntoStdout) {
+    auto res = runProcess({"sh", "-c", "echo a; echo b >&2"},
+                          {.out = Stream::Capture, .err = Stream::ToStdout});
+
+    ASSERT_TRUE(res.success());
+    EXPECT_EQ(res.out(), "a\nb\n");
+    EXPECT_TRUE(res.err().empty());
+}
+
+TEST_F(ProcessLauncherTest, RunProcess_ReportsExitCodeWithoutShell) {
+    auto res = runProcess({"false"});
+
+    EXPECT_FALSE(res.success());
+    EXPECT_TRUE(res.exited());
+    EXPECT_EQ(res.exitCode(), 1);
+    EXPECT_EQ(res.spawnError, 0);
+}
+
+TEST_F(ProcessLauncherTest, RunProcess_MissingProgram_SpawnError) {
+    auto res = runProcess({"cpprepl-no-such-program-xyz"});
+
+    EXPECT_FALSE(res.success());
+    EXPECT_NE(res.spawnError, 0);
+    EXPECT_EQ(res.exitCode(), -1);
+}
+
+TEST_F(ProcessLauncherTest, RunProcess_LargeOutput) {
+    auto res = runProcess({"head", "-c", "1000000", "/dev/zero"});
+
+    ASSERT_TRUE(res.success());
+    EXPECT_EQ(res.out().size(), 1000000u);
+}
+
+TEST_F(ProcessLauncherTest, ParseCommandLine_QuotesAndRedirects) {
+    std::vector<std::string> argv;
+    ProcessOptions opts;
+
+    ASSERT_TRUE(parseCommandLine(
+        R"(clang++ -DNAME="a b" 'x y' a\ b - < /dev/null 2>/dev/null)", argv,
+        opts));
+
+    EXPECT_EQ(argv, (std::vector<std::string>{"clang++", "-DNAME=a b", "x y",
+                                              "a b", "-"}));
+    EXPECT_EQ(opts.inPath, "/dev/null");
+    EXPECT_EQ(opts.err, Stream::File);
+    EXPECT_EQ(opts.errPath, "/dev/null");
+    EXPECT_EQ(opts.out, Stream::Capture);
+}
+
+TEST_F(ProcessLauncherTest, ParseCommandLine_MergeStderr) {
+    std::vector<std::string> argv;
+    ProcessOptions opts;
+
+    ASSERT_TRUE(parseCommandLine("clang++ --version 2>&1", argv, opts));
+    EXPECT_EQ(argv.size(), 2u);
+    EXPECT_EQ(opts.err, Stream::ToStdout);
+}
+
+TEST_F(ProcessLauncherTest, ParseCommandLine_ShellSyntax_Rejected) {
+    for (const char *cmd :
+         {"nm -D lib.so | grep T", "echo $HOME", "a && b", "ls *.cpp",
+          "FOO=1 make", "echo `id`", "a; b", "cmd 2>&1 >out.txt"}) {
+        std::vector<std::string> argv;
+        ProcessOptions opts;
+        EXPECT_FALSE(parseCommandLine(cmd, argv, opts)) << cmd;
+    }
+}
+
+TEST_F(ProcessLauncherTest, RunCommandLine_RedirectsToFile) {
+    auto res = runCommandLine("echo hello > out.txt");
+    ASSERT_TRUE(res.success());
+
+    std::ifstream in("out.txt");
+    std::string content;
+    std::getline(in, content);
+    EXPECT_EQ(content, "hello");
+    EXPECT_TRUE(res.out().empty());
+}
+
+TEST_F(ProcessLauncherTest, RunCommandLine_FallsBackToShell) {
+    auto res = runCommandLine("printf 'a\\nb\\n' | wc -l");
+
+    ASSERT_TRUE(res.success());
+    EXPECT_EQ(res.out(), "2\n");
+}
@@ -0,0 +1,126 @@
+#include "execution/speculative_compiler.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <gtest/gtest.h>
+#include <thread>
+
+using execution::CancellationToken;
+using execution::SpeculativeCompiler;
+
+namespace {
+
+// Build falso: espera até ser liberado ou cancelado
+struct FakeBuild {
+    std::atomic<bool> release{true};
+    std::atomic<bool> fail{false};
+    std::atomic<int> calls{0};
+    std::atomic<int> cancelled{0};
+
+    SpeculativeCompiler::Build build() {
+        return [this](const std::string &, const std::string &,
+                      const CancellationToken &cancel) {
+            ++calls;
+            while (!release.load()) {
+                if (cancel.cancelled()) {
+                    ++cancelled;
+                    return false;
+                }
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+            return !fail.load();
+        };
+    }
+};
+
+} // namespace
+
+TEST(SpeculativeCompilerTest, DisabledDoesNothing) {
+    FakeBuild fake;
+    SpeculativeCompiler speculative;
+    speculative.setBuild(fake.build());
+    speculative.setEnabled(false);
+
+    speculative.speculate("a", "void exec() {}");
+    EXPECT_FALSE(speculative.claim("a"));
+    EXPECT_EQ(fake.calls.load(), 0);
+    EXPECT_EQ(speculative.stats().started, 0u);
+}
+
+TEST(SpeculativeCompilerTest, MatchingKeyIsAHit) {
+    FakeBuild fake;
+    SpeculativeCompiler speculative;
+    speculative.setBuild(fake.build());
+    speculative.setEnabled(true);
+
+    speculative.speculate("a", "void exec() {}");
+    speculative.speculate("a", "void exec() {}"); // mesma chave: um job só
+
+    const auto name = speculative.claim("a");
+    ASSERT_TRUE(name);
+    EXPECT_TRUE(name->starts_with("spec_"));
+    EXPECT_EQ(fake.calls.load(), 1);
+
+    // Consumido pelo claim
+    EXPECT_FALSE(speculative.claim("a"));
+
+    const auto stats = speculative.stats();
+    EXPECT_EQ(stats.started, 1u);
+    EXPECT_EQ(stats.hits, 1u);
+    EXPECT_EQ(stats.misses, 0u);
+}
+
+TEST(SpeculativeCompilerTest, NewKeyCancelsStaleJob) {
+    FakeBuild fake;
+    fake.release = false;
+    SpeculativeCompiler speculative;
+    speculative.setBuild(fake.build());
+    speculative.setEnabled(true);
+
+    speculative.speculate("a", "1");
+    while (fake.calls.load() == 0) {
+        std::this_thread::yield();
+    }
+    speculative.speculate("ab", "2");
+    EXPECT_EQ(fake.cancelled.load(), 1);
+
+    fake.release = true;
+    EXPECT_FALSE(speculative.claim("abc")); // miss
+
+    const auto stats = speculative.stats();
+    EXPECT_EQ(stats.started, 2u);
+    EXPECT_EQ(stats.cancelled, 1u);
+    EXPECT_EQ(stats.misses, 1u);
+    EXPECT_EQ(stats.hits, 0u);
+}
+
+TEST(SpeculativeCompilerTest, ClaimWaitsForRunningJob) {
+    FakeBuild fake;
+    fake.release = false;
+    SpeculativeCompiler speculative;
+    speculative.setBuild(fake.build());
+    speculative.setEnabled(true);
+
+    speculative.speculate("a", "1");
+    std::thread releaser([&] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        fake.release = true;
+    });
+    EXPECT_TRUE(speculative.claim("a"));
+    releaser.join();
+}
+
+TEST(SpeculativeCompilerTest, FailedBuildIsAMiss) {
+    FakeBuild fake;
+    fake.fail = true;
+    SpeculativeCompiler speculative;
+    speculative.setBuild(fake.build());
+    speculative.setEnabled(true);
+
+    speculative.speculate("a", "1");
+    EXPECT_FALSE(speculative.claim("a"));
+
+    const auto stats = speculative.stats();
+    EXPECT_EQ(stats.misses, 1u);
+    EXPECT_EQ(stats.failed, 1u);
+}
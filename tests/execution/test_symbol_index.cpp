@@ -0,0 +1,118 @@
+#include "execution/symbol_index.hpp"
+
+#include <chrono>
+#include <format>
+#include <gtest/gtest.h>
+#include <iostream>
+
+using execution::SymbolIndex;
+
+namespace {
+
+VarDecl makeDecl(std::string name, std::string mangled, std::string kind,
+                 std::string qualType = "int") {
+    return VarDecl{.name = std::move(name),
+                   .mangledName = std::move(mangled),
+                   .type = {},
+                   .qualType = std::move(qualType),
+                   .kind = std::move(kind),
+                   .file = {},
+                   .line = 0};
+}
+
+} // namespace
+
+TEST(SymbolIndexTest, Add_NewAndExisting) {
+    SymbolIndex index;
+    EXPECT_TRUE(index.add(makeDecl("x", "x", "VarDecl"), 1));
+    EXPECT_FALSE(
+        index.add(makeDecl("x", "x", "VarDecl", "long"), 2, "./lib2.so"));
+    EXPECT_EQ(index.size(), 1u);
+
+    auto record = index.find("x");
+    ASSERT_TRUE(record.has_value());
+    EXPECT_EQ(record->decl.qualType, "long");
+    EXPECT_EQ(record->generation, 2);
+    EXPECT_EQ(record->library, "./lib2.so");
+}
+
+TEST(SymbolIndexTest, Overloads_KeyedByMangledName) {
+    SymbolIndex index;
+    EXPECT_TRUE(index.add(makeDecl("f", "_Z1fi", "FunctionDecl"), 1));
+    EXPECT_TRUE(index.add(makeDecl("f", "_Z1fd", "FunctionDecl"), 1));
+    EXPECT_EQ(index.size(), 2u);
+    EXPECT_TRUE(index.containsName("f"));
+    EXPECT_FALSE(index.containsName("g"));
+    EXPECT_EQ(index.find("_Z1fd")->demangledName, "f(double)");
+}
+
+TEST(SymbolIndexTest, WrappedAndAddress) {
+    SymbolIndex index;
+    index.add(makeDecl("f", "_Z1fv", "FunctionDecl"), 1);
+    EXPECT_FALSE(index.isWrapped("_Z1fv"));
+    index.markWrapped("_Z1fv");
+    EXPECT_TRUE(index.isWrapped("_Z1fv"));
+    EXPECT_FALSE(index.isWrapped("_Z1gv"));
+
+    index.setAddress("_Z1fv", 0x1000);
+    EXPECT_EQ(index.find("_Z1fv")->address, 0x1000u);
+}
+
+TEST(SymbolIndexTest, WithPrefix_SortedAndLimited) {
+    SymbolIndex index;
+    index.add(makeDecl("counter", "counter", "VarDecl"), 1);
+    index.add(makeDecl("count", "_Z5countv", "FunctionDecl"), 2);
+    index.add(makeDecl("cost", "cost", "VarDecl"), 3);
+    index.add(makeDecl("value", "value", "VarDecl"), 4);
+
+    auto matches = index.withPrefix("cou");
+    ASSERT_EQ(matches.size(), 2u);
+    EXPECT_EQ(matches[0].decl.name, "count");
+    EXPECT_EQ(matches[1].decl.name, "counter");
+
+    EXPECT_EQ(index.withPrefix("c", 1).size(), 1u);
+    EXPECT_TRUE(index.withPrefix("z").empty());
+    EXPECT_EQ(index.withPrefix("").size(), 4u);
+}
+
+TEST(SymbolIndexTest, Declarations_InsertionOrder) {
+    SymbolIndex index;
+    index.add(makeDecl("b", "b", "VarDecl"), 1);
+    index.add(makeDecl("a", "a", "VarDecl"), 2);
+    index.add(makeDecl("b", "b", "VarDecl"), 3);
+
+    auto decls = index.declarations();
+    ASSERT_EQ(decls.size(), 2u);
+    EXPECT_EQ(decls[0].name, "b");
+    EXPECT_EQ(decls[1].name, "a");
+}
+
+TEST(SymbolIndexTest, Benchmark_PerEvalCostStaysFlat) {
+    SymbolIndex index;
+
+    // Mede o custo de um eval pequeno com sessões de tamanhos diferentes
+    auto evalCost = [&](int existing) {
+        for (int i = static_cast<int>(index.size()); i < existing; ++i) {
+            index.add(makeDecl(std::format("v{}", i), std::format("v{}", i),
+                               "VarDecl"),
+                      i);
+        }
+        auto t0 = std::chrono::steady_clock::now();
+        for (int i = 0; i < 100; ++i) {
+            auto name = std::format("new{}_{}", existing, i);
+            index.add(makeDecl(name, name, "VarDecl"), existing);
+            (void)index.withPrefix("new", 10);
+        }
+        return std::chrono::steady_clock::now() - t0;
+    };
+
+    auto small = evalCost(100);
+    auto large = evalCost(20000);
+    std::cout << std::format(
+        "100 symbols: {}us, 20000 symbols: {}us\n",
+        std::chrono::duration_cast<std::chrono::microseconds>(small).count(),
+        std::chrono::duration_cast<std::chrono::microseconds>(large).count());
+
+    // Folga grande para não ficar instável em máquinas carregadas
+    EXPECT_LT(large, small * 20 + std::chrono::milliseconds(5));
+}
@@ -0,0 +1,102 @@
+#include "execution/task_scheduler.hpp"
+
+#include <atomic>
+#include <gtest/gtest.h>
+#include <numeric>
+#include <stdexcept>
+#include <vector>
+
+using execution::TaskGroup;
+using execution::TaskScheduler;
+
+TEST(TaskSchedulerTest, ParallelForVisitsEveryIndexOnce) {
+    TaskScheduler scheduler(4);
+    std::vector<int> hits(100, 0);
+
+    scheduler.parallelFor(hits.size(), [&](size_t i) { ++hits[i]; });
+
+    for (int h : hits) {
+        EXPECT_EQ(h, 1);
+    }
+}
+
+TEST(TaskSchedulerTest, ParallelForRespectsOwnLimit) {
+    TaskScheduler scheduler(4);
+    std::atomic<int> running{0};
+    std::atomic<int> peak{0};
+
+    scheduler.parallelFor(
+        16,
+        [&](size_t) {
+            const int now = ++running;
+            int seen = peak.load();
+            while (now > seen && !peak.compare_exchange_weak(seen, now)) {
+            }
+            --running;
+        },
+        1);
+
+    EXPECT_EQ(peak.load(), 1);
+}
+
+TEST(TaskSchedulerTest, SubmitReturnsResultThroughFuture) {
+    TaskScheduler scheduler(2);
+
+    auto answer = scheduler.submit([] { return 42; });
+    auto failing =
+        scheduler.submit([]() -> int { throw std::runtime_error("boom"); });
+
+    EXPECT_EQ(answer.get(), 42);
+    EXPECT_THROW(failing.get(), std::runtime_error);
+}
+
+TEST(TaskSchedulerTest, TaskGroupRunsStageAndPropagatesErrors) {
+    TaskScheduler scheduler(2);
+
+    int value = 0;
+    {
+        TaskGroup stage(scheduler);
+        stage.run([&] { value = 7; });
+        stage.wait();
+    }
+    EXPECT_EQ(value, 7);
+
+    TaskGroup failing(scheduler);
+    failing.run([] { throw std::logic_error("stage failed"); });
+    EXPECT_THROW(failing.wait(), std::logic_error);
+}
+
+TEST(TaskSchedulerTest, NestedInvokeInsideParallelFor) {
+    TaskScheduler scheduler(2);
+    std::vector<int> sums(8, 0);
+
+    // Um job por fonte que dispara AST + compile, como no eval
+    scheduler.parallelFor(sums.size(), [&](size_t i) {
+        int a = 0;
+        int b = 0;
+        scheduler.parallelInvoke([&] { a = static_cast<int>(i); },
+                                 [&] { b = 1; });
+        sums[i] = a + b;
+    });
+
+    std::vector<int> expected(sums.size());
+    std::iota(expected.begin(), expected.end(), 1);
+    EXPECT_EQ(sums, expected);
+}
+
+TEST(TaskSchedulerTest, SetConcurrencyReplacesArena) {
+    TaskScheduler scheduler(2);
+    auto before = scheduler.arena();
+
+    scheduler.setConcurrency(3);
+    EXPECT_EQ(scheduler.concurrency(), 3u);
+    EXPECT_NE(scheduler.arena(), before);
+    EXPECT_EQ(scheduler.arena()->max_concurrency(), 3);
+
+    // Mesmo valor: a arena é mantida
+    auto same = scheduler.arena();
+    scheduler.setConcurrency(3);
+    EXPECT_EQ(scheduler.arena(), same);
+
+    EXPECT_EQ(scheduler.execute([] { return 5; }), 5);
+}
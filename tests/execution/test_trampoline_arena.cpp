@@ -0,0 +1,123 @@
+#include "execution/trampoline_arena.hpp"
+#include "utility/elf_symbols.hpp"
+
+#include <dlfcn.h>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <string>
+
+using namespace execution;
+
+namespace {
+
+double realTarget(int a, double b, long c, double d) {
+    return a + b + static_cast<double>(c) + d;
+}
+
+int resolverCalls = 0;
+std::string resolvedName;
+
+void testResolver(void **slot, const char *name) {
+    ++resolverCalls;
+    resolvedName = name;
+    *slot = reinterpret_cast<void *>(&realTarget);
+}
+
+} // namespace
+
+class TrampolineArenaTest : public ::testing::Test {
+  protected:
+    void SetUp() override {
+        if (!arena.available()) {
+            GTEST_SKIP() << "trampoline arena not supported here";
+        }
+        resolverCalls = 0;
+        resolvedName.clear();
+    }
+
+    TrampolineArena arena{1024 * 1024};
+};
+
+TEST_F(TrampolineArenaTest, Emit_LazyStubResolvesAndPreservesArguments) {
+    auto t = arena.emit("cpprepl_tramp_target", &testResolver);
+    ASSERT_TRUE(t.has_value());
+
+    using Fn = double (*)(int, double, long, double);
+    auto fn = reinterpret_cast<Fn>(t->entry);
+
+    // Primeira chamada passa pelo stub lazy (registradores inteiros e xmm)
+    EXPECT_DOUBLE_EQ(fn(1, 2.5, 3, 4.25), 10.75);
+    EXPECT_EQ(resolverCalls, 1);
+    EXPECT_EQ(resolvedName, "cpprepl_tramp_target");
+    EXPECT_EQ(*t->slot, reinterpret_cast<void *>(&realTarget));
+
+    // Depois disso é só o jmp *slot
+    EXPECT_DOUBLE_EQ(fn(2, 0.5, 1, 0.5), 4.0);
+    EXPECT_EQ(resolverCalls, 1);
+}
+
+TEST_F(TrampolineArenaTest, Emit_SlotUpdateRedirectsCalls) {
+    auto t = arena.emit("cpprepl_tramp_redirect", &testResolver);
+    ASSERT_TRUE(t.has_value());
+
+    *t->slot = reinterpret_cast<void *>(+[](int a, double, long, double) {
+        return a * 2.0;
+    });
+
+    using Fn = double (*)(int, double, long, double);
+    EXPECT_DOUBLE_EQ(reinterpret_cast<Fn>(t->entry)(21, 0, 0, 0), 42.0);
+    EXPECT_EQ(resolverCalls, 0);
+}
+
+TEST_F(TrampolineArenaTest, Emit_ManyTrampolinesStayDistinct) {
+    std::vector<TrampolineArena::Trampoline> all;
+    for (int i = 0; i < 100; ++i) {
+        auto t = arena.emit("fn_" + std::to_string(i), &testResolver);
+        ASSERT_TRUE(t.has_value());
+        all.push_back(*t);
+    }
+    EXPECT_EQ(arena.trampolineCount(), 100u);
+    for (size_t i = 1; i < all.size(); ++i) {
+        EXPECT_NE(all[i].entry, all[i - 1].entry);
+        EXPECT_NE(all[i].slot, all[i - 1].slot);
+    }
+}
+
+TEST_F(TrampolineArenaTest, ExportSymbols_VisibleThroughDynamicLinker) {
+    auto t = arena.emit("cpprepl_tramp_exported", &testResolver);
+    ASSERT_TRUE(t.has_value());
+
+    void *handle = arena.exportSymbols({*t}, "cpprepl_tramp_test.so");
+    if (handle == nullptr) {
+        GTEST_SKIP() << "dynamic linker does not honor SHN_ABS symbols";
+    }
+
+    EXPECT_EQ(dlsym(RTLD_DEFAULT, "cpprepl_tramp_exported"), t->entry);
+    EXPECT_EQ(dlsym(handle, "cpprepl_tramp_exported_ptr"),
+              static_cast<void *>(t->slot));
+}
+
+TEST(TrampolineArenaImage, BuildAbsoluteSymbolObject_ReadableAsElf) {
+    auto image = TrampolineArena::buildAbsoluteSymbolObject(
+        {{.name = "alpha", .address = 0x1234, .function = true, .size = 16},
+         {.name = "alpha_ptr", .address = 0x5678, .function = false,
+          .size = 8}},
+        "libimage.so");
+
+    const std::string path = ::testing::TempDir() + "cpprepl_abs_image.so";
+    std::ofstream(path, std::ios::binary) << image;
+
+    utility::ElfDynamicSymbols elf(path);
+    ASSERT_TRUE(elf.valid());
+
+    auto alpha = elf.find("alpha");
+    ASSERT_TRUE(alpha.has_value());
+    EXPECT_EQ(alpha->address, 0x1234u);
+    EXPECT_EQ(alpha->libSection, 'A');
+
+    auto ptr = elf.find("alpha_ptr");
+    ASSERT_TRUE(ptr.has_value());
+    EXPECT_EQ(ptr->address, 0x5678u);
+
+    EXPECT_FALSE(elf.find("beta").has_value());
+}
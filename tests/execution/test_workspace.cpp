@@ -0,0 +1,131 @@
+#include "../test_helpers/temp_directory_fixture.hpp"
+#include "execution/workspace.hpp"
+
+#include <cstdlib>
+#include <dlfcn.h>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using execution::Workspace;
+using test_helpers::TempDirectoryFixture;
+
+namespace {
+
+void writeFile(const std::string &path, const std::string &content) {
+    std::ofstream(path, std::ios::out | std::ios::trunc) << content;
+}
+
+} // namespace
+
+class WorkspaceTest : public TempDirectoryFixture {};
+
+TEST_F(WorkspaceTest, PlaceUsesShardedSessionDirectory) {
+    Workspace workspace(getTempDir());
+    ASSERT_TRUE(workspace.enabled());
+
+    const auto path = workspace.place("./repl_1.cpp");
+    const std::filesystem::path physical(path);
+    EXPECT_EQ(physical.extension(), ".cpp");
+    EXPECT_EQ(physical.parent_path().parent_path(), workspace.root());
+    EXPECT_EQ(workspace.resolve("repl_1.cpp"), path);
+    EXPECT_EQ(workspace.resolve("unknown.cpp"), "unknown.cpp");
+
+    // Nada no diretório atual
+    EXPECT_FALSE(std::filesystem::exists("repl_1.cpp"));
+}
+
+TEST_F(WorkspaceTest, SupersededVersionsAreDeleted) {
+    Workspace workspace(getTempDir());
+
+    const auto first = workspace.place("printerOutput.cpp");
+    writeFile(first, "// v1");
+    const auto second = workspace.place("printerOutput.cpp");
+    writeFile(second, "// v2");
+    EXPECT_NE(first, second);
+
+    workspace.advance();
+    workspace.drain();
+
+    EXPECT_FALSE(std::filesystem::exists(first));
+    EXPECT_TRUE(std::filesystem::exists(second));
+    EXPECT_EQ(workspace.stats().deleted, 1u);
+}
+
+TEST_F(WorkspaceTest, OldGenerationsCollectedButLoadedLibrariesKept) {
+    Workspace workspace(getTempDir(), 1);
+
+    const auto source = workspace.place("libkept.c");
+    writeFile(source, "int kept_value(void) { return 7; }\n");
+    const auto library = workspace.place("libkept.so");
+    const auto cmd =
+        std::format("cc -shared -fPIC {} -o {} 2>/dev/null", source, library);
+    if (std::system(cmd.c_str()) != 0) {
+        GTEST_SKIP() << "cc not available";
+    }
+
+    void *handle = dlopen(library.c_str(), RTLD_NOW | RTLD_LOCAL);
+    ASSERT_NE(handle, nullptr) << dlerror();
+
+    workspace.advance();
+    workspace.advance();
+    workspace.drain();
+
+    EXPECT_FALSE(std::filesystem::exists(source));
+    EXPECT_TRUE(std::filesystem::exists(library));
+    EXPECT_EQ(workspace.stats().retained, 1u);
+
+    // Enquanto o arquivo existe, o nome lógico ainda o encontra
+    EXPECT_EQ(workspace.resolve("libkept.so"), library);
+    EXPECT_EQ(workspace.resolve("libkept.c"), "libkept.c");
+
+    // Descarregada: sai na próxima coleta
+    dlclose(handle);
+    workspace.advance();
+    workspace.drain();
+    EXPECT_FALSE(std::filesystem::exists(library));
+    EXPECT_EQ(workspace.resolve("libkept.so"), "libkept.so");
+}
+
+TEST_F(WorkspaceTest, SessionDirectoryRemovedOnDestruction) {
+    std::filesystem::path root;
+    {
+        Workspace workspace(getTempDir());
+        root = workspace.root();
+        writeFile(workspace.place("repl_2.log"), "warning");
+        EXPECT_GE(workspace.stats().files, 1u);
+    }
+    EXPECT_FALSE(std::filesystem::exists(root));
+}
+
+TEST_F(WorkspaceTest, StaleSessionsOfDeadProcessesRemoved) {
+    // pid de um processo que já terminou
+    pid_t dead = fork();
+    if (dead == 0) {
+        _exit(0);
+    }
+    ASSERT_GT(dead, 0);
+    waitpid(dead, nullptr, 0);
+
+    const auto userDir =
+        getTempDir() / std::format("cpprepl-{}", ::getuid());
+    const auto stale = userDir / std::format("session-{}-0", dead);
+    std::filesystem::create_directories(stale);
+    writeFile((stale / "repl_0.cpp").string(), "//");
+
+    {
+        // A limpeza roda no início da thread de remoção, antes do join
+        Workspace workspace(getTempDir());
+    }
+    EXPECT_FALSE(std::filesystem::exists(stale));
+}
+
+TEST_F(WorkspaceTest, DisabledWithEmptyBase) {
+    Workspace workspace({});
+    EXPECT_FALSE(workspace.enabled());
+    EXPECT_EQ(workspace.place("repl_3.cpp"), "repl_3.cpp");
+    EXPECT_EQ(workspace.resolve("repl_3.cpp"), "repl_3.cpp");
+}
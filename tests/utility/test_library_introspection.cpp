@@ -1,10 +1,19 @@
 #include "../test_helpers/temp_directory_fixture.hpp"
 #include "repl.hpp" // For VarDecl definition
+#include "execution/process_launcher.hpp"
+#include "utility/elf_symbols.hpp"
 #include "utility/library_introspection.hpp"
+#include "utility/loaded_libraries.hpp"
 
+#include <algorithm>
+#include <chrono>
+#include <dlfcn.h>
 #include <filesystem>
+#include <format>
 #include <fstream>
 #include <gtest/gtest.h>
+#include <iostream>
+#include <link.h>
 
 using namespace test_helpers;
 
@@ -22,6 +31,42 @@ class LibraryIntrospectionTest : public TempDirectoryFixture {
         std::string filename = "lib" + libname + ".so";
         createFile(filename, "mock_library_content");
     }
+
+    // Compila um .so de verdade; vazio se não houver compilador
+    std::string buildRealLibrary(const std::string &name,
+                                 const std::string &hashStyle = "gnu") {
+        createFile(name + ".cpp", R"(
+extern "C" int cpprepl_test_fn(int x) { return x + 1; }
+extern "C" int cpprepl_test_var = 42;
+extern "C" int cpprepl_test_bss;
+int cpprepl_test_bss = 0;
+extern "C" const int cpprepl_test_const = 7;
+__attribute__((weak)) int cpprepl_test_weak() { return 3; }
+namespace ns { int mangled(double) { return 1; } }
+static int hidden() { return 2; }
+int (*keep)() = hidden;
+)");
+        const std::string lib = "lib" + name + ".so";
+        auto res = execution::runProcess(
+            {"c++", "-shared", "-fPIC", "-O1",
+             "-Wl,--hash-style=" + hashStyle, name + ".cpp", "-o", lib},
+            {.out = execution::Stream::Capture,
+             .err = execution::Stream::ToStdout});
+        return res.success() ? (getTempDir() / lib).string() : std::string{};
+    }
+
+    static std::vector<std::tuple<std::string, uintptr_t, char>>
+    normalized(const std::vector<utility::SymbolDef> &defs) {
+        std::vector<std::tuple<std::string, uintptr_t, char>> out;
+        for (const auto &def : defs) {
+            // nm recente mostra a versão (nome@VERSAO) para símbolos
+            // versionados; o leitor ELF devolve só o nome
+            auto name = def.nativeName.substr(0, def.nativeName.find('@'));
+            out.emplace_back(name, def.address, def.libSection);
+        }
+        std::sort(out.begin(), out.end());
+        return out;
+    }
 };
 
 // ============================================================================
@@ -217,3 +262,166 @@ TEST_F(LibraryIntrospectionTest,
     EXPECT_TRUE(result2.empty())
         << "Whitespace-only string should return empty result";
 }
+
+// ============================================================================
+// Native ELF reader
+// ============================================================================
+
+TEST_F(LibraryIntrospectionTest, ElfReader_MatchesNmOutput) {
+    auto lib = buildRealLibrary("elfcmp");
+    if (lib.empty()) {
+        GTEST_SKIP() << "no C++ compiler available";
+    }
+
+    auto viaNm = utility::getAllBuiltFileDeclsNm(lib);
+    if (viaNm.empty()) {
+        GTEST_SKIP() << "nm not available";
+    }
+
+    auto viaElf = utility::getAllBuiltFileDecls(lib);
+    EXPECT_EQ(normalized(viaElf), normalized(viaNm));
+}
+
+TEST_F(LibraryIntrospectionTest, ElfReader_FindWithGnuHash) {
+    auto lib = buildRealLibrary("elfgnu", "gnu");
+    if (lib.empty()) {
+        GTEST_SKIP() << "no C++ compiler available";
+    }
+
+    utility::ElfDynamicSymbols elf(lib);
+    ASSERT_TRUE(elf.valid());
+
+    auto fn = elf.find("cpprepl_test_fn");
+    ASSERT_TRUE(fn.has_value());
+    EXPECT_EQ(fn->libSection, 'T');
+    EXPECT_NE(fn->address, 0u);
+
+    auto var = elf.find("cpprepl_test_var");
+    ASSERT_TRUE(var.has_value());
+    EXPECT_EQ(var->libSection, 'D');
+
+    EXPECT_EQ(elf.find("cpprepl_test_bss")->libSection, 'B');
+    EXPECT_EQ(elf.find("cpprepl_test_const")->libSection, 'R');
+    EXPECT_EQ(elf.find("_Z17cpprepl_test_weakv")->libSection, 'W');
+    EXPECT_TRUE(elf.find("_ZN2ns7mangledEd").has_value());
+
+    EXPECT_FALSE(elf.find("cpprepl_missing").has_value());
+    EXPECT_FALSE(elf.find("_ZL6hiddenv").has_value());
+}
+
+TEST_F(LibraryIntrospectionTest, ElfReader_FindWithSysvHash) {
+    auto lib = buildRealLibrary("elfsysv", "sysv");
+    if (lib.empty()) {
+        GTEST_SKIP() << "no C++ compiler available";
+    }
+
+    utility::ElfDynamicSymbols elf(lib);
+    ASSERT_TRUE(elf.valid());
+    ASSERT_TRUE(elf.find("cpprepl_test_fn").has_value());
+    EXPECT_FALSE(elf.find("cpprepl_missing").has_value());
+}
+
+TEST_F(LibraryIntrospectionTest, ElfReader_NotElf_Invalid) {
+    createMockLibrary("notelf");
+
+    utility::ElfDynamicSymbols elf((getTempDir() / "libnotelf.so").string());
+    EXPECT_FALSE(elf.valid());
+    EXPECT_FALSE(elf.isElf());
+    EXPECT_FALSE(elf.find("anything").has_value());
+}
+
+TEST_F(LibraryIntrospectionTest, ElfReader_Benchmark_AgainstNm) {
+    auto lib = buildRealLibrary("elfbench");
+    if (lib.empty()) {
+        GTEST_SKIP() << "no C++ compiler available";
+    }
+
+    constexpr int iterations = 20;
+    size_t sink = 0;
+
+    auto t0 = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        sink += utility::getAllBuiltFileDeclsNm(lib).size();
+    }
+    auto t1 = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        sink += utility::getAllBuiltFileDecls(lib).size();
+    }
+    auto t2 = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        sink += utility::ElfDynamicSymbols(lib).find("cpprepl_test_fn") ? 1 : 0;
+    }
+    auto t3 = std::chrono::steady_clock::now();
+
+    auto us = [](auto d) {
+        return std::chrono::duration_cast<std::chrono::microseconds>(d)
+            .count();
+    };
+    std::cout << std::format("nm: {}us/lib, elf: {}us/lib, "
+                             "elf find: {}us/lookup\n",
+                             us(t1 - t0) / iterations, us(t2 - t1) / iterations,
+                             us(t3 - t2) / iterations);
+
+    EXPECT_GT(sink, 0u);
+    EXPECT_LT(t2 - t1, t1 - t0) << "in-process reader should beat nm";
+}
+
+// ============================================================================
+// Loaded Library Registry Tests
+// ============================================================================
+
+TEST_F(LibraryIntrospectionTest, LoadedLibraries_RegisteredHandleLookups) {
+    auto lib = buildRealLibrary("registry");
+    if (lib.empty()) {
+        GTEST_SKIP() << "no C++ compiler available";
+    }
+
+    void *handle = dlopen(lib.c_str(), RTLD_NOW | RTLD_LOCAL);
+    ASSERT_NE(handle, nullptr) << dlerror();
+
+    utility::LoadedLibraries libraries;
+    libraries.registerHandle(handle);
+
+    struct link_map *lm = nullptr;
+    ASSERT_EQ(dlinfo(handle, RTLD_DI_LINKMAP, &lm), 0);
+
+    auto base = libraries.baseAddress(lib);
+    ASSERT_TRUE(base.has_value());
+    EXPECT_EQ(*base, lm->l_addr);
+
+    auto fn = libraries.symbolAddress(lib, "cpprepl_test_fn");
+    ASSERT_TRUE(fn.has_value());
+    EXPECT_EQ(*fn,
+              reinterpret_cast<uintptr_t>(dlsym(handle, "cpprepl_test_fn")));
+
+    // Outro caminho para o mesmo arquivo
+    auto relative = "./" + std::filesystem::path(lib).filename().string();
+    EXPECT_EQ(libraries.baseAddress(relative), base);
+
+    EXPECT_FALSE(libraries.symbolAddress(lib, "does_not_exist").has_value());
+
+    libraries.unregisterHandle(handle);
+    dlclose(handle);
+    EXPECT_FALSE(libraries.baseAddress(lib).has_value());
+}
+
+TEST_F(LibraryIntrospectionTest, LoadedLibraries_UnregisteredFoundByRefresh) {
+    auto lib = buildRealLibrary("registry_refresh");
+    if (lib.empty()) {
+        GTEST_SKIP() << "no C++ compiler available";
+    }
+
+    void *handle = dlopen(lib.c_str(), RTLD_NOW | RTLD_LOCAL);
+    ASSERT_NE(handle, nullptr) << dlerror();
+
+    // Sem registerHandle: cai no dl_iterate_phdr
+    utility::LoadedLibraries libraries;
+    EXPECT_TRUE(libraries.baseAddress(lib).has_value());
+    EXPECT_GT(libraries.size(), 0u);
+
+    EXPECT_EQ(utility::getSymbolAddress(lib.c_str(), "cpprepl_test_var"),
+              reinterpret_cast<uintptr_t>(dlsym(handle, "cpprepl_test_var")));
+
+    dlclose(handle);
+    EXPECT_FALSE(libraries.baseAddress("not_a_library.so").has_value());
+}
@@ -13,22 +13,18 @@
 #include <sstream>
 #include <string>
 #include <unistd.h>
+#include <vector>
 
-#include "file_raii.hpp"
+#include "../include/execution/process_launcher.hpp"
 
 namespace assembly_info {
-inline std::string executeCommand(const std::string &command) {
-    std::ostringstream result;
-    auto pipe = utility::make_popen(command, "r");
-    if (!pipe) {
-        std::cerr << "Error running command: " << command << std::endl;
+inline std::string executeCommand(const std::vector<std::string> &argv) {
+    auto res = execution::runProcess(argv);
+    if (res.spawnError != 0) {
+        std::cerr << "Error running command: " << argv.front() << std::endl;
         return "";
     }
-    char buffer[128];
-    while (fgets(buffer, sizeof(buffer), pipe.get()) != nullptr) {
-        result << buffer;
-    }
-    return result.str();
+    return std::string(res.out());
 }
 
 inline std::string printSourceLine(const std::string &filePath, int lineNumber,
@@ -75,10 +71,12 @@ inline std::string analyzeAddress(const std::string &binaryPath,
 
     // Get the instruction using gdb
     if (getInstruction) {
-        std::ostringstream gdbCommand;
-        gdbCommand << "gdb --batch -ex 'file " << binaryPath << "' "
-                   << "-ex 'x/i 0x" << std::hex << address << "' -ex 'quit'";
-        output << "Instruction:\n" << executeCommand(gdbCommand.str());
+        std::ostringstream examine;
+        examine << "x/i 0x" << std::hex << address;
+        output << "Instruction:\n"
+               << executeCommand({"gdb", "--batch", "-ex",
+                                  "file " + binaryPath, "-ex", examine.str(),
+                                  "-ex", "quit"});
 
         if (linefeed) {
             output << "\n";
@@ -88,10 +86,10 @@ inline std::string analyzeAddress(const std::string &binaryPath,
     }
 
     // Get the source line using addr2line
-    std::ostringstream addr2lineCommand;
-    addr2lineCommand << "addr2line -e " << binaryPath << " " << std::hex
-                     << address;
-    std::string sourceFile = executeCommand(addr2lineCommand.str());
+    std::ostringstream addressHex;
+    addressHex << std::hex << address;
+    std::string sourceFile =
+        executeCommand({"addr2line", "-e", binaryPath, addressHex.str()});
     output << "Source:";
     if (linefeed) {
         output << "\n";
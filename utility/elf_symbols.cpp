@@ -0,0 +1,316 @@
+#include "../include/utility/elf_symbols.hpp"
+
+#include <cctype>
+#include <cstring>
+#include <elf.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace utility {
+
+namespace {
+
+// dl_new_hash (DT_GNU_HASH)
+uint32_t gnuHash(std::string_view name) {
+    uint32_t h = 5381;
+    for (unsigned char c : name) {
+        h = (h << 5) + h + c;
+    }
+    return h;
+}
+
+// ELF hash clássico (DT_HASH)
+uint32_t sysvHash(std::string_view name) {
+    uint32_t h = 0;
+    for (unsigned char c : name) {
+        h = (h << 4) + c;
+        uint32_t g = h & 0xf0000000U;
+        if (g != 0) {
+            h ^= g >> 24;
+        }
+        h &= ~g;
+    }
+    return h;
+}
+
+bool inBounds(size_t fileSize, uint64_t offset, uint64_t length) {
+    return offset <= fileSize && length <= fileSize - offset;
+}
+
+} // namespace
+
+ElfDynamicSymbols::ElfDynamicSymbols(const std::string &path) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return;
+    }
+
+    struct stat st {};
+    if (::fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) ||
+        static_cast<size_t>(st.st_size) < sizeof(Elf64_Ehdr)) {
+        ::close(fd);
+        return;
+    }
+
+    size_ = static_cast<size_t>(st.st_size);
+    void *addr = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (addr == MAP_FAILED) {
+        size_ = 0;
+        return;
+    }
+    base_ = static_cast<const unsigned char *>(addr);
+
+    const auto *ehdr = reinterpret_cast<const Elf64_Ehdr *>(base_);
+    isElf_ = std::memcmp(ehdr->e_ident, ELFMAG, SELFMAG) == 0;
+    if (!isElf_ || ehdr->e_ident[EI_CLASS] != ELFCLASS64 ||
+        ehdr->e_ident[EI_DATA] != ELFDATA2LSB ||
+        ehdr->e_shentsize != sizeof(Elf64_Shdr) ||
+        !inBounds(size_, ehdr->e_shoff,
+                  uint64_t{ehdr->e_shnum} * sizeof(Elf64_Shdr))) {
+        return;
+    }
+
+    sections_ = base_ + ehdr->e_shoff;
+    sectionCount_ = ehdr->e_shnum;
+    const auto *shdrs = reinterpret_cast<const Elf64_Shdr *>(sections_);
+
+    for (size_t i = 0; i < sectionCount_; ++i) {
+        const auto &sh = shdrs[i];
+        if (!inBounds(size_, sh.sh_offset, sh.sh_size)) {
+            continue;
+        }
+
+        switch (sh.sh_type) {
+        case SHT_DYNSYM: {
+            if (sh.sh_entsize != sizeof(Elf64_Sym) ||
+                sh.sh_link >= sectionCount_) {
+                break;
+            }
+            const auto &str = shdrs[sh.sh_link];
+            if (str.sh_type != SHT_STRTAB ||
+                !inBounds(size_, str.sh_offset, str.sh_size)) {
+                break;
+            }
+            symtab_ = base_ + sh.sh_offset;
+            symbolCount_ = sh.sh_size / sizeof(Elf64_Sym);
+            strtab_ = reinterpret_cast<const char *>(base_ + str.sh_offset);
+            strtabSize_ = str.sh_size;
+            break;
+        }
+        case SHT_GNU_HASH:
+            gnuHash_ = reinterpret_cast<const uint32_t *>(base_ + sh.sh_offset);
+            gnuHashSize_ = sh.sh_size;
+            break;
+        case SHT_HASH:
+            sysvHash_ =
+                reinterpret_cast<const uint32_t *>(base_ + sh.sh_offset);
+            sysvHashSize_ = sh.sh_size;
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+ElfDynamicSymbols::~ElfDynamicSymbols() {
+    if (base_ != nullptr) {
+        ::munmap(const_cast<unsigned char *>(base_), size_);
+    }
+}
+
+const void *ElfDynamicSymbols::symbol(size_t index) const {
+    return index < symbolCount_ ? symtab_ + index * sizeof(Elf64_Sym)
+                                : nullptr;
+}
+
+std::string_view ElfDynamicSymbols::symbolName(const void *sym) const {
+    const auto *s = static_cast<const Elf64_Sym *>(sym);
+    if (s->st_name >= strtabSize_) {
+        return {};
+    }
+    const char *name = strtab_ + s->st_name;
+    return {name, ::strnlen(name, strtabSize_ - s->st_name)};
+}
+
+char ElfDynamicSymbols::typeLetter(const void *sym) const {
+    const auto *s = static_cast<const Elf64_Sym *>(sym);
+    const auto bind = ELF64_ST_BIND(s->st_info);
+    const auto type = ELF64_ST_TYPE(s->st_info);
+
+    // Mesma precedência do nm (binutils)
+    if (type == STT_GNU_IFUNC) {
+        return 'i';
+    }
+    if (bind == STB_GNU_UNIQUE) {
+        return 'u';
+    }
+    if (bind == STB_WEAK) {
+        return type == STT_OBJECT ? 'V' : 'W';
+    }
+
+    char letter = '?';
+    if (s->st_shndx == SHN_ABS) {
+        letter = 'A';
+    } else if (s->st_shndx == SHN_COMMON) {
+        letter = 'C';
+    } else if (s->st_shndx < sectionCount_) {
+        const auto &sh =
+            reinterpret_cast<const Elf64_Shdr *>(sections_)[s->st_shndx];
+        if (sh.sh_flags & SHF_EXECINSTR) {
+            letter = 'T';
+        } else if (!(sh.sh_flags & SHF_ALLOC)) {
+            letter = 'N';
+        } else if (sh.sh_type == SHT_NOBITS) {
+            letter = 'B';
+        } else if (sh.sh_flags & SHF_WRITE) {
+            letter = 'D';
+        } else {
+            letter = 'R';
+        }
+    }
+
+    return bind == STB_LOCAL
+               ? static_cast<char>(std::tolower(static_cast<unsigned char>(
+                     letter)))
+               : letter;
+}
+
+std::optional<SymbolDef> ElfDynamicSymbols::toDef(const void *sym) const {
+    const auto *s = static_cast<const Elf64_Sym *>(sym);
+    const auto type = ELF64_ST_TYPE(s->st_info);
+    if (s->st_shndx == SHN_UNDEF || type == STT_SECTION || type == STT_FILE) {
+        return std::nullopt;
+    }
+
+    auto name = symbolName(sym);
+    if (name.empty()) {
+        return std::nullopt;
+    }
+
+    return SymbolDef{.nativeName = std::string(name),
+                     .address = static_cast<uintptr_t>(s->st_value),
+                     .libSection = typeLetter(sym)};
+}
+
+std::vector<SymbolDef> ElfDynamicSymbols::definedSymbols() const {
+    std::vector<SymbolDef> symbols;
+    symbols.reserve(symbolCount_);
+
+    // Índice 0 é sempre o símbolo nulo
+    for (size_t i = 1; i < symbolCount_; ++i) {
+        if (auto def = toDef(symbol(i))) {
+            symbols.push_back(std::move(*def));
+        }
+    }
+    return symbols;
+}
+
+std::optional<SymbolDef>
+ElfDynamicSymbols::findGnuHash(std::string_view name) const {
+    // nbuckets, symoffset, bloomSize, bloomShift, bloom[], buckets[], chain[]
+    if (gnuHashSize_ < 4 * sizeof(uint32_t)) {
+        return std::nullopt;
+    }
+    const uint32_t nbuckets = gnuHash_[0];
+    const uint32_t symoffset = gnuHash_[1];
+    const uint32_t bloomSize = gnuHash_[2];
+    const uint32_t bloomShift = gnuHash_[3];
+
+    const size_t header = 4 * sizeof(uint32_t);
+    const size_t bloomBytes = size_t{bloomSize} * sizeof(uint64_t);
+    const size_t bucketBytes = size_t{nbuckets} * sizeof(uint32_t);
+    if (nbuckets == 0 || bloomSize == 0 ||
+        header + bloomBytes + bucketBytes > gnuHashSize_) {
+        return std::nullopt;
+    }
+
+    const auto *bytes = reinterpret_cast<const unsigned char *>(gnuHash_);
+    const uint32_t h = gnuHash(name);
+
+    uint64_t word;
+    std::memcpy(&word,
+                bytes + header + ((h / 64) % bloomSize) * sizeof(uint64_t),
+                sizeof(word));
+    const uint64_t mask =
+        (uint64_t{1} << (h % 64)) | (uint64_t{1} << ((h >> bloomShift) % 64));
+    if ((word & mask) != mask) {
+        return std::nullopt;
+    }
+
+    const auto *buckets =
+        reinterpret_cast<const uint32_t *>(bytes + header + bloomBytes);
+    const auto *chain = buckets + nbuckets;
+    const size_t chainCount =
+        (gnuHashSize_ - header - bloomBytes - bucketBytes) / sizeof(uint32_t);
+
+    uint32_t index = buckets[h % nbuckets];
+    if (index < symoffset) {
+        return std::nullopt;
+    }
+
+    for (; index < symbolCount_ && index - symoffset < chainCount; ++index) {
+        const uint32_t h2 = chain[index - symoffset];
+        if ((h | 1) == (h2 | 1)) {
+            const void *sym = symbol(index);
+            if (symbolName(sym) == name) {
+                return toDef(sym);
+            }
+        }
+        if (h2 & 1) {
+            break;
+        }
+    }
+    return std::nullopt;
+}
+
+std::optional<SymbolDef>
+ElfDynamicSymbols::findSysvHash(std::string_view name) const {
+    // nbucket, nchain, buckets[], chains[]
+    if (sysvHashSize_ < 2 * sizeof(uint32_t)) {
+        return std::nullopt;
+    }
+    const uint32_t nbucket = sysvHash_[0];
+    const uint32_t nchain = sysvHash_[1];
+    if (nbucket == 0 ||
+        (size_t{2} + nbucket + nchain) * sizeof(uint32_t) > sysvHashSize_) {
+        return std::nullopt;
+    }
+
+    const uint32_t *buckets = sysvHash_ + 2;
+    const uint32_t *chains = buckets + nbucket;
+    size_t steps = 0;
+    for (uint32_t index = buckets[sysvHash(name) % nbucket];
+         index != STN_UNDEF && index < nchain && steps++ < nchain;
+         index = chains[index]) {
+        const void *sym = symbol(index);
+        if (sym != nullptr && symbolName(sym) == name) {
+            return toDef(sym);
+        }
+    }
+    return std::nullopt;
+}
+
+std::optional<SymbolDef> ElfDynamicSymbols::find(std::string_view name) const {
+    if (!valid() || name.empty()) {
+        return std::nullopt;
+    }
+    if (gnuHash_ != nullptr) {
+        return findGnuHash(name);
+    }
+    if (sysvHash_ != nullptr) {
+        return findSysvHash(name);
+    }
+
+    for (size_t i = 1; i < symbolCount_; ++i) {
+        const void *sym = symbol(i);
+        if (symbolName(sym) == name) {
+            return toDef(sym);
+        }
+    }
+    return std::nullopt;
+}
+
+} // namespace utility
@@ -1,47 +1,41 @@
 #include "../include/utility/library_introspection.hpp"
 #include "../repl.hpp" // Para VarDecl
 
-#include "file_raii.hpp"
+#include "../include/execution/process_launcher.hpp"
+#include "../include/utility/elf_symbols.hpp"
+#include "../include/utility/loaded_libraries.hpp"
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
-#include <filesystem>
 #include <format>
 #include <iostream>
-#include <system_error>
 
 namespace utility {
 
-constexpr int MAX_LINE_LENGTH = 1024;
+namespace {
 
-auto getBuiltFileDecls(const std::string &path) -> std::vector<VarDecl> {
-    std::vector<VarDecl> vars;
-    char line[MAX_LINE_LENGTH]{};
-
-    // Get the address of the symbol within the library using nm
-    auto command = std::format("nm -D --defined-only {} | grep ' T '", path);
-    auto symbol_address_command = utility::make_popen(command, "r");
-    if (!symbol_address_command) {
-        perror("popen");
-        exit(EXIT_FAILURE);
+// Saída de "nm -D --defined-only <path>", sem shell
+auto runNm(const std::string &path) -> execution::ProcessResult {
+    auto res = execution::runProcess({"nm", "-D", "--defined-only", path});
+    if (res.spawnError != 0) {
+        std::cerr << std::format("nm: {}\n", std::strerror(res.spawnError));
     }
+    return res;
+}
 
-    // Parse the output of nm command to get the symbol address
-    while (fgets(line, MAX_LINE_LENGTH, symbol_address_command.get()) !=
-               nullptr &&
-           !std::feof(symbol_address_command.get())) {
-        char address[32]{};
-        char symbol_location[256]{};
-        char symbol_name[512]{};
-        sscanf(line, "%16s %s %s", address, symbol_location, symbol_name);
-        vars.push_back({.name = symbol_name,
-                        .mangledName = symbol_name,
-                        .kind = "FunctionDecl"});
+template <typename Fn> void forEachLine(std::string_view text, Fn &&fn) {
+    while (!text.empty()) {
+        auto eol = text.find('\n');
+        fn(text.substr(0, eol));
+        if (eol == std::string_view::npos) {
+            break;
+        }
+        text.remove_prefix(eol + 1);
     }
-
-    return vars;
 }
 
+} // namespace
+
 static bool parse_nm_line(std::string_view line, uintptr_t &addrOut,
                           char &typeOut, std::string &nameOut) {
     size_t i = 0, n = line.size();
@@ -84,138 +78,79 @@ static bool parse_nm_line(std::string_view line, uintptr_t &addrOut,
     return true;
 }
 
-auto getAllBuiltFileDecls(const std::string &path) -> std::vector<SymbolDef> {
-    std::vector<SymbolDef> symbols;
-    symbols.reserve(16384); // reserva inicial razoável
+auto getBuiltFileDecls(const std::string &path) -> std::vector<VarDecl> {
+    std::vector<VarDecl> vars;
 
-    // Sem -C para manter mangled (compatível com dlsym/filtros existentes)
-    const auto cmd = std::format("nm -D --defined-only {}", path);
-    auto pipe = utility::make_popen(cmd, "r");
-    if (!pipe) {
-        perror("popen");
-        return symbols;
+    // Símbolos de texto (' T ') exportados pela biblioteca
+    for (auto &def : getAllBuiltFileDecls(path)) {
+        if (def.libSection != 'T') {
+            continue;
+        }
+        vars.push_back({.name = def.nativeName,
+                        .mangledName = std::move(def.nativeName),
+                        .kind = "FunctionDecl"});
     }
 
-    char buf[4096];
-    std::string line;
-    line.reserve(sizeof(buf));
+    return vars;
+}
+
+auto getAllBuiltFileDecls(const std::string &path) -> std::vector<SymbolDef> {
+    ElfDynamicSymbols elf(path);
+    if (elf.valid()) {
+        return elf.definedSymbols();
+    }
 
-    // fgets já sinaliza EOF; não precisa checar feof no while
-    while (std::fgets(buf, sizeof(buf), pipe.get())) {
-        line.assign(buf);
+    // ELF que o leitor não entende (32 bits, big-endian...): deixa com o nm
+    return elf.isElf() ? getAllBuiltFileDeclsNm(path)
+                       : std::vector<SymbolDef>{};
+}
 
+auto getAllBuiltFileDeclsNm(const std::string &path)
+    -> std::vector<SymbolDef> {
+    std::vector<SymbolDef> symbols;
+    symbols.reserve(16384); // reserva inicial razoável
+
+    // Sem -C para manter mangled (compatível com dlsym/filtros existentes)
+    auto nm = runNm(path);
+    forEachLine(nm.out(), [&](std::string_view line) {
         uintptr_t addr = 0;
         char type = '?';
         std::string name;
         if (!parse_nm_line(line, addr, type, name)) {
-            continue;
+            return;
         }
         symbols.push_back(SymbolDef{.nativeName = std::move(name),
                                     .address = addr,
                                     .libSection = type});
-    }
+    });
     return symbols;
 }
 
 auto getLibraryStartAddress(const char *library_name) -> uintptr_t {
-    char line[MAX_LINE_LENGTH]{};
-    char library_path[MAX_LINE_LENGTH]{};
-    uintptr_t start_address{}, end_address{};
-
-    // Open /proc/self/maps
-    auto maps_file = make_fopen("/proc/self/maps", "r");
-    if (!maps_file) {
-        perror("fopen");
-        exit(EXIT_FAILURE);
-    }
-
-    // Search for the library in memory maps
-    while (fgets(line, MAX_LINE_LENGTH, maps_file.get()) != nullptr) {
-        library_path[0] = '\0';
-        line[strcspn(line, "\n")] = '\0';
-        std::cout << strlen(line) << "   \"" << line << '"' << std::endl;
-        try {
-            sscanf(line, "%zx-%zx %*s %*s %*s %*s %1023s", &start_address,
-                   &end_address, library_path);
-            std::error_code ec;
-            if (std::filesystem::equivalent(library_path, library_name, ec) &&
-                !ec) {
-                break;
-            }
-        } catch (...) {
-        }
-    }
-
-    if (library_path[0] == '\0') {
-        std::cout << std::format("Library {} not found in memory maps.\n",
-                                 library_name);
+    auto base = loadedLibraries().baseAddress(library_name);
+    if (!base) {
+        std::cerr << std::format("Library {} is not loaded.\n", library_name);
         return 0;
     }
-
-    return start_address;
+    return *base;
 }
 
 auto getSymbolAddress(const char *library_name,
                       const char *symbol_name) -> uintptr_t {
-    char line[MAX_LINE_LENGTH]{};
-    char library_path[MAX_LINE_LENGTH]{};
-    uintptr_t start_address{}, end_address{};
-    uintptr_t symbol_offset = 0;
-
-    // Open /proc/self/maps
-    auto maps_file = make_fopen("/proc/self/maps", "r");
-    if (!maps_file) {
-        perror("fopen");
-        exit(EXIT_FAILURE);
+    auto &libraries = loadedLibraries();
+    auto address = libraries.symbolAddress(library_name, symbol_name);
+    if (address) {
+        return *address;
     }
 
-    // Search for the library in memory maps
-    while (fgets(line, MAX_LINE_LENGTH, maps_file.get()) != nullptr) {
-        library_path[0] = '\0';
-        int readed = sscanf(line, "%zx-%zx %*s %*s %*s %*s %s", &start_address,
-                            &end_address, library_path);
-        std::cout << readed << "   " << library_path << "   " << library_name
-                  << std::endl;
-        if (strnlen(library_path, std::size(library_path)) == 0) {
-            continue;
-        }
-
-        if (std::filesystem::equivalent(library_path, library_name)) {
-            // Get the base address of the library
-            break;
-        }
-    }
-
-    if (strlen(library_path) == 0) {
-        std::cout << std::format("Library {} not found in memory maps.\n",
-                                 library_name);
+    if (!libraries.baseAddress(library_name)) {
+        std::cerr << std::format("Library {} is not loaded.\n", library_name);
         return 0;
     }
 
-    // Get the address of the symbol within the library using nm
-    auto command = std::format("nm -D --defined-only {} | grep ' {}$'",
-                               library_path, symbol_name);
-    auto symbol_address_command = make_popen(command, "r");
-    if (!symbol_address_command) {
-        perror("popen");
-        exit(EXIT_FAILURE);
-    }
-
-    // Parse the output of nm command to get the symbol address
-    if (fgets(line, MAX_LINE_LENGTH, symbol_address_command.get()) != nullptr) {
-        char address[17]; // Assuming address length of 16 characters
-        sscanf(line, "%16s", address);
-        sscanf(address, "%zx",
-               &symbol_offset); // Convert hex string to unsigned long
-        std::cout << std::format("Address of symbol {} in {}: 0x{:x}\n",
-                                 symbol_name, library_name,
-                                 start_address + symbol_offset);
-    } else {
-        std::cout << std::format("Symbol {} not found in {}.\n", symbol_name,
-                                 library_name);
-    }
-
-    return start_address + symbol_offset;
+    std::cerr << std::format("Symbol {} not found in {}.\n", symbol_name,
+                             library_name);
+    return 0;
 }
 
 } // namespace utility
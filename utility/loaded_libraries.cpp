@@ -0,0 +1,187 @@
+#include "../include/utility/loaded_libraries.hpp"
+#include "../include/utility/elf_symbols.hpp"
+
+#include <dlfcn.h>
+#include <link.h>
+#include <mutex>
+#include <sys/stat.h>
+#include <utility>
+#include <vector>
+
+namespace utility {
+
+std::optional<LoadedLibraries::FileId>
+LoadedLibraries::fileIdOf(const char *path) {
+    struct stat st {};
+    if (path == nullptr || *path == '\0' || ::stat(path, &st) != 0) {
+        return std::nullopt;
+    }
+    return FileId{.dev = static_cast<uint64_t>(st.st_dev),
+                  .ino = static_cast<uint64_t>(st.st_ino)};
+}
+
+void LoadedLibraries::registerHandle(void *handle) {
+    if (handle == nullptr) {
+        return;
+    }
+
+    struct link_map *lm = nullptr;
+    if (dlinfo(handle, RTLD_DI_LINKMAP, &lm) != 0 || lm == nullptr) {
+        return;
+    }
+
+    auto id = fileIdOf(lm->l_name);
+    if (!id) {
+        return;
+    }
+
+    std::unique_lock lock(mutex_);
+    auto &entry = entries_[*id];
+    if (!entry || entry->base != lm->l_addr) {
+        entry = std::make_shared<Entry>(
+            Entry{.path = lm->l_name, .base = lm->l_addr, .symbols = {}});
+    }
+    handles_[handle] = *id;
+}
+
+void LoadedLibraries::unregisterHandle(void *handle) {
+    std::unique_lock lock(mutex_);
+    auto it = handles_.find(handle);
+    if (it == handles_.end()) {
+        return;
+    }
+
+    const FileId id = it->second;
+    handles_.erase(it);
+    entries_.erase(id);
+    std::erase_if(aliases_,
+                  [&](const auto &alias) { return alias.second == id; });
+}
+
+void LoadedLibraries::refresh() {
+    struct Loaded {
+        std::string path;
+        uintptr_t base;
+    };
+    std::vector<Loaded> loaded;
+
+    dl_iterate_phdr(
+        [](struct dl_phdr_info *info, size_t, void *data) -> int {
+            // O executável principal vem com nome vazio
+            if (info->dlpi_name != nullptr && info->dlpi_name[0] != '\0') {
+                static_cast<std::vector<Loaded> *>(data)->push_back(
+                    Loaded{info->dlpi_name, info->dlpi_addr});
+            }
+            return 0;
+        },
+        &loaded);
+
+    std::unordered_map<FileId, std::shared_ptr<Entry>, FileIdHash> fresh;
+    fresh.reserve(loaded.size());
+    for (auto &lib : loaded) {
+        if (auto id = fileIdOf(lib.path.c_str())) {
+            fresh[*id] = std::make_shared<Entry>(Entry{
+                .path = std::move(lib.path), .base = lib.base, .symbols = {}});
+        }
+    }
+
+    std::unique_lock lock(mutex_);
+    // Mantém os caches de símbolos de quem continua no mesmo endereço
+    for (auto &[id, entry] : fresh) {
+        auto it = entries_.find(id);
+        if (it != entries_.end() && it->second->base == entry->base) {
+            entry = it->second;
+        }
+    }
+    entries_ = std::move(fresh);
+    std::erase_if(handles_, [&](const auto &handle) {
+        return !entries_.contains(handle.second);
+    });
+}
+
+std::shared_ptr<LoadedLibraries::Entry>
+LoadedLibraries::lookupLocked(std::string_view path) const {
+    auto alias = aliases_.find(std::string(path));
+    if (alias == aliases_.end()) {
+        return nullptr;
+    }
+    auto it = entries_.find(alias->second);
+    return it != entries_.end() ? it->second : nullptr;
+}
+
+std::shared_ptr<LoadedLibraries::Entry>
+LoadedLibraries::lookup(std::string_view path) {
+    {
+        std::shared_lock lock(mutex_);
+        if (auto entry = lookupLocked(path)) {
+            return entry;
+        }
+    }
+
+    const std::string key(path);
+    auto id = fileIdOf(key.c_str());
+    if (!id) {
+        return nullptr;
+    }
+
+    for (int attempt = 0; attempt < 2; ++attempt) {
+        {
+            std::unique_lock lock(mutex_);
+            auto it = entries_.find(*id);
+            if (it != entries_.end()) {
+                aliases_[key] = *id;
+                return it->second;
+            }
+        }
+        if (attempt == 0) {
+            refresh();
+        }
+    }
+    return nullptr;
+}
+
+std::optional<uintptr_t> LoadedLibraries::baseAddress(std::string_view path) {
+    auto entry = lookup(path);
+    if (!entry) {
+        return std::nullopt;
+    }
+    return entry->base;
+}
+
+std::optional<uintptr_t>
+LoadedLibraries::symbolAddress(std::string_view path, std::string_view symbol) {
+    auto entry = lookup(path);
+    if (!entry) {
+        return std::nullopt;
+    }
+
+    std::string name(symbol);
+    {
+        std::shared_lock lock(mutex_);
+        auto it = entry->symbols.find(name);
+        if (it != entry->symbols.end()) {
+            return entry->base + it->second;
+        }
+    }
+
+    auto def = ElfDynamicSymbols(entry->path).find(symbol);
+    if (!def) {
+        return std::nullopt;
+    }
+
+    std::unique_lock lock(mutex_);
+    entry->symbols.emplace(std::move(name), def->address);
+    return entry->base + def->address;
+}
+
+size_t LoadedLibraries::size() const {
+    std::shared_lock lock(mutex_);
+    return entries_.size();
+}
+
+LoadedLibraries &loadedLibraries() {
+    static LoadedLibraries instance;
+    return instance;
+}
+
+} // namespace utility
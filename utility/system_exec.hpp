@@ -1,67 +1,51 @@
 #pragma once
-#include "file_raii.hpp"
+#include "execution/process_launcher.hpp"
+#include <cstring>
+#include <format>
 #include <iostream>
 #include <string>
 #include <string_view>
 #include <utility>
+#include <vector>
 
 namespace utility {
 
+/**
+ * @brief Executa um programa e devolve {stdout, status do waitpid}
+ *
+ * Sem shell quando a linha é simples (ver execution::parseCommandLine);
+ * redirecionamentos como "2>&1" continuam funcionando.
+ */
 inline auto
 runProgramGetOutput(std::string_view cmd) -> std::pair<std::string, int> {
-    std::pair<std::string, int> result{{}, -1};
+    auto res = execution::runCommandLine(cmd);
 
-    auto pipe = utility::make_popen(cmd.data(), "r");
-
-    if (!pipe) {
-        std::cerr << "popen() failed!" << std::endl;
-        return result;
-    }
-
-    constexpr size_t MBPAGE2 = 1024 * 2;
-
-    auto &buffer = result.first;
-    try {
-        buffer.resize(MBPAGE2);
-    } catch (const std::bad_alloc &e) {
-        pipe.reset();
-        std::cerr << "bad_alloc caught: " << e.what() << std::endl;
-        return result;
-    }
-
-    size_t finalSize = 0;
-
-    while (!feof(pipe.get())) {
-        size_t read = fread(buffer.data() + finalSize, 1,
-                            buffer.size() - finalSize, pipe.get());
-
-        if (read < 0) {
-            std::cerr << "fread() failed!" << std::endl;
-            break;
-        }
-
-        finalSize += read;
-
-        try {
-            if (finalSize == buffer.size()) {
-                buffer.resize(buffer.size() * 2);
-            }
-        } catch (const std::bad_alloc &e) {
-            std::cerr << "bad_alloc caught: " << e.what() << std::endl;
-            break;
-        }
+    if (res.spawnError != 0) {
+        std::cerr << std::format("spawn failed: {}\n",
+                                 std::strerror(res.spawnError));
+    } else if (res.status != 0) {
+        std::cerr << std::format("program failed! {}\n", res.status);
     }
 
-    pipe.reset();
-    result.second = pipe.get_deleter().retcode;
+    return {std::string(res.out()), res.status};
+}
 
-    if (result.second != 0) {
-        std::cerr << std::format("program failed! {}\n", result.second);
+inline auto runProgramGetOutput(const std::vector<std::string> &argv,
+                                bool mergeStderr = false)
+    -> std::pair<std::string, int> {
+    auto res = execution::runProcess(
+        argv, {.out = execution::Stream::Capture,
+               .err = mergeStderr ? execution::Stream::ToStdout
+                                  : execution::Stream::Inherit});
+
+    if (res.spawnError != 0) {
+        std::cerr << std::format("spawn failed: {}\n",
+                                 std::strerror(res.spawnError));
+    } else if (res.status != 0) {
+        std::cerr << std::format("program failed! {}\n", res.status);
     }
 
-    buffer.resize(finalSize);
-
-    return result;
+    return {std::string(res.out()), res.status};
 }
 
 } // namespace utility
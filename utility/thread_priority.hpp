@@ -0,0 +1,35 @@
+#pragma once
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace utility {
+
+/**
+ * @brief Rebaixa a thread atual para trabalho de fundo
+ *
+ * CPU: SCHED_BATCH e nice +niceness; I/O: classe best-effort, nível 7. No
+ * Linux esses atributos são por thread e herdados por fork/exec, então um
+ * clang++ lançado a partir desta thread também fica atrás das compilações
+ * interativas. Falhas são ignoradas (a thread só continua com a prioridade
+ * normal).
+ */
+inline void lowerCurrentThreadPriority(int niceness = 10) noexcept {
+    const auto tid = static_cast<pid_t>(syscall(SYS_gettid));
+
+    sched_param param{};
+    param.sched_priority = 0;
+    sched_setscheduler(tid, SCHED_BATCH, &param);
+    setpriority(PRIO_PROCESS, static_cast<id_t>(tid), niceness);
+
+#ifdef SYS_ioprio_set
+    constexpr int ioprioWhoProcess = 1;
+    constexpr int ioprioClassBestEffort = 2;
+    constexpr int ioprioClassShift = 13;
+    syscall(SYS_ioprio_set, ioprioWhoProcess, tid,
+            (ioprioClassBestEffort << ioprioClassShift) | 7);
+#endif
+}
+
+} // namespace utility